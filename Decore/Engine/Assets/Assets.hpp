@@ -1,4 +1,5 @@
 #pragma once
 #include "BaseAsset.hpp"
 #include "glTF/StaticGLTFAsset.hpp"
-#include "glTF/SkinnedGLTFAsset.hpp"
\ No newline at end of file
+#include "glTF/SkinnedGLTFAsset.hpp"
+#include "glTF/CrowdGLTFAsset.hpp"
\ No newline at end of file
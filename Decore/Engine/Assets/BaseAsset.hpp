@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+
 namespace Engine::Renderer {
 	class CommandBuffer;
 	class Descriptor;
@@ -7,6 +10,25 @@ namespace Engine::Renderer {
 }
 
 namespace Engine::Assets {
+	// Draw ranges of an asset, in the order the forward pass draws them. Each one has its own pipeline variant:
+	// opaque without discard, alpha tested, alpha blended (depth read only, sorted back to front), and their double sided counterparts without culling.
+	enum DrawBucket : uint32_t {
+		DB_OPAQUE,
+		DB_OPAQUE_DOUBLE_SIDED,
+		DB_MASK,
+		DB_MASK_DOUBLE_SIDED,
+		DB_BLEND,
+		DB_BLEND_DOUBLE_SIDED,
+		DRAW_BUCKET_COUNT
+	};
+
+	constexpr bool IsDoubleSided(DrawBucket bucket) { return bucket % 2 == 1; }
+	constexpr bool IsAlphaTested(DrawBucket bucket) { return bucket == DB_MASK || bucket == DB_MASK_DOUBLE_SIDED; }
+	constexpr bool IsBlended(DrawBucket bucket) { return bucket >= DB_BLEND; }
+
+	// One pipeline per DrawBucket, null for the buckets a pass skips.
+	using DrawBucketPipelines_t = std::array<Renderer::Pipeline*, DRAW_BUCKET_COUNT>;
+
 	class BaseAsset {
 	public:
 		virtual std::string GetName() const = 0;
@@ -153,4 +153,168 @@ namespace Engine::Assets {
 			}
 		);
 	}
-}
\ No newline at end of file
+
+	void BaseGLTFAsset::CreateIndexBuffers(const std::vector<uint32_t>& indices)
+	{
+		std::vector<uint16_t> shortIndices{};
+		std::vector<uint32_t> longIndices{};
+
+		for (auto* mesh : GetUniqueMeshes())
+		{
+			for (auto& primitive : mesh->m_Primitives)
+			{
+				const uint32_t* source = indices.data() + primitive.m_IndexOffset;
+
+				primitive.m_ShortIndices = m_VertexFormat == VertexFormat::VF_PACKED && primitive.m_VertexCount < std::numeric_limits<uint16_t>::max();
+
+				if (primitive.m_ShortIndices)
+				{
+					primitive.m_DrawIndexOffset = static_cast<uint32_t>(shortIndices.size());
+
+					for (auto i = 0u; i < primitive.m_IndexCount; i++)
+						shortIndices.push_back(static_cast<uint16_t>(source[i] - primitive.m_VertexOffset));
+				}
+				else
+				{
+					primitive.m_DrawIndexOffset = static_cast<uint32_t>(longIndices.size());
+					longIndices.insert(longIndices.end(), source, source + primitive.m_IndexCount);
+				}
+
+				// LODs reference the same vertices, so they share the index size of their primitive.
+				for (auto& lod : primitive.m_Lods)
+				{
+					const uint32_t* lodSource = m_LodIndices.data() + lod.m_IndexOffset;
+
+					if (primitive.m_ShortIndices)
+					{
+						lod.m_DrawIndexOffset = static_cast<uint32_t>(shortIndices.size());
+
+						for (auto i = 0u; i < lod.m_IndexCount; i++)
+							shortIndices.push_back(static_cast<uint16_t>(lodSource[i] - primitive.m_VertexOffset));
+					}
+					else
+					{
+						lod.m_DrawIndexOffset = static_cast<uint32_t>(longIndices.size());
+						longIndices.insert(longIndices.end(), lodSource, lodSource + lod.m_IndexCount);
+					}
+				}
+			}
+		}
+
+		auto* arena = Renderer::GeometryArena::Get();
+
+		m_IndexRange = arena->AllocateIndices(longIndices.data(), longIndices.size() * sizeof(uint32_t), sizeof(uint32_t));
+		m_ShortIndexRange = arena->AllocateIndices(shortIndices.data(), shortIndices.size() * sizeof(uint16_t), sizeof(uint16_t));
+
+		// An empty list gets an empty range, anything else has to fit.
+		if ((!longIndices.empty() && !m_IndexRange.IsValid()) || (!shortIndices.empty() && !m_ShortIndexRange.IsValid()))
+		{
+			ReleaseGeometryBuffers();
+			throw std::runtime_error("Geometry arena out of index memory for " + GetName());
+		}
+	}
+
+	void BaseGLTFAsset::ReportGeometryMemory(size_t fullVertexStride) const
+	{
+		constexpr double toMB = 1.0 / (1024.0 * 1024.0);
+
+		const double vertexBytes = static_cast<double>(m_VertexRange.m_Size);
+		const double fullVertexBytes = static_cast<double>(m_VertexCount * fullVertexStride);
+
+		const double indexBytes = static_cast<double>(m_IndexRange.m_Size + m_ShortIndexRange.m_Size);
+		const double fullIndexBytes = static_cast<double>(m_IndexCount * sizeof(uint32_t));
+
+		// Vertex fetch bandwidth scales with the stride, index fetch with the index size.
+		printf("[%s] %s vertices: %zu x %u B = %.2f MB (fp32: %zu B, %.2f MB), indices: %.2f MB (uint32: %.2f MB), geometry bandwidth: %.1f%% of fp32\n",
+			GetName().c_str(),
+			m_VertexFormat == VertexFormat::VF_PACKED ? "packed" : "full",
+			m_VertexCount, m_VertexStride, vertexBytes * toMB,
+			fullVertexStride, fullVertexBytes * toMB,
+			indexBytes * toMB, fullIndexBytes * toMB,
+			fullVertexBytes + fullIndexBytes > 0.0 ? 100.0 * (vertexBytes + indexBytes) / (fullVertexBytes + fullIndexBytes) : 100.0
+		);
+	}
+
+	void BaseGLTFAsset::ReportMeshOptimization() const
+	{
+		const auto& before = m_OptimizeStatsBefore;
+		const auto& after = m_OptimizeStatsAfter;
+
+		if (before.m_Triangles == 0)
+			return;
+
+		printf("[%s] mesh optimization: vertices %llu -> %llu, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, overdraw %.3f -> %.3f\n",
+			GetName().c_str(),
+			before.m_Vertices, after.m_Vertices,
+			before.GetACMR(), after.GetACMR(),
+			before.GetATVR(), after.GetATVR(),
+			before.GetOverdraw(), after.GetOverdraw()
+		);
+	}
+
+	bool BaseGLTFAsset::ParseMeshInstancing(const tinygltf::Node& inputNode, Node* node)
+	{
+		const auto extension = inputNode.extensions.find("EXT_mesh_gpu_instancing");
+		if (extension == inputNode.extensions.cend() || !extension->second.Has("attributes"))
+			return false;
+
+		const auto& attributes = extension->second.Get("attributes");
+
+		// All instance attributes have the same count, only float data is supported.
+		size_t instanceCount = 0;
+
+		const auto getAttribute = [&](const char* name, int components, int& stride) -> const float* {
+			if (!attributes.Has(name))
+				return nullptr;
+
+			const auto& accessor = m_LoadedModel.accessors[attributes.Get(name).GetNumberAsInt()];
+			if (accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT) {
+				printf("Node %s: EXT_mesh_gpu_instancing %s is not float, ignored\n", inputNode.name.c_str(), name);
+				return nullptr;
+			}
+
+			const auto& view = m_LoadedModel.bufferViews[accessor.bufferView];
+
+			stride = accessor.ByteStride(view) ? (accessor.ByteStride(view) / sizeof(float)) : components;
+			instanceCount = accessor.count;
+
+			return reinterpret_cast<const float*>(&(m_LoadedModel.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
+		};
+
+		int translationStride{}, rotationStride{}, scaleStride{};
+		const float* translations = getAttribute("TRANSLATION", 3, translationStride);
+		const float* rotations = getAttribute("ROTATION", 4, rotationStride);
+		const float* scales = getAttribute("SCALE", 3, scaleStride);
+
+		node->m_Instances.resize(instanceCount);
+
+		for (size_t i = 0; i < instanceCount; i++) {
+			const glm::vec3 translation = translations ? glm::make_vec3(&translations[i * translationStride]) : glm::vec3(0.f);
+			const glm::quat rotation = rotations ? glm::make_quat(&rotations[i * rotationStride]) : glm::identity<glm::quat>();
+			const glm::vec3 scale = scales ? glm::make_vec3(&scales[i * scaleStride]) : glm::vec3(1.f);
+
+			// Same order as Node::GetLocalMatrix.
+			node->m_Instances[i] = glm::translate(glm::identity<glm::mat4>(), translation) * glm::mat4(rotation) * glm::scale(glm::identity<glm::mat4>(), scale);
+		}
+
+		return instanceCount > 0;
+	}
+
+	void BaseGLTFAsset::DrawRangeIndirect(Renderer::CommandBuffer& commandBuffer, const Renderer::Buffer& indirectBuffer, const DrawRange& range) const
+	{
+		auto* arena = Renderer::GeometryArena::Get();
+
+		// TODO: Check if device supports MultiDrawIndirect.
+		if (range.m_ShortCount > 0)
+		{
+			arena->BindIndices(commandBuffer, VK_INDEX_TYPE_UINT16);
+			vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer, range.m_First * sizeof(VkDrawIndexedIndirectCommand), range.m_ShortCount, sizeof(VkDrawIndexedIndirectCommand));
+		}
+
+		if (range.m_Count > range.m_ShortCount)
+		{
+			arena->BindIndices(commandBuffer, VK_INDEX_TYPE_UINT32);
+			vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer, (range.m_First + range.m_ShortCount) * sizeof(VkDrawIndexedIndirectCommand), range.m_Count - range.m_ShortCount, sizeof(VkDrawIndexedIndirectCommand));
+		}
+	}
+}
@@ -7,7 +7,13 @@
 
 #include <tiny_gltf.h>
 
+#include <unordered_map>
+#include <unordered_set>
+
 #include "../BaseAsset.hpp"
+#include "VertexPacking.hpp"
+#include "MeshOptimizer.hpp"
+#include "NodeHierarchy.hpp"
 #include "../../Core/Collision/CollisionBox.hpp"
 #include "../../Core/Collision/CollisionCapsule.hpp"
 
@@ -20,6 +26,17 @@ namespace Engine::Assets
 		AM_MASK
 	};
 
+	// LOD0 plus up to four simplified levels per primitive.
+	constexpr uint32_t MAX_LOD_COUNT = 5;
+
+	// Simplification stops once the error would exceed this fraction of the primitive bounding radius.
+	constexpr float LOD_MAX_RELATIVE_ERROR = 0.05f;
+
+	enum class VertexFormat {
+		VF_FULL,	// fp32 attributes, 32-bit indices.
+		VF_PACKED	// Quantized positions, octahedral normals/tangents, half UVs, 8-bit joints/weights, 16-bit indices where possible.
+	};
+
 	class BaseGLTFAsset : public BaseAsset {
 	protected:
 		using RGBColor_t = glm::vec3;
@@ -35,7 +52,7 @@ namespace Engine::Assets
 			int m_NormalMapIndex{};
 			int m_MetalRoughnessMapIndex{};
 			int m_EmissiveMapIndex{};
-			glm::ivec4 m_OcclusionMapIndex{};
+			glm::ivec4 m_OcclusionMapIndex{}; // x: texture, y: 1 when double sided.
 
 			RGBAColor_t m_BaseColor{};
 			RGBAColor_t m_EmissiveFactor{};
@@ -46,16 +63,78 @@ namespace Engine::Assets
 			float m_RoughnessFactor{};
 		};
 
+		DrawBucket GetDrawBucket( int materialIndex ) const
+		{
+			if ( materialIndex < 0 || materialIndex >= static_cast< int >( m_Materials.size( ) ) )
+				return DB_OPAQUE;
+
+			const auto& material = m_Materials[ materialIndex ];
+			const uint32_t doubleSided = material.m_OcclusionMapIndex.y != 0 ? 1u : 0u;
+
+			switch ( material.m_AlphaMode )
+			{
+			case AlphaMode::AM_MASK:
+				return static_cast< DrawBucket >( DB_MASK + doubleSided );
+			case AlphaMode::AM_BLEND:
+				return static_cast< DrawBucket >( DB_BLEND + doubleSided );
+			default:
+				return static_cast< DrawBucket >( DB_OPAQUE + doubleSided );
+			}
+		}
+
+		// Draws of one bucket inside the indirect buffer, 16-bit indexed ones first.
+		struct DrawRange {
+			uint32_t m_First{}, m_ShortCount{}, m_Count{};
+		};
+
+		std::array<DrawRange, DRAW_BUCKET_COUNT> m_DrawRanges{};
+
+		// Issues the 16-bit and 32-bit indexed draws of a range, the pipeline and descriptors are already bound.
+		void DrawRangeIndirect( Renderer::CommandBuffer& commandBuffer, const Renderer::Buffer& indirectBuffer, const DrawRange& range ) const;
+
+		// Range of one draw of a bucket, its index type follows from its place inside the bucket.
+		DrawRange GetSingleDrawRange( uint32_t draw, DrawBucket bucket ) const
+		{
+			const auto& range = m_DrawRanges[ bucket ];
+			return { draw, draw < range.m_First + range.m_ShortCount ? 1u : 0u, 1u };
+		}
+
 		struct Bounds {
 			glm::vec3 m_Mins{ std::numeric_limits<float>::max( ) }, m_Maxs{ std::numeric_limits<float>::min( ) };
 		};
 
+		// Simplified index range sharing the vertices of its primitive.
+		struct Lod {
+			size_t m_IndexOffset{}; // Into m_LodIndices.
+			uint32_t m_IndexCount{};
+			uint32_t m_DrawIndexOffset{};
+
+			float m_Error{}; // Object space.
+		};
+
 		struct Primitive {
 			uint32_t m_IndexCount{}, m_VertexCount{};
 			size_t m_IndexOffset{};
+			uint32_t m_VertexOffset{};
 
 			int m_MaterialIndex{};
 
+			// Where the primitive is drawn from inside the 16 or 32-bit index range.
+			bool m_ShortIndices{};
+			uint32_t m_DrawIndexOffset{};
+
+			// Position dequantization (packed vertices only).
+			glm::vec3 m_QuantOffset{ 0.f }, m_QuantScale{ 1.f };
+
+			// LOD1 and up, coarsest last.
+			std::vector<Lod> m_Lods{};
+
+			// LOD0 split into meshlets, in index order (see MeshOptimizer::BuildMeshlets).
+			uint32_t m_MeshletOffset{}, m_MeshletCount{};
+
+			// Sparse morph targets (skinned assets only), index into SkinnedGLTFAsset::m_MorphPrimitives.
+			int32_t m_MorphIndex{ -1 };
+
 			// TODO: GetBounds function.
 			Bounds m_Bounds{};
 		};
@@ -80,6 +159,9 @@ namespace Engine::Assets
 
 			int m_Index{}, m_SkinIndex{ -1 };
 
+			// Into m_Hierarchy, which owns the runtime transforms.
+			int32_t m_Slot{ NodeHierarchy::INVALID_SLOT };
+
 			// TRS transform info.
 			glm::vec3 m_Translation{}, m_Scale{};
 			glm::quat m_Rotation{};
@@ -90,6 +172,9 @@ namespace Engine::Assets
 			glm::mat4 m_CachedMatrix{};
 			bool m_UseCachedMatrix{};
 
+			// EXT_mesh_gpu_instancing, one local transform per instance. Empty when the mesh is drawn once.
+			std::vector<glm::mat4> m_Instances{};
+
 			inline void ParseOrientation( const tinygltf::Node& node )
 			{
 				m_Matrix = glm::identity<glm::mat4>( );
@@ -159,8 +244,13 @@ namespace Engine::Assets
 
 		tinygltf::Model m_LoadedModel{};
 
-		Renderer::Buffer* m_VertexBuffer{};
-		Renderer::Buffer* m_IndexBuffer{};
+		// Ranges inside the shared geometry arena.
+		Renderer::BufferArena::Range m_VertexRange{};
+		Renderer::BufferArena::Range m_IndexRange{};
+		Renderer::BufferArena::Range m_ShortIndexRange{};
+
+		VertexFormat m_VertexFormat{ VertexFormat::VF_FULL };
+		uint32_t m_VertexStride{};
 
 		std::vector<Node*> m_Nodes;
 
@@ -177,48 +267,70 @@ namespace Engine::Assets
 		size_t m_VertexCount{}, m_IndexCount{};
 		size_t m_LastVertex{}, m_LastIndex{};
 
+		// Import-time optimization statistics, summed over every primitive.
+		MeshOptimizer::Statistics m_OptimizeStatsBefore{};
+		MeshOptimizer::Statistics m_OptimizeStatsAfter{};
+
+		// Indices of every simplified LOD, uploaded next to the primitive indices.
+		std::vector<uint32_t> m_LodIndices{};
+
+		// Meshlets of every primitive, meshlet vertices are relative to their primitive.
+		std::vector<MeshOptimizer::Meshlet> m_Meshlets{};
+		std::vector<MeshOptimizer::MeshletBounds> m_MeshletBounds{};
+		std::vector<uint32_t> m_MeshletVertices{};
+		std::vector<uint8_t> m_MeshletTriangles{};
+
 		Renderer::Sampler* m_DefaultTextureSampler = nullptr;
 		Renderer::Buffer* m_MaterialsBuffer = nullptr;
 
 		Renderer::Descriptor* m_MaterialBufferDescriptor = nullptr;
 		Renderer::Descriptor* m_TextureBufferDescriptor = nullptr;
 
-		__forceinline Node* FindNode( Node* source, int index )
+		// Flat copy of the node tree, parents first. Built once the nodes are loaded.
+		NodeHierarchy m_Hierarchy{};
+		std::vector<Node*> m_SlotNodes{};
+
+		void AddToHierarchy( Node* node, int32_t parentSlot )
 		{
-			if ( source->m_Index == index )
-				return source;
+			node->m_Slot = m_Hierarchy.AddNode( node->m_Index, parentSlot, node->m_Translation, node->m_Rotation, node->m_Scale, node->m_Matrix );
+			m_SlotNodes.push_back( node );
 
-			for ( auto& child : source->m_Children )
-			{
-				Node* res = FindNode( child, index );
-				if ( res )
-					return res;
-			}
+			for ( auto* child : node->m_Children )
+				AddToHierarchy( child, node->m_Slot );
+		}
+
+		void BuildHierarchy( )
+		{
+			m_Hierarchy.Clear( );
+			m_SlotNodes.clear( );
+
+			for ( auto* node : m_Nodes )
+				AddToHierarchy( node, NodeHierarchy::INVALID_SLOT );
 
-			return nullptr;
+			m_Hierarchy.UpdateWorldMatrices( );
 		}
 
+		const glm::mat4& GetWorldMatrix( const Node* node ) const { return m_Hierarchy.GetWorldMatrix( node->m_Slot ); }
+
 		__forceinline Node* GetNodeByIndex( int index )
 		{
-			for ( auto& node : m_Nodes )
-			{
-				Node* res = FindNode( node, index );
-				if ( res )
-					return res;
-			}
-
-			return nullptr;
+			const int32_t slot = m_Hierarchy.GetSlot( index );
+			return slot != NodeHierarchy::INVALID_SLOT ? m_SlotNodes[ slot ] : nullptr;
 		}
 
-		__forceinline void GetNodeInfo( const tinygltf::Node& node, const tinygltf::Model& model, size_t& vertexCount, size_t& indexCount )
+		// Meshes already in countedMeshes are skipped, for assets that share one Mesh between the nodes referencing it.
+		__forceinline void GetNodeInfo( const tinygltf::Node& node, const tinygltf::Model& model, size_t& vertexCount, size_t& indexCount, std::vector<bool>* countedMeshes = nullptr )
 		{
 			for ( auto i = 0; i < node.children.size( ); i++ )
 			{
-				GetNodeInfo( model.nodes[ node.children[ i ] ], model, vertexCount, indexCount );
+				GetNodeInfo( model.nodes[ node.children[ i ] ], model, vertexCount, indexCount, countedMeshes );
 			}
 
-			if ( node.mesh > -1 )
+			if ( node.mesh > -1 && !( countedMeshes && ( *countedMeshes )[ node.mesh ] ) )
 			{
+				if ( countedMeshes )
+					( *countedMeshes )[ node.mesh ] = true;
+
 				const auto& mesh = model.meshes[ node.mesh ];
 				for ( const auto& primitive : mesh.primitives )
 				{
@@ -233,6 +345,24 @@ namespace Engine::Assets
 			}
 		}
 
+		// Every mesh once, in node order.
+		std::vector<Mesh*> GetUniqueMeshes( ) const
+		{
+			std::vector<Mesh*> meshes{};
+			std::unordered_set<Mesh*> visited{};
+
+			for ( auto* node : m_AllNodes )
+			{
+				if ( node->m_Mesh && visited.insert( node->m_Mesh ).second )
+					meshes.push_back( node->m_Mesh );
+			}
+
+			return meshes;
+		}
+
+		// Reads the EXT_mesh_gpu_instancing transforms of the node, returns false when there are none.
+		bool ParseMeshInstancing( const tinygltf::Node& inputNode, Node* node );
+
 		bool OpenFile( const std::string& gltfPath )
 		{
 			tinygltf::TinyGLTF loader;
@@ -264,12 +394,241 @@ namespace Engine::Assets
 		virtual bool LoadAsset( const std::string& gltfPath, int sceneIndex ) = 0;
 		virtual void LoadNode( const tinygltf::Node& inputNode, Node* parent, uint32_t nodeIndex ) = 0;
 		virtual void CreateGeometryBuffers( std::shared_ptr<Renderer::Device> device, std::shared_ptr<Renderer::CommandPool> commandPool ) = 0;
+
+		__forceinline void ReleaseGeometryBuffers( )
+		{
+			if ( auto* arena = Renderer::GeometryArena::Get( ) )
+			{
+				arena->FreeVertices( m_VertexRange );
+				arena->FreeIndices( m_IndexRange );
+				arena->FreeIndices( m_ShortIndexRange );
+			}
+
+			m_VertexRange = {};
+			m_IndexRange = {};
+			m_ShortIndexRange = {};
+		}
+
+		// Absolute draw offsets into the geometry arena.
+		uint32_t GetFirstIndex( ) const { return static_cast< uint32_t >( m_IndexRange.m_Offset / sizeof( uint32_t ) ); }
+		uint32_t GetFirstShortIndex( ) const { return static_cast< uint32_t >( m_ShortIndexRange.m_Offset / sizeof( uint16_t ) ); }
+		int32_t GetBaseVertex( ) const { return static_cast< int32_t >( m_VertexRange.m_Offset / m_VertexStride ); }
+
+		uint32_t GetLodFirstIndex( const Primitive& primitive, const Lod& lod ) const
+		{
+			return ( primitive.m_ShortIndices ? GetFirstShortIndex( ) : GetFirstIndex( ) ) + lod.m_DrawIndexOffset;
+		}
+
+		__forceinline void GetDrawOffsets( const Primitive& primitive, uint32_t& firstIndex, int32_t& vertexOffset ) const
+		{
+			// 16-bit indices are relative to the primitive, 32-bit ones to the asset.
+			if ( primitive.m_ShortIndices )
+			{
+				firstIndex = GetFirstShortIndex( ) + primitive.m_DrawIndexOffset;
+				vertexOffset = GetBaseVertex( ) + static_cast< int32_t >( primitive.m_VertexOffset );
+			}
+			else
+			{
+				firstIndex = GetFirstIndex( ) + primitive.m_DrawIndexOffset;
+				vertexOffset = GetBaseVertex( );
+			}
+		}
+
+		template<typename T>
+		void ComputeQuantization( const std::vector<T>& vertices )
+		{
+			for ( auto* mesh : GetUniqueMeshes( ) )
+			{
+				for ( auto& primitive : mesh->m_Primitives )
+				{
+					glm::vec3 mins( std::numeric_limits<float>::max( ) ), maxs( -std::numeric_limits<float>::max( ) );
+
+					for ( auto v = primitive.m_VertexOffset; v < primitive.m_VertexOffset + primitive.m_VertexCount; v++ )
+					{
+						mins = glm::min( mins, vertices[ v ].Position );
+						maxs = glm::max( maxs, vertices[ v ].Position );
+					}
+
+					if ( primitive.m_VertexCount == 0 )
+						mins = maxs = glm::vec3( 0.f );
+
+					primitive.m_QuantOffset = mins;
+					primitive.m_QuantScale = maxs - mins;
+				}
+			}
+		}
+
+		// Deduplicates the primitive vertices, reorders its triangles for the vertex cache and overdraw, then its vertices for fetch locality.
+		// Works in place on the primitive that was just appended, returns its new vertex count.
+		template<typename T>
+		uint32_t OptimizePrimitive( std::vector<T>& vertices, std::vector<uint32_t>& indices, uint32_t vertexStart, uint32_t vertexCount, uint32_t indexStart, uint32_t indexCount )
+		{
+			if ( indexCount == 0 || indexCount % 3 != 0 )
+				return vertexCount;
+
+			std::vector<uint32_t> local( indices.begin( ) + indexStart, indices.begin( ) + indexStart + indexCount );
+			for ( auto& index : local )
+				index -= vertexStart;
+
+			const T* source = vertices.data( ) + vertexStart;
+
+			MeshOptimizer::Statistics before{};
+			MeshOptimizer::AnalyzeVertexCache( before, local, vertexCount );
+			MeshOptimizer::AnalyzeOverdraw( before, local, &source->Position.x, vertexCount, sizeof( T ) );
+
+			std::vector<uint32_t> remap{};
+			const uint32_t uniqueCount = MeshOptimizer::GenerateVertexRemap( remap, source, vertexCount, sizeof( T ) );
+
+			std::vector<T> unique( uniqueCount );
+			for ( uint32_t v = 0; v < vertexCount; v++ )
+				unique[ remap[ v ] ] = source[ v ];
+
+			for ( auto& index : local )
+				index = remap[ index ];
+
+			std::vector<uint32_t> clusters{};
+			MeshOptimizer::OptimizeVertexCache( local, uniqueCount, &clusters );
+
+			// The cluster sort is view independent, keep it only when it actually lowers the overdraw.
+			std::vector<uint32_t> sorted = local;
+			MeshOptimizer::OptimizeOverdraw( sorted, clusters, &unique[ 0 ].Position.x, uniqueCount, sizeof( T ) );
+
+			MeshOptimizer::Statistics cacheOrder{}, overdrawOrder{};
+			MeshOptimizer::AnalyzeOverdraw( cacheOrder, local, &unique[ 0 ].Position.x, uniqueCount, sizeof( T ) );
+			MeshOptimizer::AnalyzeOverdraw( overdrawOrder, sorted, &unique[ 0 ].Position.x, uniqueCount, sizeof( T ) );
+
+			const bool useSorted = overdrawOrder.GetOverdraw( ) < cacheOrder.GetOverdraw( );
+			if ( useSorted )
+				local.swap( sorted );
+
+			const uint32_t fetchCount = MeshOptimizer::OptimizeVertexFetchRemap( remap, local, uniqueCount );
+
+			for ( uint32_t v = 0; v < uniqueCount; v++ )
+			{
+				if ( remap[ v ] != ~0u )
+					vertices[ vertexStart + remap[ v ] ] = unique[ v ];
+			}
+
+			for ( uint32_t i = 0; i < indexCount; i++ )
+			{
+				local[ i ] = remap[ local[ i ] ];
+				indices[ indexStart + i ] = local[ i ] + vertexStart;
+			}
+
+			MeshOptimizer::Statistics after = useSorted ? overdrawOrder : cacheOrder;
+			MeshOptimizer::AnalyzeVertexCache( after, local, fetchCount );
+
+			m_OptimizeStatsBefore += before;
+			m_OptimizeStatsAfter += after;
+
+			return fetchCount;
+		}
+
+		void ReportMeshOptimization( ) const;
+
+		// Builds the simplified index ranges of a primitive, its vertices and bounds must already be final.
+		template<typename T>
+		void GenerateLods( const std::vector<T>& vertices, const std::vector<uint32_t>& indices, Primitive& primitive )
+		{
+			if ( primitive.m_IndexCount == 0 || primitive.m_IndexCount % 3 != 0 )
+				return;
+
+			std::vector<uint32_t> local( indices.begin( ) + primitive.m_IndexOffset, indices.begin( ) + primitive.m_IndexOffset + primitive.m_IndexCount );
+			for ( auto& index : local )
+				index -= primitive.m_VertexOffset;
+
+			const float* positions = &vertices[ primitive.m_VertexOffset ].Position.x;
+			const float maxError = glm::length( primitive.m_Bounds.m_Maxs - primitive.m_Bounds.m_Mins ) * 0.5f * LOD_MAX_RELATIVE_ERROR;
+
+			size_t previousCount = local.size( );
+			float previousError = 0.f;
+
+			for ( uint32_t lod = 1; lod < MAX_LOD_COUNT; lod++ )
+			{
+				float error = 0.f;
+				std::vector<uint32_t> simplified = MeshOptimizer::Simplify( local, positions, primitive.m_VertexCount, sizeof( T ), previousCount / 6 * 3, maxError, &error );
+
+				// Not worth a level if it barely removed anything.
+				if ( simplified.empty( ) || simplified.size( ) > previousCount * 3 / 4 )
+					break;
+
+				MeshOptimizer::OptimizeVertexCache( simplified, primitive.m_VertexCount );
+
+				Lod newLod{};
+				newLod.m_IndexOffset = m_LodIndices.size( );
+				newLod.m_IndexCount = static_cast< uint32_t >( simplified.size( ) );
+				newLod.m_Error = glm::max( error, previousError );
+
+				for ( const auto index : simplified )
+					m_LodIndices.push_back( index + primitive.m_VertexOffset );
+
+				primitive.m_Lods.push_back( newLod );
+
+				previousCount = simplified.size( );
+				previousError = newLod.m_Error;
+			}
+		}
+
+		// Partitions the final LOD0 indices of a primitive into meshlets and computes their culling bounds.
+		template<typename T>
+		void BuildMeshlets( const std::vector<T>& vertices, const std::vector<uint32_t>& indices, Primitive& primitive )
+		{
+			if ( primitive.m_IndexCount == 0 || primitive.m_IndexCount % 3 != 0 )
+				return;
+
+			std::vector<uint32_t> local( indices.begin( ) + primitive.m_IndexOffset, indices.begin( ) + primitive.m_IndexOffset + primitive.m_IndexCount );
+			for ( auto& index : local )
+				index -= primitive.m_VertexOffset;
+
+			primitive.m_MeshletOffset = static_cast< uint32_t >( m_Meshlets.size( ) );
+			primitive.m_MeshletCount = static_cast< uint32_t >( MeshOptimizer::BuildMeshlets( m_Meshlets, m_MeshletVertices, m_MeshletTriangles, local, primitive.m_VertexCount ) );
+
+			const float* positions = &vertices[ primitive.m_VertexOffset ].Position.x;
+
+			for ( auto m = primitive.m_MeshletOffset; m < primitive.m_MeshletOffset + primitive.m_MeshletCount; m++ )
+				m_MeshletBounds.push_back( MeshOptimizer::ComputeMeshletBounds( m_Meshlets[ m ], m_MeshletVertices, m_MeshletTriangles, positions, primitive.m_VertexCount, sizeof( T ) ) );
+		}
+
+		// Splits the asset indices into 16-bit (per primitive) and 32-bit ranges and uploads them.
+		void CreateIndexBuffers( const std::vector<uint32_t>& indices );
+		void ReportGeometryMemory( size_t fullVertexStride ) const;
+
 		virtual void UnloadAsset( ) = 0;
 
 		virtual std::string GetName( ) const override { return m_LoadedModel.nodes[ 0 ].name; }
 		virtual void LoadMaterials( std::shared_ptr<Renderer::Device> device, std::shared_ptr<Renderer::CommandPool> commandPool, const Renderer::DescriptorLayout& materialLayout );
 		virtual void LoadTextures( std::shared_ptr<Renderer::Device> device, std::shared_ptr<Renderer::CommandPool> commandPool, const Renderer::DescriptorLayout& textureLayout );
 	public:
+		// Vertex layout used by assets loaded from now on, pipelines pick their input layout from it as well.
+		// Must be set before any asset or scene is created.
+		static inline VertexFormat s_VertexFormat = VertexFormat::VF_FULL;
+
+		// Runs OptimizePrimitive on every indexed primitive while loading.
+		static inline bool s_OptimizeMeshes = true;
+
+		// Builds a LOD chain for every static primitive while loading.
+		static inline bool s_GenerateLods = true;
+
+		// Splits every static primitive into meshlets while loading, needed for cluster culling.
+		static inline bool s_BuildMeshlets = true;
+
 		virtual void SetupDevice( const std::vector<Renderer::DescriptorLayout>& descriptorLayouts ) = 0;
+
+		// Draws the range of one bucket with its pipeline variant, bufferIndex as in Render.
+		virtual void RenderBucket( Renderer::CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline, const std::vector<Renderer::Descriptor*>& sceneDescriptors, int bufferIndex, DrawBucket bucket ) = 0;
+
+		bool HasDraws( DrawBucket bucket ) const { return m_DrawRanges[ bucket ].m_Count > 0; }
+		VertexFormat GetVertexFormat( ) const { return m_VertexFormat; }
+
+		// One blended draw of the main view, the scene sorts them over every asset before drawing them one by one.
+		struct BlendedDraw {
+			BaseGLTFAsset* m_Asset{};
+			uint32_t m_Draw{};		// Index into the indirect commands.
+			DrawBucket m_Bucket{};
+			float m_Distance{};		// Squared, from the view position to the center of the draw.
+		};
+
+		virtual void GetBlendedDraws( const glm::vec3& viewPosition, std::vector<BlendedDraw>& draws ) const = 0;
+		virtual void RenderBlendedDraw( Renderer::CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline, const std::vector<Renderer::Descriptor*>& sceneDescriptors, const BlendedDraw& draw ) = 0;
 	};
 }
\ No newline at end of file
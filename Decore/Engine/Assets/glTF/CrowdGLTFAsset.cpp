@@ -0,0 +1,156 @@
+#include "../../Renderer/Vulkan/VulkanRenderer.hpp"
+
+#include "CrowdGLTFAsset.hpp"
+
+namespace Engine::Assets {
+	CrowdGLTFAsset::CrowdGLTFAsset(
+		const SkinnedGLTFAsset& source,
+		int animIndex,
+		const std::vector<CrowdInstance>& instances,
+		float frameRate ) : StaticGLTFAsset(source.m_Device, source.m_CommandPool), m_Source(source), m_CrowdInstances(instances)
+	{
+		m_Name = source.GetName() + " crowd";
+
+		m_Animation = source.BakeVertexAnimation(animIndex, frameRate);
+		if (m_Animation.m_Frames.empty() || m_CrowdInstances.empty())
+			throw std::runtime_error("Failed to create crowd of " + source.GetName());
+
+		m_Vertices.resize(source.m_Vertices.size());
+		for (auto v = 0; v < source.m_Vertices.size(); v++) {
+			const auto& src = source.m_Vertices[v];
+			m_Vertices[v] = { src.Position, src.Normal, src.UV, src.Tangent };
+		}
+
+		m_Indices = source.m_Indices;
+		m_VertexCount = source.m_VertexCount;
+		m_IndexCount = source.m_IndexCount;
+
+		// Instances use the skinned world matrix convention (applied after the model matrix), static node matrices apply before it.
+		glm::mat4 flip = glm::mat4(1.f);
+		flip[2][2] *= -1.f;
+
+		std::vector<glm::mat4> matrices(m_CrowdInstances.size());
+		for (auto i = 0; i < m_CrowdInstances.size(); i++)
+			matrices[i] = flip * m_CrowdInstances[i].m_WorldMatrix * flip;
+
+		// The baked vertices are already in model space, one identity node per source mesh carries every instance.
+		std::unordered_set<const Mesh*> visited{};
+
+		for (const auto* sourceNode : source.m_AllNodes) {
+			if (!sourceNode->m_Mesh || !visited.insert(sourceNode->m_Mesh).second)
+				continue;
+
+			Node* node = new Node(sourceNode->m_Name, nullptr, static_cast<int>(m_AllNodes.size()), -1);
+			node->m_Matrix = glm::mat4(1.f);
+			node->m_Translation = glm::vec3(0.f);
+			node->m_Scale = glm::vec3(1.f);
+			node->m_Rotation = glm::quat(1.f, 0.f, 0.f, 0.f);
+
+			node->m_Mesh = new Mesh(*sourceNode->m_Mesh);
+
+			for (auto& primitive : node->m_Mesh->m_Primitives) {
+				primitive.m_Lods.clear();
+				primitive.m_MeshletOffset = primitive.m_MeshletCount = 0; // Bind pose meshlet bounds would cull animated triangles.
+				primitive.m_MorphIndex = -1;
+
+				// Bounds over the whole clip so the culling sphere holds every frame.
+				primitive.m_Bounds = {};
+				primitive.m_Bounds.m_Maxs = glm::vec3(-std::numeric_limits<float>::max());
+
+				for (auto f = 0u; f < m_Animation.m_FrameCount; f++) {
+					const auto* frame = &m_Animation.m_Frames[static_cast<size_t>(f) * m_Animation.m_VertexCount];
+
+					for (auto v = primitive.m_VertexOffset; v < primitive.m_VertexOffset + primitive.m_VertexCount; v++) {
+						const glm::vec3 position = glm::uintBitsToFloat(glm::uvec3(frame[v]));
+						primitive.m_Bounds.m_Mins = glm::min(primitive.m_Bounds.m_Mins, position);
+						primitive.m_Bounds.m_Maxs = glm::max(primitive.m_Bounds.m_Maxs, position);
+					}
+				}
+
+				if (primitive.m_VertexCount == 0)
+					primitive.m_Bounds.m_Mins = primitive.m_Bounds.m_Maxs = glm::vec3(0.f);
+
+				if (s_GenerateLods)
+					GenerateLods(m_Vertices, m_Indices, primitive);
+			}
+
+			node->m_Instances = matrices;
+
+			m_Meshes.push_back(node->m_Mesh);
+			m_AllNodes.push_back(node);
+			m_Nodes.push_back(node);
+		}
+
+		BuildHierarchy();
+	}
+
+	CrowdGLTFAsset::~CrowdGLTFAsset() {
+		delete m_VertexAnimationDescriptor;
+		delete m_VertexAnimationBuffer;
+	}
+
+	void CrowdGLTFAsset::SetupDevice(const std::vector<Renderer::DescriptorLayout>& descriptorLayouts) {
+		CreateGeometryBuffers(m_Device, m_CommandPool);
+
+		// Materials and textures stay owned by the source asset.
+		m_Materials = m_Source.m_Materials;
+		m_MaterialBufferDescriptor = m_Source.m_MaterialBufferDescriptor;
+		m_TextureBufferDescriptor = m_Source.m_TextureBufferDescriptor;
+
+		BuildIndirectBatches();
+
+		// Every draw is instanced over the whole crowd, in instance order.
+		for (const auto& cmd : m_IndirectCommands) {
+			for (auto n = 0u; n < cmd.instanceCount; n++) {
+				auto& data = m_PerPrimitiveData[cmd.firstInstance + n];
+				data.MaterialIndex.w = 1;
+				data.PosOffset.w = m_CrowdInstances[n].m_TimeOffset;
+			}
+		}
+
+		UploadIndirectBatches(m_Device, m_CommandPool, descriptorLayouts[2]);
+		LoadVertexAnimation(descriptorLayouts[2]);
+	}
+
+	void CrowdGLTFAsset::LoadVertexAnimation(const Renderer::DescriptorLayout& layout) {
+		const auto& graphicsQueue = m_Device->GetGraphicsQueue();
+
+		// x: frame count, y: vertex count, z: frame rate (float bits), w: base vertex of the asset in the geometry arena.
+		std::vector<glm::uvec4> data{};
+		data.reserve(m_Animation.m_Frames.size() + 1);
+		data.push_back(glm::uvec4(m_Animation.m_FrameCount, m_Animation.m_VertexCount, glm::floatBitsToUint(m_Animation.m_FrameRate), static_cast<uint32_t>(GetBaseVertex())));
+		data.insert(data.end(), m_Animation.m_Frames.begin(), m_Animation.m_Frames.end());
+
+		const auto bufferSize = data.size() * sizeof(glm::uvec4);
+
+		std::unique_ptr<Renderer::CommandBuffer> commandBuffer = std::make_unique<Renderer::CommandBuffer>(m_Device, m_CommandPool);
+		std::unique_ptr<Renderer::StagingBuffer> stagingBuffer = std::make_unique<Renderer::StagingBuffer>(m_Device, bufferSize);
+
+		stagingBuffer->Patch(data.data(), bufferSize);
+
+		m_VertexAnimationBuffer = new Renderer::Buffer(m_Device, bufferSize,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			VK_SHARING_MODE_EXCLUSIVE,
+			VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT
+		);
+
+		commandBuffer->Begin();
+		commandBuffer->CopyBuffer(*stagingBuffer, *m_VertexAnimationBuffer, static_cast<VkDeviceSize>(bufferSize));
+		commandBuffer->End();
+		commandBuffer->SubmitToQueue(graphicsQueue);
+
+		m_VertexAnimationDescriptor = new Renderer::Descriptor(m_Device,
+			layout,
+			VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+		);
+
+		m_VertexAnimationDescriptor->Bind(
+			{
+				Renderer::Descriptor::BindingInfo{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, {.m_Buffer = m_VertexAnimationBuffer } }
+			}
+		);
+
+		printf("%s: %zu instances, vertex animation %.2f MB\n", m_Name.c_str(), m_CrowdInstances.size(), bufferSize / (1024.f * 1024.f));
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "StaticGLTFAsset.hpp"
+#include "SkinnedGLTFAsset.hpp"
+
+namespace Engine::Assets {
+
+	// Background crowd of a skinned asset without per instance skeletal evaluation. One clip is baked once (see SkinnedGLTFAsset::BakeVertexAnimation),
+	// every instance is a static instance that plays it from its own time offset. Culled and drawn like any static asset, the static VS fetches the frames.
+	// Materials and textures are shared with the source asset, which has to be set up first and outlive the crowd.
+	class CrowdGLTFAsset : public StaticGLTFAsset {
+	public:
+		struct CrowdInstance {
+			glm::mat4 m_WorldMatrix{ 1.f };
+			float m_TimeOffset{}; // Seconds into the clip.
+		};
+
+		CrowdGLTFAsset(
+			const SkinnedGLTFAsset& source,
+			int animIndex,
+			const std::vector<CrowdInstance>& instances,
+			float frameRate = 30.f
+		);
+		~CrowdGLTFAsset();
+
+		virtual void SetupDevice(const std::vector<Renderer::DescriptorLayout>& descriptorLayouts) override;
+
+		// Instances are placed once, the crowd does not collide.
+		virtual bool Intersects(const Core::CollisionCapsule& capsule) override { return false; }
+		virtual bool Intersects(const Core::CollisionBox& aabb, glm::vec3& normal) override { return false; }
+
+		virtual std::string GetName() const override { return m_Name; }
+
+		size_t GetCrowdSize() const { return m_CrowdInstances.size(); }
+		const SkinnedGLTFAsset::VertexAnimation& GetVertexAnimation() const { return m_Animation; }
+	protected:
+		// Built from the source asset, never from a file.
+		virtual bool LoadAsset(const std::string& gltfPath, int sceneIndex = -1) override { return false; }
+		virtual void LoadNode(const tinygltf::Node& inputNode, Node* parent, uint32_t nodeIndex) override {}
+	private:
+		const SkinnedGLTFAsset& m_Source;
+		std::string m_Name{};
+
+		SkinnedGLTFAsset::VertexAnimation m_Animation{};
+		std::vector<CrowdInstance> m_CrowdInstances{};
+
+		// Header texel followed by the baked frames, see Shaders/VertexAnimation.hlsli.
+		Renderer::Buffer* m_VertexAnimationBuffer = nullptr;
+
+		void LoadVertexAnimation(const Renderer::DescriptorLayout& layout);
+	};
+}
@@ -0,0 +1,1005 @@
+#include "MeshOptimizer.hpp"
+
+#include <glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+namespace Engine::Assets::MeshOptimizer
+{
+	namespace
+	{
+		constexpr uint32_t INVALID_INDEX = ~0u;
+
+		// Resolution of the overdraw analysis viewport.
+		constexpr int OVERDRAW_VIEWPORT = 256;
+
+		uint32_t HashBytes(const uint8_t* data, size_t size)
+		{
+			// FNV-1a.
+			uint32_t hash = 2166136261u;
+
+			for (size_t i = 0; i < size; i++)
+			{
+				hash ^= data[i];
+				hash *= 16777619u;
+			}
+
+			return hash;
+		}
+
+		glm::vec3 GetPosition(const float* positions, size_t positionStride, uint32_t index)
+		{
+			const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + index * positionStride);
+			return glm::vec3(p[0], p[1], p[2]);
+		}
+
+		// Symmetric 4x4 matrix accumulating squared distances to planes, normalized by the total weight when evaluated.
+		struct Quadric {
+			double a2{}, b2{}, c2{}, d2{};
+			double ab{}, ac{}, ad{};
+			double bc{}, bd{}, cd{};
+			double w{};
+
+			static Quadric FromPlane(const glm::vec3& n, float d, float weight)
+			{
+				Quadric q{};
+				q.a2 = double(n.x) * n.x * weight;
+				q.b2 = double(n.y) * n.y * weight;
+				q.c2 = double(n.z) * n.z * weight;
+				q.d2 = double(d) * d * weight;
+				q.ab = double(n.x) * n.y * weight;
+				q.ac = double(n.x) * n.z * weight;
+				q.ad = double(n.x) * d * weight;
+				q.bc = double(n.y) * n.z * weight;
+				q.bd = double(n.y) * d * weight;
+				q.cd = double(n.z) * d * weight;
+				q.w = weight;
+				return q;
+			}
+
+			Quadric& operator+=(const Quadric& o)
+			{
+				a2 += o.a2; b2 += o.b2; c2 += o.c2; d2 += o.d2;
+				ab += o.ab; ac += o.ac; ad += o.ad;
+				bc += o.bc; bd += o.bd; cd += o.cd;
+				w += o.w;
+				return *this;
+			}
+
+			// Average squared distance of p to the accumulated planes.
+			double Evaluate(const glm::vec3& p) const
+			{
+				const double x = p.x, y = p.y, z = p.z;
+				const double e = a2 * x * x + b2 * y * y + c2 * z * z + d2
+					+ 2.0 * (ab * x * y + ac * x * z + bc * y * z)
+					+ 2.0 * (ad * x + bd * y + cd * z);
+
+				return w > 0.0 ? std::abs(e / w) : 0.0;
+			}
+		};
+
+		// Border edges weigh more than faces so the silhouette of open meshes is preserved.
+		constexpr float BORDER_WEIGHT = 10.f;
+
+		uint64_t EdgeKey(uint32_t a, uint32_t b)
+		{
+			return (uint64_t(a) << 32) | b;
+		}
+
+		float EdgeFunction(const glm::vec3& a, const glm::vec3& b, const glm::vec2& p)
+		{
+			return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+		}
+
+		// Counts every pixel that passes the depth test.
+		void RasterizeTriangle(std::vector<float>& depthBuffer, uint64_t& shaded, glm::vec3 a, glm::vec3 b, glm::vec3 c)
+		{
+			float area = EdgeFunction(a, b, glm::vec2(c));
+
+			if (glm::abs(area) < 1e-6f)
+				return;
+
+			// No culling, flip the winding instead.
+			if (area < 0.f)
+			{
+				std::swap(b, c);
+				area = -area;
+			}
+
+			const int minX = std::max(int(glm::floor(glm::min(a.x, glm::min(b.x, c.x)))), 0);
+			const int minY = std::max(int(glm::floor(glm::min(a.y, glm::min(b.y, c.y)))), 0);
+			const int maxX = std::min(int(glm::ceil(glm::max(a.x, glm::max(b.x, c.x)))), OVERDRAW_VIEWPORT - 1);
+			const int maxY = std::min(int(glm::ceil(glm::max(a.y, glm::max(b.y, c.y)))), OVERDRAW_VIEWPORT - 1);
+
+			for (int y = minY; y <= maxY; y++)
+			{
+				for (int x = minX; x <= maxX; x++)
+				{
+					const glm::vec2 p(float(x) + 0.5f, float(y) + 0.5f);
+
+					const float w0 = EdgeFunction(b, c, p);
+					const float w1 = EdgeFunction(c, a, p);
+					const float w2 = EdgeFunction(a, b, p);
+
+					if (w0 < 0.f || w1 < 0.f || w2 < 0.f)
+						continue;
+
+					const float z = (w0 * a.z + w1 * b.z + w2 * c.z) / area;
+					float& depth = depthBuffer[y * OVERDRAW_VIEWPORT + x];
+
+					if (z < depth)
+					{
+						depth = z;
+						shaded++;
+					}
+				}
+			}
+		}
+	}
+
+	Statistics& Statistics::operator+=(const Statistics& other)
+	{
+		m_Triangles += other.m_Triangles;
+		m_Vertices += other.m_Vertices;
+		m_CacheMisses += other.m_CacheMisses;
+		m_PixelsCovered += other.m_PixelsCovered;
+		m_PixelsShaded += other.m_PixelsShaded;
+
+		return *this;
+	}
+
+	uint32_t GenerateVertexRemap(std::vector<uint32_t>& remap, const void* vertices, size_t vertexCount, size_t vertexStride)
+	{
+		remap.assign(vertexCount, INVALID_INDEX);
+
+		size_t tableSize = 16;
+		while (tableSize < vertexCount * 2)
+			tableSize *= 2;
+
+		// Open addressing, stores the first vertex seen with a given content.
+		std::vector<uint32_t> table(tableSize, INVALID_INDEX);
+
+		const uint8_t* bytes = static_cast<const uint8_t*>(vertices);
+		uint32_t uniqueCount = 0;
+
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{
+			const uint8_t* vertex = bytes + i * vertexStride;
+			size_t bucket = HashBytes(vertex, vertexStride) & (tableSize - 1);
+
+			while (true)
+			{
+				const uint32_t entry = table[bucket];
+
+				if (entry == INVALID_INDEX)
+				{
+					table[bucket] = i;
+					remap[i] = uniqueCount++;
+					break;
+				}
+
+				if (memcmp(bytes + entry * vertexStride, vertex, vertexStride) == 0)
+				{
+					remap[i] = remap[entry];
+					break;
+				}
+
+				bucket = (bucket + 1) & (tableSize - 1);
+			}
+		}
+
+		return uniqueCount;
+	}
+
+	void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>* clusters)
+	{
+		const size_t triangleCount = indices.size() / 3;
+
+		if (clusters)
+			clusters->assign(1, 0);
+
+		if (triangleCount == 0 || vertexCount == 0)
+			return;
+
+		// Vertex -> triangle adjacency.
+		std::vector<uint32_t> liveTriangles(vertexCount, 0);
+		for (const auto index : indices)
+			liveTriangles[index]++;
+
+		std::vector<uint32_t> offsets(vertexCount + 1, 0);
+		for (size_t v = 0; v < vertexCount; v++)
+			offsets[v + 1] = offsets[v] + liveTriangles[v];
+
+		std::vector<uint32_t> adjacency(triangleCount * 3);
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+
+		for (uint32_t t = 0; t < triangleCount; t++)
+		{
+			for (auto k = 0; k < 3; k++)
+				adjacency[fill[indices[t * 3 + k]]++] = t;
+		}
+
+		std::vector<uint32_t> cacheTime(vertexCount, 0);
+		std::vector<bool> emitted(triangleCount, false);
+
+		std::vector<uint32_t> deadEnd{};
+		std::vector<uint32_t> candidates{};
+
+		std::vector<uint32_t> result{};
+		result.reserve(triangleCount * 3);
+
+		uint32_t time = VERTEX_CACHE_SIZE + 1;
+		uint32_t cursor = 0;
+		int64_t current = 0;
+
+		while (current >= 0)
+		{
+			candidates.clear();
+
+			// Emit every remaining triangle around the fanning vertex.
+			for (auto a = offsets[current]; a < offsets[current + 1]; a++)
+			{
+				const uint32_t t = adjacency[a];
+
+				if (emitted[t])
+					continue;
+
+				for (auto k = 0; k < 3; k++)
+				{
+					const uint32_t v = indices[t * 3 + k];
+
+					result.push_back(v);
+					deadEnd.push_back(v);
+					candidates.push_back(v);
+
+					liveTriangles[v]--;
+
+					if (time - cacheTime[v] > VERTEX_CACHE_SIZE)
+						cacheTime[v] = time++;
+				}
+
+				emitted[t] = true;
+			}
+
+			// Next fanning vertex: the one that stays in cache the longest while its remaining triangles are emitted.
+			int64_t next = -1;
+			int64_t bestPriority = -1;
+
+			for (const auto v : candidates)
+			{
+				if (liveTriangles[v] == 0)
+					continue;
+
+				int64_t priority = 0;
+
+				if (time - cacheTime[v] + 2 * liveTriangles[v] <= VERTEX_CACHE_SIZE)
+					priority = time - cacheTime[v];
+
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					next = v;
+				}
+			}
+
+			if (next == -1)
+			{
+				// Dead end, prefer recently used vertices then fall back to a linear scan.
+				while (!deadEnd.empty() && next == -1)
+				{
+					const uint32_t v = deadEnd.back();
+					deadEnd.pop_back();
+
+					if (liveTriangles[v] > 0)
+						next = v;
+				}
+
+				while (cursor < vertexCount && next == -1)
+				{
+					if (liveTriangles[cursor] > 0)
+						next = cursor;
+
+					cursor++;
+				}
+
+				const uint32_t triangle = static_cast<uint32_t>(result.size() / 3);
+
+				if (clusters && next != -1 && triangle != clusters->back())
+					clusters->push_back(triangle);
+			}
+
+			current = next;
+		}
+
+		indices.swap(result);
+	}
+
+	void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<uint32_t>& clusters, const float* positions, size_t vertexCount, size_t positionStride, float threshold)
+	{
+		const size_t triangleCount = indices.size() / 3;
+
+		if (triangleCount == 0)
+			return;
+
+		// Split the clusters further wherever the cache has warmed up enough, a split there costs at most (threshold - 1) of the ACMR.
+		Statistics meshStats{};
+		AnalyzeVertexCache(meshStats, indices, vertexCount);
+
+		const double splitACMR = meshStats.GetACMR() * threshold;
+
+		std::vector<uint32_t> softClusters{};
+		std::vector<uint32_t> cacheTime(vertexCount, 0);
+		uint32_t time = VERTEX_CACHE_SIZE + 1;
+
+		for (size_t i = 0; i < clusters.size(); i++)
+		{
+			const uint32_t end = i + 1 < clusters.size() ? clusters[i + 1] : static_cast<uint32_t>(triangleCount);
+
+			uint32_t start = clusters[i];
+			uint32_t misses = 0;
+
+			softClusters.push_back(start);
+
+			// Flush the simulated cache at every cluster start.
+			time += VERTEX_CACHE_SIZE + 1;
+
+			for (auto t = start; t < end; t++)
+			{
+				for (auto k = 0; k < 3; k++)
+				{
+					const uint32_t v = indices[t * 3 + k];
+
+					if (time - cacheTime[v] > VERTEX_CACHE_SIZE)
+					{
+						cacheTime[v] = time++;
+						misses++;
+					}
+				}
+
+				if (t + 1 < end && double(misses) / double(t + 1 - start) <= splitACMR)
+				{
+					start = t + 1;
+					misses = 0;
+
+					softClusters.push_back(start);
+					time += VERTEX_CACHE_SIZE + 1;
+				}
+			}
+		}
+
+		if (softClusters.size() <= 1)
+			return;
+
+		struct ClusterInfo {
+			uint32_t m_Begin{}, m_End{};
+			glm::vec3 m_Centroid{ 0.f };
+			glm::vec3 m_Normal{ 0.f };
+			float m_Area{};
+			float m_SortKey{};
+		};
+
+		std::vector<ClusterInfo> infos(softClusters.size());
+
+		glm::vec3 meshCentroid(0.f);
+		float meshArea = 0.f;
+
+		for (size_t i = 0; i < softClusters.size(); i++)
+		{
+			ClusterInfo& info = infos[i];
+			info.m_Begin = softClusters[i];
+			info.m_End = i + 1 < softClusters.size() ? softClusters[i + 1] : static_cast<uint32_t>(triangleCount);
+
+			for (auto t = info.m_Begin; t < info.m_End; t++)
+			{
+				const glm::vec3 a = GetPosition(positions, positionStride, indices[t * 3 + 0]);
+				const glm::vec3 b = GetPosition(positions, positionStride, indices[t * 3 + 1]);
+				const glm::vec3 c = GetPosition(positions, positionStride, indices[t * 3 + 2]);
+
+				const glm::vec3 normal = glm::cross(b - a, c - a);
+				const float area = glm::length(normal);
+
+				info.m_Centroid += (a + b + c) * (area / 3.f);
+				info.m_Normal += normal;
+				info.m_Area += area;
+			}
+
+			meshCentroid += info.m_Centroid;
+			meshArea += info.m_Area;
+		}
+
+		if (meshArea <= 0.f)
+			return;
+
+		meshCentroid /= meshArea;
+
+		// Clusters facing away from the mesh center are likely to occlude the others (Sander et al. 2007).
+		for (auto& info : infos)
+		{
+			if (info.m_Area <= 0.f)
+				continue;
+
+			const glm::vec3 centroid = info.m_Centroid / info.m_Area;
+			const float normalLength = glm::length(info.m_Normal);
+
+			info.m_SortKey = normalLength > 0.f ? glm::dot(centroid - meshCentroid, info.m_Normal / normalLength) : 0.f;
+		}
+
+		std::stable_sort(infos.begin(), infos.end(), [](const ClusterInfo& a, const ClusterInfo& b) { return a.m_SortKey > b.m_SortKey; });
+
+		std::vector<uint32_t> result{};
+		result.reserve(indices.size());
+
+		for (const auto& info : infos)
+			result.insert(result.end(), indices.begin() + info.m_Begin * 3, indices.begin() + info.m_End * 3);
+
+		indices.swap(result);
+	}
+
+	uint32_t OptimizeVertexFetchRemap(std::vector<uint32_t>& remap, const std::vector<uint32_t>& indices, size_t vertexCount)
+	{
+		remap.assign(vertexCount, INVALID_INDEX);
+
+		uint32_t next = 0;
+
+		for (const auto index : indices)
+		{
+			if (remap[index] == INVALID_INDEX)
+				remap[index] = next++;
+		}
+
+		return next;
+	}
+
+	std::vector<uint32_t> Simplify(const std::vector<uint32_t>& indices, const float* positions, size_t vertexCount, size_t positionStride, size_t targetIndexCount, float targetError, float* resultError)
+	{
+		std::vector<uint32_t> triangles = indices;
+
+		if (resultError)
+			*resultError = 0.f;
+
+		if (indices.size() <= targetIndexCount || vertexCount == 0)
+			return triangles;
+
+		// Weld vertices by position, collapses happen between positions.
+		std::vector<uint32_t> canonical(vertexCount);
+		{
+			size_t tableSize = 16;
+			while (tableSize < vertexCount * 2)
+				tableSize *= 2;
+
+			std::vector<uint32_t> table(tableSize, INVALID_INDEX);
+
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				const glm::vec3 p = GetPosition(positions, positionStride, v);
+				size_t bucket = HashBytes(reinterpret_cast<const uint8_t*>(&p), sizeof(p)) & (tableSize - 1);
+
+				while (true)
+				{
+					const uint32_t entry = table[bucket];
+
+					if (entry == INVALID_INDEX)
+					{
+						table[bucket] = v;
+						canonical[v] = v;
+						break;
+					}
+
+					const glm::vec3 q = GetPosition(positions, positionStride, entry);
+					if (p.x == q.x && p.y == q.y && p.z == q.z)
+					{
+						canonical[v] = entry;
+						break;
+					}
+
+					bucket = (bucket + 1) & (tableSize - 1);
+				}
+			}
+		}
+
+		// Positions referenced by more than one vertex sit on an attribute seam.
+		std::vector<uint32_t> wedge(vertexCount, INVALID_INDEX);
+		std::vector<bool> seam(vertexCount, false);
+
+		for (const auto v : indices)
+		{
+			const uint32_t p = canonical[v];
+
+			if (wedge[p] == INVALID_INDEX)
+				wedge[p] = v;
+			else if (wedge[p] != v)
+				seam[p] = true;
+		}
+
+		// Classify positions from the half edges of the input mesh.
+		enum class VertexKind : uint8_t { Manifold, Border, Locked };
+		std::vector<VertexKind> kind(vertexCount, VertexKind::Manifold);
+
+		std::unordered_map<uint64_t, uint32_t> halfEdges{};
+
+		const auto buildHalfEdges = [&]() {
+			halfEdges.clear();
+			halfEdges.reserve(triangles.size());
+
+			for (size_t i = 0; i < triangles.size(); i += 3)
+			{
+				for (auto k = 0; k < 3; k++)
+					halfEdges[EdgeKey(canonical[triangles[i + k]], canonical[triangles[i + (k + 1) % 3]])]++;
+			}
+		};
+
+		const auto isBorderEdge = [&](uint32_t a, uint32_t b) {
+			return halfEdges.find(EdgeKey(b, a)) == halfEdges.end() && halfEdges.find(EdgeKey(a, b)) != halfEdges.end();
+		};
+
+		buildHalfEdges();
+
+		for (const auto& [key, count] : halfEdges)
+		{
+			const uint32_t a = uint32_t(key >> 32);
+			const uint32_t b = uint32_t(key & 0xffffffff);
+
+			if (count > 1)
+				kind[a] = kind[b] = VertexKind::Locked;
+			else if (halfEdges.find(EdgeKey(b, a)) == halfEdges.end())
+			{
+				if (kind[a] != VertexKind::Locked)
+					kind[a] = VertexKind::Border;
+
+				if (kind[b] != VertexKind::Locked)
+					kind[b] = VertexKind::Border;
+			}
+		}
+
+		for (uint32_t p = 0; p < vertexCount; p++)
+		{
+			if (seam[p])
+				kind[p] = VertexKind::Locked;
+		}
+
+		// Plane quadrics per position, weighted by triangle area.
+		std::vector<Quadric> quadrics(vertexCount);
+
+		for (size_t i = 0; i < triangles.size(); i += 3)
+		{
+			const uint32_t p0 = canonical[triangles[i + 0]], p1 = canonical[triangles[i + 1]], p2 = canonical[triangles[i + 2]];
+			const glm::vec3 a = GetPosition(positions, positionStride, p0);
+			const glm::vec3 b = GetPosition(positions, positionStride, p1);
+			const glm::vec3 c = GetPosition(positions, positionStride, p2);
+
+			const glm::vec3 normal = glm::cross(b - a, c - a);
+			const float area = glm::length(normal);
+
+			if (area <= 0.f)
+				continue;
+
+			const glm::vec3 n = normal / area;
+			const Quadric q = Quadric::FromPlane(n, -glm::dot(n, a), area);
+
+			quadrics[p0] += q;
+			quadrics[p1] += q;
+			quadrics[p2] += q;
+
+			// Planes through border edges, perpendicular to the triangle.
+			const uint32_t corners[3] = { p0, p1, p2 };
+			const glm::vec3 points[3] = { a, b, c };
+
+			for (auto k = 0; k < 3; k++)
+			{
+				if (!isBorderEdge(corners[k], corners[(k + 1) % 3]))
+					continue;
+
+				const glm::vec3 edge = points[(k + 1) % 3] - points[k];
+				const float length = glm::length(edge);
+
+				if (length <= 0.f)
+					continue;
+
+				glm::vec3 perpendicular = glm::cross(edge, n);
+				perpendicular = perpendicular / glm::length(perpendicular);
+
+				const Quadric border = Quadric::FromPlane(perpendicular, -glm::dot(perpendicular, points[k]), length * length * BORDER_WEIGHT);
+
+				quadrics[corners[k]] += border;
+				quadrics[corners[(k + 1) % 3]] += border;
+			}
+		}
+
+		struct Collapse {
+			uint32_t m_From{}, m_To{};
+			float m_Error{};
+		};
+
+		std::vector<Collapse> collapses{};
+		std::vector<uint32_t> collapseTarget(vertexCount);
+		std::vector<bool> touched(vertexCount);
+
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+		std::vector<uint32_t> adjacency{};
+
+		const float maxError = targetError * targetError;
+		float worstError = 0.f;
+
+		const size_t targetTriangles = targetIndexCount / 3;
+
+		while (triangles.size() / 3 > targetTriangles)
+		{
+			buildHalfEdges();
+
+			// Position -> triangle adjacency for the flip test.
+			std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+			for (const auto v : triangles)
+				adjacencyOffsets[canonical[v] + 1]++;
+
+			for (size_t p = 0; p < vertexCount; p++)
+				adjacencyOffsets[p + 1] += adjacencyOffsets[p];
+
+			adjacency.resize(triangles.size());
+			std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+			for (uint32_t i = 0; i < triangles.size(); i++)
+				adjacency[fill[canonical[triangles[i]]]++] = i / 3;
+
+			const auto canCollapse = [&](uint32_t from, uint32_t to) {
+				if (seam[to] || kind[from] == VertexKind::Locked)
+					return false;
+
+				if (kind[from] == VertexKind::Border)
+					return kind[to] == VertexKind::Border && (isBorderEdge(from, to) || isBorderEdge(to, from));
+
+				return true;
+			};
+
+			// Cheapest valid direction per edge.
+			collapses.clear();
+
+			for (size_t i = 0; i < triangles.size(); i += 3)
+			{
+				for (auto k = 0; k < 3; k++)
+				{
+					const uint32_t a = canonical[triangles[i + k]];
+					const uint32_t b = canonical[triangles[i + (k + 1) % 3]];
+
+					// Interior edges are seen twice, only keep one of them.
+					if (a > b && !isBorderEdge(a, b))
+						continue;
+
+					Collapse best{ INVALID_INDEX, INVALID_INDEX, std::numeric_limits<float>::max() };
+
+					if (canCollapse(a, b))
+						best = { a, b, float(quadrics[a].Evaluate(GetPosition(positions, positionStride, b))) };
+
+					if (canCollapse(b, a))
+					{
+						const float error = float(quadrics[b].Evaluate(GetPosition(positions, positionStride, a)));
+
+						if (error < best.m_Error)
+							best = { b, a, error };
+					}
+
+					if (best.m_From != INVALID_INDEX && best.m_Error <= maxError)
+						collapses.push_back(best);
+				}
+			}
+
+			if (collapses.empty())
+				break;
+
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.m_Error < b.m_Error; });
+
+			std::iota(collapseTarget.begin(), collapseTarget.end(), 0);
+			std::fill(touched.begin(), touched.end(), false);
+
+			size_t removed = 0;
+			const size_t removeGoal = triangles.size() / 3 - targetTriangles;
+
+			for (const auto& collapse : collapses)
+			{
+				const uint32_t from = collapse.m_From;
+				const uint32_t to = collapse.m_To;
+
+				if (touched[from] || touched[to])
+					continue;
+
+				// Reject collapses that flip a triangle around the moving vertex.
+				const glm::vec3 target = GetPosition(positions, positionStride, to);
+				bool flips = false;
+
+				for (auto a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1] && !flips; a++)
+				{
+					const uint32_t t = adjacency[a];
+					uint32_t corners[3] = { canonical[triangles[t * 3 + 0]], canonical[triangles[t * 3 + 1]], canonical[triangles[t * 3 + 2]] };
+
+					if (corners[0] == to || corners[1] == to || corners[2] == to)
+						continue;
+
+					glm::vec3 p[3], q[3];
+					for (auto k = 0; k < 3; k++)
+					{
+						p[k] = GetPosition(positions, positionStride, corners[k]);
+						q[k] = corners[k] == from ? target : p[k];
+					}
+
+					const glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+					const glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+
+					flips = glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after);
+				}
+
+				if (flips)
+					continue;
+
+				collapseTarget[from] = to;
+				quadrics[to] += quadrics[from];
+				worstError = glm::max(worstError, collapse.m_Error);
+
+				// Lock the one-ring so the flip test of the next collapses stays valid.
+				for (auto a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1]; a++)
+				{
+					const uint32_t t = adjacency[a];
+					for (auto k = 0; k < 3; k++)
+						touched[canonical[triangles[t * 3 + k]]] = true;
+				}
+
+				removed += kind[from] == VertexKind::Border ? 1 : 2;
+
+				if (removed >= removeGoal)
+					break;
+			}
+
+			// Apply the pass, the target position has a single vertex so its wedge can be used directly.
+			size_t write = 0;
+
+			for (size_t i = 0; i < triangles.size(); i += 3)
+			{
+				uint32_t v[3];
+
+				for (auto k = 0; k < 3; k++)
+				{
+					const uint32_t p = canonical[triangles[i + k]];
+					v[k] = collapseTarget[p] != p ? wedge[collapseTarget[p]] : triangles[i + k];
+				}
+
+				if (canonical[v[0]] == canonical[v[1]] || canonical[v[1]] == canonical[v[2]] || canonical[v[0]] == canonical[v[2]])
+					continue;
+
+				triangles[write++] = v[0];
+				triangles[write++] = v[1];
+				triangles[write++] = v[2];
+			}
+
+			if (write == triangles.size())
+				break;
+
+			triangles.resize(write);
+		}
+
+		if (resultError)
+			*resultError = glm::sqrt(worstError);
+
+		return triangles;
+	}
+
+	size_t BuildMeshlets(std::vector<Meshlet>& meshlets, std::vector<uint32_t>& meshletVertices, std::vector<uint8_t>& meshletTriangles, const std::vector<uint32_t>& indices, size_t vertexCount, size_t maxVertices, size_t maxTriangles)
+	{
+		const size_t firstMeshlet = meshlets.size();
+
+		// Local index of every vertex inside the meshlet being built, 0xff when it is not part of it.
+		std::vector<uint8_t> localIndex(vertexCount, 0xff);
+
+		Meshlet current{};
+		current.m_VertexOffset = static_cast<uint32_t>(meshletVertices.size());
+		current.m_TriangleOffset = static_cast<uint32_t>(meshletTriangles.size());
+
+		const auto flush = [&]()
+		{
+			if (current.m_TriangleCount == 0)
+				return;
+
+			for (auto v = 0u; v < current.m_VertexCount; v++)
+				localIndex[meshletVertices[current.m_VertexOffset + v]] = 0xff;
+
+			meshlets.push_back(current);
+
+			current = {};
+			current.m_VertexOffset = static_cast<uint32_t>(meshletVertices.size());
+			current.m_TriangleOffset = static_cast<uint32_t>(meshletTriangles.size());
+		};
+
+		for (size_t t = 0; t < indices.size() / 3; t++)
+		{
+			const uint32_t a = indices[t * 3 + 0], b = indices[t * 3 + 1], c = indices[t * 3 + 2];
+
+			const uint32_t newVertices = (localIndex[a] == 0xff) + (localIndex[b] == 0xff && b != a) + (localIndex[c] == 0xff && c != a && c != b);
+
+			if (current.m_VertexCount + newVertices > maxVertices || current.m_TriangleCount + 1 > maxTriangles)
+				flush();
+
+			for (const auto v : { a, b, c })
+			{
+				if (localIndex[v] == 0xff)
+				{
+					localIndex[v] = static_cast<uint8_t>(current.m_VertexCount++);
+					meshletVertices.push_back(v);
+				}
+
+				meshletTriangles.push_back(localIndex[v]);
+			}
+
+			current.m_TriangleCount++;
+		}
+
+		flush();
+
+		return meshlets.size() - firstMeshlet;
+	}
+
+	MeshletBounds ComputeMeshletBounds(const Meshlet& meshlet, const std::vector<uint32_t>& meshletVertices, const std::vector<uint8_t>& meshletTriangles, const float* positions, size_t vertexCount, size_t positionStride)
+	{
+		MeshletBounds bounds{};
+
+		if (meshlet.m_VertexCount == 0)
+			return bounds;
+
+		const auto position = [&](uint32_t local) {
+			return GetPosition(positions, positionStride, meshletVertices[meshlet.m_VertexOffset + local]);
+		};
+
+		// Ritter's bounding sphere, seeded with the most distant pair of axis extremes.
+		uint32_t minAxis[3] = {}, maxAxis[3] = {};
+		for (auto v = 0u; v < meshlet.m_VertexCount; v++)
+		{
+			const glm::vec3 p = position(v);
+
+			for (auto axis = 0; axis < 3; axis++)
+			{
+				if (p[axis] < position(minAxis[axis])[axis])
+					minAxis[axis] = v;
+
+				if (p[axis] > position(maxAxis[axis])[axis])
+					maxAxis[axis] = v;
+			}
+		}
+
+		int seedAxis = 0;
+		float seedDistance = -1.f;
+		for (auto axis = 0; axis < 3; axis++)
+		{
+			const float distance = glm::length(position(maxAxis[axis]) - position(minAxis[axis]));
+			if (distance > seedDistance)
+			{
+				seedDistance = distance;
+				seedAxis = axis;
+			}
+		}
+
+		glm::vec3 center = (position(minAxis[seedAxis]) + position(maxAxis[seedAxis])) * 0.5f;
+		float radius = seedDistance * 0.5f;
+
+		for (auto v = 0u; v < meshlet.m_VertexCount; v++)
+		{
+			const glm::vec3 p = position(v);
+			const float distance = glm::length(p - center);
+
+			if (distance > radius)
+			{
+				const float newRadius = (radius + distance) * 0.5f;
+				center += (p - center) * ((newRadius - radius) / distance);
+				radius = newRadius;
+			}
+		}
+
+		// Backface cone from the unit triangle normals.
+		std::vector<glm::vec3> normals{};
+		normals.reserve(meshlet.m_TriangleCount);
+
+		glm::vec3 axis(0.f);
+		for (auto t = 0u; t < meshlet.m_TriangleCount; t++)
+		{
+			const uint8_t* triangle = &meshletTriangles[meshlet.m_TriangleOffset + t * 3];
+			const glm::vec3 n = glm::cross(position(triangle[1]) - position(triangle[0]), position(triangle[2]) - position(triangle[0]));
+			const float area = glm::length(n);
+
+			if (area <= 0.f)
+				continue;
+
+			normals.push_back(n / area);
+			axis += normals.back();
+		}
+
+		bounds.m_Center[0] = center.x;
+		bounds.m_Center[1] = center.y;
+		bounds.m_Center[2] = center.z;
+		bounds.m_Radius = radius;
+
+		const float axisLength = glm::length(axis);
+		if (normals.empty() || axisLength <= 0.f)
+			return bounds;
+
+		axis /= axisLength;
+
+		float minDot = 1.f;
+		for (const auto& n : normals)
+			minDot = glm::min(minDot, glm::dot(n, axis));
+
+		bounds.m_ConeAxis[0] = axis.x;
+		bounds.m_ConeAxis[1] = axis.y;
+		bounds.m_ConeAxis[2] = axis.z;
+
+		// The cone is too wide to ever be fully backfacing.
+		bounds.m_ConeCutoff = minDot <= 0.1f ? 1.f : glm::sqrt(1.f - minDot * minDot);
+
+		return bounds;
+	}
+
+	void AnalyzeVertexCache(Statistics& stats, const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+	{
+		std::vector<uint32_t> cacheTime(vertexCount, 0);
+		uint32_t time = cacheSize + 1;
+
+		for (const auto index : indices)
+		{
+			if (time - cacheTime[index] > cacheSize)
+			{
+				cacheTime[index] = time++;
+				stats.m_CacheMisses++;
+			}
+		}
+
+		stats.m_Triangles += indices.size() / 3;
+		stats.m_Vertices += vertexCount;
+	}
+
+	void AnalyzeOverdraw(Statistics& stats, const std::vector<uint32_t>& indices, const float* positions, size_t vertexCount, size_t positionStride)
+	{
+		if (indices.empty() || vertexCount == 0)
+			return;
+
+		glm::vec3 mins(std::numeric_limits<float>::max()), maxs(-std::numeric_limits<float>::max());
+
+		for (const auto index : indices)
+		{
+			const glm::vec3 p = GetPosition(positions, positionStride, index);
+			mins = glm::min(mins, p);
+			maxs = glm::max(maxs, p);
+		}
+
+		const glm::vec3 extent = maxs - mins;
+		const float largestExtent = glm::max(extent.x, glm::max(extent.y, extent.z));
+
+		if (largestExtent <= 0.f)
+			return;
+
+		const float scale = float(OVERDRAW_VIEWPORT) / largestExtent;
+
+		std::vector<float> depthBuffer(OVERDRAW_VIEWPORT * OVERDRAW_VIEWPORT);
+
+		for (auto axis = 0; axis < 3; axis++)
+		{
+			for (const float direction : { 1.f, -1.f })
+			{
+				std::fill(depthBuffer.begin(), depthBuffer.end(), std::numeric_limits<float>::max());
+
+				// Orthographic projection along the axis, depth grows away from the viewer.
+				const auto project = [&](uint32_t index) {
+					const glm::vec3 p = (GetPosition(positions, positionStride, index) - mins) * scale;
+					return glm::vec3(p[(axis + 1) % 3], p[(axis + 2) % 3], p[axis] * direction);
+				};
+
+				for (size_t t = 0; t < indices.size() / 3; t++)
+					RasterizeTriangle(depthBuffer, stats.m_PixelsShaded, project(indices[t * 3 + 0]), project(indices[t * 3 + 1]), project(indices[t * 3 + 2]));
+
+				for (const float depth : depthBuffer)
+				{
+					if (depth != std::numeric_limits<float>::max())
+						stats.m_PixelsCovered++;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Import-time index/vertex reordering for glTF primitives.
+// All functions work on primitive-local indices (0 .. vertexCount - 1).
+namespace Engine::Assets::MeshOptimizer
+{
+	// Post-transform cache size the optimizer and the analyzer assume.
+	constexpr uint32_t VERTEX_CACHE_SIZE = 16;
+
+	// Meshlet limits, small enough for a single mesh shader workgroup on every vendor.
+	constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+	constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+	// Raw counters so statistics can be accumulated over every primitive of an asset.
+	struct Statistics {
+		uint64_t m_Triangles{};
+		uint64_t m_Vertices{};
+		uint64_t m_CacheMisses{};
+
+		uint64_t m_PixelsCovered{};
+		uint64_t m_PixelsShaded{};
+
+		// Average cache miss ratio, transformed vertices per triangle.
+		double GetACMR( ) const { return m_Triangles ? double( m_CacheMisses ) / double( m_Triangles ) : 0.0; }
+		// Average transform to vertex ratio, 1.0 is optimal.
+		double GetATVR( ) const { return m_Vertices ? double( m_CacheMisses ) / double( m_Vertices ) : 0.0; }
+		// Shaded pixels per covered pixel, 1.0 is optimal.
+		double GetOverdraw( ) const { return m_PixelsCovered ? double( m_PixelsShaded ) / double( m_PixelsCovered ) : 0.0; }
+
+		Statistics& operator+=( const Statistics& other );
+	};
+
+	struct Meshlet {
+		uint32_t m_VertexOffset{};		// Into the meshlet vertex list.
+		uint32_t m_TriangleOffset{};	// Into the meshlet triangle list, three bytes per triangle.
+		uint32_t m_VertexCount{};
+		uint32_t m_TriangleCount{};
+	};
+
+	// Bounding sphere and backface cone. Every triangle of the meshlet faces away from an eye for which
+	// dot( center - eye, axis ) >= cutoff * length( center - eye ) + radius.
+	struct MeshletBounds {
+		float m_Center[ 3 ]{};
+		float m_Radius{};
+
+		float m_ConeAxis[ 3 ]{};
+		float m_ConeCutoff{ 1.f }; // 1 never culls.
+	};
+
+	// Finds bitwise identical vertices, remap[ i ] is the new index of vertex i. Returns the unique vertex count.
+	uint32_t GenerateVertexRemap( std::vector<uint32_t>& remap, const void* vertices, size_t vertexCount, size_t vertexStride );
+
+	// Tipsify (Sander et al. 2007). Optionally returns the first triangle of every cluster, clusters start where the cache had to restart.
+	void OptimizeVertexCache( std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>* clusters = nullptr );
+
+	// Sorts the clusters so outward facing ones are drawn first, the order inside a cluster is kept.
+	// Clusters are split further as long as the ACMR stays within threshold times the input ACMR.
+	void OptimizeOverdraw( std::vector<uint32_t>& indices, const std::vector<uint32_t>& clusters, const float* positions, size_t vertexCount, size_t positionStride, float threshold = 1.05f );
+
+	// Renumbers vertices in first use order and drops unreferenced ones. Returns the new vertex count.
+	uint32_t OptimizeVertexFetchRemap( std::vector<uint32_t>& remap, const std::vector<uint32_t>& indices, size_t vertexCount );
+
+	// Quadric error metric edge collapse (Garland & Heckbert 1997), vertices only move onto existing vertices so the result indexes the same vertex data.
+	// Attribute seams stay locked and border vertices only slide along the border. Stops at targetIndexCount or once a collapse would exceed targetError.
+	// Returns the simplified indices, resultError receives the largest collapse error in position units.
+	std::vector<uint32_t> Simplify( const std::vector<uint32_t>& indices, const float* positions, size_t vertexCount, size_t positionStride, size_t targetIndexCount, float targetError, float* resultError = nullptr );
+
+	// Splits the triangles into meshlets in index order, so the meshlets also are consecutive ranges of the input indices.
+	// Appends to the output lists, meshlet vertices are indices into the input vertices. Returns the number of meshlets added.
+	size_t BuildMeshlets( std::vector<Meshlet>& meshlets, std::vector<uint32_t>& meshletVertices, std::vector<uint8_t>& meshletTriangles, const std::vector<uint32_t>& indices, size_t vertexCount, size_t maxVertices = MESHLET_MAX_VERTICES, size_t maxTriangles = MESHLET_MAX_TRIANGLES );
+
+	MeshletBounds ComputeMeshletBounds( const Meshlet& meshlet, const std::vector<uint32_t>& meshletVertices, const std::vector<uint8_t>& meshletTriangles, const float* positions, size_t vertexCount, size_t positionStride );
+
+	// FIFO cache simulation.
+	void AnalyzeVertexCache( Statistics& stats, const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_SIZE );
+
+	// Rasterizes the primitive from the six axis directions with a depth test.
+	void AnalyzeOverdraw( Statistics& stats, const std::vector<uint32_t>& indices, const float* positions, size_t vertexCount, size_t positionStride );
+}
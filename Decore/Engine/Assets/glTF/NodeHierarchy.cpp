@@ -0,0 +1,89 @@
+#include "NodeHierarchy.hpp"
+
+namespace Engine::Assets
+{
+	namespace
+	{
+		constexpr uint8_t LOCAL_DIRTY = 1;
+		constexpr uint8_t WORLD_DIRTY = 2;
+
+		// Same as BaseGLTFAsset::Node::GetLocalMatrix, written out so no temporaries are built.
+		glm::mat4 ComposeTRS(const glm::vec3& t, const glm::quat& r, const glm::vec3& s)
+		{
+			glm::mat4 m = glm::mat4_cast(r);
+
+			m[0] *= s.x;
+			m[1] *= s.y;
+			m[2] *= s.z;
+			m[3] = glm::vec4(t, 1.f);
+
+			return m;
+		}
+	}
+
+	int32_t NodeHierarchy::AddNode(int nodeIndex, int32_t parentSlot, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale, const glm::mat4& matrix)
+	{
+		const int32_t slot = static_cast<int32_t>(m_Parents.size());
+
+		m_Parents.push_back(parentSlot);
+		m_Translations.push_back(translation);
+		m_Rotations.push_back(rotation);
+		m_Scales.push_back(scale);
+		m_Matrices.push_back(matrix);
+		m_Locals.push_back(glm::mat4(1.f));
+		m_Worlds.push_back(glm::mat4(1.f));
+		m_Dirty.push_back(LOCAL_DIRTY);
+
+		if (nodeIndex >= static_cast<int>(m_Slots.size()))
+			m_Slots.resize(nodeIndex + 1, INVALID_SLOT);
+
+		m_Slots[nodeIndex] = slot;
+
+		return slot;
+	}
+
+	void NodeHierarchy::Clear()
+	{
+		m_Parents.clear();
+		m_Slots.clear();
+		m_Translations.clear();
+		m_Rotations.clear();
+		m_Scales.clear();
+		m_Matrices.clear();
+		m_Locals.clear();
+		m_Worlds.clear();
+		m_Dirty.clear();
+	}
+
+	bool NodeHierarchy::UpdateWorldMatrices()
+	{
+		bool changed = false;
+
+		// Parents come first, their world matrix and dirty state are final when a child is reached.
+		for (size_t i = 0; i < m_Parents.size(); i++)
+		{
+			const int32_t parent = m_Parents[i];
+			const bool parentChanged = parent != INVALID_SLOT && (m_Dirty[parent] & WORLD_DIRTY);
+
+			if (m_Dirty[i] & LOCAL_DIRTY)
+				m_Locals[i] = ComposeTRS(m_Translations[i], m_Rotations[i], m_Scales[i]) * m_Matrices[i];
+			else if (!parentChanged)
+			{
+				m_Dirty[i] = 0;
+				continue;
+			}
+
+			m_Worlds[i] = parent != INVALID_SLOT ? m_Worlds[parent] * m_Locals[i] : m_Locals[i];
+			m_Dirty[i] = WORLD_DIRTY;
+			changed = true;
+		}
+
+		return changed;
+	}
+
+	void NodeHierarchy::ComputeJointPalette(const std::vector<int32_t>& jointSlots, const std::vector<glm::mat4>& inverseBindMatrices, glm::mat4* palette) const
+	{
+		for (size_t i = 0; i < jointSlots.size(); i++)
+			palette[i] = m_Worlds[jointSlots[i]] * inverseBindMatrices[i];
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <glm.hpp>
+#include <gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace Engine::Assets
+{
+	// Node transforms as flat arrays, sorted so every parent comes before its children.
+	// World matrices are refreshed in one linear pass, only below nodes whose TRS changed.
+	class NodeHierarchy {
+	public:
+		static constexpr int32_t INVALID_SLOT = -1;
+
+		// Appends a node, its parent slot must already exist. Returns the new slot.
+		int32_t AddNode( int nodeIndex, int32_t parentSlot, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale, const glm::mat4& matrix );
+
+		void Clear( );
+
+		size_t GetSize( ) const { return m_Parents.size( ); }
+
+		// glTF node index to slot, INVALID_SLOT when the node is not part of the scene.
+		int32_t GetSlot( int nodeIndex ) const
+		{
+			return nodeIndex >= 0 && nodeIndex < static_cast< int >( m_Slots.size( ) ) ? m_Slots[ nodeIndex ] : INVALID_SLOT;
+		}
+
+		const glm::vec3& GetTranslation( int32_t slot ) const { return m_Translations[ slot ]; }
+		const glm::quat& GetRotation( int32_t slot ) const { return m_Rotations[ slot ]; }
+		const glm::vec3& GetScale( int32_t slot ) const { return m_Scales[ slot ]; }
+
+		void SetTranslation( int32_t slot, const glm::vec3& translation ) { m_Translations[ slot ] = translation; m_Dirty[ slot ] = 1; }
+		void SetRotation( int32_t slot, const glm::quat& rotation ) { m_Rotations[ slot ] = rotation; m_Dirty[ slot ] = 1; }
+		void SetScale( int32_t slot, const glm::vec3& scale ) { m_Scales[ slot ] = scale; m_Dirty[ slot ] = 1; }
+
+		// Valid after UpdateWorldMatrices.
+		const glm::mat4& GetWorldMatrix( int32_t slot ) const { return m_Worlds[ slot ]; }
+
+		// Returns true when any world matrix changed.
+		bool UpdateWorldMatrices( );
+
+		// palette[ i ] = world( jointSlots[ i ] ) * inverseBindMatrices[ i ].
+		void ComputeJointPalette( const std::vector<int32_t>& jointSlots, const std::vector<glm::mat4>& inverseBindMatrices, glm::mat4* palette ) const;
+	private:
+		std::vector<int32_t> m_Parents{};
+		std::vector<int32_t> m_Slots{};
+
+		std::vector<glm::vec3> m_Translations{};
+		std::vector<glm::quat> m_Rotations{};
+		std::vector<glm::vec3> m_Scales{};
+		std::vector<glm::mat4> m_Matrices{}; // glTF "matrix", applied after TRS.
+
+		std::vector<glm::mat4> m_Locals{};
+		std::vector<glm::mat4> m_Worlds{};
+
+		// 1: TRS changed, 2: world changed this update (inherited by the children).
+		std::vector<uint8_t> m_Dirty{};
+	};
+}
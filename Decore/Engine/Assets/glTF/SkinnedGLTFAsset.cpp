@@ -1,10 +1,133 @@
 #include "../../Renderer/Vulkan/VulkanRenderer.hpp"
+#include "../../Core/Jobs/JobSystem.hpp"
 #include "../../Core/Time/TimeSystem.hpp"
 
 #include "SkinnedGLTFAsset.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <random>
+
 namespace Engine::Assets
 {
+	namespace
+	{
+		// Largest magnitude of the three smaller components of a unit quaternion.
+		constexpr float SMALLEST_THREE_RANGE = 0.70710678f;
+
+		// Drops the largest component, made positive, and stores its index in the top bits of the first two words.
+		// The other three get 15 bits each.
+		void PackQuat(const glm::vec4& q, uint16_t* words)
+		{
+			int largest = 0;
+			for (int i = 1; i < 4; i++)
+			{
+				if (std::abs(q[i]) > std::abs(q[largest]))
+					largest = i;
+			}
+
+			const float sign = q[largest] < 0.f ? -1.f : 1.f;
+
+			for (int i = 0, k = 0; i < 4; i++)
+			{
+				if (i == largest)
+					continue;
+
+				const float v = glm::clamp(q[i] * sign / SMALLEST_THREE_RANGE * 0.5f + 0.5f, 0.f, 1.f);
+				words[k++] = static_cast<uint16_t>(v * 32767.f + 0.5f);
+			}
+
+			words[0] |= static_cast<uint16_t>((largest & 1) << 15);
+			words[1] |= static_cast<uint16_t>((largest >> 1) << 15);
+		}
+
+		glm::vec4 UnpackQuat(const uint16_t* words)
+		{
+			const int largest = (words[0] >> 15) | ((words[1] >> 15) << 1);
+
+			const glm::vec3 small = (glm::vec3(words[0] & 0x7FFF, words[1] & 0x7FFF, words[2]) * (2.f / 32767.f) - 1.f) * SMALLEST_THREE_RANGE;
+			const float w = std::sqrt(std::max(1.f - glm::dot(small, small), 0.f));
+
+			switch (largest)
+			{
+			case 0: return glm::vec4(w, small.x, small.y, small.z);
+			case 1: return glm::vec4(small.x, w, small.y, small.z);
+			case 2: return glm::vec4(small.x, small.y, w, small.z);
+			default: return glm::vec4(small.x, small.y, small.z, w);
+			}
+		}
+
+		// Same interpolation as Animation::Update.
+		glm::vec4 InterpolateKeys(const glm::vec4& a, const glm::vec4& b, float t, ChannelType type)
+		{
+			if (type != ChannelType::Rotation)
+				return glm::mix(a, b, t);
+
+			const glm::quat q = glm::normalize(glm::slerp(glm::quat(a.w, a.x, a.y, a.z), glm::quat(b.w, b.x, b.y, b.z), t));
+			return glm::vec4(q.x, q.y, q.z, q.w);
+		}
+
+		// Distance for translation/scale, angle for rotation.
+		float KeyError(const glm::vec4& a, const glm::vec4& b, ChannelType type)
+		{
+			// |a - b| = 2 sin(angle / 4) on the same hemisphere, acos(dot) is too coarse near zero.
+			if (type == ChannelType::Rotation)
+				return 4.f * std::asin(std::min((glm::dot(a, b) < 0.f ? glm::length(a + b) : glm::length(a - b)) * 0.5f, 1.f));
+
+			return glm::length(glm::vec3(a) - glm::vec3(b));
+		}
+
+		// Float vec3 accessor, morph targets are often sparse or have no buffer view at all (all zero).
+		std::vector<glm::vec3> ReadVec3Accessor(const tinygltf::Model& model, int accessorIndex)
+		{
+			const auto& accessor = model.accessors[accessorIndex];
+
+			std::vector<glm::vec3> values(accessor.count, glm::vec3(0.f));
+
+			if (accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT || accessor.type != TINYGLTF_TYPE_VEC3)
+			{
+				printf("Morph target accessor %d is not a float vec3, ignored!\n", accessorIndex);
+				return values;
+			}
+
+			if (accessor.bufferView > -1)
+			{
+				const auto& view = model.bufferViews[accessor.bufferView];
+				const auto* data = &model.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset];
+				const int stride = accessor.ByteStride(view) ? accessor.ByteStride(view) : sizeof(glm::vec3);
+
+				for (size_t i = 0; i < accessor.count; i++)
+					values[i] = glm::make_vec3(reinterpret_cast<const float*>(data + i * stride));
+			}
+
+			if (accessor.sparse.isSparse)
+			{
+				const auto& indexView = model.bufferViews[accessor.sparse.indices.bufferView];
+				const auto& valueView = model.bufferViews[accessor.sparse.values.bufferView];
+
+				const auto* indices = &model.buffers[indexView.buffer].data[accessor.sparse.indices.byteOffset + indexView.byteOffset];
+				const auto* sparseValues = reinterpret_cast<const float*>(&model.buffers[valueView.buffer].data[accessor.sparse.values.byteOffset + valueView.byteOffset]);
+
+				for (int i = 0; i < accessor.sparse.count; i++)
+				{
+					uint32_t index{};
+
+					switch (accessor.sparse.indices.componentType)
+					{
+					case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: index = indices[i]; break;
+					case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: index = reinterpret_cast<const uint16_t*>(indices)[i]; break;
+					default: index = reinterpret_cast<const uint32_t*>(indices)[i]; break;
+					}
+
+					if (index < values.size())
+						values[index] = glm::make_vec3(&sparseValues[i * 3]);
+				}
+			}
+
+			return values;
+		}
+	}
+
 
 	SkinnedGLTFAsset::SkinnedGLTFAsset(
 		const std::string& gltfPath,
@@ -18,6 +141,45 @@ namespace Engine::Assets
 
 		m_Device = device;
 		m_CommandPool = commandPool;
+		m_VertexFormat = s_VertexFormat;
+
+		CreateInstance();
+	}
+
+	SkinnedGLTFAsset::~SkinnedGLTFAsset()
+	{
+		ReleaseGeometryBuffers();
+
+		for (auto* instance : m_Instances)
+			delete instance;
+
+		if (m_JointBuffer)
+		{
+			m_JointBuffer->Unmap();
+			delete m_JointBuffer;
+		}
+
+		if (m_PrimitiveStorageBuffer)
+		{
+			m_PrimitiveStorageBuffer->Unmap();
+			delete m_PrimitiveStorageBuffer;
+		}
+
+		if (m_MorphWeightBuffer)
+		{
+			m_MorphWeightBuffer->Unmap();
+			m_MorphJobBuffer->Unmap();
+		}
+
+		for (auto* descriptor : m_MorphDescriptors)
+			delete descriptor;
+
+		delete m_MorphOutputDescriptor;
+		delete m_MorphVertexBuffer;
+		delete m_MorphDeltaBuffer;
+		delete m_MorphWeightBuffer;
+		delete m_MorphJobBuffer;
+		delete m_MorphOutputBuffer;
 	}
 
 	bool SkinnedGLTFAsset::LoadAsset(const std::string& gltfPath, int sceneIndex)
@@ -44,7 +206,13 @@ namespace Engine::Assets
 			LoadNode(m_LoadedModel.nodes[scene.nodes[i]], nullptr, scene.nodes[i]);
 		}
 
-		m_WorldMatrix = glm::mat4(1.f);
+		// Deduplication may have shrunk the vertex data.
+		m_VertexCount = m_LastVertex;
+		m_Vertices.resize(m_VertexCount);
+
+		BuildHierarchy();
+
+		ReportMeshOptimization();
 
 		return true;
 	}
@@ -70,6 +238,9 @@ namespace Engine::Assets
 
 			node->m_Mesh->m_Primitives.resize(srcMesh.primitives.size());
 
+			// Every primitive of a mesh has the same targets, the node owns one set of weights.
+			int32_t morphWeightOffset = -1;
+
 			for (auto i = 0; i < srcMesh.primitives.size(); i++)
 			{
 				uint32_t vertexStart = static_cast<uint32_t>(m_LastVertex);
@@ -232,11 +403,36 @@ namespace Engine::Assets
 					}
 				}
 
+				int32_t morphIndex = -1;
+
+				if (!primitive.targets.empty())
+				{
+					if (morphWeightOffset < 0)
+					{
+						morphWeightOffset = static_cast<int32_t>(m_DefaultMorphWeights.size());
+
+						const auto& weights = !inputNode.weights.empty() ? inputNode.weights : srcMesh.weights;
+						for (size_t t = 0; t < primitive.targets.size(); t++)
+							m_DefaultMorphWeights.push_back(t < weights.size() ? static_cast<float>(weights[t]) : 0.f);
+					}
+
+					morphIndex = LoadMorphTargets(primitive, static_cast<int>(nodeIndex), static_cast<uint32_t>(morphWeightOffset), vertexCount);
+				}
+
+				// The deltas address the source vertices, deduplication could also merge vertices that only differ in their targets.
+				if (s_OptimizeMeshes && morphIndex < 0)
+				{
+					vertexCount = OptimizePrimitive(m_Vertices, m_Indices, vertexStart, vertexCount, indexStart, indexCount);
+					m_LastVertex = vertexStart + vertexCount;
+				}
+
 				Primitive& newPrimitive = node->m_Mesh->m_Primitives[i];
 				newPrimitive.m_MaterialIndex = primitive.material > -1 ? primitive.material : 0; // Default to first material...
 				newPrimitive.m_IndexOffset = indexStart;
 				newPrimitive.m_IndexCount = indexCount;
 				newPrimitive.m_VertexCount = vertexCount;
+				newPrimitive.m_VertexOffset = vertexStart;
+				newPrimitive.m_MorphIndex = morphIndex;
 
 				newPrimitive.m_Bounds.m_Mins = glm::min(posMin, newPrimitive.m_Bounds.m_Mins);
 				newPrimitive.m_Bounds.m_Maxs = glm::max(posMax, newPrimitive.m_Bounds.m_Maxs);
@@ -253,39 +449,420 @@ namespace Engine::Assets
 		}
 	}
 
-	void SkinnedGLTFAsset::UpdateAnimation(int animIndex, float dt)
+	int32_t SkinnedGLTFAsset::LoadMorphTargets(const tinygltf::Primitive& primitive, int nodeIndex, uint32_t weightOffset, uint32_t vertexCount)
+	{
+		const uint32_t targetCount = static_cast<uint32_t>(primitive.targets.size());
+
+		// Tangent deltas are not applied, the skinned VS does not output tangents.
+		std::vector<std::vector<glm::vec3>> positions(targetCount), normals(targetCount);
+
+		for (uint32_t t = 0; t < targetCount; t++)
+		{
+			const auto& target = primitive.targets[t];
+
+			if (const auto it = target.find("POSITION"); it != target.end())
+				positions[t] = ReadVec3Accessor(m_LoadedModel, it->second);
+
+			if (const auto it = target.find("NORMAL"); it != target.end())
+				normals[t] = ReadVec3Accessor(m_LoadedModel, it->second);
+		}
+
+		MorphPrimitive morph{};
+		morph.m_NodeIndex = nodeIndex;
+		morph.m_TargetCount = targetCount;
+		morph.m_WeightOffset = weightOffset;
+		morph.m_FirstVertex = static_cast<uint32_t>(m_MorphVertices.size());
+		morph.m_OutputOffset = m_MorphOutputsPerInstance;
+
+		// Vertex major, the deltas summed by one thread are contiguous. Zero deltas are dropped.
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			const uint32_t firstDelta = static_cast<uint32_t>(m_MorphDeltas.size());
+
+			for (uint32_t t = 0; t < targetCount; t++)
+			{
+				const glm::vec3 position = v < positions[t].size() ? positions[t][v] : glm::vec3(0.f);
+				const glm::vec3 normal = v < normals[t].size() ? normals[t][v] : glm::vec3(0.f);
+
+				if (position == glm::vec3(0.f) && normal == glm::vec3(0.f))
+					continue;
+
+				m_MorphDeltas.push_back({ glm::vec4(position, static_cast<float>(t)), glm::vec4(normal, 0.f) });
+			}
+
+			const uint32_t deltaCount = static_cast<uint32_t>(m_MorphDeltas.size()) - firstDelta;
+
+			if (deltaCount > 0)
+				m_MorphVertices.emplace_back(morph.m_OutputOffset + v, firstDelta, deltaCount, 0u);
+		}
+
+		morph.m_VertexCount = static_cast<uint32_t>(m_MorphVertices.size()) - morph.m_FirstVertex;
+
+		m_MorphOutputsPerInstance += vertexCount;
+		m_MaxMorphVertexCount = std::max(m_MaxMorphVertexCount, morph.m_VertexCount);
+
+		m_MorphPrimitives.push_back(morph);
+		return static_cast<int32_t>(m_MorphPrimitives.size()) - 1;
+	}
+
+	SkinnedGLTFAsset::Instance* SkinnedGLTFAsset::CreateInstance(const glm::mat4& worldMatrix)
+	{
+		// The joint and primitive buffers hold a fixed number of instances.
+		if (m_JointBuffer)
+		{
+			printf("[%s] Instances have to be created before SetupDevice!\n", GetName().c_str());
+			return nullptr;
+		}
+
+		Instance* instance = new Instance();
+		instance->m_WorldMatrix = worldMatrix;
+		instance->m_Hierarchy = m_Hierarchy;
+
+		m_Instances.push_back(instance);
+		return instance;
+	}
+
+	void SkinnedGLTFAsset::UpdateInstance(uint32_t index, float dt)
 	{
+		Instance& instance = *m_Instances[index];
+
+		// Every draw has one entry per instance, no other instance touches these.
+		if (m_MappedPrimitives)
+		{
+			for (const auto& cmd : m_IndirectCommands)
+				m_MappedPrimitives[cmd.firstInstance + index].NodeMatrix = instance.m_WorldMatrix;
+		}
+
 		if (m_Animations.empty())
 			return;
 
-		Animation& animation = m_Animations[animIndex];
+		instance.m_PendingTime += dt;
+
+		switch (instance.m_Update)
+		{
+		case AnimationUpdate::Skip:
+			// The palette went stale, blending restarts from the next sample.
+			instance.m_HistoryValid = false;
+			return;
+		case AnimationUpdate::Interpolate:
+			instance.m_FramesSinceSample++;
+			BlendPalette(instance);
+			return;
+		default:
+			break;
+		}
+
+		const Animation& animation = m_Animations[instance.m_ActiveAnimIndex];
+		const bool updated = animation.Update(instance.m_PendingTime, instance.m_AnimationStates[instance.m_ActiveAnimIndex], instance.m_Hierarchy, instance.m_SkipLeafJoints, instance.m_MorphWeights.data());
+
+		instance.m_PendingTime = 0.f;
+		instance.m_FramesSinceSample = 0;
+
+		if (!updated)
+			return;
+
+		if (instance.m_SampleInterval <= 1 || !m_JointPalettes)
+		{
+			instance.m_HistoryValid = false;
+			UpdateJoints(instance);
+			return;
+		}
+
+		// Throttled, the written palette trails the samples by one interval and blends toward the newest one.
+		instance.m_Hierarchy.UpdateWorldMatrices();
+
+		if (instance.m_HistoryValid)
+			std::swap(instance.m_PrevPose, instance.m_NextPose);
+
+		const NodeHierarchy& hierarchy = instance.m_Hierarchy;
+		instance.m_NextPose.resize(hierarchy.GetSize());
 
-		bool updated = animation.Update(dt);
+		for (int32_t slot = 0; slot < static_cast<int32_t>(hierarchy.GetSize()); slot++)
+			instance.m_NextPose[slot] = { hierarchy.GetTranslation(slot), hierarchy.GetRotation(slot), hierarchy.GetScale(slot) };
 
-		if (updated)
+		if (!instance.m_HistoryValid)
 		{
-			for (auto& Node : m_Nodes)
-				UpdateJoints(Node);
+			instance.m_PrevPose = instance.m_NextPose;
+			instance.m_BlendHierarchy = hierarchy;
+			instance.m_HistoryValid = true;
 		}
+
+		BlendPalette(instance);
+	}
+
+	glm::vec4 SkinnedGLTFAsset::GetBoundingSphere(const Instance& instance) const
+	{
+		// Same transform as the skinned VS, z flipped by the scene model matrix then the world matrix of the instance.
+		const glm::mat4& world = instance.m_WorldMatrix;
+		const glm::vec3 center = world * glm::vec4(m_BoundsCenter.x, m_BoundsCenter.y, -m_BoundsCenter.z, 1.f);
+		const float scale = std::max(glm::length(glm::vec3(world[0])), std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+
+		return glm::vec4(center, m_BoundsRadius * scale);
+	}
+
+	void SkinnedGLTFAsset::BenchmarkAnimation(int animIndex, uint32_t iterations)
+	{
+		if (m_Animations.empty() || m_Instances.empty() || iterations == 0)
+			return;
+
+		using Clock = std::chrono::high_resolution_clock;
+
+		Instance& instance = *m_Instances[0];
+		const Animation& animation = m_Animations[animIndex];
+
+		const auto measure = [&](const char* label, auto step)
+		{
+			// The playback state of the instance is left untouched.
+			AnimationState state = instance.m_AnimationStates[animIndex];
+			state.m_IsPaused = false;
+
+			double sampleTime{}, jointTime{};
+
+			for (uint32_t i = 0; i < iterations; i++)
+			{
+				const auto start = Clock::now();
+				step(state, i);
+				const auto sampled = Clock::now();
+
+				UpdateJoints(instance);
+
+				const auto end = Clock::now();
+
+				sampleTime += std::chrono::duration<double, std::micro>(sampled - start).count();
+				jointTime += std::chrono::duration<double, std::micro>(end - sampled).count();
+			}
+
+			printf("[%s] %s: %zu channels, sampling %.3f us, joints %.3f us per update\n",
+				GetName().c_str(), label, animation.m_Channels.size(), sampleTime / iterations, jointTime / iterations);
+		};
+
+		std::mt19937 random(1337);
+		std::uniform_real_distribution<float> clipTime(animation.m_Start, animation.m_End);
+
+		measure(s_ResampleAnimations ? "playback (resampled)" : "playback", [&](AnimationState& state, uint32_t) { animation.Update(1.f / 60.f, state, instance.m_Hierarchy); });
+		measure(s_ResampleAnimations ? "seek (resampled)" : "seek", [&](AnimationState& state, uint32_t) { state.m_CurTime = clipTime(random); animation.Update(0.f, state, instance.m_Hierarchy); });
+
+		// Put the pose of the active clip back.
+		UpdateInstance(0, 0.f);
 	}
 
-	void SkinnedGLTFAsset::UpdateJoints(Node* node)
+	SkinnedGLTFAsset::VertexAnimation SkinnedGLTFAsset::BakeVertexAnimation(int animIndex, float frameRate) const
 	{
-		node->m_UseCachedMatrix = false;
+		VertexAnimation result{};
+
+		if (animIndex < 0 || animIndex >= static_cast<int>(m_Animations.size()) || frameRate <= 0.f || m_Vertices.empty())
+			return result;
+
+		const Animation& animation = m_Animations[animIndex];
+		const float duration = animation.m_End - animation.m_Start;
+
+		// A frame at the clip end would repeat frame 0, playback wraps instead.
+		const uint32_t frameCount = std::max(1u, static_cast<uint32_t>(std::round(duration * frameRate)));
+		const uint32_t vertexCount = static_cast<uint32_t>(m_Vertices.size());
+
+		result.m_FrameCount = frameCount;
+		result.m_VertexCount = vertexCount;
+		result.m_FrameRate = duration > 0.f ? frameCount / duration : frameRate;
+		result.m_Frames.resize(static_cast<size_t>(frameCount) * vertexCount);
+
+		// What deforms every vertex. Meshes without a skin follow their node.
+		struct VertexSource {
+			int32_t m_PaletteOffset{ -1 };
+			uint32_t m_MeshNode{};
+			uint32_t m_FirstDelta{}, m_DeltaCount{}, m_WeightOffset{};
+		};
+
+		std::vector<VertexSource> sources(vertexCount);
+		std::vector<const Node*> meshNodes{};
+
+		for (const auto* node : m_AllNodes)
+		{
+			if (!node->m_Mesh)
+				continue;
+
+			const uint32_t meshNode = static_cast<uint32_t>(meshNodes.size());
+			meshNodes.push_back(node);
+
+			const int32_t paletteOffset = node->m_SkinIndex > -1 ? static_cast<int32_t>(m_Skins[node->m_SkinIndex].m_PaletteOffset) : -1;
+
+			for (const auto& primitive : node->m_Mesh->m_Primitives)
+			{
+				for (auto v = primitive.m_VertexOffset; v < primitive.m_VertexOffset + primitive.m_VertexCount; v++)
+				{
+					sources[v].m_PaletteOffset = paletteOffset;
+					sources[v].m_MeshNode = meshNode;
+				}
+
+				if (primitive.m_MorphIndex < 0)
+					continue;
+
+				// Morphed primitives keep their source vertex order, outputs map straight back to vertices.
+				const auto& morph = m_MorphPrimitives[primitive.m_MorphIndex];
+
+				for (auto k = morph.m_FirstVertex; k < morph.m_FirstVertex + morph.m_VertexCount; k++)
+				{
+					const auto& morphVertex = m_MorphVertices[k];
+					auto& source = sources[primitive.m_VertexOffset + morphVertex.x - morph.m_OutputOffset];
+
+					source.m_FirstDelta = morphVertex.y;
+					source.m_DeltaCount = morphVertex.z;
+					source.m_WeightOffset = morph.m_WeightOffset;
+				}
+			}
+		}
+
+		// Sampling is sequential, Update eases from the previous pose toward the keys.
+		// The first pass over the clip only settles the pose, so the last frame leads into the first.
+		Instance instance{};
+		instance.m_Hierarchy = m_Hierarchy;
+		instance.m_MorphWeights = m_DefaultMorphWeights;
+
+		AnimationState state{};
+		state.m_Cursors.resize(animation.m_Channels.size());
+		state.m_CurTime = animation.m_Start;
+
+		const size_t weightCount = m_DefaultMorphWeights.size();
+
+		std::vector<glm::mat4> palettes(static_cast<size_t>(frameCount) * m_JointsPerInstance);
+		std::vector<glm::mat4> nodeMatrices(static_cast<size_t>(frameCount) * meshNodes.size());
+		std::vector<float> weights(static_cast<size_t>(frameCount) * weightCount);
+
+		for (int pass = 0; pass < 2; pass++)
+		{
+			for (uint32_t f = 0; f < frameCount; f++)
+			{
+				animation.Update(pass == 0 && f == 0 ? 0.f : 1.f / result.m_FrameRate, state, instance.m_Hierarchy, false, instance.m_MorphWeights.data());
+
+				if (pass == 0)
+					continue;
 
-		if (node->m_SkinIndex > -1)
+				instance.m_Hierarchy.UpdateWorldMatrices();
+				ComputePalette(instance.m_Hierarchy, palettes.data() + static_cast<size_t>(f) * m_JointsPerInstance);
+
+				for (size_t n = 0; n < meshNodes.size(); n++)
+					nodeMatrices[f * meshNodes.size() + n] = instance.m_Hierarchy.GetWorldMatrix(meshNodes[n]->m_Slot);
+
+				std::copy(instance.m_MorphWeights.begin(), instance.m_MorphWeights.end(), weights.begin() + f * weightCount);
+			}
+		}
+
+		// Frames are independent once the poses are known, same math as GLTF_SkinnedVS.hlsl.
+		const auto bakeFrame = [&](uint32_t f)
+		{
+			const glm::mat4* palette = palettes.data() + static_cast<size_t>(f) * m_JointsPerInstance;
+			const float* frameWeights = weights.data() + f * weightCount;
+			glm::uvec4* out = result.m_Frames.data() + static_cast<size_t>(f) * vertexCount;
+
+			const auto joint = [&](int32_t offset, int32_t index) -> const glm::mat4& {
+				return palette[std::min(static_cast<uint32_t>(offset + index), m_JointsPerInstance - 1)];
+			};
+
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				const VertexType& vertex = m_Vertices[v];
+				const VertexSource& source = sources[v];
+
+				glm::vec3 position = vertex.Position;
+				glm::vec3 normal = vertex.Normal;
+
+				if (source.m_DeltaCount > 0)
+				{
+					for (auto d = source.m_FirstDelta; d < source.m_FirstDelta + source.m_DeltaCount; d++)
+					{
+						const auto& delta = m_MorphDeltas[d];
+						const float weight = frameWeights[source.m_WeightOffset + static_cast<uint32_t>(delta.Position.w)];
+
+						position += glm::vec3(delta.Position) * weight;
+						normal += glm::vec3(delta.Normal) * weight;
+					}
+
+					normal = glm::normalize(normal);
+				}
+
+				glm::mat4 transform{};
+
+				if (source.m_PaletteOffset < 0 || m_JointsPerInstance == 0)
+					transform = nodeMatrices[f * meshNodes.size() + source.m_MeshNode];
+				else
+				{
+					transform = joint(source.m_PaletteOffset, vertex.Joints.x) * vertex.Weights.x +
+						joint(source.m_PaletteOffset, vertex.Joints.y) * vertex.Weights.y +
+						joint(source.m_PaletteOffset, vertex.Joints.z) * vertex.Weights.z +
+						joint(source.m_PaletteOffset, vertex.Joints.w) * vertex.Weights.w;
+				}
+
+				const glm::vec3 skinnedPosition = transform * glm::vec4(position, 1.f);
+				glm::vec3 skinnedNormal = glm::mat3(transform) * normal;
+
+				if (glm::dot(skinnedNormal, skinnedNormal) > 0.f)
+					skinnedNormal = glm::normalize(skinnedNormal);
+
+				int16_t packedNormal[2]{};
+				VertexPacking::PackOctahedral(skinnedNormal, packedNormal);
+
+				out[v] = glm::uvec4(
+					glm::floatBitsToUint(skinnedPosition.x),
+					glm::floatBitsToUint(skinnedPosition.y),
+					glm::floatBitsToUint(skinnedPosition.z),
+					static_cast<uint32_t>(static_cast<uint16_t>(packedNormal[0])) | (static_cast<uint32_t>(static_cast<uint16_t>(packedNormal[1])) << 16)
+				);
+			}
+		};
+
+		if (auto* jobSystem = Core::JobSystem::Get())
+			jobSystem->ParallelFor(frameCount, 1, bakeFrame);
+		else
 		{
-			auto& skin = m_Skins[node->m_SkinIndex];
+			for (uint32_t f = 0; f < frameCount; f++)
+				bakeFrame(f);
+		}
+
+		printf("[%s] baked clip %s: %u frames at %.2f fps, %u vertices, %.2f MB\n",
+			GetName().c_str(), animation.m_Name.c_str(), frameCount, result.m_FrameRate, vertexCount,
+			result.m_Frames.size() * sizeof(glm::uvec4) / (1024.0 * 1024.0));
+
+		return result;
+	}
 
-			std::vector<glm::mat4> jointMatrices(skin.m_Joints.size());
-			for (auto i = 0; i < jointMatrices.size(); i++)
-				jointMatrices[i] = skin.m_Joints[i]->GetMatrix() * skin.m_InverseBindMatrices[i];
+	void SkinnedGLTFAsset::UpdateJoints(Instance& instance, bool force)
+	{
+		// One pass over the hierarchy, then every palette is built from the final world matrices.
+		if (!instance.m_Hierarchy.UpdateWorldMatrices() && !force)
+			return;
+
+		// The renderer waits for the previous frame before recording, the GPU is not reading the palettes here.
+		if (m_JointPalettes)
+			ComputePalette(instance.m_Hierarchy, m_JointPalettes + instance.m_PaletteOffset);
+	}
+
+	void SkinnedGLTFAsset::ComputePalette(const NodeHierarchy& hierarchy, glm::mat4* palette) const
+	{
+		for (const auto& skin : m_Skins)
+			hierarchy.ComputeJointPalette(skin.m_JointSlots, skin.m_InverseBindMatrices, palette + skin.m_PaletteOffset);
+	}
+
+	void SkinnedGLTFAsset::BlendPalette(Instance& instance)
+	{
+		if (!m_JointPalettes || !instance.m_HistoryValid)
+			return;
+
+		const float a = std::min((instance.m_FramesSinceSample + 1) / static_cast<float>(instance.m_SampleInterval), 1.f);
+
+		// Blended skinning matrices would shear the mesh, the local TRS is blended instead and the palette rebuilt from it.
+		NodeHierarchy& hierarchy = instance.m_BlendHierarchy;
 
-			skin.m_Buffer->Patch(jointMatrices.data(), jointMatrices.size() * sizeof(glm::mat4));
+		for (int32_t slot = 0; slot < static_cast<int32_t>(instance.m_NextPose.size()); slot++)
+		{
+			const auto& prev = instance.m_PrevPose[slot];
+			const auto& next = instance.m_NextPose[slot];
+
+			hierarchy.SetTranslation(slot, glm::mix(prev.m_Translation, next.m_Translation, a));
+			hierarchy.SetRotation(slot, glm::normalize(glm::slerp(prev.m_Rotation, next.m_Rotation, a)));
+			hierarchy.SetScale(slot, glm::mix(prev.m_Scale, next.m_Scale, a));
 		}
 
-		for (auto& child : node->m_Children)
-			UpdateJoints(child);
+		hierarchy.UpdateWorldMatrices();
+		ComputePalette(hierarchy, m_JointPalettes + instance.m_PaletteOffset);
 	}
 
 	void SkinnedGLTFAsset::LoadAnimations()
@@ -343,6 +920,12 @@ namespace Engine::Assets
 					for (size_t index = 0; index < outputAccessor.count; index++)
 						samplerData.m_Outputs.push_back(buf[index]);
 				}
+
+				if (outputAccessor.type == TINYGLTF_TYPE_SCALAR && outputAccessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
+				{
+					const float* buf = static_cast<const float*>(outputData);
+					samplerData.m_WeightOutputs.assign(buf, buf + outputAccessor.count);
+				}
 			}
 
 			m_Animations[i].m_Channels.resize(animation.channels.size());
@@ -353,56 +936,390 @@ namespace Engine::Assets
 				channelData.m_Sampler = channel.sampler;
 				channelData.m_Type = GetChannelType(channel.target_path);
 				channelData.m_Node = GetNodeByIndex(channel.target_node);
-			}
-		}
-	}
+				channelData.m_Slot = m_Hierarchy.GetSlot(channel.target_node);
+				channelData.m_IsLeaf = channelData.m_Node && channelData.m_Node->m_Children.empty();
 
-	void SkinnedGLTFAsset::BuildIndirectBatches(std::shared_ptr<Renderer::Device> device, std::shared_ptr<Renderer::CommandPool> commandPool, const Renderer::DescriptorLayout& primitiveLayout)
-	{
-		m_IndirectCommands.clear();
+				if (channelData.m_Type != ChannelType::Weights)
+					continue;
 
-		// Build the indirect commands.
-		uint32_t m = 0;
-		for (auto i = 0; i < m_AllNodes.size(); i++)
-		{
-			auto* node = m_AllNodes[i];
+				const auto morph = std::find_if(m_MorphPrimitives.cbegin(), m_MorphPrimitives.cend(), [&](const MorphPrimitive& p) { return p.m_NodeIndex == channel.target_node; });
+				const auto& sampler = animData.m_Samplers[channelData.m_Sampler];
+				const size_t keyValues = sampler.m_Inputs.size() * (sampler.m_Interpolation == "CUBICSPLINE" ? 3 : 1);
 
-			if (node->m_Mesh)
-			{
-				for (const auto& primitive : node->m_Mesh->m_Primitives)
+				// Left with no weights (and skipped) when the outputs do not match the targets of the node.
+				if (morph != m_MorphPrimitives.cend() && sampler.m_WeightOutputs.size() == keyValues * morph->m_TargetCount)
 				{
-					VkDrawIndexedIndirectCommand cmd{};
-					IndirectPrimitiveData data{};
-
-					const auto& bounds = primitive.m_Bounds;
-					const auto origin = (bounds.m_Maxs + bounds.m_Mins) * 0.5f;
-					const auto extents = (bounds.m_Maxs - bounds.m_Mins) * 0.5f;
-					const auto radius = glm::length(extents);
-
-					// TODO: Replace with model matrix.
-					glm::mat4 inv = glm::mat4(1.f);
-					inv[2][2] *= -1.f;
-
-					data.NodeMatrix = m_WorldMatrix;
-					data.MaterialIndex.x = primitive.m_MaterialIndex;
-					data.MaterialIndex.y = node->m_Index;
-					data.NodePos = glm::vec4(origin, 1.f) * inv * data.NodeMatrix;
-					data.NodePos.w = radius;
-
-					cmd.indexCount = primitive.m_IndexCount;
-					cmd.instanceCount = 1;
-					cmd.firstIndex = static_cast<uint32_t>(primitive.m_IndexOffset);
-					cmd.vertexOffset = 0;
-					cmd.firstInstance = m++;
-
-					m_IndirectCommands.push_back(cmd);
-					m_PerPrimitiveData.push_back(data);
+					channelData.m_WeightOffset = morph->m_WeightOffset;
+					channelData.m_WeightCount = morph->m_TargetCount;
 				}
 			}
+
+			if (s_ResampleAnimations)
+				ResampleAnimation(m_Animations[i]);
 		}
 
-		// Setup and transfer the data to the GPU.
-		const auto& graphicsQueue = device->GetGraphicsQueue();
+		if (!s_CompressAnimations || m_Animations.empty())
+			return;
+
+		// Clips are independent, large libraries are compressed across the worker threads.
+		std::vector<AnimationCompressionStats> stats(m_Animations.size());
+
+		Core::JobSystem::Get()->ParallelFor(static_cast<uint32_t>(m_Animations.size()), 1, [&](uint32_t i) { stats[i] = CompressAnimation(m_Animations[i]); });
+
+		for (size_t i = 0; i < m_Animations.size(); i++)
+		{
+			const auto& clip = stats[i];
+
+			printf("[%s] clip %s: keys %zu -> %zu, %.1f KB -> %.1f KB, max error: translation %.5f, rotation %.5f rad, scale %.5f\n",
+				GetName().c_str(), m_Animations[i].m_Name.c_str(), clip.m_KeysBefore, clip.m_KeysAfter, clip.m_BytesBefore / 1024.f, clip.m_BytesAfter / 1024.f,
+				clip.m_MaxTranslationError, clip.m_MaxRotationError, clip.m_MaxScaleError);
+		}
+	}
+
+	void SkinnedGLTFAsset::ResampleAnimation(Animation& animation)
+	{
+		std::vector<bool> resampled(animation.m_Samplers.size());
+
+		for (const auto& channel : animation.m_Channels)
+		{
+			if (resampled[channel.m_Sampler])
+				continue;
+
+			resampled[channel.m_Sampler] = true;
+
+			auto& sampler = animation.m_Samplers[channel.m_Sampler];
+			const auto& inputs = sampler.m_Inputs;
+			const auto& outputs = sampler.m_Outputs;
+
+			// Cubic spline outputs hold the tangents as well, those clips keep their keys.
+			if (inputs.size() < 2 || outputs.size() != inputs.size() || sampler.m_Interpolation == "CUBICSPLINE")
+				continue;
+
+			const float start = inputs.front(), end = inputs.back();
+			if (end <= start)
+				continue;
+
+			const uint32_t count = std::max(static_cast<uint32_t>(std::ceil((end - start) * s_AnimationSampleRate)) + 1, 2u);
+			const float step = (end - start) / (count - 1);
+
+			std::vector<float> uniformInputs(count);
+			std::vector<glm::vec4> uniformOutputs(count);
+
+			uint32_t key = 0;
+			for (uint32_t k = 0; k < count; k++)
+			{
+				const float time = k == count - 1 ? end : start + step * k;
+
+				while (key < inputs.size() - 2 && time > inputs[key + 1])
+					key++;
+
+				const float a = glm::clamp((time - inputs[key]) / (inputs[key + 1] - inputs[key]), 0.f, 1.f);
+
+				uniformInputs[k] = time;
+
+				if (sampler.m_Interpolation == "STEP")
+				{
+					uniformOutputs[k] = a >= 1.f ? outputs[key + 1] : outputs[key];
+				}
+				else if (channel.m_Type == ChannelType::Rotation)
+				{
+					glm::quat q1(outputs[key].w, outputs[key].x, outputs[key].y, outputs[key].z);
+					glm::quat q2(outputs[key + 1].w, outputs[key + 1].x, outputs[key + 1].y, outputs[key + 1].z);
+
+					glm::quat q = glm::normalize(glm::slerp(q1, q2, a));
+					uniformOutputs[k] = glm::vec4(q.x, q.y, q.z, q.w);
+				}
+				else
+				{
+					uniformOutputs[k] = glm::mix(outputs[key], outputs[key + 1], a);
+				}
+			}
+
+			sampler.m_Inputs = std::move(uniformInputs);
+			sampler.m_Outputs = std::move(uniformOutputs);
+			sampler.m_InvStep = 1.f / step;
+		}
+	}
+
+	SkinnedGLTFAsset::AnimationCompressionStats SkinnedGLTFAsset::CompressAnimation(Animation& animation)
+	{
+		AnimationCompressionStats stats{};
+		std::vector<bool> compressed(animation.m_Samplers.size());
+
+		for (const auto& channel : animation.m_Channels)
+		{
+			if (compressed[channel.m_Sampler])
+				continue;
+
+			compressed[channel.m_Sampler] = true;
+
+			auto& sampler = animation.m_Samplers[channel.m_Sampler];
+			const ChannelType type = channel.m_Type;
+
+			const size_t sourceBytes = sampler.m_Inputs.size() * sizeof(float) + sampler.m_Outputs.size() * sizeof(glm::vec4);
+
+			stats.m_KeysBefore += sampler.m_Inputs.size();
+			stats.m_BytesBefore += sourceBytes;
+
+			// Cubic spline outputs hold the tangents as well, those clips stay as they are.
+			if (sampler.m_Inputs.size() < 2 || sampler.m_Outputs.size() != sampler.m_Inputs.size() || sampler.m_Interpolation == "CUBICSPLINE" || type == ChannelType::None)
+			{
+				stats.m_KeysAfter += sampler.m_Inputs.size();
+				stats.m_BytesAfter += sourceBytes;
+				continue;
+			}
+
+			const std::vector<float> inputs = std::move(sampler.m_Inputs);
+			const std::vector<glm::vec4> outputs = std::move(sampler.m_Outputs);
+
+			std::vector<uint32_t> kept{ 0 };
+
+			if (sampler.m_InvStep > 0.f)
+			{
+				// Resampled keys have to stay evenly spaced.
+				for (uint32_t k = 1; k < inputs.size(); k++)
+					kept.push_back(k);
+			}
+			else
+			{
+				// Extend the segment from the last kept key while interpolating over it reproduces every key it spans.
+				for (uint32_t next = 2; next < inputs.size(); next++)
+				{
+					const uint32_t anchor = kept.back();
+					const float span = inputs[next] - inputs[anchor];
+
+					for (uint32_t k = anchor + 1; k < next; k++)
+					{
+						const float t = span > 0.f ? (inputs[k] - inputs[anchor]) / span : 0.f;
+
+						if (KeyError(InterpolateKeys(outputs[anchor], outputs[next], t, type), outputs[k], type) > s_AnimationTolerance)
+						{
+							kept.push_back(next - 1);
+							break;
+						}
+					}
+				}
+
+				kept.push_back(static_cast<uint32_t>(inputs.size()) - 1);
+			}
+
+			glm::vec4 rangeMin(FLT_MAX), rangeMax(-FLT_MAX);
+			for (const uint32_t k : kept)
+			{
+				rangeMin = glm::min(rangeMin, outputs[k]);
+				rangeMax = glm::max(rangeMax, outputs[k]);
+			}
+
+			sampler.m_PackedType = type;
+			sampler.m_RangeMin = glm::vec4(glm::vec3(rangeMin), 0.f);
+			sampler.m_RangeScale = glm::vec4(glm::vec3(rangeMax - rangeMin) / 65535.f, 0.f);
+
+			sampler.m_Inputs.clear();
+			sampler.m_Outputs.clear();
+			sampler.m_Outputs.shrink_to_fit();
+			sampler.m_PackedOutputs.resize(kept.size() * 3);
+
+			for (size_t k = 0; k < kept.size(); k++)
+			{
+				const glm::vec4& value = outputs[kept[k]];
+				uint16_t* words = &sampler.m_PackedOutputs[k * 3];
+
+				sampler.m_Inputs.push_back(inputs[kept[k]]);
+
+				if (type == ChannelType::Rotation)
+				{
+					PackQuat(glm::normalize(value), words);
+					continue;
+				}
+
+				for (int c = 0; c < 3; c++)
+					words[c] = sampler.m_RangeScale[c] > 0.f ? static_cast<uint16_t>((value[c] - sampler.m_RangeMin[c]) / sampler.m_RangeScale[c] + 0.5f) : 0;
+			}
+
+			stats.m_KeysAfter += kept.size();
+			stats.m_BytesAfter += sampler.m_Inputs.size() * sizeof(float) + sampler.m_PackedOutputs.size() * sizeof(uint16_t) + 2 * sizeof(glm::vec4);
+
+			// Error of the decompressed clip at every source key.
+			float& maxError = type == ChannelType::Rotation ? stats.m_MaxRotationError : type == ChannelType::Scale ? stats.m_MaxScaleError : stats.m_MaxTranslationError;
+
+			uint32_t cursor = 0;
+			for (size_t k = 0; k < inputs.size(); k++)
+			{
+				cursor = sampler.FindKey(inputs[k], cursor);
+
+				const float t = glm::clamp((inputs[k] - sampler.m_Inputs[cursor]) / (sampler.m_Inputs[cursor + 1] - sampler.m_Inputs[cursor]), 0.f, 1.f);
+				const glm::vec4 source = type == ChannelType::Rotation ? glm::normalize(outputs[k]) : outputs[k];
+
+				maxError = std::max(maxError, KeyError(InterpolateKeys(sampler.GetOutput(cursor), sampler.GetOutput(cursor + 1), t, type), source, type));
+			}
+		}
+
+		return stats;
+	}
+
+	void SkinnedGLTFAsset::CreateGeometryBuffers(std::shared_ptr<Renderer::Device> device, std::shared_ptr<Renderer::CommandPool> commandPool)
+	{
+		auto* arena = Renderer::GeometryArena::Get();
+
+		// Packed joints are 8-bit, larger skins keep full vertices.
+		if (m_VertexFormat == VertexFormat::VF_PACKED)
+		{
+			int maxJoint = 0;
+			for (const auto& vertex : m_Vertices)
+				maxJoint = std::max({ maxJoint, vertex.Joints.x, vertex.Joints.y, vertex.Joints.z, vertex.Joints.w });
+
+			if (maxJoint > std::numeric_limits<uint8_t>::max())
+			{
+				printf("%s: joint index %d does not fit the packed vertex format, using full vertices.\n", GetName().c_str(), maxJoint);
+				m_VertexFormat = VertexFormat::VF_FULL;
+			}
+		}
+
+		if (m_VertexFormat == VertexFormat::VF_PACKED)
+		{
+			ComputeQuantization(m_Vertices);
+
+			std::vector<PackedVertexAttribute> packedVertices(m_Vertices.size());
+
+			for (auto* node : m_AllNodes)
+			{
+				if (!node->m_Mesh)
+					continue;
+
+				for (const auto& primitive : node->m_Mesh->m_Primitives)
+				{
+					for (auto v = primitive.m_VertexOffset; v < primitive.m_VertexOffset + primitive.m_VertexCount; v++)
+					{
+						const VertexType& src = m_Vertices[v];
+						PackedVertexAttribute& dst = packedVertices[v];
+
+						VertexPacking::QuantizePosition(src.Position, primitive.m_QuantOffset, primitive.m_QuantScale, dst.Position);
+						dst.Position[3] = src.Tangent.w < 0.f ? 0 : std::numeric_limits<uint16_t>::max();
+
+						VertexPacking::PackOctahedral(src.Normal, dst.Normal);
+						VertexPacking::PackOctahedral(glm::vec3(src.Tangent), dst.Tangent);
+						VertexPacking::PackHalf2(src.UV, dst.UV);
+						VertexPacking::PackWeights(src.Weights, dst.Weights);
+
+						for (auto j = 0; j < 4; j++)
+							dst.Joints[j] = static_cast<uint8_t>(src.Joints[j]);
+					}
+				}
+			}
+
+			m_VertexStride = sizeof(PackedVertexAttribute);
+			m_VertexRange = arena->AllocateVertices(packedVertices.data(), packedVertices.size() * sizeof(PackedVertexAttribute), m_VertexStride);
+		}
+		else
+		{
+			m_VertexStride = sizeof(VertexType);
+			m_VertexRange = arena->AllocateVertices(m_Vertices.data(), m_Vertices.size() * sizeof(VertexType), m_VertexStride);
+		}
+
+		if (!m_Vertices.empty() && !m_VertexRange.IsValid())
+			throw std::runtime_error("Geometry arena out of vertex memory for " + GetName());
+
+		CreateIndexBuffers(m_Indices);
+		ReportGeometryMemory(sizeof(VertexType));
+	}
+
+	void SkinnedGLTFAsset::BuildIndirectBatches(std::shared_ptr<Renderer::Device> device, std::shared_ptr<Renderer::CommandPool> commandPool, const Renderer::DescriptorLayout& primitiveLayout)
+	{
+		m_IndirectCommands.clear();
+		m_PerPrimitiveData.clear();
+		m_DrawOrigins.clear();
+
+		const uint32_t instanceCount = static_cast<uint32_t>(m_Instances.size());
+
+		glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+
+		// Build the indirect commands grouped by draw bucket, 16-bit indexed primitives first inside each so every index type is one contiguous multi-draw.
+		// Every primitive is one draw over all instances, the instance ID picks the world matrix and the joint palette.
+		uint32_t m = 0;
+		for (uint32_t bucket = 0; bucket < DRAW_BUCKET_COUNT; bucket++)
+		{
+			auto& range = m_DrawRanges[bucket];
+			range = { static_cast<uint32_t>(m_IndirectCommands.size()), 0u, 0u };
+
+			for (const bool shortIndices : { true, false })
+			{
+				for (auto i = 0; i < m_AllNodes.size(); i++)
+				{
+					auto* node = m_AllNodes[i];
+
+					if (node->m_Mesh)
+					{
+						for (const auto& primitive : node->m_Mesh->m_Primitives)
+						{
+							if (primitive.m_ShortIndices != shortIndices || GetDrawBucket(primitive.m_MaterialIndex) != bucket)
+								continue;
+
+							VkDrawIndexedIndirectCommand cmd{};
+
+							const auto& bounds = primitive.m_Bounds;
+							const auto origin = (bounds.m_Maxs + bounds.m_Mins) * 0.5f;
+							const auto extents = (bounds.m_Maxs - bounds.m_Mins) * 0.5f;
+							const auto radius = glm::length(extents);
+
+							// TODO: Replace with model matrix.
+							glm::mat4 inv = glm::mat4(1.f);
+							inv[2][2] *= -1.f;
+
+							boundsMin = glm::min(boundsMin, bounds.m_Mins);
+							boundsMax = glm::max(boundsMax, bounds.m_Maxs);
+
+							const uint32_t skinOffset = node->m_SkinIndex > -1 ? m_Skins[node->m_SkinIndex].m_PaletteOffset : 0;
+
+							// SV_VertexID includes the base vertex, the VS adds it to z to find the deformed vertex.
+							const int32_t firstVertex = GetBaseVertex() + static_cast<int32_t>(primitive.m_VertexOffset);
+							const MorphPrimitive* morph = primitive.m_MorphIndex > -1 ? &m_MorphPrimitives[primitive.m_MorphIndex] : nullptr;
+
+							for (uint32_t n = 0; n < instanceCount; n++)
+							{
+								const auto* instance = m_Instances[n];
+
+								IndirectPrimitiveData data{};
+
+								data.NodeMatrix = instance->m_WorldMatrix;
+								data.MaterialIndex.x = primitive.m_MaterialIndex;
+								data.MaterialIndex.y = node->m_Index;
+								data.MaterialIndex.z = morph ? static_cast<int32_t>(n * m_MorphOutputsPerInstance + morph->m_OutputOffset) - firstVertex : 0;
+								data.MaterialIndex.w = instance->m_PaletteOffset + skinOffset;
+								data.NodePos = glm::vec4(origin, 1.f) * inv * data.NodeMatrix;
+								data.NodePos.w = radius;
+								data.PosOffset = glm::vec4(primitive.m_QuantOffset, morph ? 1.f : 0.f);
+								data.PosScale = glm::vec4(primitive.m_QuantScale, m_VertexFormat == VertexFormat::VF_PACKED ? 1.f : 0.f);
+
+								m_PerPrimitiveData.push_back(data);
+							}
+
+							cmd.indexCount = primitive.m_IndexCount;
+							cmd.instanceCount = instanceCount;
+							cmd.firstInstance = m;
+							GetDrawOffsets(primitive, cmd.firstIndex, cmd.vertexOffset);
+
+							m += instanceCount;
+
+							range.m_Count++;
+							if (shortIndices)
+								range.m_ShortCount++;
+
+							m_IndirectCommands.push_back(cmd);
+							m_DrawOrigins.push_back(origin);
+						}
+					}
+				}
+			}
+		}
+
+		if (!m_IndirectCommands.empty())
+		{
+			m_BoundsCenter = (boundsMin + boundsMax) * 0.5f;
+			m_BoundsRadius = glm::length(boundsMax - boundsMin) * 0.5f;
+		}
+
+		// Setup and transfer the data to the GPU.
+		const auto& graphicsQueue = device->GetGraphicsQueue();
 
 		std::unique_ptr<Renderer::CommandBuffer> commandBuffer = std::make_unique<Renderer::CommandBuffer>(device, commandPool);
 
@@ -426,7 +1343,9 @@ namespace Engine::Assets
 			VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT
 		);
 
-		m_PrimitiveStorageBuffer->Patch(m_PerPrimitiveData.data(), m_PerPrimitiveData.size() * sizeof(IndirectPrimitiveData));
+		// Stays mapped, UpdateInstance writes the world matrices.
+		m_MappedPrimitives = static_cast<IndirectPrimitiveData*>(m_PrimitiveStorageBuffer->Map());
+		memcpy(m_MappedPrimitives, m_PerPrimitiveData.data(), storageBufferSize);
 
 		commandBuffer->Begin();
 		commandBuffer->CopyBuffer(*cmdStagingBuffer, *m_IndirectCommandsBuffer, static_cast<VkDeviceSize>(cmdBufferSize));
@@ -478,6 +1397,7 @@ namespace Engine::Assets
 					continue;
 
 				m_Skins[i].m_Joints.push_back(node);
+				m_Skins[i].m_JointSlots.push_back(node->m_Slot);
 			}
 
 			if (gltfSkin.inverseBindMatrices > -1)
@@ -489,41 +1409,82 @@ namespace Engine::Assets
 				m_Skins[i].m_InverseBindMatrices.resize(inverseBindMatricesAccessor.count);
 
 				memcpy(m_Skins[i].m_InverseBindMatrices.data(), &buffer.data[inverseBindMatricesAccessor.byteOffset + inverseBindMatricesBufferView.byteOffset], inverseBindMatricesAccessor.count * sizeof(glm::mat4));
-
-				m_Skins[i].m_Buffer = new Renderer::Buffer(m_Device, sizeof(glm::mat4) * m_Skins[i].m_InverseBindMatrices.size(),
-					VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-					VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT);
 			}
+
+			// Identity when the skin has no inverse bind matrices.
+			if (m_Skins[i].m_InverseBindMatrices.size() < m_Skins[i].m_JointSlots.size())
+				m_Skins[i].m_InverseBindMatrices.resize(m_Skins[i].m_JointSlots.size(), glm::mat4(1.f));
+
+			// The joint indices of the vertices address the skin's slice of the instance palette.
+			m_Skins[i].m_PaletteOffset = m_JointsPerInstance;
+			m_JointsPerInstance += static_cast<uint32_t>(m_Skins[i].m_InverseBindMatrices.size());
 		}
 	}
 
 	void SkinnedGLTFAsset::Render(Renderer::CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline, const std::vector<Renderer::Descriptor*>& sceneDescriptors, int bufferIndex)
 	{
-		for (auto& primData : m_PerPrimitiveData)
-			primData.NodeMatrix = m_WorldMatrix;
-
-		m_PrimitiveStorageBuffer->Patch(m_PerPrimitiveData.data(), m_PerPrimitiveData.size() * sizeof(IndirectPrimitiveData));
+		// Every bucket but the blended ones with the same pipeline.
+		for (uint32_t bucket = 0; bucket < DB_BLEND; bucket++)
+			RenderBucket(commandBuffer, pipeline, sceneDescriptors, bufferIndex, static_cast<DrawBucket>(bucket));
+	}
 
-		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, *pipeline);
+	void SkinnedGLTFAsset::BindDrawDescriptors(Renderer::CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline, const std::vector<Renderer::Descriptor*>& sceneDescriptors)
+	{
+		commandBuffer.BindPipeline(*pipeline);
 
 		std::vector<Renderer::Descriptor*> descriptors = sceneDescriptors;
 
 		// TODO: Add Per Node UBO.
-		std::vector<Renderer::Descriptor*> assetDescriptors = { m_MaterialBufferDescriptor, m_TextureBufferDescriptor, m_PrimitiveBufferDescriptor, m_JointDescriptor };
+		std::vector<Renderer::Descriptor*> assetDescriptors = { m_MaterialBufferDescriptor, m_TextureBufferDescriptor, m_PrimitiveBufferDescriptor, m_JointDescriptor, m_MorphOutputDescriptor };
 
 		descriptors.insert(descriptors.end(), assetDescriptors.cbegin(), assetDescriptors.cend());
 
 		commandBuffer.BindDescriptors(descriptors);
 		commandBuffer.SetDescriptorOffsets(descriptors, *pipeline);
+	}
 
-		const VkDeviceSize offsets[1] = { 0 };
-		const VkBuffer vertexBuffer = *m_VertexBuffer;
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, offsets);
-		vkCmdBindIndexBuffer(commandBuffer, *m_IndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+	void SkinnedGLTFAsset::RenderBucket(Renderer::CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline, const std::vector<Renderer::Descriptor*>& sceneDescriptors, int bufferIndex, DrawBucket bucket)
+	{
+		const auto& range = m_DrawRanges[bucket];
+		if (range.m_Count == 0)
+			return;
 
-		// TODO: Check if device supports MultiDrawIndirect.
-		vkCmdDrawIndexedIndirect(commandBuffer, *m_IndirectCommandsBuffer, 0, static_cast<uint32_t>(m_IndirectCommands.size()), sizeof(VkDrawIndexedIndirectCommand));
+		BindDrawDescriptors(commandBuffer, pipeline, sceneDescriptors);
+
+		// Skinned draws are not culled, every view reads the same commands.
+		DrawRangeIndirect(commandBuffer, *m_IndirectCommandsBuffer, range);
+	}
+
+	void SkinnedGLTFAsset::GetBlendedDraws(const glm::vec3& viewPosition, std::vector<BlendedDraw>& draws) const
+	{
+		if (m_Instances.empty())
+			return;
+
+		// Same space as the rendered geometry.
+		glm::mat4 flip = glm::mat4(1.f);
+		flip[2][2] *= -1.f;
+
+		for (const auto bucket : { DB_BLEND, DB_BLEND_DOUBLE_SIDED })
+		{
+			const auto& range = m_DrawRanges[bucket];
+
+			for (auto draw = range.m_First; draw < range.m_First + range.m_Count; draw++)
+			{
+				// Instances move, the center is taken from their current world matrices.
+				glm::vec3 center(0.f);
+				for (const auto* instance : m_Instances)
+					center += glm::vec3(flip * instance->m_WorldMatrix * glm::vec4(m_DrawOrigins[draw], 1.f));
+
+				const glm::vec3 offset = center / static_cast<float>(m_Instances.size()) - viewPosition;
+				draws.push_back({ const_cast<SkinnedGLTFAsset*>(this), draw, bucket, glm::dot(offset, offset) });
+			}
+		}
+	}
+
+	void SkinnedGLTFAsset::RenderBlendedDraw(Renderer::CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline, const std::vector<Renderer::Descriptor*>& sceneDescriptors, const BlendedDraw& draw)
+	{
+		BindDrawDescriptors(commandBuffer, pipeline, sceneDescriptors);
+		DrawRangeIndirect(commandBuffer, *m_IndirectCommandsBuffer, GetSingleDrawRange(draw.m_Draw, draw.m_Bucket));
 	}
 
 	void SkinnedGLTFAsset::SetupDevice(const std::vector<Renderer::DescriptorLayout>& descriptorLayouts)
@@ -531,15 +1492,45 @@ namespace Engine::Assets
 		LoadSkins();
 		LoadAnimations();
 
+		for (auto* instance : m_Instances)
+		{
+			instance->m_AnimationStates.resize(m_Animations.size());
+
+			for (size_t i = 0; i < m_Animations.size(); i++)
+				instance->m_AnimationStates[i].m_Cursors.resize(m_Animations[i].m_Channels.size());
+
+			// The deformed outputs start out zero, which matches all zero weights.
+			instance->m_MorphWeights = m_DefaultMorphWeights;
+			instance->m_EvaluatedMorphWeights.assign(m_DefaultMorphWeights.size(), 0.f);
+		}
+
 		CreateGeometryBuffers(m_Device, m_CommandPool);
 		LoadMaterials(m_Device, m_CommandPool, descriptorLayouts[0]);
 		LoadTextures(m_Device, m_CommandPool, descriptorLayouts[1]);
 		LoadBoneData(m_Device);
+		LoadMorphData(m_Device, m_CommandPool);
 		BuildIndirectBatches(m_Device, m_CommandPool, descriptorLayouts[2]);
 	}
 
 	void SkinnedGLTFAsset::LoadBoneData(std::shared_ptr<Renderer::Device> device)
 	{
+		for (uint32_t i = 0; i < m_Instances.size(); i++)
+			m_Instances[i]->m_PaletteOffset = i * m_JointsPerInstance;
+
+		// One shared buffer for every palette, written in place by UpdateJoints.
+		const auto jointCount = std::max<size_t>(m_Instances.size() * m_JointsPerInstance, 1);
+
+		m_JointBuffer = new Renderer::Buffer(device, sizeof(glm::mat4) * jointCount,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT);
+
+		m_JointPalettes = static_cast<glm::mat4*>(m_JointBuffer->Map());
+
+		// Bind pose until the first animation update.
+		for (auto* instance : m_Instances)
+			UpdateJoints(*instance, true);
+
 		m_JointDescriptor = new Renderer::Descriptor(
 			device,
 			{
@@ -550,63 +1541,266 @@ namespace Engine::Assets
 
 		m_JointDescriptor->Bind(
 			{
-				Renderer::Descriptor::BindingInfo{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, {.m_Buffer = m_Skins[0].m_Buffer } }
+				Renderer::Descriptor::BindingInfo{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, {.m_Buffer = m_JointBuffer } }
 			}
 		);
 	}
 
-	bool SkinnedGLTFAsset::Animation::Update( float dt )
+	void SkinnedGLTFAsset::LoadMorphData(std::shared_ptr<Renderer::Device> device, std::shared_ptr<Renderer::CommandPool> commandPool)
+	{
+		const auto createDescriptor = [&](Renderer::Buffer* buffer)
+		{
+			auto* descriptor = new Renderer::Descriptor(
+				device,
+				{
+					{ 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_ALL, nullptr }
+				},
+				VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+			);
+
+			descriptor->Bind(
+				{
+					Renderer::Descriptor::BindingInfo{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, {.m_Buffer = buffer } }
+				}
+			);
+
+			return descriptor;
+		};
+
+		const uint32_t instanceCount = static_cast<uint32_t>(m_Instances.size());
+
+		// Bound by every skinned draw, one zero entry when the asset has no morph targets.
+		const auto outputSize = sizeof(glm::vec4) * 2 * std::max<size_t>(static_cast<size_t>(instanceCount) * m_MorphOutputsPerInstance, 1);
+
+		m_MorphOutputBuffer = new Renderer::Buffer(device, outputSize,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT);
+
+		m_MorphOutputDescriptor = createDescriptor(m_MorphOutputBuffer);
+
+		std::unique_ptr<Renderer::CommandBuffer> commandBuffer = std::make_unique<Renderer::CommandBuffer>(device, commandPool);
+		std::unique_ptr<Renderer::StagingBuffer> vertexStagingBuffer{}, deltaStagingBuffer{};
+
+		commandBuffer->Begin();
+
+		// Vertices no target moves are never written again.
+		vkCmdFillBuffer(*commandBuffer, *m_MorphOutputBuffer, 0, VK_WHOLE_SIZE, 0);
+
+		if (!m_MorphPrimitives.empty())
+		{
+			const auto vertexSize = m_MorphVertices.size() * sizeof(glm::uvec4);
+			const auto deltaSize = m_MorphDeltas.size() * sizeof(MorphDelta);
+
+			vertexStagingBuffer = std::make_unique<Renderer::StagingBuffer>(device, vertexSize);
+			vertexStagingBuffer->Patch(m_MorphVertices.data(), vertexSize);
+
+			deltaStagingBuffer = std::make_unique<Renderer::StagingBuffer>(device, deltaSize);
+			deltaStagingBuffer->Patch(m_MorphDeltas.data(), deltaSize);
+
+			m_MorphVertexBuffer = new Renderer::Buffer(device, vertexSize,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT);
+
+			m_MorphDeltaBuffer = new Renderer::Buffer(device, deltaSize,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT);
+
+			// Written on the CPU every frame an instance's weights change, mapped for the lifetime of the asset.
+			m_MorphWeightBuffer = new Renderer::Buffer(device, sizeof(float) * instanceCount * m_DefaultMorphWeights.size(),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT);
+
+			// At most one job per instance and morphed primitive.
+			m_MorphJobBuffer = new Renderer::Buffer(device, sizeof(glm::uvec4) * instanceCount * m_MorphPrimitives.size(),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT);
+
+			m_MappedMorphWeights = static_cast<float*>(m_MorphWeightBuffer->Map());
+			m_MappedMorphJobs = static_cast<glm::uvec4*>(m_MorphJobBuffer->Map());
+
+			commandBuffer->CopyBuffer(*vertexStagingBuffer, *m_MorphVertexBuffer, static_cast<VkDeviceSize>(vertexSize));
+			commandBuffer->CopyBuffer(*deltaStagingBuffer, *m_MorphDeltaBuffer, static_cast<VkDeviceSize>(deltaSize));
+
+			m_MorphDescriptors = {
+				createDescriptor(m_MorphVertexBuffer),
+				createDescriptor(m_MorphDeltaBuffer),
+				createDescriptor(m_MorphWeightBuffer),
+				createDescriptor(m_MorphJobBuffer)
+			};
+
+			printf("[%s] morph targets: %zu primitives, %zu of %u vertices moved, %zu deltas (%.1f KB)\n",
+				GetName().c_str(), m_MorphPrimitives.size(), m_MorphVertices.size(), m_MorphOutputsPerInstance, m_MorphDeltas.size(), (vertexSize + deltaSize) / 1024.f);
+		}
+
+		commandBuffer->End();
+		commandBuffer->SubmitToQueue(device->GetGraphicsQueue());
+	}
+
+	void SkinnedGLTFAsset::DispatchMorphTargets(Renderer::CommandBuffer& commandBuffer, Renderer::ComputePipeline* pipeline)
 	{
-		if ( !m_IsPaused )
-			m_CurTime += dt;
+		if (m_MorphPrimitives.empty())
+			return;
+
+		const uint32_t weightCount = static_cast<uint32_t>(m_DefaultMorphWeights.size());
 
-		while ( m_CurTime > m_End )
+		// A primitive is evaluated again only when one of its node's weights changed, untouched instances keep their deltas.
+		uint32_t jobCount = 0;
+
+		for (uint32_t i = 0; i < m_Instances.size(); i++)
 		{
-			m_CurTime -= ( m_End - m_Start );
+			Instance& instance = *m_Instances[i];
+
+			if (instance.m_MorphWeights == instance.m_EvaluatedMorphWeights)
+				continue;
+
+			for (const auto& morph : m_MorphPrimitives)
+			{
+				const auto weights = instance.m_MorphWeights.cbegin() + morph.m_WeightOffset;
+
+				if (morph.m_VertexCount == 0 || std::equal(weights, weights + morph.m_TargetCount, instance.m_EvaluatedMorphWeights.cbegin() + morph.m_WeightOffset))
+					continue;
+
+				m_MappedMorphJobs[jobCount++] = glm::uvec4(morph.m_FirstVertex, morph.m_VertexCount, i * m_MorphOutputsPerInstance, i * weightCount + morph.m_WeightOffset);
+			}
+
+			// The GPU finished the previous frame before recording, the weights are not being read.
+			memcpy(m_MappedMorphWeights + i * weightCount, instance.m_MorphWeights.data(), weightCount * sizeof(float));
+			instance.m_EvaluatedMorphWeights = instance.m_MorphWeights;
 		}
 
+		if (jobCount == 0)
+			return;
+
+		std::vector<Renderer::Descriptor*> descriptors = m_MorphDescriptors;
+		descriptors.push_back(m_MorphOutputDescriptor);
+
+		commandBuffer.BindPipeline(*pipeline);
+
+		commandBuffer.BindDescriptors(descriptors);
+		commandBuffer.SetDescriptorOffsets(descriptors, *pipeline);
+
+		// One row of groups per job, wide enough for the largest primitive.
+		// Recorded on the compute queue, the vertex stages of the graphics submit wait on its semaphore (VulkanRenderer::EndFrame).
+		vkCmdDispatch(commandBuffer, (m_MaxMorphVertexCount + 63) / 64, jobCount, 1);
+	}
+
+	uint32_t SkinnedGLTFAsset::AnimationSampler::FindKey( float time, uint32_t cursor ) const
+	{
+		const uint32_t last = static_cast< uint32_t >( m_Inputs.size( ) ) - 2;
+
+		// Resampled, the keys are evenly spaced.
+		if ( m_InvStep > 0.f )
+			return std::min( static_cast< uint32_t >( ( time - m_Inputs.front( ) ) * m_InvStep ), last );
+
+		cursor = std::min( cursor, last );
+
+		// Regular playback only moves a key or two per update.
+		for ( auto i = 0; i < 2 && cursor < last && time > m_Inputs[ cursor + 1 ]; i++ )
+			cursor++;
+
+		if ( time >= m_Inputs[ cursor ] && time <= m_Inputs[ cursor + 1 ] )
+			return cursor;
+
+		// Seeks and loops, last key at or before time.
+		const auto it = std::upper_bound( m_Inputs.cbegin( ), m_Inputs.cend( ), time );
+		return static_cast< uint32_t >( std::clamp< ptrdiff_t >( ( it - m_Inputs.cbegin( ) ) - 1, 0, last ) );
+	}
+
+	glm::vec4 SkinnedGLTFAsset::AnimationSampler::GetOutput( uint32_t key ) const
+	{
+		if ( m_PackedOutputs.empty( ) )
+			return m_Outputs[ key ];
+
+		const uint16_t* words = &m_PackedOutputs[ key * 3 ];
+
+		if ( m_PackedType == ChannelType::Rotation )
+			return UnpackQuat( words );
+
+		return m_RangeMin + glm::vec4( words[ 0 ], words[ 1 ], words[ 2 ], 0.f ) * m_RangeScale;
+	}
+
+	bool SkinnedGLTFAsset::Animation::Update( float dt, AnimationState& state, NodeHierarchy& hierarchy, bool skipLeaves, float* morphWeights ) const
+	{
+		if ( !state.m_IsPaused )
+			state.m_CurTime += dt;
+
+		while ( state.m_CurTime > m_End )
+		{
+			state.m_CurTime -= ( m_End - m_Start );
+		}
+
+		const float time = state.m_CurTime;
+
 		bool updated = false;
-		for ( auto& channel : m_Channels )
+		for ( size_t c = 0; c < m_Channels.size( ); c++ )
 		{
+			const auto& channel = m_Channels[ c ];
+
+			if ( skipLeaves && channel.m_IsLeaf )
+				continue;
+
 			const auto& sampler = m_Samplers[ channel.m_Sampler ];
 			const auto& inputs = sampler.m_Inputs;
-			const auto& outputs = sampler.m_Outputs;
 
-			for ( auto i = 0; i < inputs.size( ) - 1; i++ )
+			if ( channel.m_Slot == NodeHierarchy::INVALID_SLOT || inputs.size( ) < 2 || time < inputs.front( ) || time > inputs.back( ) )
+				continue;
+
+			const uint32_t i = sampler.FindKey( time, state.m_Cursors[ c ] );
+			state.m_Cursors[ c ] = i;
+
+			float a = glm::clamp( ( time - inputs[ i ] ) / ( inputs[ i + 1 ] - inputs[ i ] ), 0.f, 1.f );
+
+			if ( channel.m_Type == ChannelType::Weights )
 			{
-				if ( ( m_CurTime >= inputs[ i ] ) && ( m_CurTime <= inputs[ i + 1 ] ) )
-				{
-					float a = ( m_CurTime - inputs[ i ] ) / ( inputs[ i + 1 ] - inputs[ i ] );
+				if ( !morphWeights || channel.m_WeightCount == 0 )
+					continue;
 
-					if ( channel.m_Type == ChannelType::Translation )
-					{
-						glm::vec3 t1 = outputs[ i ];
-						glm::vec3 t2 = outputs[ i + 1 ];
+				// Cubic splines store (in tangent, value, out tangent) per key, only the values are interpolated.
+				const uint32_t stride = sampler.m_Interpolation == "CUBICSPLINE" ? 3 : 1;
+				const float* w1 = &sampler.m_WeightOutputs[ ( i * stride + stride / 2 ) * channel.m_WeightCount ];
+				const float* w2 = &sampler.m_WeightOutputs[ ( ( i + 1 ) * stride + stride / 2 ) * channel.m_WeightCount ];
 
-						channel.m_Node->m_Translation = glm::mix(channel.m_Node->m_Translation, glm::mix(t1, t2, a), a * 0.5f);
-					}
+				const float t = sampler.m_Interpolation == "STEP" ? 0.f : a;
 
-					if (channel.m_Type == ChannelType::Rotation)
-					{
-						glm::quat q1(outputs[i].w, outputs[i].x, outputs[i].y, outputs[i].z);
-						glm::quat q2(outputs[i + 1].w, outputs[i + 1].x, outputs[i + 1].y, outputs[i + 1].z);
+				for ( uint32_t k = 0; k < channel.m_WeightCount; k++ )
+					morphWeights[ channel.m_WeightOffset + k ] = w1[ k ] + ( w2[ k ] - w1[ k ] ) * t;
 
-						channel.m_Node->m_Rotation = glm::slerp(channel.m_Node->m_Rotation, glm::slerp(q1, q2, a), a * 0.5f);
-						channel.m_Node->m_Rotation = glm::normalize(channel.m_Node->m_Rotation);
-					}
+				continue;
+			}
 
-					if (channel.m_Type == ChannelType::Scale)
-					{
-						auto lerped = glm::vec3(glm::mix(outputs[i], outputs[i + 1], a));
-						channel.m_Node->m_Scale = glm::mix(channel.m_Node->m_Scale, lerped, a * 0.5f);
-					}
+			const glm::vec4 o1 = sampler.GetOutput( i );
+			const glm::vec4 o2 = sampler.GetOutput( i + 1 );
 
-					updated = true;
-					break;
-				}
+			if ( channel.m_Type == ChannelType::Translation )
+			{
+				glm::vec3 t1 = o1;
+				glm::vec3 t2 = o2;
+
+				hierarchy.SetTranslation( channel.m_Slot, glm::mix( hierarchy.GetTranslation( channel.m_Slot ), glm::mix( t1, t2, a ), a * 0.5f ) );
 			}
+
+			if (channel.m_Type == ChannelType::Rotation)
+			{
+				glm::quat q1(o1.w, o1.x, o1.y, o1.z);
+				glm::quat q2(o2.w, o2.x, o2.y, o2.z);
+
+				hierarchy.SetRotation( channel.m_Slot, glm::normalize( glm::slerp( hierarchy.GetRotation( channel.m_Slot ), glm::slerp( q1, q2, a ), a * 0.5f ) ) );
+			}
+
+			if (channel.m_Type == ChannelType::Scale)
+			{
+				auto lerped = glm::vec3(glm::mix(o1, o2, a));
+				hierarchy.SetScale( channel.m_Slot, glm::mix( hierarchy.GetScale( channel.m_Slot ), lerped, a * 0.5f ) );
+			}
+
+			updated = true;
 		}
 
 		return updated;
 	}
-}
\ No newline at end of file
+}
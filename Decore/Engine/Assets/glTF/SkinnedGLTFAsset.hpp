@@ -6,7 +6,8 @@ namespace Engine::Assets {
 		None,
 		Translation,
 		Rotation,
-		Scale
+		Scale,
+		Weights
 	};
 
 	inline ChannelType GetChannelType(const std::string& string)
@@ -14,9 +15,12 @@ namespace Engine::Assets {
 		if (string == "translation") return ChannelType::Translation;
 		if (string == "rotation") return ChannelType::Rotation;
 		if (string == "scale") return ChannelType::Scale;
+		if (string == "weights") return ChannelType::Weights;
 		return ChannelType::None;
 	}
 
+	class CrowdGLTFAsset;
+
 	class SkinnedGLTFAsset : public BaseGLTFAsset {
 	public:
 		SkinnedGLTFAsset(
@@ -25,6 +29,7 @@ namespace Engine::Assets {
 			std::shared_ptr<Renderer::CommandPool> commandPool,
 			int sceneIndex = -1
 		);
+		~SkinnedGLTFAsset();
 
 		struct VertexAttribute {
 			glm::vec3 Position{};
@@ -52,18 +57,90 @@ namespace Engine::Assets {
 			}
 		};
 
+		struct PackedVertexAttribute {
+			uint16_t Position[4]{};	// xyz: unorm16 inside the primitive bounds, w: tangent handedness (0 = -1, 1 = +1).
+			int16_t Normal[2]{};	// Octahedral snorm16.
+			uint16_t UV[2]{};		// Half floats.
+			int16_t Tangent[2]{};	// Octahedral snorm16.
+			uint8_t Joints[4]{};
+			uint8_t Weights[4]{};	// unorm8, sums to one.
+
+			static VkVertexInputBindingDescription GetBindingDescription( )
+			{
+				return { 0, sizeof( PackedVertexAttribute ), VK_VERTEX_INPUT_RATE_VERTEX };
+			}
+
+			static std::vector<VkVertexInputAttributeDescription> GetInputAttributeDescriptions( )
+			{
+				return {
+					{ 0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof( PackedVertexAttribute, Position ) },
+					{ 1, 0, VK_FORMAT_R16G16_SNORM, offsetof( PackedVertexAttribute, Normal ) },
+					{ 2, 0, VK_FORMAT_R16G16_SFLOAT, offsetof( PackedVertexAttribute, UV ) },
+					{ 3, 0, VK_FORMAT_R16G16_SNORM, offsetof( PackedVertexAttribute, Tangent ) },
+					{ 4, 0, VK_FORMAT_R8G8B8A8_UINT, offsetof( PackedVertexAttribute, Joints ) },
+					{ 5, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof( PackedVertexAttribute, Weights ) },
+				};
+			}
+		};
+
 		using VertexType = SkinnedGLTFAsset::VertexAttribute;
 
+		// Input layout matching BaseGLTFAsset::s_VertexFormat. Assets whose joints don't fit the packed format keep full vertices,
+		// the passes build a VF_FULL variant of their skinned pipelines for those.
+		static VkVertexInputBindingDescription GetBindingDescription( VertexFormat format = s_VertexFormat )
+		{
+			return format == VertexFormat::VF_PACKED ? PackedVertexAttribute::GetBindingDescription( ) : VertexAttribute::GetBindingDescription( );
+		}
+
+		static std::vector<VkVertexInputAttributeDescription> GetInputAttributeDescriptions( VertexFormat format = s_VertexFormat )
+		{
+			return format == VertexFormat::VF_PACKED ? PackedVertexAttribute::GetInputAttributeDescriptions( ) : VertexAttribute::GetInputAttributeDescriptions( );
+		}
+
 		struct AnimationSampler {
 			std::string m_Interpolation{};
 			std::vector<float> m_Inputs{};
 			std::vector<glm::vec4> m_Outputs{};
+
+			// Keys per second when resampled to a uniform rate, 0 otherwise.
+			float m_InvStep{};
+
+			// Filled by CompressAnimation, m_Outputs is released then. 3 words per key:
+			// translation/scale as unorm16 between m_RangeMin and m_RangeMin + m_RangeScale * 65535, rotations as smallest three.
+			std::vector<uint16_t> m_PackedOutputs{};
+			glm::vec4 m_RangeMin{};
+			glm::vec4 m_RangeScale{};
+			ChannelType m_PackedType{};
+
+			// Morph target weights, m_WeightCount per key (times three for cubic splines). Never compressed.
+			std::vector<float> m_WeightOutputs{};
+
+			bool IsCompressed( ) const { return !m_PackedOutputs.empty( ); }
+
+			// Key i with m_Inputs[i] <= time <= m_Inputs[i + 1], time must lie inside the inputs.
+			uint32_t FindKey( float time, uint32_t cursor ) const;
+
+			// Output of a key, rotations as (x, y, z, w).
+			glm::vec4 GetOutput( uint32_t key ) const;
 		};
 
 		struct AnimationChannel {
 			ChannelType m_Type{};
 			Node* m_Node{};
+			int32_t m_Slot{ NodeHierarchy::INVALID_SLOT }; // Target inside the node hierarchy.
 			uint32_t m_Sampler{}; // Sampler Index.
+			bool m_IsLeaf{}; // Targets a node without children, skipped by far animation LODs.
+
+			// Weights channels, range of the node inside Instance::m_MorphWeights. Empty when the node has no morph targets.
+			uint32_t m_WeightOffset{}, m_WeightCount{};
+		};
+
+		// Playback of one clip by one instance, the clip itself is shared.
+		struct AnimationState {
+			float m_CurTime{};
+			bool m_IsPaused{};
+
+			std::vector<uint32_t> m_Cursors{}; // Key found by the last update, per channel.
 		};
 
 		struct Animation {
@@ -71,25 +148,82 @@ namespace Engine::Assets {
 			std::vector<AnimationSampler> m_Samplers{};
 			std::vector<AnimationChannel> m_Channels{};
 			float m_Start{ FLT_MAX }, m_End{ FLT_MIN };
-			float m_CurTime{};
 
-			bool m_IsPaused{};
 			// TODO: Animation event system.
 
-			bool Update( float dt );
+			// Writes the sampled TRS into the hierarchy, world matrices are refreshed by UpdateJoints.
+			// Weights channels write into morphWeights when given, they do not count as an update of the joints.
+			bool Update( float dt, AnimationState& state, NodeHierarchy& hierarchy, bool skipLeaves = false, float* morphWeights = nullptr ) const;
 		};
 
 		struct Skin {
 			Node* m_SkeletonRootJoint{};
 			std::vector<Node*> m_Joints{};
+			std::vector<int32_t> m_JointSlots{};
 			std::vector<glm::mat4> m_InverseBindMatrices{};
 
-			Renderer::Buffer* m_Buffer;
+			// First joint matrix of the skin inside an instance palette.
+			uint32_t m_PaletteOffset{};
+		};
+
+		// How an instance is advanced this frame, picked by the scene's animation LOD policy.
+		enum class AnimationUpdate : unsigned char {
+			Sample,			// Sample the clip, update the hierarchy and write the palette.
+			Interpolate,	// Blend between the last two sampled palettes (throttled instances only).
+			Skip			// Only the clip time moves on, the palette is left as is.
+		};
+
+		// One placed copy of the asset. Geometry, materials, skins and clips are shared, every instance animates its own hierarchy.
+		struct Instance {
+			glm::mat4 m_WorldMatrix{ 1.f };
+			int m_ActiveAnimIndex{};
+
+			std::vector<AnimationState> m_AnimationStates{}; // One per clip, filled by SetupDevice.
+			NodeHierarchy m_Hierarchy{};
+
+			// First joint matrix of the instance in m_JointBuffer.
+			uint32_t m_PaletteOffset{};
+
+			// Animation LOD, set before UpdateInstance.
+			AnimationUpdate m_Update{ AnimationUpdate::Sample };
+			uint32_t m_Lod{};
+			uint32_t m_SampleInterval{ 1 };	// Frames between samples, the palette blends toward the last sample in between.
+			bool m_SkipLeafJoints{};
+
+			uint32_t m_FramesSinceSample{};
+			float m_PendingTime{}; // Clip time not sampled yet.
+
+			struct LocalPose {
+				glm::vec3 m_Translation{};
+				glm::quat m_Rotation{};
+				glm::vec3 m_Scale{};
+			};
+
+			// Local TRS of every node at the last two samples of a throttled instance, the written palette trails them by one interval.
+			std::vector<LocalPose> m_PrevPose{};
+			std::vector<LocalPose> m_NextPose{};
+			bool m_HistoryValid{};
+
+			// Holds the blended pose in between samples, m_Hierarchy keeps the sampled one that the next sample eases from.
+			NodeHierarchy m_BlendHierarchy{};
+
+			// Blend shape weights of every morphed node, sampled from weights channels or set by hand.
+			// A primitive is re-evaluated on the GPU only when its weights differ from the last evaluated ones.
+			std::vector<float> m_MorphWeights{};
+			std::vector<float> m_EvaluatedMorphWeights{};
 		};
 
 		std::vector<Skin> m_Skins{};
 		std::vector<Animation> m_Animations{};
-		int m_ActiveAnimIndex{};
+
+		// Resamples every linear and step clip to s_AnimationSampleRate at load time, keys are then found without searching.
+		static inline bool s_ResampleAnimations = false;
+		static inline float s_AnimationSampleRate = 30.f;
+
+		// Quantizes every linear and step clip at load time. Keys that interpolation reproduces within
+		// s_AnimationTolerance (units for translation/scale, radians for rotation) are dropped first, unless the clip was resampled.
+		static inline bool s_CompressAnimations = false;
+		static inline float s_AnimationTolerance = 0.0005f;
 
 		__forceinline int GetAnimationIndexByName(const std::string& name) {
 			if (m_Animations.empty())
@@ -109,12 +243,46 @@ namespace Engine::Assets {
 		}
 
 		virtual void Render(Renderer::CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline, const std::vector<Renderer::Descriptor*>& sceneDescriptors, int bufferIndex) override;
+		virtual void RenderBucket(Renderer::CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline, const std::vector<Renderer::Descriptor*>& sceneDescriptors, int bufferIndex, DrawBucket bucket) override;
+
+		// A blended draw covers every instance, it is sorted by their average center.
+		virtual void GetBlendedDraws(const glm::vec3& viewPosition, std::vector<BlendedDraw>& draws) const override;
+		virtual void RenderBlendedDraw(Renderer::CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline, const std::vector<Renderer::Descriptor*>& sceneDescriptors, const BlendedDraw& draw) override;
 		virtual void SetupDevice(const std::vector<Renderer::DescriptorLayout>& descriptorLayouts) override;
 		
-		void UpdateAnimation(int animIndex, float dt);
+		// The asset starts with one instance. Instances are fixed once SetupDevice sized the GPU buffers for them.
+		Instance* CreateInstance(const glm::mat4& worldMatrix = glm::mat4(1.f));
+
+		Instance* GetInstance(size_t index) { return m_Instances[index]; }
+		size_t GetInstanceCount() const { return m_Instances.size(); }
 
-		glm::mat4 m_WorldMatrix{ 1.f };
+		// CPU only (sampling, hierarchy, palette), different instances can be updated from different threads at once.
+		void UpdateInstance(uint32_t index, float dt);
+
+		// World space bounding sphere of the bind pose, radius in w.
+		glm::vec4 GetBoundingSphere(const Instance& instance) const;
+
+		// Evaluates the morph targets of every instance whose weights changed since the last call, on the given compute command buffer.
+		// Sets: morphed vertices, deltas, weights, jobs, deformed outputs (see Shaders/Compute/MorphTargetsCS.hlsl).
+		void DispatchMorphTargets(Renderer::CommandBuffer& commandBuffer, Renderer::ComputePipeline* pipeline);
+
+		// Times the update of the first instance on a copy of its playback state, for frame by frame playback and for random seeks.
+		void BenchmarkAnimation(int animIndex, uint32_t iterations);
+
+		// One clip sampled at a fixed rate into model space skinned positions and normals, played back without a skeleton (see CrowdGLTFAsset).
+		struct VertexAnimation {
+			uint32_t m_FrameCount{};
+			uint32_t m_VertexCount{};
+			float m_FrameRate{}; // Adjusted so the clip loops on a whole frame.
+
+			// m_VertexCount per frame, in m_Vertices order. xyz: position (float bits), w: octahedral snorm16x2 normal.
+			std::vector<glm::uvec4> m_Frames{};
+		};
+
+		// Samples the clip on a copy of the bind pose, morph targets included. Valid after SetupDevice.
+		VertexAnimation BakeVertexAnimation(int animIndex, float frameRate) const;
 	protected:
+		friend class CrowdGLTFAsset;
 
 		// Vertex & Index Buffers
 		std::vector<VertexType> m_Vertices{};
@@ -123,55 +291,99 @@ namespace Engine::Assets {
 		virtual bool LoadAsset(const std::string& gltfPath, int sceneIndex = -1) override;
 		virtual void LoadNode(const tinygltf::Node& inputNode, BaseGLTFAsset::Node* parent, uint32_t nodeIndex) override;
 
-		virtual void CreateGeometryBuffers(std::shared_ptr<Renderer::Device> device, std::shared_ptr<Renderer::CommandPool> commandPool) override
-		{
-			const auto vertexSize = m_Vertices.size() * sizeof(VertexType);
-			const auto indexSize = m_Indices.size() * sizeof(uint32_t);
-
-			std::unique_ptr<Renderer::StagingBuffer> vertexStagingBuffer = std::make_unique<Renderer::StagingBuffer>(device, vertexSize);
-			vertexStagingBuffer->Patch(m_Vertices.data(), vertexSize);
+		// Packs the non-zero deltas of the primitive's targets, returns the index into m_MorphPrimitives.
+		int32_t LoadMorphTargets(const tinygltf::Primitive& primitive, int nodeIndex, uint32_t weightOffset, uint32_t vertexCount);
 
-			std::unique_ptr<Renderer::StagingBuffer> indexStagingBuffer = std::make_unique<Renderer::StagingBuffer>(device, indexSize);
-			indexStagingBuffer->Patch(m_Indices.data(), indexSize);
-
-			m_VertexBuffer = new Renderer::Buffer(device, vertexSize,
-				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_SHARING_MODE_EXCLUSIVE);
-			m_IndexBuffer = new Renderer::Buffer(device, indexSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_SHARING_MODE_EXCLUSIVE);
-
-			std::unique_ptr<Renderer::CommandBuffer> commandBuffer = std::make_unique<Renderer::CommandBuffer>(device, commandPool);
-
-			const auto& graphicsQueue = device->GetGraphicsQueue();
-
-			commandBuffer->Begin();
-			commandBuffer->CopyBuffer(*vertexStagingBuffer, *m_VertexBuffer, static_cast<VkDeviceSize>(vertexSize));
-			commandBuffer->CopyBuffer(*indexStagingBuffer, *m_IndexBuffer, static_cast<VkDeviceSize>(indexSize));
-			commandBuffer->End();
-			commandBuffer->SubmitToQueue(graphicsQueue);
-		}
+		virtual void CreateGeometryBuffers(std::shared_ptr<Renderer::Device> device, std::shared_ptr<Renderer::CommandPool> commandPool) override;
 	private:
+		std::vector<Instance*> m_Instances{};
+
+		// Palettes of every instance back to back, mapped for the lifetime of the asset.
 		Renderer::Descriptor* m_JointDescriptor = nullptr;
 		Renderer::Buffer* m_JointBuffer = nullptr;
+		glm::mat4* m_JointPalettes = nullptr;
+		uint32_t m_JointsPerInstance{};
 
 		struct IndirectPrimitiveData {
-			glm::ivec4 MaterialIndex;
+			glm::ivec4 MaterialIndex; // x: material, y: node, z: morph output of vertex 0 (minus the base vertex), w: first joint matrix.
 			glm::mat4 NodeMatrix;
 			glm::vec4 NodePos; // Node bounding sphere.
+			glm::vec4 PosOffset; // Position dequantization, w: 1 when the primitive has morph targets.
+			glm::vec4 PosScale; // w: 1 when normals/tangents are octahedral encoded.
 		};
 
+		// One draw per primitive, instanced over every instance of the asset.
 		std::vector<VkDrawIndexedIndirectCommand> m_IndirectCommands{};
+		// Per instance, the instances of a draw are contiguous from its firstInstance.
 		std::vector<IndirectPrimitiveData> m_PerPrimitiveData{};
 
+		// Per draw, model space center of its primitive.
+		std::vector<glm::vec3> m_DrawOrigins{};
+
 		Renderer::Buffer* m_IndirectCommandsBuffer = nullptr;
 		Renderer::Buffer* m_PrimitiveStorageBuffer = nullptr;
 		Renderer::Descriptor* m_PrimitiveBufferDescriptor = nullptr;
+		IndirectPrimitiveData* m_MappedPrimitives = nullptr; // World matrices are written per instance update.
+
+		// Blend shapes, sparse per primitive. Only vertices moved by at least one target are stored and evaluated.
+		struct MorphPrimitive {
+			int m_NodeIndex{};
+			uint32_t m_TargetCount{};
+			uint32_t m_WeightOffset{};					// First weight of the node inside Instance::m_MorphWeights.
+			uint32_t m_FirstVertex{}, m_VertexCount{};	// Range of m_MorphVertices.
+			uint32_t m_OutputOffset{};					// First vertex of the primitive inside an instance block of m_MorphOutputBuffer.
+		};
+
+		struct MorphDelta {
+			glm::vec4 Position; // w: target index.
+			glm::vec4 Normal;
+		};
+
+		std::vector<MorphPrimitive> m_MorphPrimitives{};
+		std::vector<glm::uvec4> m_MorphVertices{}; // x: output inside the instance block, y: first delta, z: delta count.
+		std::vector<MorphDelta> m_MorphDeltas{};
+		std::vector<float> m_DefaultMorphWeights{}; // Node or mesh weights, copied into every instance.
+
+		uint32_t m_MorphOutputsPerInstance{};
+		uint32_t m_MaxMorphVertexCount{};
+
+		Renderer::Buffer* m_MorphVertexBuffer = nullptr;
+		Renderer::Buffer* m_MorphDeltaBuffer = nullptr;
+		Renderer::Buffer* m_MorphWeightBuffer = nullptr;
+		Renderer::Buffer* m_MorphJobBuffer = nullptr;
+		Renderer::Buffer* m_MorphOutputBuffer = nullptr; // Position and normal delta per vertex of every morphed primitive, per instance.
+		float* m_MappedMorphWeights = nullptr;
+		glm::uvec4* m_MappedMorphJobs = nullptr;
+
+		std::vector<Renderer::Descriptor*> m_MorphDescriptors{}; // Inputs of the compute pass, the output descriptor comes last.
+		Renderer::Descriptor* m_MorphOutputDescriptor = nullptr; // Read by the skinned VS as well.
+
+		void LoadMorphData(std::shared_ptr<Renderer::Device> device, std::shared_ptr<Renderer::CommandPool> commandPool);
 
 		void BuildIndirectBatches(std::shared_ptr<Renderer::Device> device, std::shared_ptr<Renderer::CommandPool> commandPool, const Renderer::DescriptorLayout& primitiveLayout);
+		void BindDrawDescriptors(Renderer::CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline, const std::vector<Renderer::Descriptor*>& sceneDescriptors);
 
 		void LoadSkins();
 		void LoadAnimations();
+		void ResampleAnimation(Animation& animation);
+
+		struct AnimationCompressionStats {
+			size_t m_KeysBefore{}, m_KeysAfter{};
+			size_t m_BytesBefore{}, m_BytesAfter{};
+			float m_MaxTranslationError{}, m_MaxRotationError{}, m_MaxScaleError{}; // Measured at the source keys.
+		};
+
+		AnimationCompressionStats CompressAnimation(Animation& animation);
 		
 		void LoadBoneData(std::shared_ptr<Renderer::Device> device);
 
-		void UpdateJoints(Node* node);
+		// Palettes are rewritten when a world matrix changed, or always with force.
+		void UpdateJoints(Instance& instance, bool force = false);
+		void ComputePalette(const NodeHierarchy& hierarchy, glm::mat4* palette) const;
+		void BlendPalette(Instance& instance);
+
+		// Bind pose bounds of every primitive, model space.
+		glm::vec3 m_BoundsCenter{};
+		float m_BoundsRadius{};
 	};
 }
\ No newline at end of file
@@ -4,6 +4,9 @@
 #include "StaticGLTFAsset.hpp"
 #include "BaseGLTFAsset.hpp"
 
+#include <chrono>
+#include <random>
+
 namespace Engine::Assets {
 	StaticGLTFAsset::StaticGLTFAsset(
 		const std::string& gltfPath,
@@ -16,10 +19,20 @@ namespace Engine::Assets {
 
 		m_Device = device;
 		m_CommandPool = commandPool;
+		m_VertexFormat = s_VertexFormat;
 	}
 
-	StaticGLTFAsset::~StaticGLTFAsset() {
+	StaticGLTFAsset::StaticGLTFAsset(
+		std::shared_ptr<Renderer::Device> device,
+		std::shared_ptr<Renderer::CommandPool> commandPool )
+	{
+		m_Device = device;
+		m_CommandPool = commandPool;
+		m_VertexFormat = s_VertexFormat;
+	}
 
+	StaticGLTFAsset::~StaticGLTFAsset() {
+		ReleaseGeometryBuffers();
 	}
 
 	bool StaticGLTFAsset::LoadAsset(const std::string& gltfPath, int sceneIndex) {
@@ -33,8 +46,12 @@ namespace Engine::Assets {
 			return false;
 		}
 
+		// Nodes referencing the same mesh share its geometry, it is only counted and loaded once.
+		std::vector<bool> countedMeshes(m_LoadedModel.meshes.size());
+		m_Meshes.assign(m_LoadedModel.meshes.size(), nullptr);
+
 		for (size_t i = 0; i < scene.nodes.size(); i++) {
-			GetNodeInfo(m_LoadedModel.nodes[scene.nodes[i]], m_LoadedModel, m_VertexCount, m_IndexCount);
+			GetNodeInfo(m_LoadedModel.nodes[scene.nodes[i]], m_LoadedModel, m_VertexCount, m_IndexCount, &countedMeshes);
 		}
 
 		m_Vertices.resize(m_VertexCount);
@@ -44,6 +61,15 @@ namespace Engine::Assets {
 			LoadNode(m_LoadedModel.nodes[scene.nodes[i]], nullptr, scene.nodes[i]);
 		}
 
+		// Deduplication may have shrunk the vertex data.
+		m_VertexCount = m_LastVertex;
+		m_Vertices.resize(m_VertexCount);
+
+		BuildHierarchy();
+		BuildCollision();
+
+		ReportMeshOptimization();
+
 		return true;
 	}
 
@@ -58,8 +84,14 @@ namespace Engine::Assets {
 			LoadNode(m_LoadedModel.nodes[inputNode.children[i]], node, inputNode.children[i]);
 		}
 
-		if (inputNode.mesh > -1) {
+		ParseMeshInstancing(inputNode, node);
+
+		if (inputNode.mesh > -1 && m_Meshes[inputNode.mesh]) {
+			node->m_Mesh = m_Meshes[inputNode.mesh];
+		}
+		else if (inputNode.mesh > -1) {
 			node->m_Mesh = new Mesh();
+			m_Meshes[inputNode.mesh] = node->m_Mesh;
 
 			const auto& srcMesh = m_LoadedModel.meshes[inputNode.mesh];
 
@@ -164,14 +196,26 @@ namespace Engine::Assets {
 					}
 				}
 
+				if (s_OptimizeMeshes) {
+					vertexCount = OptimizePrimitive(m_Vertices, m_Indices, vertexStart, vertexCount, indexStart, indexCount);
+					m_LastVertex = vertexStart + vertexCount;
+				}
+
 				Primitive& newPrimitive = node->m_Mesh->m_Primitives[i];
 				newPrimitive.m_MaterialIndex = primitive.material > -1 ? primitive.material : 0; // Default to first material...
 				newPrimitive.m_IndexOffset = indexStart;
 				newPrimitive.m_IndexCount = indexCount;
 				newPrimitive.m_VertexCount = vertexCount;
+				newPrimitive.m_VertexOffset = vertexStart;
 
 				newPrimitive.m_Bounds.m_Mins = glm::min( posMin, newPrimitive.m_Bounds.m_Mins );
 				newPrimitive.m_Bounds.m_Maxs = glm::max( posMax, newPrimitive.m_Bounds.m_Maxs );
+
+				if (s_GenerateLods)
+					GenerateLods(m_Vertices, m_Indices, newPrimitive);
+
+				if (s_BuildMeshlets)
+					BuildMeshlets(m_Vertices, m_Indices, newPrimitive);
 				 
 				//printf( "mins: %f %f %f\n", newPrimitive.m_Bounds.m_Mins.x, newPrimitive.m_Bounds.m_Mins.y, newPrimitive.m_Bounds.m_Mins.z );
 				//printf( "maxs: %f %f %f\n", newPrimitive.m_Bounds.m_Maxs.x, newPrimitive.m_Bounds.m_Maxs.y, newPrimitive.m_Bounds.m_Maxs.z );
@@ -186,46 +230,216 @@ namespace Engine::Assets {
 		}
 	}
 
-	void StaticGLTFAsset::BuildIndirectBatches(std::shared_ptr<Renderer::Device> device, std::shared_ptr<Renderer::CommandPool> commandPool, const Renderer::DescriptorLayout& primitiveLayout) {
+	void StaticGLTFAsset::CreateGeometryBuffers(std::shared_ptr<Renderer::Device> device, std::shared_ptr<Renderer::CommandPool> commandPool)
+	{
+		auto* arena = Renderer::GeometryArena::Get();
+
+		if (m_VertexFormat == VertexFormat::VF_PACKED) {
+			ComputeQuantization(m_Vertices);
+
+			std::vector<PackedVertexAttribute> packedVertices(m_Vertices.size());
+
+			for (auto* mesh : GetUniqueMeshes()) {
+				for (const auto& primitive : mesh->m_Primitives) {
+					for (auto v = primitive.m_VertexOffset; v < primitive.m_VertexOffset + primitive.m_VertexCount; v++) {
+						const VertexAttribute& src = m_Vertices[v];
+						PackedVertexAttribute& dst = packedVertices[v];
+
+						VertexPacking::QuantizePosition(src.Position, primitive.m_QuantOffset, primitive.m_QuantScale, dst.Position);
+						dst.Position[3] = src.Tangent.w < 0.f ? 0 : std::numeric_limits<uint16_t>::max();
+
+						VertexPacking::PackOctahedral(src.Normal, dst.Normal);
+						VertexPacking::PackOctahedral(glm::vec3(src.Tangent), dst.Tangent);
+						VertexPacking::PackHalf2(src.UV, dst.UV);
+					}
+				}
+			}
+
+			m_VertexStride = sizeof(PackedVertexAttribute);
+			m_VertexRange = arena->AllocateVertices(packedVertices.data(), packedVertices.size() * sizeof(PackedVertexAttribute), m_VertexStride);
+		}
+		else {
+			m_VertexStride = sizeof(VertexAttribute);
+			m_VertexRange = arena->AllocateVertices(m_Vertices.data(), m_Vertices.size() * sizeof(VertexAttribute), m_VertexStride);
+		}
+
+		if (!m_Vertices.empty() && !m_VertexRange.IsValid())
+			throw std::runtime_error("Geometry arena out of vertex memory for " + GetName());
+
+		CreateIndexBuffers(m_Indices);
+		ReportGeometryMemory(sizeof(VertexAttribute));
+	}
+
+	void StaticGLTFAsset::BuildIndirectBatches() {
 		m_IndirectCommands.clear();
+		m_PerPrimitiveData.clear();
+		m_PerPrimitiveLods.clear();
+		m_PerMeshletData.clear();
+		m_MeshletGeometry.clear();
+		m_DrawCenters.clear();
+		m_ShortIndexedMeshletCount = 0;
+
+		// Gather the instances of every mesh, in node order. Nodes using EXT_mesh_gpu_instancing add one instance per transform.
+		struct MeshInstance {
+			uint32_t m_NodeIndex{};
+			glm::mat4 m_Matrix{};
+		};
+
+		const std::vector<Mesh*> meshes = GetUniqueMeshes();
+		std::unordered_map<Mesh*, std::vector<MeshInstance>> meshInstances{};
 
-		// Build the indirect commands.
-		uint32_t m = 0;
 		for (auto i = 0; i < m_AllNodes.size(); i++) {
 			auto* node = m_AllNodes[i];
+			if (!node->m_Mesh)
+				continue;
 
-			if (node->m_Mesh) {
-				for (const auto& primitive : node->m_Mesh->m_Primitives) {
-					VkDrawIndexedIndirectCommand cmd{};
-					IndirectPrimitiveData data{};
-
-					const auto& bounds = primitive.m_Bounds;
-					const auto origin = (bounds.m_Maxs + bounds.m_Mins) * 0.5f;
-					const auto extents = (bounds.m_Maxs - bounds.m_Mins) * 0.5f;
-					const auto radius = glm::length(extents);
-
-					// TODO: Replace with model matrix.
-					glm::mat4 inv = glm::mat4(1.f);
-					inv[2][2] *= -1.f;
-
-					data.NodeMatrix = node->GetMatrix();
-					data.MaterialIndex.x = primitive.m_MaterialIndex;
-					data.MaterialIndex.y = i;
-					data.NodePos = glm::vec4(origin, 1.f) * inv * data.NodeMatrix;
-					data.NodePos.w = radius;
-
-					cmd.indexCount = primitive.m_IndexCount;
-					cmd.instanceCount = 1;
-					cmd.firstIndex = static_cast<uint32_t>(primitive.m_IndexOffset);
-					cmd.vertexOffset = 0;
-					cmd.firstInstance = m++;
-
-					m_IndirectCommands.push_back(cmd);
-					m_PerPrimitiveData.push_back(data);
+			auto& instances = meshInstances[node->m_Mesh];
+
+			if (node->m_Instances.empty())
+				instances.push_back({ static_cast<uint32_t>(i), GetWorldMatrix(node) });
+
+			for (const auto& instance : node->m_Instances)
+				instances.push_back({ static_cast<uint32_t>(i), GetWorldMatrix(node) * instance });
+		}
+
+		// Same space as the rendered geometry, sorts the blended draws against the view position.
+		glm::mat4 flip = glm::mat4(1.f);
+		flip[2][2] *= -1.f;
+
+		// Build the indirect commands grouped by draw bucket, 16-bit indexed primitives first inside each so every index type is one contiguous multi-draw.
+		// Every mesh primitive is a single draw over all of its instances, the culling pass compacts the visible ones.
+		// Only opaque single sided primitives get meshlets, the other buckets always take the regular draw path.
+		uint32_t m = 0;
+		for (uint32_t bucket = 0; bucket < DRAW_BUCKET_COUNT; bucket++) {
+			auto& range = m_DrawRanges[bucket];
+			range = { static_cast<uint32_t>(m_IndirectCommands.size()), 0u, 0u };
+
+			for (const bool shortIndices : { true, false }) {
+				for (auto* mesh : meshes) {
+					const auto& instances = meshInstances[mesh];
+
+					for (const auto& primitive : mesh->m_Primitives) {
+						if (primitive.m_ShortIndices != shortIndices || GetDrawBucket(primitive.m_MaterialIndex) != bucket)
+							continue;
+
+						const uint32_t drawIndex = static_cast<uint32_t>(m_IndirectCommands.size());
+
+						VkDrawIndexedIndirectCommand cmd{};
+
+						const auto& bounds = primitive.m_Bounds;
+						const auto origin = (bounds.m_Maxs + bounds.m_Mins) * 0.5f;
+						const auto extents = (bounds.m_Maxs - bounds.m_Mins) * 0.5f;
+						const auto radius = glm::length(extents);
+
+						// TODO: Replace with model matrix.
+						glm::mat4 inv = glm::mat4(1.f);
+						inv[2][2] *= -1.f;
+
+						glm::vec3 center(0.f);
+
+						for (const auto& instance : instances) {
+							IndirectPrimitiveData data{};
+
+							data.NodeMatrix = instance.m_Matrix;
+							data.MaterialIndex.x = primitive.m_MaterialIndex;
+							data.MaterialIndex.y = instance.m_NodeIndex;
+							data.MaterialIndex.z = drawIndex;
+							data.NodePos = glm::vec4(origin, 1.f) * inv * data.NodeMatrix;
+							data.NodePos.w = radius;
+							data.PosOffset = glm::vec4(primitive.m_QuantOffset, 0.f);
+							data.PosScale = glm::vec4(primitive.m_QuantScale, m_VertexFormat == VertexFormat::VF_PACKED ? 1.f : 0.f);
+
+							m_PerPrimitiveData.push_back(data);
+							center += glm::vec3(flip * instance.m_Matrix * glm::vec4(origin, 1.f));
+						}
+
+						cmd.indexCount = primitive.m_IndexCount;
+						cmd.instanceCount = static_cast<uint32_t>(instances.size());
+						cmd.firstInstance = m;
+						GetDrawOffsets(primitive, cmd.firstIndex, cmd.vertexOffset);
+
+						m += cmd.instanceCount;
+
+						// The culling pass picks one of these per frame and rewrites the command.
+						IndirectLodData lods{};
+						lods.Lods[0] = glm::uvec4(cmd.firstIndex, cmd.indexCount, 0u, 0u);
+
+						for (auto l = 0; l < primitive.m_Lods.size(); l++) {
+							const auto& lod = primitive.m_Lods[l];
+							lods.Lods[l + 1] = glm::uvec4(GetLodFirstIndex(primitive, lod), lod.m_IndexCount, glm::floatBitsToUint(lod.m_Error), 0u);
+						}
+
+						lods.LodCount = glm::uvec4(1 + static_cast<uint32_t>(primitive.m_Lods.size()), cmd.firstInstance, cmd.instanceCount, 0u);
+
+						if (bucket == DB_OPAQUE) {
+							// Meshlets are consecutive triangle ranges of LOD0 (built in index order).
+							// Their geometry is written once, the culling entries are repeated for every instance.
+							const uint32_t flags = shortIndices ? 0u : MESHLET_LONG_INDICES;
+
+							std::vector<IndirectMeshletData> primitiveMeshlets{};
+
+							if (primitive.m_MeshletCount == 0) {
+								IndirectMeshletData meshletData{};
+								meshletData.Sphere = glm::vec4(origin, radius);
+								meshletData.Draw = glm::uvec4(drawIndex, 0u, cmd.indexCount, flags | MESHLET_FIRST_IN_DRAW | MESHLET_WHOLE_DRAW);
+								primitiveMeshlets.push_back(meshletData);
+							}
+
+							uint32_t meshletIndexOffset = 0;
+							for (auto k = primitive.m_MeshletOffset; k < primitive.m_MeshletOffset + primitive.m_MeshletCount; k++) {
+								const auto& meshlet = m_Meshlets[k];
+								const auto& meshletBounds = m_MeshletBounds[k];
+
+								IndirectMeshletData meshletData{};
+								meshletData.Sphere = glm::vec4(glm::make_vec3(meshletBounds.m_Center), meshletBounds.m_Radius);
+								meshletData.Cone = glm::vec4(glm::make_vec3(meshletBounds.m_ConeAxis), meshletBounds.m_ConeCutoff);
+								meshletData.Draw = glm::uvec4(drawIndex, meshletIndexOffset, meshlet.m_TriangleCount * 3, flags | (k == primitive.m_MeshletOffset ? MESHLET_FIRST_IN_DRAW : 0u));
+								meshletData.Geometry = glm::uvec4(static_cast<uint32_t>(m_MeshletGeometry.size()), 0u, meshlet.m_VertexCount | (meshlet.m_TriangleCount << 16), 0u);
+
+								// The mesh shader path fetches vertices by their absolute arena index.
+								for (auto v = 0u; v < meshlet.m_VertexCount; v++)
+									m_MeshletGeometry.push_back(static_cast<uint32_t>(GetBaseVertex()) + primitive.m_VertexOffset + m_MeshletVertices[meshlet.m_VertexOffset + v]);
+
+								meshletData.Geometry.y = static_cast<uint32_t>(m_MeshletGeometry.size());
+
+								const auto triangleIndices = meshlet.m_TriangleCount * 3;
+								for (auto t = 0u; t < triangleIndices; t += 4) {
+									uint32_t packed = 0;
+									for (auto b = 0u; b < 4 && t + b < triangleIndices; b++)
+										packed |= static_cast<uint32_t>(m_MeshletTriangles[meshlet.m_TriangleOffset + t + b]) << (b * 8);
+
+									m_MeshletGeometry.push_back(packed);
+								}
+
+								meshletIndexOffset += triangleIndices;
+								primitiveMeshlets.push_back(meshletData);
+							}
+
+							for (auto n = 0u; n < cmd.instanceCount; n++) {
+								for (auto meshletData : primitiveMeshlets) {
+									meshletData.Geometry.w = cmd.firstInstance + n;
+									m_PerMeshletData.push_back(meshletData);
+								}
+							}
+
+							if (shortIndices)
+								m_ShortIndexedMeshletCount = static_cast<uint32_t>(m_PerMeshletData.size());
+						}
+
+						range.m_Count++;
+						if (shortIndices)
+							range.m_ShortCount++;
+
+						m_IndirectCommands.push_back(cmd);
+						m_PerPrimitiveLods.push_back(lods);
+						m_DrawCenters.push_back(center / static_cast<float>(glm::max(cmd.instanceCount, 1u)));
+					}
 				}
 			}
 		}
+	}
 
+	void StaticGLTFAsset::UploadIndirectBatches(std::shared_ptr<Renderer::Device> device, std::shared_ptr<Renderer::CommandPool> commandPool, const Renderer::DescriptorLayout& primitiveLayout) {
 		// Setup and transfer the data to the GPU.
 		const auto& graphicsQueue = device->GetGraphicsQueue();
 
@@ -242,6 +456,12 @@ namespace Engine::Assets {
 
 		storageStagingBuffer->Patch(m_PerPrimitiveData.data(), m_PerPrimitiveData.size() * sizeof(IndirectPrimitiveData));
 
+		const auto lodBufferSize = m_PerPrimitiveLods.size() * sizeof(IndirectLodData);
+
+		std::unique_ptr<Renderer::StagingBuffer> lodStagingBuffer = std::make_unique<Renderer::StagingBuffer>(device, lodBufferSize);
+
+		lodStagingBuffer->Patch(m_PerPrimitiveLods.data(), lodBufferSize);
+
 		for (auto i = 0; i < m_IndirectCommandsBuffers.size(); i++) {
 			m_IndirectCommandsBuffers[i] = new Renderer::Buffer(device, cmdBufferSize,
 				VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
@@ -258,11 +478,33 @@ namespace Engine::Assets {
 			VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT
 		);
 
+		for (auto i = 0; i < m_VisibleInstanceBuffers.size(); i++) {
+			m_VisibleInstanceBuffers[i] = new Renderer::Buffer(device, storageBufferSize,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				VK_SHARING_MODE_EXCLUSIVE,
+				VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT
+			);
+		}
+
+		m_LodStorageBuffer = new Renderer::Buffer(device, lodBufferSize,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			VK_SHARING_MODE_EXCLUSIVE,
+			VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT
+		);
+
 		commandBuffer->Begin();
 		for (auto i = 0; i < m_IndirectCommandsBuffers.size(); i++)
 			commandBuffer->CopyBuffer(*cmdStagingBuffer, *m_IndirectCommandsBuffers[i], static_cast<VkDeviceSize>(cmdBufferSize));
 
 		commandBuffer->CopyBuffer(*storageStagingBuffer, *m_PrimitiveStorageBuffer, static_cast<VkDeviceSize>(storageBufferSize));
+
+		// Every instance is visible until the first culling pass.
+		for (auto i = 0; i < m_VisibleInstanceBuffers.size(); i++)
+			commandBuffer->CopyBuffer(*storageStagingBuffer, *m_VisibleInstanceBuffers[i], static_cast<VkDeviceSize>(storageBufferSize));
+
+		commandBuffer->CopyBuffer(*lodStagingBuffer, *m_LodStorageBuffer, static_cast<VkDeviceSize>(lodBufferSize));
 		commandBuffer->End();
 		commandBuffer->SubmitToQueue(graphicsQueue);
 
@@ -277,6 +519,19 @@ namespace Engine::Assets {
 			}
 		);
 
+		for (auto i = 0; i < m_VisibleInstanceBuffers.size(); i++) {
+			m_VisibleInstanceDescriptors[i] = new Renderer::Descriptor(device,
+				primitiveLayout,
+				VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+			);
+
+			m_VisibleInstanceDescriptors[i]->Bind(
+				{
+					Renderer::Descriptor::BindingInfo{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, {.m_Buffer = m_VisibleInstanceBuffers[i] } }
+				}
+			);
+		}
+
 		auto indirectLayout = Renderer::DescriptorLayout(device, { { 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr} });
 
 		for (auto i = 0; i < m_IndirectCommandsBuffers.size(); i++) {
@@ -291,27 +546,202 @@ namespace Engine::Assets {
 				}
 			);
 		}
+
+		m_LodBufferDescriptor = new Renderer::Descriptor(device,
+			indirectLayout,
+			VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+		);
+
+		m_LodBufferDescriptor->Bind(
+			{
+				Renderer::Descriptor::BindingInfo{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, {.m_Buffer = m_LodStorageBuffer }}
+			}
+		);
+
+		if (device->SupportsDrawIndirectCount() && !m_PerMeshletData.empty())
+			CreateMeshletBuffers(device, commandPool);
+	}
+
+	void StaticGLTFAsset::CreateMeshletBuffers(std::shared_ptr<Renderer::Device> device, std::shared_ptr<Renderer::CommandPool> commandPool) {
+		const auto& graphicsQueue = device->GetGraphicsQueue();
+
+		std::unique_ptr<Renderer::CommandBuffer> commandBuffer = std::make_unique<Renderer::CommandBuffer>(device, commandPool);
+
+		const auto meshletBufferSize = m_PerMeshletData.size() * sizeof(IndirectMeshletData);
+		// Never empty, keeps the descriptor valid for assets without meshlet geometry.
+		const auto geometryBufferSize = std::max<size_t>(m_MeshletGeometry.size(), 1) * sizeof(uint32_t);
+
+		std::unique_ptr<Renderer::StagingBuffer> meshletStagingBuffer = std::make_unique<Renderer::StagingBuffer>(device, meshletBufferSize);
+		meshletStagingBuffer->Patch(m_PerMeshletData.data(), meshletBufferSize);
+
+		std::unique_ptr<Renderer::StagingBuffer> geometryStagingBuffer = std::make_unique<Renderer::StagingBuffer>(device, geometryBufferSize);
+		if (!m_MeshletGeometry.empty())
+			geometryStagingBuffer->Patch(m_MeshletGeometry.data(), m_MeshletGeometry.size() * sizeof(uint32_t));
+
+		m_MeshletStorageBuffer = new Renderer::Buffer(device, meshletBufferSize,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			VK_SHARING_MODE_EXCLUSIVE,
+			VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT
+		);
+
+		m_MeshletGeometryBuffer = new Renderer::Buffer(device, geometryBufferSize,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			VK_SHARING_MODE_EXCLUSIVE,
+			VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT
+		);
+
+		// Worst case every meshlet survives.
+		m_MeshletCommandsBuffer = new Renderer::Buffer(device, m_PerMeshletData.size() * sizeof(VkDrawIndexedIndirectCommand),
+			VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			VK_SHARING_MODE_EXCLUSIVE,
+			VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT
+		);
+
+		// x: 16-bit indexed draws, y: 32-bit indexed draws. Reset by the culling pass.
+		m_MeshletCountBuffer = new Renderer::Buffer(device, 2 * sizeof(uint32_t),
+			VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			VK_SHARING_MODE_EXCLUSIVE,
+			VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT
+		);
+
+		commandBuffer->Begin();
+		commandBuffer->CopyBuffer(*meshletStagingBuffer, *m_MeshletStorageBuffer, static_cast<VkDeviceSize>(meshletBufferSize));
+		commandBuffer->CopyBuffer(*geometryStagingBuffer, *m_MeshletGeometryBuffer, static_cast<VkDeviceSize>(geometryBufferSize));
+		commandBuffer->End();
+		commandBuffer->SubmitToQueue(graphicsQueue);
+
+		// Read by the culling compute pass and the task/mesh shaders.
+		auto meshletLayout = Renderer::DescriptorLayout(device, { { 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_ALL, nullptr} });
+
+		const auto createDescriptor = [&](Renderer::Buffer* buffer) {
+			auto* descriptor = new Renderer::Descriptor(device,
+				meshletLayout,
+				VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+			);
+
+			descriptor->Bind(
+				{
+					Renderer::Descriptor::BindingInfo{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, {.m_Buffer = buffer }}
+				}
+			);
+
+			return descriptor;
+		};
+
+		m_MeshletBufferDescriptor = createDescriptor(m_MeshletStorageBuffer);
+		m_MeshletGeometryDescriptor = createDescriptor(m_MeshletGeometryBuffer);
+		m_MeshletCommandsDescriptor = createDescriptor(m_MeshletCommandsBuffer);
+		m_MeshletCountDescriptor = createDescriptor(m_MeshletCountBuffer);
 	}
 
 	void StaticGLTFAsset::Render( Renderer::CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline, const std::vector<Renderer::Descriptor*>& sceneDescriptors, int bufferIndex )
 	{
-		vkCmdBindPipeline( commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, *pipeline );
+		// Every bucket but the blended ones with the same pipeline.
+		for ( uint32_t bucket = 0; bucket < DB_BLEND; bucket++ )
+			RenderBucket( commandBuffer, pipeline, sceneDescriptors, bufferIndex, static_cast< DrawBucket >( bucket ) );
+	}
+
+	void StaticGLTFAsset::BindDrawDescriptors( Renderer::CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline, const std::vector<Renderer::Descriptor*>& sceneDescriptors, Renderer::Descriptor* primitiveDescriptor )
+	{
+		commandBuffer.BindPipeline( *pipeline );
 
 		std::vector<Renderer::Descriptor*> descriptors = sceneDescriptors;
-	
-		std::vector<Renderer::Descriptor*> assetDescriptors = { m_MaterialBufferDescriptor, m_TextureBufferDescriptor, m_PrimitiveBufferDescriptor };
+
+		// Without a vertex animation the instance data stands in for it, the VS never reads it then.
+		Renderer::Descriptor* vertexAnimationDescriptor = m_VertexAnimationDescriptor ? m_VertexAnimationDescriptor : primitiveDescriptor;
+
+		std::vector<Renderer::Descriptor*> assetDescriptors = { m_MaterialBufferDescriptor, m_TextureBufferDescriptor, primitiveDescriptor, vertexAnimationDescriptor };
 		descriptors.insert( descriptors.end( ), assetDescriptors.cbegin( ), assetDescriptors.cend( ) );
 
 		commandBuffer.BindDescriptors( descriptors );
 		commandBuffer.SetDescriptorOffsets( descriptors, *pipeline );
+	}
+
+	void StaticGLTFAsset::RenderBucket( Renderer::CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline, const std::vector<Renderer::Descriptor*>& sceneDescriptors, int bufferIndex, DrawBucket bucket )
+	{
+		const auto& range = m_DrawRanges[ bucket ];
+		if ( range.m_Count == 0 )
+			return;
 
-		const VkDeviceSize offsets[ 1 ] = { 0 };
-		const VkBuffer vertexBuffer = *m_VertexBuffer;
-		vkCmdBindVertexBuffers( commandBuffer, 0, 1, &vertexBuffer, offsets );
-		vkCmdBindIndexBuffer( commandBuffer, *m_IndexBuffer, 0, VK_INDEX_TYPE_UINT32 );
+		// Meshlet draws carry the index of their instance, the regular draws read the instances compacted by the culling pass.
+		// Only the opaque single sided draws are split into meshlets.
+		const bool meshletDraws = bufferIndex == 0 && bucket == DB_OPAQUE && UsesMeshletDraws( );
+		BindDrawDescriptors( commandBuffer, pipeline, sceneDescriptors, meshletDraws ? m_PrimitiveBufferDescriptor : m_VisibleInstanceDescriptors[ bufferIndex ] );
+
+		// Main view, only the meshlets that survived culling, compacted per index type.
+		if ( meshletDraws )
+		{
+			// Vertex & index buffers are bound once per pass through the geometry arena, only the index type changes.
+			auto* arena = Renderer::GeometryArena::Get( );
+
+			const uint32_t meshletCount = GetMeshletCount( );
+
+			if ( m_ShortIndexedMeshletCount > 0 )
+			{
+				arena->BindIndices( commandBuffer, VK_INDEX_TYPE_UINT16 );
+				vkCmdDrawIndexedIndirectCount( commandBuffer, *m_MeshletCommandsBuffer, 0, *m_MeshletCountBuffer, 0, m_ShortIndexedMeshletCount, sizeof( VkDrawIndexedIndirectCommand ) );
+			}
 
-		// TODO: Check if device supports MultiDrawIndirect.
-		vkCmdDrawIndexedIndirect( commandBuffer, *m_IndirectCommandsBuffers[ bufferIndex ], 0, static_cast< uint32_t >( m_IndirectCommands.size( ) ), sizeof( VkDrawIndexedIndirectCommand ) );
+			if ( meshletCount > m_ShortIndexedMeshletCount )
+			{
+				arena->BindIndices( commandBuffer, VK_INDEX_TYPE_UINT32 );
+				vkCmdDrawIndexedIndirectCount( commandBuffer, *m_MeshletCommandsBuffer, m_ShortIndexedMeshletCount * sizeof( VkDrawIndexedIndirectCommand ), *m_MeshletCountBuffer, sizeof( uint32_t ), meshletCount - m_ShortIndexedMeshletCount, sizeof( VkDrawIndexedIndirectCommand ) );
+			}
+
+			return;
+		}
+
+		DrawRangeIndirect( commandBuffer, *m_IndirectCommandsBuffers[ bufferIndex ], range );
+	}
+
+	void StaticGLTFAsset::GetBlendedDraws( const glm::vec3& viewPosition, std::vector<BlendedDraw>& draws ) const
+	{
+		for ( const auto bucket : { DB_BLEND, DB_BLEND_DOUBLE_SIDED } )
+		{
+			const auto& range = m_DrawRanges[ bucket ];
+
+			for ( auto draw = range.m_First; draw < range.m_First + range.m_Count; draw++ )
+			{
+				const glm::vec3 offset = m_DrawCenters[ draw ] - viewPosition;
+				draws.push_back( { const_cast< StaticGLTFAsset* >( this ), draw, bucket, glm::dot( offset, offset ) } );
+			}
+		}
+	}
+
+	void StaticGLTFAsset::RenderBlendedDraw( Renderer::CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline, const std::vector<Renderer::Descriptor*>& sceneDescriptors, const BlendedDraw& draw )
+	{
+		BindDrawDescriptors( commandBuffer, pipeline, sceneDescriptors, m_VisibleInstanceDescriptors[ 0 ] );
+		DrawRangeIndirect( commandBuffer, *m_IndirectCommandsBuffers[ 0 ], GetSingleDrawRange( draw.m_Draw, draw.m_Bucket ) );
+	}
+
+	void StaticGLTFAsset::RenderMeshlets( Renderer::CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline, const std::vector<Renderer::Descriptor*>& sceneDescriptors, const std::vector<Renderer::Descriptor*>& cullDescriptors )
+	{
+		if ( !m_MeshletStorageBuffer )
+			return;
+
+		commandBuffer.BindPipeline( *pipeline );
+
+		std::vector<Renderer::Descriptor*> descriptors = sceneDescriptors;
+
+		// Same sets as Render, followed by the meshlet data and the culling inputs.
+		std::vector<Renderer::Descriptor*> assetDescriptors = { m_MaterialBufferDescriptor, m_TextureBufferDescriptor, m_PrimitiveBufferDescriptor,
+			m_MeshletBufferDescriptor, m_MeshletGeometryDescriptor, Renderer::GeometryArena::Get( )->GetVertexDescriptor( ), m_IndirectBufferDescriptors[ 0 ] };
+		descriptors.insert( descriptors.end( ), assetDescriptors.cbegin( ), assetDescriptors.cend( ) );
+		descriptors.insert( descriptors.end( ), cullDescriptors.cbegin( ), cullDescriptors.cend( ) );
+
+		commandBuffer.BindDescriptors( descriptors );
+		commandBuffer.SetDescriptorOffsets( descriptors, *pipeline );
+
+		const uint32_t meshletCount = GetMeshletCount( );
+		// Offset 0 belongs to the fragment shader.
+		vkCmdPushConstants( commandBuffer, pipeline->GetPipelineLayout( ), VK_SHADER_STAGE_TASK_BIT_EXT, sizeof( uint32_t ), sizeof( uint32_t ), &meshletCount );
+
+		// One task workgroup per 32 meshlets.
+		vkCmdDrawMeshTasksEXT( commandBuffer, ( meshletCount + 31 ) / 32, 1, 1 );
 	}
 
 	void StaticGLTFAsset::SetupDevice( const std::vector<Renderer::DescriptorLayout>& descriptorLayouts )
@@ -319,14 +749,152 @@ namespace Engine::Assets {
 		CreateGeometryBuffers( m_Device, m_CommandPool );
 		LoadMaterials( m_Device, m_CommandPool, descriptorLayouts[ 0 ] );
 		LoadTextures( m_Device, m_CommandPool, descriptorLayouts[ 1 ] );
-		BuildIndirectBatches( m_Device, m_CommandPool, descriptorLayouts[ 2 ] );
+		BuildIndirectBatches( );
+		UploadIndirectBatches( m_Device, m_CommandPool, descriptorLayouts[ 2 ] );
+	}
+
+	void StaticGLTFAsset::GetCollisionTriangle(const CollisionInstance& instance, uint32_t triangle, glm::vec3& p0, glm::vec3& p1, glm::vec3& p2) const {
+		const size_t index = instance.m_Primitive->m_IndexOffset + triangle * 3;
+
+		p0 = glm::vec3( instance.m_Matrix * glm::vec4( m_Vertices[ m_Indices[ index ] ].Position, 1.f ) );
+		p1 = glm::vec3( instance.m_Matrix * glm::vec4( m_Vertices[ m_Indices[ index + 1 ] ].Position, 1.f ) );
+		p2 = glm::vec3( instance.m_Matrix * glm::vec4( m_Vertices[ m_Indices[ index + 2 ] ].Position, 1.f ) );
+	}
+
+	template<typename Fn>
+	void StaticGLTFAsset::QueryTriangles(const Core::CollisionBox& aabb, Fn&& fn) const {
+		m_CollisionTree.Query( aabb, [ & ]( uint32_t instanceIndex )
+		{
+			const auto& instance = m_CollisionInstances[ instanceIndex ];
+
+			// Conservative under rotation, the triangles are tested exactly in world space.
+			const Core::CollisionBox localBox = aabb.Transform( instance.m_InverseMatrix );
+
+			return m_TriangleTrees[ instance.m_TriangleTree ].Query( localBox, [ & ]( uint32_t triangle )
+			{
+				glm::vec3 p0{}, p1{}, p2{};
+				GetCollisionTriangle( instance, triangle, p0, p1, p2 );
+
+				return fn( p0, p1, p2 );
+			} );
+		} );
 	}
 
 	bool StaticGLTFAsset::Intersects(const Core::CollisionCapsule& capsule) {
-		return true;
+		glm::vec3 normal{};
+		return Intersects( capsule, normal );
 	}
 
 	bool StaticGLTFAsset::Intersects(const Core::CollisionBox& aabb, glm::vec3& normal ) {
+		const glm::vec3 center = ( aabb.GetMins( ) + aabb.GetMaxs( ) ) * 0.5f;
+		float closestDistance = std::numeric_limits<float>::max( );
+
+		QueryTriangles( aabb, [ & ]( const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2 )
+		{
+			if ( !aabb.Intersects( p0, p1, p2 ) )
+				return false;
+
+			// Pushes away from the closest triangle, along its face normal when the center lies on it.
+			const glm::vec3 offset = center - Core::CollisionBox::ClosestPointOnTriangle( center, p0, p1, p2 );
+			const float distance = glm::dot( offset, offset );
+
+			if ( distance < closestDistance )
+			{
+				closestDistance = distance;
+				normal = distance > 0.f ? offset : glm::normalize( glm::cross( p1 - p0, p2 - p0 ) );
+			}
+
+			return false;
+		} );
+
+		return closestDistance < std::numeric_limits<float>::max( );
+	}
+
+	bool StaticGLTFAsset::Intersects(const Core::CollisionSphere& sphere, glm::vec3& normal) const {
+		float closestDistance = std::numeric_limits<float>::max( );
+
+		QueryTriangles( sphere.GetAABB( ), [ & ]( const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2 )
+		{
+			const glm::vec3 offset = sphere.m_Center - Core::CollisionBox::ClosestPointOnTriangle( sphere.m_Center, p0, p1, p2 );
+			const float distance = glm::dot( offset, offset );
+
+			if ( distance <= sphere.m_Radius * sphere.m_Radius && distance < closestDistance )
+			{
+				closestDistance = distance;
+				normal = distance > 0.f ? offset : glm::normalize( glm::cross( p1 - p0, p2 - p0 ) );
+			}
+
+			return false;
+		} );
+
+		return closestDistance < std::numeric_limits<float>::max( );
+	}
+
+	bool StaticGLTFAsset::Intersects(const Core::CollisionCapsule& capsule, glm::vec3& normal) const {
+		float closestDistance = std::numeric_limits<float>::max( );
+
+		QueryTriangles( capsule.GetAABB( ), [ & ]( const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2 )
+		{
+			glm::vec3 segmentPoint{}, trianglePoint{};
+			const float distance = capsule.GetClosestPoints( p0, p1, p2, segmentPoint, trianglePoint );
+
+			if ( distance <= capsule.m_Radius * capsule.m_Radius && distance < closestDistance )
+			{
+				closestDistance = distance;
+				normal = distance > 0.f ? segmentPoint - trianglePoint : glm::normalize( glm::cross( p1 - p0, p2 - p0 ) );
+			}
+
+			return false;
+		} );
+
+		return closestDistance < std::numeric_limits<float>::max( );
+	}
+
+	bool StaticGLTFAsset::Raycast(const Core::CollisionRay& ray, float& distance, glm::vec3& normal) const {
+		float closest = ray.m_Length;
+		bool hit = false;
+
+		m_CollisionTree.Raycast( ray.m_Origin, ray.m_Direction, closest, [ & ]( uint32_t instanceIndex )
+		{
+			const auto& instance = m_CollisionInstances[ instanceIndex ];
+
+			// The local ray keeps the world parametrization, distances along it stay comparable.
+			const glm::vec3 localOrigin = glm::vec3( instance.m_InverseMatrix * glm::vec4( ray.m_Origin, 1.f ) );
+			const glm::vec3 localDirection = glm::mat3( instance.m_InverseMatrix ) * ray.m_Direction;
+
+			m_TriangleTrees[ instance.m_TriangleTree ].Raycast( localOrigin, localDirection, closest, [ & ]( uint32_t triangle )
+			{
+				glm::vec3 p0{}, p1{}, p2{};
+				GetCollisionTriangle( instance, triangle, p0, p1, p2 );
+
+				Core::CollisionRay clipped = ray;
+				clipped.m_Length = closest;
+
+				float t = 0.f;
+				if ( clipped.Intersects( p0, p1, p2, t ) && t < closest )
+				{
+					closest = t;
+					normal = glm::normalize( glm::cross( p1 - p0, p2 - p0 ) );
+					hit = true;
+				}
+
+				return false;
+			} );
+
+			return false;
+		} );
+
+		if ( !hit )
+			return false;
+
+		if ( glm::dot( normal, ray.m_Direction ) > 0.f )
+			normal = -normal;
+
+		distance = closest;
+		return true;
+	}
+
+	bool StaticGLTFAsset::IntersectsBounds(const Core::CollisionBox& aabb, glm::vec3& normal ) {
 		for (auto node : m_AllNodes) {
 			if (node->m_Mesh) {
 				for (auto& primitive : node->m_Mesh->m_Primitives) 
@@ -337,10 +905,10 @@ namespace Engine::Assets {
 					glm::mat4 m = glm::mat4( 1.f );
 					m[ 2 ][ 2 ] *= -1.f;
 
-					mins = glm::vec3( node->GetMatrix( ) * glm::vec4( mins, 1.f ) );
+					mins = glm::vec3( GetWorldMatrix( node ) * glm::vec4( mins, 1.f ) );
 					mins = glm::vec3( m * glm::vec4( mins, 1.f ) );
 
-					maxs = glm::vec3( node->GetMatrix( ) * glm::vec4( maxs, 1.f ) );
+					maxs = glm::vec3( GetWorldMatrix( node ) * glm::vec4( maxs, 1.f ) );
 					maxs = glm::vec3( m * glm::vec4( maxs, 1.f ) );
 
 					if ( mins.x > maxs.x )
@@ -350,25 +918,6 @@ namespace Engine::Assets {
 					if ( mins.z > maxs.z )
 						std::swap( mins.z, maxs.z );
 
-					/*
-					glm::vec3 mins( std::numeric_limits<float>::max( ) );
-					glm::vec3 maxs( std::numeric_limits<float>::min( ) );
-					
-					for ( auto i = 0; i < primitive.m_IndexCount; i++ )
-					{
-						glm::vec3 p0 = m_Vertices[ m_Indices[ primitive.m_IndexOffset + i ] ].Position;
-
-						glm::mat4 m = glm::mat4( 1.f );
-						m[ 2 ][ 2 ] *= -1.f;
-
-						p0 = glm::vec3( node->GetMatrix( ) * glm::vec4( p0, 1.f ) );
-						p0 = glm::vec3( m * glm::vec4( p0, 1.f ) );
-
-						// TODO: Debug why these results are incorrect.
-						mins = glm::min( p0, mins );
-						maxs = glm::max( p0, maxs );
-					}*/
-
 					Core::CollisionBox primBox(mins, maxs);
 
 					if ( aabb.Intersects( primBox ) )
@@ -382,21 +931,147 @@ namespace Engine::Assets {
 			}
 		}
 
-		/*for (auto i = 0; i < m_Indices.size() / 3; i += 3) {
-			glm::vec3 p0 = m_Vertices[m_Indices[i]].Position;
-			glm::vec3 p1 = m_Vertices[m_Indices[i + 1]].Position;
-			glm::vec3 p2 = m_Vertices[m_Indices[i + 2]].Position;
+		return false;
+	}
+
+	void StaticGLTFAsset::BuildCollision() {
+		using Clock = std::chrono::high_resolution_clock;
+		const auto start = Clock::now();
 
-			glm::mat4 m = glm::mat4(1.f);
-			m[2][2] *= -1.f;
+		m_CollisionInstances.clear();
+		m_TriangleTrees.clear();
 
-			p0 = glm::vec4(p0, 1.f) * m;
-			p1 = glm::vec4(p1, 1.f) * m;
-			p2 = glm::vec4(p2, 1.f) * m;
+		// Same space as the rendered geometry, z flipped after the node transform.
+		glm::mat4 flip = glm::mat4(1.f);
+		flip[2][2] *= -1.f;
 
-		
-		}*/
+		std::unordered_map<const Primitive*, uint32_t> primitiveTrees{};
+		std::vector<Core::CollisionBox> treeBounds{};
+		std::vector<Core::CollisionBox> instanceBounds{};
+		size_t triangleCount = 0;
 
-		return false;
+		for (auto* node : m_AllNodes) {
+			if (!node->m_Mesh)
+				continue;
+
+			std::vector<glm::mat4> matrices{};
+
+			if (node->m_Instances.empty())
+				matrices.push_back(flip * GetWorldMatrix(node));
+
+			for (const auto& instance : node->m_Instances)
+				matrices.push_back(flip * GetWorldMatrix(node) * instance);
+
+			for (const auto& primitive : node->m_Mesh->m_Primitives) {
+				if (primitive.m_IndexCount < 3)
+					continue;
+
+				// Meshes shared between nodes get a single triangle tree.
+				const auto [tree, inserted] = primitiveTrees.try_emplace(&primitive, static_cast<uint32_t>(m_TriangleTrees.size()));
+
+				if (inserted) {
+					std::vector<Core::CollisionBox> triangles(primitive.m_IndexCount / 3);
+					Core::CollisionBox bounds(glm::vec3(std::numeric_limits<float>::max()), glm::vec3(-std::numeric_limits<float>::max()));
+
+					for (auto t = 0; t < triangles.size(); t++) {
+						const size_t index = primitive.m_IndexOffset + t * 3;
+
+						const glm::vec3& p0 = m_Vertices[m_Indices[index]].Position;
+						const glm::vec3& p1 = m_Vertices[m_Indices[index + 1]].Position;
+						const glm::vec3& p2 = m_Vertices[m_Indices[index + 2]].Position;
+
+						triangles[t] = Core::CollisionBox(glm::min(p0, glm::min(p1, p2)), glm::max(p0, glm::max(p1, p2)));
+						bounds = Core::CollisionBox::Merge(bounds, triangles[t]);
+					}
+
+					m_TriangleTrees.emplace_back().Build(triangles);
+					treeBounds.push_back(bounds);
+					triangleCount += triangles.size();
+				}
+
+				for (const auto& matrix : matrices) {
+					m_CollisionInstances.push_back({ &primitive, tree->second, matrix, glm::inverse(matrix) });
+					instanceBounds.push_back(treeBounds[tree->second].Transform(matrix));
+				}
+			}
+		}
+
+		m_CollisionTree.Build(instanceBounds);
+
+		m_CollisionBounds = Core::CollisionBox(glm::vec3(0.f), glm::vec3(0.f));
+		for (auto i = 0; i < instanceBounds.size(); i++)
+			m_CollisionBounds = i == 0 ? instanceBounds[i] : Core::CollisionBox::Merge(m_CollisionBounds, instanceBounds[i]);
+
+		size_t memory = m_CollisionTree.GetMemoryUsage() + m_CollisionInstances.size() * sizeof(CollisionInstance);
+		for (const auto& triangleTree : m_TriangleTrees)
+			memory += triangleTree.GetMemoryUsage();
+
+		printf("[%s] Collision: %zu instances, %zu triangles, %.2f MB, built in %.2f ms\n", GetName().c_str(), m_CollisionInstances.size(), triangleCount,
+			memory / (1024.f * 1024.f), std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+	}
+
+	void StaticGLTFAsset::GetCollisionMesh(std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices) const {
+		positions.clear();
+		indices.clear();
+
+		std::unordered_map<uint32_t, uint32_t> remap{};
+
+		for (const auto& instance : m_CollisionInstances) {
+			const auto& primitive = *instance.m_Primitive;
+			remap.clear();
+
+			// The z flip mirrors the geometry, swap the winding back so front faces stay front faces.
+			const bool mirrored = glm::determinant(glm::mat3(instance.m_Matrix)) < 0.f;
+
+			for (auto i = primitive.m_IndexOffset; i + 2 < primitive.m_IndexOffset + primitive.m_IndexCount; i += 3) {
+				const uint32_t triangle[3] = { m_Indices[i], m_Indices[i + (mirrored ? 2 : 1)], m_Indices[i + (mirrored ? 1 : 2)] };
+
+				for (const auto vertex : triangle) {
+					const auto [it, inserted] = remap.try_emplace(vertex, static_cast<uint32_t>(positions.size()));
+					if (inserted)
+						positions.push_back(glm::vec3(instance.m_Matrix * glm::vec4(m_Vertices[vertex].Position, 1.f)));
+
+					indices.push_back(it->second);
+				}
+			}
+		}
+	}
+
+	void StaticGLTFAsset::BenchmarkCollision(uint32_t iterations) {
+		if (m_CollisionInstances.empty() || iterations == 0)
+			return;
+
+		using Clock = std::chrono::high_resolution_clock;
+
+		// Player sized boxes spread over the asset.
+		std::mt19937 random(1337);
+		std::uniform_real_distribution<float> x(m_CollisionBounds.m_Mins.x, m_CollisionBounds.m_Maxs.x);
+		std::uniform_real_distribution<float> y(m_CollisionBounds.m_Mins.y, m_CollisionBounds.m_Maxs.y);
+		std::uniform_real_distribution<float> z(m_CollisionBounds.m_Mins.z, m_CollisionBounds.m_Maxs.z);
+
+		const glm::vec3 halfSize = glm::vec3(0.25f, 0.5f, 0.25f);
+
+		std::vector<Core::CollisionBox> queries(iterations);
+		for (auto& query : queries) {
+			const glm::vec3 center(x(random), y(random), z(random));
+			query = Core::CollisionBox(center - halfSize, center + halfSize);
+		}
+
+		const auto measure = [&](const char* label, auto intersects)
+		{
+			uint32_t hits = 0;
+			glm::vec3 normal{};
+
+			const auto start = Clock::now();
+			for (const auto& query : queries)
+				hits += intersects(query, normal) ? 1 : 0;
+
+			const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+			printf("[%s] %s: %.1f queries/ms, %u of %u hit\n", GetName().c_str(), label, iterations / std::max(ms, 1e-6), hits, iterations);
+		};
+
+		measure("BVH + triangles", [this](const Core::CollisionBox& query, glm::vec3& normal) { return Intersects(query, normal); });
+		measure("primitive bounds", [this](const Core::CollisionBox& query, glm::vec3& normal) { return IntersectsBounds(query, normal); });
 	}
 }
\ No newline at end of file
@@ -1,5 +1,9 @@
 #pragma once
 #include "BaseGLTFAsset.hpp"
+#include "../../Core/Collision/CollisionBVH.hpp"
+#include "../../Core/Collision/CollisionCapsule.hpp"
+#include "../../Core/Collision/CollisionSphere.hpp"
+#include "../../Core/Collision/CollisionRay.hpp"
 
 namespace Engine::Assets {
 
@@ -43,17 +47,92 @@ namespace Engine::Assets {
 			}
 		};
 
+		struct PackedVertexAttribute {
+			uint16_t Position[4]{};	// xyz: unorm16 inside the primitive bounds, w: tangent handedness (0 = -1, 1 = +1).
+			int16_t Normal[2]{};	// Octahedral snorm16.
+			uint16_t UV[2]{};		// Half floats.
+			int16_t Tangent[2]{};	// Octahedral snorm16.
+
+			static VkVertexInputBindingDescription GetBindingDescription() {
+				return { 0, sizeof(PackedVertexAttribute), VK_VERTEX_INPUT_RATE_VERTEX };
+			}
+
+			static std::vector<VkVertexInputAttributeDescription> GetInputAttributeDescriptions()
+			{
+				return {
+					{ 0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(PackedVertexAttribute, Position) },
+					{ 1, 0, VK_FORMAT_R16G16_SNORM, offsetof(PackedVertexAttribute, Normal) },
+					{ 2, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(PackedVertexAttribute, UV) },
+					{ 3, 0, VK_FORMAT_R16G16_SNORM, offsetof(PackedVertexAttribute, Tangent) }
+				};
+			}
+		};
+
 		using VertexType = StaticGLTFAsset::VertexAttribute;
 
+		// Input layout matching BaseGLTFAsset::s_VertexFormat.
+		static VkVertexInputBindingDescription GetBindingDescription() {
+			return s_VertexFormat == VertexFormat::VF_PACKED ? PackedVertexAttribute::GetBindingDescription() : VertexAttribute::GetBindingDescription();
+		}
+
+		static std::vector<VkVertexInputAttributeDescription> GetInputAttributeDescriptions() {
+			return s_VertexFormat == VertexFormat::VF_PACKED ? PackedVertexAttribute::GetInputAttributeDescriptions() : VertexAttribute::GetInputAttributeDescriptions();
+		}
+
 		virtual void Render(Renderer::CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline, const std::vector<Renderer::Descriptor*>& sceneDescriptors, int bufferIndex) override;
+		virtual void RenderBucket(Renderer::CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline, const std::vector<Renderer::Descriptor*>& sceneDescriptors, int bufferIndex, DrawBucket bucket) override;
+
+		// Blended draws are sorted by the center of their instances, the visible ones are drawn in instance order.
+		virtual void GetBlendedDraws(const glm::vec3& viewPosition, std::vector<BlendedDraw>& draws) const override;
+		virtual void RenderBlendedDraw(Renderer::CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline, const std::vector<Renderer::Descriptor*>& sceneDescriptors, const BlendedDraw& draw) override;
+
+		// Task/mesh shader path, culls the meshlets itself. cullDescriptors are the SceneCuller meshlet descriptors.
+		void RenderMeshlets(Renderer::CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline, const std::vector<Renderer::Descriptor*>& sceneDescriptors, const std::vector<Renderer::Descriptor*>& cullDescriptors);
 		virtual void SetupDevice(const std::vector<Renderer::DescriptorLayout>& descriptorLayouts) override;
 	
-		bool Intersects(const Core::CollisionCapsule& capsule);
-		bool Intersects(const Core::CollisionBox& aabb, glm::vec3& normal);
+		virtual bool Intersects(const Core::CollisionCapsule& capsule);
+		virtual bool Intersects(const Core::CollisionBox& aabb, glm::vec3& normal);
+
+		// Const queries over the collision BVH, safe to run from several threads at once (see Scene::Query).
+		// normal points from the closest triangle towards the query, it is not normalized.
+		bool Intersects(const Core::CollisionSphere& sphere, glm::vec3& normal) const;
+		bool Intersects(const Core::CollisionCapsule& capsule, glm::vec3& normal) const;
+
+		// Closest hit along the ray, normal is the unit face normal facing the ray.
+		bool Raycast(const Core::CollisionRay& ray, float& distance, glm::vec3& normal) const;
+
+		const Core::CollisionBox& GetCollisionBounds() const { return m_CollisionBounds; }
+
+		// Times random box queries through the collision BVH and through the per primitive bounds loop it replaced, results are printed to the console.
+		void BenchmarkCollision(uint32_t iterations);
+
+		// Every collision instance as one world space triangle mesh, for Core::Physics::AddStaticMesh.
+		void GetCollisionMesh(std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices) const;
 
 		size_t GetIndirectCommandsCount() { return m_IndirectCommands.size(); }
+		size_t GetInstanceCount() { return m_PerPrimitiveData.size(); }
 		Renderer::Descriptor* GetIndirectDescriptor(int index = 0) { return m_IndirectBufferDescriptors[index]; }
+		Renderer::Buffer* GetIndirectBuffer(int index = 0) { return m_IndirectCommandsBuffers[index]; }
 		Renderer::Descriptor* GetPrimitiveDescriptor() { return m_PrimitiveBufferDescriptor; }
+		Renderer::Descriptor* GetVisibleInstanceDescriptor(int index = 0) { return m_VisibleInstanceDescriptors[index]; }
+		Renderer::Descriptor* GetLodDescriptor() { return m_LodBufferDescriptor; }
+
+		// Deformed by a baked vertex animation, only drawn through the vertex shader path.
+		bool HasVertexAnimation() const { return m_VertexAnimationDescriptor != nullptr; }
+
+		// Main view draws go through the meshlet culling pass (compacted draws + draw count).
+		bool UsesMeshletDraws() const { return s_MeshletCulling && m_MeshletCommandsBuffer && m_Device->SupportsDrawIndirectCount(); }
+
+		uint32_t GetMeshletCount() const { return static_cast<uint32_t>(m_PerMeshletData.size()); }
+		uint32_t GetShortIndexedMeshletCount() const { return m_ShortIndexedMeshletCount; }
+		Renderer::Buffer* GetMeshletCommandsBuffer() { return m_MeshletCommandsBuffer; }
+		Renderer::Buffer* GetMeshletCountBuffer() { return m_MeshletCountBuffer; }
+		Renderer::Descriptor* GetMeshletDescriptor() { return m_MeshletBufferDescriptor; }
+		Renderer::Descriptor* GetMeshletCommandsDescriptor() { return m_MeshletCommandsDescriptor; }
+		Renderer::Descriptor* GetMeshletCountDescriptor() { return m_MeshletCountDescriptor; }
+
+		// Per meshlet culling after the per primitive pass.
+		static inline bool s_MeshletCulling = true;
 	public: // TODO: Remove.
 		// Vertex & Index Buffers
 		std::vector<VertexType> m_Vertices{};
@@ -61,44 +140,64 @@ namespace Engine::Assets {
 
 		glm::mat4 m_WorldMatrix{ 1.f };
 	protected:
+		// For assets built from another asset instead of a glTF file (see CrowdGLTFAsset).
+		StaticGLTFAsset(
+			std::shared_ptr<Renderer::Device> device,
+			std::shared_ptr<Renderer::CommandPool> commandPool
+		);
+
 		virtual bool LoadAsset(const std::string& gltfPath, int sceneIndex = -1) override;
 		virtual void LoadNode(const tinygltf::Node& inputNode, Node* parent, uint32_t nodeIndex) override;
 
-		virtual void CreateGeometryBuffers(std::shared_ptr<Renderer::Device> device, std::shared_ptr<Renderer::CommandPool> commandPool) override
-		{
-			const auto vertexSize = m_Vertices.size() * sizeof(VertexAttribute);
-			const auto indexSize = m_Indices.size() * sizeof(uint32_t);
+		virtual void CreateGeometryBuffers(std::shared_ptr<Renderer::Device> device, std::shared_ptr<Renderer::CommandPool> commandPool) override;
 
-			std::unique_ptr<Renderer::StagingBuffer> vertexStagingBuffer = std::make_unique<Renderer::StagingBuffer>(device, vertexSize);
-			vertexStagingBuffer->Patch(m_Vertices.data(), vertexSize);
+		// Indexed by glTF mesh, shared by every node that references it.
+		std::vector<Mesh*> m_Meshes{};
 
-			std::unique_ptr<Renderer::StagingBuffer> indexStagingBuffer = std::make_unique<Renderer::StagingBuffer>(device, indexSize);
-			indexStagingBuffer->Patch(m_Indices.data(), indexSize);
+		struct IndirectPrimitiveData {
+			glm::ivec4 MaterialIndex; // x: material, y: node, z: draw, w: 1 when the instance plays the vertex animation.
+			glm::mat4 NodeMatrix;
+			glm::vec4 NodePos; // Instance bounding sphere.
+			glm::vec4 PosOffset; // Position dequantization, w: clip time offset of vertex animated instances.
+			glm::vec4 PosScale; // w: 1 when normals/tangents are octahedral encoded.
+		};
 
-			m_VertexBuffer = new Renderer::Buffer(device, vertexSize,
-				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_SHARING_MODE_EXCLUSIVE);
-			m_IndexBuffer = new Renderer::Buffer(device, indexSize,
-				VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_SHARING_MODE_EXCLUSIVE);
+		// One draw per mesh primitive, instanced over every node (and EXT_mesh_gpu_instancing instance) using the mesh.
+		std::vector<VkDrawIndexedIndirectCommand> m_IndirectCommands{};
+		// Per instance, the instances of a draw are contiguous from its firstInstance.
+		std::vector<IndirectPrimitiveData> m_PerPrimitiveData{};
 
-			std::unique_ptr<Renderer::CommandBuffer> commandBuffer = std::make_unique<Renderer::CommandBuffer>(device, commandPool);
+		// Per draw LOD table read by the culling pass (see CullFrustumCS.hlsl).
+		struct IndirectLodData {
+			glm::uvec4 Lods[MAX_LOD_COUNT]; // x: firstIndex, y: indexCount, z: error (float bits).
+			glm::uvec4 LodCount; // x: LOD count, y: first instance, z: instance count.
+		};
 
-			const auto& graphicsQueue = device->GetGraphicsQueue();
+		std::vector<IndirectLodData> m_PerPrimitiveLods{};
 
-			commandBuffer->Begin();
-			commandBuffer->CopyBuffer(*vertexStagingBuffer, *m_VertexBuffer, static_cast<VkDeviceSize>(vertexSize));
-			commandBuffer->CopyBuffer(*indexStagingBuffer, *m_IndexBuffer, static_cast<VkDeviceSize>(indexSize));
-			commandBuffer->End();
-			commandBuffer->SubmitToQueue(graphicsQueue);
-		}
+		// Per draw, center of its instances in the z flipped render space.
+		std::vector<glm::vec3> m_DrawCenters{};
 
-		struct IndirectPrimitiveData {
-			glm::ivec4 MaterialIndex;
-			glm::mat4 NodeMatrix;
-			glm::vec4 NodePos; // Node bounding sphere.
+		// Meshlet flags (IndirectMeshletData::Draw.w).
+		static constexpr uint32_t MESHLET_LONG_INDICES = 1 << 0;	// Written to the 32-bit index half of the output.
+		static constexpr uint32_t MESHLET_FIRST_IN_DRAW = 1 << 1;	// Emits the whole draw of its instance when a coarser LOD was picked.
+		static constexpr uint32_t MESHLET_WHOLE_DRAW = 1 << 2;		// Primitive without meshlets, always emits the whole draw.
+
+		// Per meshlet culling data (see MeshletCullCS.hlsl), ordered like the draws and repeated for every instance.
+		struct IndirectMeshletData {
+			glm::vec4 Sphere;		// Object space bounding sphere.
+			glm::vec4 Cone;			// xyz: axis, w: cutoff.
+			glm::uvec4 Draw;		// x: draw index, y: first index inside the LOD0 range of the draw, z: index count, w: flags.
+			glm::uvec4 Geometry;	// x: first vertex word, y: first triangle word (in m_MeshletGeometry), z: vertex count | triangle count << 16, w: instance.
 		};
 
-		std::vector<VkDrawIndexedIndirectCommand> m_IndirectCommands{};
-		std::vector<IndirectPrimitiveData> m_PerPrimitiveData{};
+		std::vector<IndirectMeshletData> m_PerMeshletData{};
+
+		// Absolute arena vertex indices followed by the packed (4 per word) local triangle indices of every meshlet.
+		std::vector<uint32_t> m_MeshletGeometry{};
+
+		// Meshlets of the opaque single sided draws only, 16-bit indexed ones first. Their output lives in the first half of m_MeshletCommandsBuffer.
+		uint32_t m_ShortIndexedMeshletCount{};
 
 		std::array<Renderer::Buffer*, 5> m_IndirectCommandsBuffers{};
 		std::array<Renderer::Descriptor*, 5> m_IndirectBufferDescriptors{}; // Used for culling.
@@ -106,7 +205,58 @@ namespace Engine::Assets {
 		Renderer::Buffer* m_PrimitiveStorageBuffer = nullptr;
 		Renderer::Descriptor* m_PrimitiveBufferDescriptor = nullptr;
 
-		void BuildIndirectBatches(std::shared_ptr<Renderer::Device> device, std::shared_ptr<Renderer::CommandPool> commandPool, const Renderer::DescriptorLayout& primitiveLayout);
+		// Instances that survived culling, compacted per draw. One per indirect buffer, bound in place of the primitive data.
+		std::array<Renderer::Buffer*, 5> m_VisibleInstanceBuffers{};
+		std::array<Renderer::Descriptor*, 5> m_VisibleInstanceDescriptors{};
+
+		Renderer::Buffer* m_LodStorageBuffer = nullptr;
+		Renderer::Descriptor* m_LodBufferDescriptor = nullptr;
+
+		Renderer::Buffer* m_MeshletStorageBuffer = nullptr;
+		Renderer::Descriptor* m_MeshletBufferDescriptor = nullptr;
+
+		Renderer::Buffer* m_MeshletGeometryBuffer = nullptr;
+		Renderer::Descriptor* m_MeshletGeometryDescriptor = nullptr;
+
+		// Compacted output of the meshlet culling pass, one count for each index type.
+		Renderer::Buffer* m_MeshletCommandsBuffer = nullptr;
+		Renderer::Descriptor* m_MeshletCommandsDescriptor = nullptr;
+		Renderer::Buffer* m_MeshletCountBuffer = nullptr;
+		Renderer::Descriptor* m_MeshletCountDescriptor = nullptr;
+
+		// Static collision, built once at load. The BVH holds the world space bounds of every primitive instance,
+		// each unique primitive has a triangle BVH in its own space for the narrow phase.
+		struct CollisionInstance {
+			const Primitive* m_Primitive{};
+			uint32_t m_TriangleTree{};
+			glm::mat4 m_Matrix{}, m_InverseMatrix{}; // Node world matrix followed by the z flip of the renderer.
+		};
+
+		std::vector<CollisionInstance> m_CollisionInstances{};
+		std::vector<Core::CollisionBVH> m_TriangleTrees{};
+		Core::CollisionBVH m_CollisionTree{};
+		Core::CollisionBox m_CollisionBounds{};
+
+		void BuildCollision();
+
+		void GetCollisionTriangle(const CollisionInstance& instance, uint32_t triangle, glm::vec3& p0, glm::vec3& p1, glm::vec3& p2) const;
+
+		// Calls fn( p0, p1, p2 ) with the world space triangles of the leaves overlapping aabb until it returns true.
+		template<typename Fn>
+		void QueryTriangles(const Core::CollisionBox& aabb, Fn&& fn) const;
+
+		// Per primitive bounds test without the BVH, the baseline of BenchmarkCollision.
+		bool IntersectsBounds(const Core::CollisionBox& aabb, glm::vec3& normal);
+
+		// Baked frames read by the static VS (see Shaders/VertexAnimation.hlsli), null for assets that do not deform.
+		Renderer::Descriptor* m_VertexAnimationDescriptor = nullptr;
+
+		// Fills the draws, instances, LOD tables and meshlet entries, UploadIndirectBatches creates their buffers.
+		void BuildIndirectBatches();
+		void UploadIndirectBatches(std::shared_ptr<Renderer::Device> device, std::shared_ptr<Renderer::CommandPool> commandPool, const Renderer::DescriptorLayout& primitiveLayout);
+		void CreateMeshletBuffers(std::shared_ptr<Renderer::Device> device, std::shared_ptr<Renderer::CommandPool> commandPool);
+
+		void BindDrawDescriptors(Renderer::CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline, const std::vector<Renderer::Descriptor*>& sceneDescriptors, Renderer::Descriptor* primitiveDescriptor);
 
 		virtual void UnloadAsset() override {
 			for (auto i{ 0u }; i < m_AllNodes.size(); i++) {
@@ -116,6 +266,11 @@ namespace Engine::Assets {
 			m_AllNodes.clear();
 			m_Nodes.clear();
 
+			for (auto* mesh : m_Meshes)
+				delete mesh;
+
+			m_Meshes.clear();
+
 			m_Textures.clear();
 			m_Materials.clear();
 		}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <glm.hpp>
+#include <gtc/packing.hpp>
+
+// Helpers used to build the packed vertex layout (see VertexFormat::VF_PACKED).
+// The matching decode lives in Shaders/VertexDecode.hlsli.
+namespace Engine::Assets::VertexPacking
+{
+	// Maps a position inside [offset, offset + scale] to unorm16.
+	inline void QuantizePosition( const glm::vec3& position, const glm::vec3& offset, const glm::vec3& scale, uint16_t out[ 3 ] )
+	{
+		for ( auto i = 0; i < 3; i++ )
+		{
+			const float v = scale[ i ] > 0.f ? ( position[ i ] - offset[ i ] ) / scale[ i ] : 0.f;
+			out[ i ] = glm::packUnorm1x16( v );
+		}
+	}
+
+	// Octahedral encoding of a unit vector into snorm16x2.
+	inline void PackOctahedral( const glm::vec3& n, int16_t out[ 2 ] )
+	{
+		const float sum = glm::abs( n.x ) + glm::abs( n.y ) + glm::abs( n.z );
+
+		glm::vec2 e = sum > 0.f ? glm::vec2( n.x, n.y ) / sum : glm::vec2( 0.f );
+
+		if ( sum > 0.f && n.z < 0.f )
+		{
+			const glm::vec2 s = glm::vec2( e.x >= 0.f ? 1.f : -1.f, e.y >= 0.f ? 1.f : -1.f );
+			e = ( 1.f - glm::abs( glm::vec2( e.y, e.x ) ) ) * s;
+		}
+
+		out[ 0 ] = static_cast< int16_t >( glm::packSnorm1x16( e.x ) );
+		out[ 1 ] = static_cast< int16_t >( glm::packSnorm1x16( e.y ) );
+	}
+
+	inline void PackHalf2( const glm::vec2& v, uint16_t out[ 2 ] )
+	{
+		out[ 0 ] = glm::packHalf1x16( v.x );
+		out[ 1 ] = glm::packHalf1x16( v.y );
+	}
+
+	// Quantizes to unorm8 and pushes the rounding error into the largest weight so the weights still sum to one.
+	inline void PackWeights( const glm::vec4& weights, uint8_t out[ 4 ] )
+	{
+		int sum = 0, largest = 0;
+
+		for ( auto i = 0; i < 4; i++ )
+		{
+			out[ i ] = glm::packUnorm1x8( weights[ i ] );
+			sum += out[ i ];
+
+			if ( weights[ i ] > weights[ largest ] )
+				largest = i;
+		}
+
+		out[ largest ] = static_cast< uint8_t >( glm::clamp( int( out[ largest ] ) + 255 - sum, 0, 255 ) );
+	}
+}
@@ -4,6 +4,7 @@
 #include "../../Renderer/Vulkan/VulkanRenderer.hpp"
 
 #include "../Input/InputSystem.hpp"
+#include "../Jobs/JobSystem.hpp"
 #include "../Time/TimeSystem.hpp"
 
 #include "../../../Dependencies/imgui/backends/imgui_impl_glfw.h"
@@ -50,6 +51,8 @@ namespace Engine::Core {
 		glfwSetInputMode(m_Window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
 		glfwSetWindowUserPointer(m_Window, this);
 
+		JobSystem::Create();
+
 		m_Renderer = new Engine::Renderer::VulkanRenderer();
 
 		return true;
@@ -58,9 +61,14 @@ namespace Engine::Core {
 	void Application::Shutdown() {
 		m_Renderer->Cleanup();
 
+		// The arena buffers have to go before the device does.
+		Renderer::GeometryArena::Dispose();
+
 		glfwDestroyWindow(m_Window);
 
 		delete m_Renderer;
+
+		JobSystem::Dispose();
 	}
 
 	void Application::Update() {
@@ -0,0 +1,72 @@
+#include "CharacterController.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace Engine::Core
+{
+	CharacterController::CharacterController( Physics& physics, const glm::vec3& position, float height, float radius ) : m_Physics( physics )
+	{
+		const float halfHeight = std::max( height * 0.5f - radius, 0.01f );
+
+		// Capsules are centered, lift it so the origin sits at the feet.
+		JPH::RefConst<JPH::Shape> capsule = new JPH::CapsuleShape( halfHeight, radius );
+		JPH::RefConst<JPH::Shape> shape = JPH::RotatedTranslatedShapeSettings( JPH::Vec3( 0.f, halfHeight + radius, 0.f ), JPH::Quat::sIdentity( ), capsule ).Create( ).Get( );
+
+		if ( !shape )
+			throw std::runtime_error( "Failed to create character shape" );
+
+		JPH::CharacterVirtualSettings settings;
+		settings.mShape = shape;
+		settings.mMaxSlopeAngle = m_MaxSlopeAngle;
+		settings.mUp = JPH::Vec3::sAxisY( );
+
+		// Only contacts with the lower hemisphere support the character.
+		settings.mSupportingVolume = JPH::Plane( JPH::Vec3::sAxisY( ), -radius );
+
+		m_Character = new JPH::CharacterVirtual( &settings, JPH::RVec3( position.x, position.y, position.z ), JPH::Quat::sIdentity( ), m_Physics.GetSystem( ) );
+		m_Slot = m_Physics.AddCharacter( this );
+	}
+
+	CharacterController::~CharacterController( )
+	{
+		m_Physics.RemoveCharacter( m_Slot );
+	}
+
+	void CharacterController::SetVelocity( const glm::vec3& velocity )
+	{
+		m_VelocityX.store( velocity.x, std::memory_order_relaxed );
+		m_VelocityZ.store( velocity.z, std::memory_order_relaxed );
+	}
+
+	void CharacterController::Update( float dt )
+	{
+		JPH::PhysicsSystem* system = m_Physics.GetSystem( );
+
+		m_Character->UpdateGroundVelocity( );
+
+		// Keep falling speed while airborne, follow the ground when standing on it.
+		JPH::Vec3 verticalVelocity = JPH::Vec3( 0.f, m_Character->GetLinearVelocity( ).GetY( ), 0.f );
+
+		if ( m_Character->GetGroundState( ) == JPH::CharacterVirtual::EGroundState::OnGround )
+			verticalVelocity = m_Character->GetGroundVelocity( );
+		else
+			verticalVelocity += system->GetGravity( ) * dt;
+
+		m_Character->SetLinearVelocity( JPH::Vec3( m_VelocityX.load( std::memory_order_relaxed ), verticalVelocity.GetY( ), m_VelocityZ.load( std::memory_order_relaxed ) ) );
+
+		JPH::CharacterVirtual::ExtendedUpdateSettings updateSettings;
+
+		m_Character->ExtendedUpdate( dt, system->GetGravity( ), updateSettings,
+			system->GetDefaultBroadPhaseLayerFilter( EPhysicsObjectLayers::MOVING ),
+			system->GetDefaultLayerFilter( EPhysicsObjectLayers::MOVING ),
+			JPH::BodyFilter( ), JPH::ShapeFilter( ), m_Physics.GetTempAllocator( ) );
+	}
+
+	PhysicsTransform CharacterController::GetSimulatedTransform( ) const
+	{
+		const JPH::RVec3 position = m_Character->GetPosition( );
+		const JPH::Quat rotation = m_Character->GetRotation( );
+
+		return { glm::vec3( position.GetX( ), position.GetY( ), position.GetZ( ) ), glm::quat( rotation.GetW( ), rotation.GetX( ), rotation.GetY( ), rotation.GetZ( ) ) };
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "Collision.hpp"
+
+namespace Engine::Core {
+	// Kinematic capsule moved through the physics world with JPH::CharacterVirtual. Slides along walls, walks up stairs
+	// and slopes, and sticks to the ground. The position is at the feet.
+	// Simulated by Physics::Step on the physics thread, the render thread only sets the velocity and reads the published state.
+	class CharacterController {
+	public:
+		CharacterController( Physics& physics, const glm::vec3& position, float height = 1.8f, float radius = 0.3f );
+		~CharacterController( );
+
+		// Horizontal velocity in world space, used from the next physics step on. Gravity is applied while airborne.
+		void SetVelocity( const glm::vec3& velocity );
+
+		// Interpolated between the last two physics steps, see Physics::BeginFrame.
+		glm::vec3 GetPosition( ) const { return m_Physics.GetTransform( m_Slot ).m_Position; }
+		bool IsGrounded( ) const { return m_Physics.IsGrounded( m_Slot ); }
+	private:
+		friend class Physics;
+
+		// Physics thread.
+		void Update( float dt );
+		PhysicsTransform GetSimulatedTransform( ) const;
+
+		Physics& m_Physics;
+		JPH::Ref<JPH::CharacterVirtual> m_Character = nullptr;
+		uint32_t m_Slot{};
+
+		std::atomic<float> m_VelocityX{}, m_VelocityZ{};
+
+		float m_MaxSlopeAngle = glm::radians( 45.f );
+	};
+}
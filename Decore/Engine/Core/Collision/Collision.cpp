@@ -1,10 +1,27 @@
 #include "Collision.hpp"
+#include "CharacterController.hpp"
 #include <cstdarg>
 #include <iostream>
+#include <fstream>
+#include <chrono>
 namespace Engine::Core
 {
 	constexpr const JPH::uint MAX_RIGIDBODIES = 65536;
 
+	// Static mesh cache header, followed by the shape saved with SaveWithChildren.
+	constexpr const uint32_t MESH_CACHE_MAGIC = 0x4853454D; // "MESH"
+	constexpr const uint32_t MESH_CACHE_VERSION = 1;
+
+	// Steps run per wake up at most, the simulation falls behind real time instead of spiralling when steps get expensive.
+	constexpr const uint32_t MAX_CATCH_UP_STEPS = 4;
+
+	using SteadyClock = std::chrono::steady_clock;
+
+	static double GetClockSeconds( )
+	{
+		return std::chrono::duration<double>( SteadyClock::now( ).time_since_epoch( ) ).count( );
+	}
+
 	static void TraceImpl( const char* inFMT, ... )
 	{
 		va_list list;
@@ -16,6 +33,56 @@ namespace Engine::Core
 		std::cout << buffer << std::endl;
 	}
 
+	PhysicsJobSystem::PhysicsJobSystem( Core::JobSystem& jobs, JPH::uint maxBarriers ) : JPH::JobSystemWithBarrier( maxBarriers ), m_Jobs( jobs )
+	{
+	}
+
+	int PhysicsJobSystem::GetMaxConcurrency( ) const
+	{
+		// Workers plus the thread that waits on the barrier, it runs jobs too.
+		return static_cast< int >( m_Jobs.GetWorkerCount( ) ) + 1;
+	}
+
+	JPH::JobSystem::JobHandle PhysicsJobSystem::CreateJob( const char* inName, JPH::ColorArg inColor, const JobFunction& inJobFunction, JPH::uint32 inNumDependencies )
+	{
+		Job* job = new Job( inName, inColor, this, inJobFunction, inNumDependencies );
+		JobHandle handle( job );
+
+		// Jobs with dependencies are queued by the last dependency that finishes.
+		if ( inNumDependencies == 0 )
+			QueueJob( job );
+
+		return handle;
+	}
+
+	void PhysicsJobSystem::QueueJob( Job* inJob )
+	{
+		// Held until it ran, a barrier may execute it first, Execute then does nothing.
+		inJob->AddRef( );
+
+		m_Jobs.Run( [ inJob ]( )
+		{
+			inJob->Execute( );
+			inJob->Release( );
+		} );
+	}
+
+	void PhysicsJobSystem::QueueJobs( Job** inJobs, JPH::uint inNumJobs )
+	{
+		for ( JPH::uint i = 0; i < inNumJobs; i++ )
+			QueueJob( inJobs[ i ] );
+	}
+
+	void PhysicsJobSystem::FreeJob( Job* inJob )
+	{
+		delete inJob;
+	}
+
+	Physics::~Physics( )
+	{
+		Stop( );
+	}
+
 	void Physics::Initialize( )
 	{
 		JPH::RegisterDefaultAllocator( );
@@ -28,13 +95,308 @@ namespace Engine::Core
 		m_PhysicsSystem->Init( MAX_RIGIDBODIES, 0, MAX_RIGIDBODIES, 10240, m_BroadPhaseLayers, m_ObjectVsBroadPhaseFilter, m_ObjectLayerPairFilter );
 
 		m_TempAllocator = std::make_unique<JPH::TempAllocatorImpl>( 100 * 1024 * 1024 );
-		m_JobSystem = std::make_unique<JPH::JobSystemThreadPool>( JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, std::thread::hardware_concurrency( ) - 1 );
+
+		if ( JobSystem* jobs = JobSystem::Get( ) )
+			m_JobSystem = std::make_unique<PhysicsJobSystem>( *jobs, JPH::cMaxPhysicsBarriers );
+		else
+			m_JobSystem = std::make_unique<JPH::JobSystemThreadPool>( JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, std::thread::hardware_concurrency( ) - 1 );
 
 		printf( "Initialized Jolt\n" );
 	}
 
+	void Physics::Start( uint32_t stepRate )
+	{
+		if ( m_Thread.joinable( ) || stepRate == 0 )
+			return;
+
+		m_Quit = false;
+		m_Thread = std::thread( &Physics::ThreadLoop, this, 1.f / stepRate );
+	}
+
+	void Physics::Stop( )
+	{
+		if ( !m_Thread.joinable( ) )
+			return;
+
+		m_Quit = true;
+		m_Thread.join( );
+	}
+
+	void Physics::ThreadLoop( float stepTime )
+	{
+		const auto step = std::chrono::duration_cast<SteadyClock::duration>( std::chrono::duration<double>( stepTime ) );
+
+		auto previous = SteadyClock::now( );
+		SteadyClock::duration accumulator{};
+
+		while ( !m_Quit.load( std::memory_order_relaxed ) )
+		{
+			const auto now = SteadyClock::now( );
+			accumulator = std::min( accumulator + ( now - previous ), step * MAX_CATCH_UP_STEPS );
+			previous = now;
+
+			// Always the same dt, the simulation does not depend on the frame rate.
+			while ( accumulator >= step )
+			{
+				Step( stepTime );
+				accumulator -= step;
+			}
+
+			std::this_thread::sleep_until( now + ( step - accumulator ) );
+		}
+	}
+
 	void Physics::Step( float dt )
 	{
+		JPH::BodyInterface& bodyInterface = m_PhysicsSystem->GetBodyInterface( );
+		bool addedBodies = false;
+
+		// Characters can't be destroyed while they are stepped, see RemoveCharacter.
+		std::lock_guard stepLock( m_StepMutex );
+
+		std::vector<JPH::ShapeRefC> readyShapes{};
+		std::vector<CharacterController*> characters{};
+
+		// Only the hand off is locked, the render thread never waits for the simulation itself.
+		{
+			std::lock_guard lock( m_Mutex );
+
+			for ( auto it = m_PendingMeshes.begin( ); it != m_PendingMeshes.end( ); )
+			{
+				if ( it->wait_for( std::chrono::seconds( 0 ) ) != std::future_status::ready )
+				{
+					it++;
+					continue;
+				}
+
+				readyShapes.push_back( it->get( ) );
+				it = m_PendingMeshes.erase( it );
+			}
+
+			characters = m_Characters;
+		}
+
+		for ( const auto& shape : readyShapes )
+		{
+			m_LoadingMeshes--;
+
+			if ( !shape )
+				continue;
+
+			JPH::BodyCreationSettings settings( shape, JPH::RVec3::sZero( ), JPH::Quat::sIdentity( ), JPH::EMotionType::Static, EPhysicsObjectLayers::NON_MOVING );
+			if ( bodyInterface.CreateAndAddBody( settings, JPH::EActivation::DontActivate ).IsInvalid( ) )
+			{
+				printf( "Failed to add static mesh body\n" );
+				continue;
+			}
+
+			addedBodies = true;
+		}
+
+		// Static bodies are added once in bulk, rebuild the broad phase tree instead of leaving them in the dynamic one.
+		if ( addedBodies )
+			m_PhysicsSystem->OptimizeBroadPhase( );
+
+		// Characters wait for the world, they would fall through it otherwise.
+		if ( m_LoadingMeshes == 0 )
+		{
+			for ( auto* character : characters )
+			{
+				if ( character )
+					character->Update( dt );
+			}
+		}
+
+		m_PhysicsSystem->Update( dt, 1, m_TempAllocator.get( ), m_JobSystem.get( ) );
+
+		Publish( dt, characters );
+	}
+
+	void Physics::Publish( float dt, const std::vector<CharacterController*>& characters )
+	{
+		const size_t trackedSlots = m_States.size( );
+		m_States.resize( characters.size( ) );
+
+		for ( size_t slot = 0; slot < characters.size( ); slot++ )
+		{
+			if ( !characters[ slot ] )
+				continue;
+
+			// New slots start at rest where they are, not blending in from the origin.
+			auto& state = m_States[ slot ];
+			const PhysicsTransform transform = characters[ slot ]->GetSimulatedTransform( );
+
+			state.m_Previous = slot < trackedSlots ? state.m_Current : transform;
+			state.m_Current = transform;
+			state.m_Grounded = characters[ slot ]->m_Character->GetGroundState( ) == JPH::CharacterVirtual::EGroundState::OnGround;
+		}
+
+		Snapshot& snapshot = m_Snapshots[ m_WriteIndex ];
+		snapshot.m_States = m_States;
+		snapshot.m_Time = GetClockSeconds( );
+		snapshot.m_StepTime = dt;
+
+		m_WriteIndex = m_SharedIndex.exchange( m_WriteIndex | SNAPSHOT_FRESH, std::memory_order_acq_rel ) & ~SNAPSHOT_FRESH;
+	}
+
+	void Physics::BeginFrame( )
+	{
+		if ( m_SharedIndex.load( std::memory_order_relaxed ) & SNAPSHOT_FRESH )
+			m_ReadIndex = m_SharedIndex.exchange( m_ReadIndex, std::memory_order_acq_rel ) & ~SNAPSHOT_FRESH;
+
+		// Rendering runs one step behind the simulation, blending into the newest step over the step time after it was published.
+		const Snapshot& snapshot = m_Snapshots[ m_ReadIndex ];
+		m_Alpha = snapshot.m_StepTime > 0.f ? glm::clamp( static_cast< float >( ( GetClockSeconds( ) - snapshot.m_Time ) / snapshot.m_StepTime ), 0.f, 1.f ) : 1.f;
+	}
+
+	PhysicsTransform Physics::GetTransform( uint32_t slot ) const
+	{
+		const Snapshot& snapshot = m_Snapshots[ m_ReadIndex ];
+
+		// Added after the newest published step, it is still where it was created.
+		if ( slot >= snapshot.m_States.size( ) )
+		{
+			std::lock_guard lock( m_Mutex );
+			return slot < m_Characters.size( ) && m_Characters[ slot ] ? m_Characters[ slot ]->GetSimulatedTransform( ) : PhysicsTransform{};
+		}
+
+		const TrackedState& state = snapshot.m_States[ slot ];
+		return { glm::mix( state.m_Previous.m_Position, state.m_Current.m_Position, m_Alpha ), glm::slerp( state.m_Previous.m_Rotation, state.m_Current.m_Rotation, m_Alpha ) };
+	}
+
+	bool Physics::IsGrounded( uint32_t slot ) const
+	{
+		const Snapshot& snapshot = m_Snapshots[ m_ReadIndex ];
+		return slot < snapshot.m_States.size( ) && snapshot.m_States[ slot ].m_Grounded;
+	}
+
+	uint32_t Physics::AddCharacter( CharacterController* character )
+	{
+		std::lock_guard lock( m_Mutex );
+
+		m_Characters.push_back( character );
+		return static_cast< uint32_t >( m_Characters.size( ) - 1 );
+	}
+
+	void Physics::RemoveCharacter( uint32_t slot )
+	{
+		// Waits for a step in progress, it may still be moving the character.
+		std::lock_guard stepLock( m_StepMutex );
+		std::lock_guard lock( m_Mutex );
+		m_Characters[ slot ] = nullptr;
+	}
+
+	void Physics::AddStaticMesh( std::vector<glm::vec3> positions, std::vector<uint32_t> indices, const std::string& cachePath )
+	{
+		if ( positions.empty( ) || indices.size( ) < 3 )
+			return;
+
+		std::lock_guard lock( m_Mutex );
+
+		m_LoadingMeshes++;
+		m_PendingMeshes.push_back( std::async( std::launch::async, [ positions = std::move( positions ), indices = std::move( indices ), cachePath ]( )
+		{
+			return BuildStaticMesh( positions, indices, cachePath );
+		} ) );
+	}
+
+	static uint64_t HashGeometry( const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices )
+	{
+		// FNV-1a over the raw geometry, a cache is only reused for identical input.
+		uint64_t hash = 14695981039346656037ull;
+
+		const auto hashBytes = [ &hash ]( const void* data, size_t size )
+		{
+			const auto* bytes = static_cast< const uint8_t* >( data );
+			for ( size_t i = 0; i < size; i++ )
+				hash = ( hash ^ bytes[ i ] ) * 1099511628211ull;
+		};
+
+		hashBytes( positions.data( ), positions.size( ) * sizeof( glm::vec3 ) );
+		hashBytes( indices.data( ), indices.size( ) * sizeof( uint32_t ) );
+
+		return hash;
+	}
+
+	JPH::ShapeRefC Physics::BuildStaticMesh( const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const std::string& cachePath )
+	{
+		const uint64_t hash = HashGeometry( positions, indices );
+
+		if ( !cachePath.empty( ) )
+		{
+			std::ifstream file( cachePath, std::ios::binary );
+
+			if ( file.is_open( ) )
+			{
+				JPH::StreamInWrapper stream( file );
+
+				uint32_t magic = 0, version = 0;
+				uint64_t cachedHash = 0;
+				stream.Read( magic );
+				stream.Read( version );
+				stream.Read( cachedHash );
+
+				if ( !stream.IsFailed( ) && magic == MESH_CACHE_MAGIC && version == MESH_CACHE_VERSION && cachedHash == hash )
+				{
+					JPH::Shape::IDToShapeMap shapeMap;
+					JPH::Shape::IDToMaterialMap materialMap;
+					const JPH::Shape::ShapeResult result = JPH::Shape::sRestoreWithChildren( stream, shapeMap, materialMap );
+
+					if ( result.IsValid( ) )
+					{
+						printf( "Loaded static mesh from %s\n", cachePath.c_str( ) );
+						return result.Get( );
+					}
+				}
+
+				printf( "Static mesh cache %s is stale, rebuilding\n", cachePath.c_str( ) );
+			}
+		}
+
+		JPH::VertexList vertices;
+		vertices.reserve( positions.size( ) );
+		for ( const glm::vec3& position : positions )
+			vertices.push_back( JPH::Float3( position.x, position.y, position.z ) );
+
+		JPH::IndexedTriangleList triangles;
+		triangles.reserve( indices.size( ) / 3 );
+		for ( size_t i = 0; i + 2 < indices.size( ); i += 3 )
+			triangles.push_back( JPH::IndexedTriangle( indices[ i ], indices[ i + 1 ], indices[ i + 2 ] ) );
+
+		const auto start = std::chrono::high_resolution_clock::now( );
+
+		JPH::MeshShapeSettings settings( std::move( vertices ), std::move( triangles ) );
+		const JPH::ShapeSettings::ShapeResult result = settings.Create( );
+
+		if ( result.HasError( ) )
+		{
+			printf( "Failed to build static mesh: %s\n", result.GetError( ).c_str( ) );
+			return nullptr;
+		}
+
+		const auto elapsed = std::chrono::duration<float, std::milli>( std::chrono::high_resolution_clock::now( ) - start ).count( );
+		printf( "Built static mesh with %zu triangles in %.1f ms\n", indices.size( ) / 3, elapsed );
+
+		if ( !cachePath.empty( ) )
+		{
+			std::ofstream file( cachePath, std::ios::binary | std::ios::trunc );
+
+			if ( file.is_open( ) )
+			{
+				JPH::StreamOutWrapper stream( file );
+				stream.Write( MESH_CACHE_MAGIC );
+				stream.Write( MESH_CACHE_VERSION );
+				stream.Write( hash );
+
+				JPH::Shape::ShapeToIDMap shapeMap;
+				JPH::Shape::MaterialToIDMap materialMap;
+				result.Get( )->SaveWithChildren( stream, shapeMap, materialMap );
+
+				if ( stream.IsFailed( ) )
+					printf( "Failed to write static mesh cache %s\n", cachePath.c_str( ) );
+			}
+		}
 
+		return result.Get( );
 	}
 }
\ No newline at end of file
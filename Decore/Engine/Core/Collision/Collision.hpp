@@ -1,8 +1,18 @@
 #pragma once
 #include "CollisionBox.hpp"
 #include "CollisionCapsule.hpp"
+#include "CollisionRay.hpp"
 #include "CollisionSphere.hpp"
+#include "../Jobs/JobSystem.hpp"
 #include <array>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtc/quaternion.hpp>
 // Jolt Physics.
 #include <Jolt/Jolt.h>
 #include <Jolt/Physics/PhysicsSystem.h>
@@ -12,6 +22,7 @@
 #include <Jolt/Physics/Collision/RayCast.h>
 #include <Jolt/Physics/Collision/CastResult.h>
 #include <Jolt/Core/JobSystemThreadPool.h>
+#include <Jolt/Core/JobSystemWithBarrier.h>
 #include <Jolt/ObjectStream/ObjectStreamBinaryIn.h>
 #include <Jolt/ObjectStream/ObjectStreamBinaryOut.h>
 #include <Jolt/Physics/PhysicsSettings.h>
@@ -26,6 +37,9 @@
 #include <Jolt/Physics/SoftBody/SoftBodyShape.h>
 #include <Jolt/Physics/SoftBody/SoftBodyCreationSettings.h>
 #include <Jolt/Physics/SoftBody/SoftBodyMotionProperties.h>
+#include <Jolt/Physics/Collision/Shape/CapsuleShape.h>
+#include <Jolt/Physics/Collision/Shape/RotatedTranslatedShape.h>
+#include <Jolt/Physics/Character/CharacterVirtual.h>
 
 namespace Engine::Core
 {
@@ -107,12 +121,109 @@ namespace Engine::Core
 	};
 
 
+	// Runs Jolt's jobs on the engine job system, physics shares its workers instead of starting a pool of its own.
+	class PhysicsJobSystem : public JPH::JobSystemWithBarrier {
+	public:
+		PhysicsJobSystem( Core::JobSystem& jobs, JPH::uint maxBarriers );
+
+		virtual int GetMaxConcurrency( ) const override;
+		virtual JobHandle CreateJob( const char* inName, JPH::ColorArg inColor, const JobFunction& inJobFunction, JPH::uint32 inNumDependencies = 0 ) override;
+	protected:
+		virtual void QueueJob( Job* inJob ) override;
+		virtual void QueueJobs( Job** inJobs, JPH::uint inNumJobs ) override;
+		virtual void FreeJob( Job* inJob ) override;
+	private:
+		Core::JobSystem& m_Jobs;
+	};
+
+	class CharacterController;
+
+	// Pose of a simulated object as seen by the render thread, see Physics::GetTransform.
+	struct PhysicsTransform {
+		glm::vec3 m_Position{};
+		glm::quat m_Rotation{ 1.f, 0.f, 0.f, 0.f };
+	};
+
 	class Physics {
 	public:
+		~Physics( );
+
 		void Initialize( );
 
+		// Runs Step at a fixed rate on a dedicated thread until Stop, catching up on missed steps with an accumulator.
+		// Step must not be called directly while the thread runs.
+		void Start( uint32_t stepRate = 60 );
+		void Stop( );
+
+		// One fixed step: adds the static meshes that finished building, moves the characters, updates the
+		// simulation and publishes the new transforms.
 		void Step( float dt );
+
+		// World space triangles registered as a NON_MOVING MeshShape body. The shape is built on a background thread,
+		// or restored from cachePath when it holds the same geometry. The body is added by the first Step after it is ready.
+		void AddStaticMesh( std::vector<glm::vec3> positions, std::vector<uint32_t> indices, const std::string& cachePath = "" );
+
+		// Static meshes that are not in the world yet, characters hold still until it is zero.
+		uint32_t GetLoadingMeshCount( ) const { return m_LoadingMeshes.load( std::memory_order_relaxed ); }
+
+		// Render thread, once per frame: picks up the newest published step and the interpolation factor between it and the step before.
+		void BeginFrame( );
+
+		// Transform of a tracked slot interpolated for the current frame, valid after BeginFrame.
+		PhysicsTransform GetTransform( uint32_t slot ) const;
+		bool IsGrounded( uint32_t slot ) const;
+
+		JPH::PhysicsSystem* GetSystem( ) { return m_PhysicsSystem.get( ); }
+		JPH::TempAllocator& GetTempAllocator( ) { return *m_TempAllocator; }
 	private:
+		friend class CharacterController;
+
+		static JPH::ShapeRefC BuildStaticMesh( const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const std::string& cachePath );
+
+		// Returns the tracked slot of the character.
+		uint32_t AddCharacter( CharacterController* character );
+		void RemoveCharacter( uint32_t slot );
+
+		void ThreadLoop( float stepTime );
+		void Publish( float dt, const std::vector<CharacterController*>& characters );
+
+		// Guards m_PendingMeshes and m_Characters, Step only holds it to take them over, never during the simulation.
+		mutable std::mutex m_Mutex{};
+		// Held by Step for the whole step, RemoveCharacter waits on it before the character goes away.
+		std::mutex m_StepMutex{};
+		std::vector<std::future<JPH::ShapeRefC>> m_PendingMeshes{};
+		std::atomic<uint32_t> m_LoadingMeshes{};
+
+		// Indexed by tracked slot, null once removed.
+		std::vector<CharacterController*> m_Characters{};
+
+		struct TrackedState {
+			PhysicsTransform m_Previous{}, m_Current{};
+			bool m_Grounded{};
+		};
+
+		struct Snapshot {
+			std::vector<TrackedState> m_States{};
+			double m_Time{};	// When the step was published, in steady clock seconds.
+			float m_StepTime{};
+		};
+
+		// Latest two states of every slot, owned by the stepping thread.
+		std::vector<TrackedState> m_States{};
+
+		// Lock free hand off: the stepping thread fills m_Snapshots[ m_WriteIndex ] and swaps it into m_SharedIndex,
+		// BeginFrame swaps m_ReadIndex back out when the shared snapshot is flagged fresh.
+		static constexpr uint32_t SNAPSHOT_FRESH = 4;
+
+		std::array<Snapshot, 3> m_Snapshots{};
+		std::atomic<uint32_t> m_SharedIndex{ 1 };
+		uint32_t m_WriteIndex = 0;
+		uint32_t m_ReadIndex = 2;
+		float m_Alpha = 1.f;
+
+		std::thread m_Thread{};
+		std::atomic<bool> m_Quit{};
+
 		std::unique_ptr<JPH::PhysicsSystem> m_PhysicsSystem = nullptr;
 		std::unique_ptr<JPH::JobSystem> m_JobSystem = nullptr;
 		std::unique_ptr<JPH::TempAllocator> m_TempAllocator = nullptr;
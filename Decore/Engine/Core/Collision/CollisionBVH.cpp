@@ -0,0 +1,236 @@
+#include "CollisionBVH.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace Engine::Core
+{
+	constexpr uint32_t SAH_BIN_COUNT = 12;
+
+	struct CollisionBVH::BuildNode {
+		CollisionBox m_Bounds{};
+
+		uint32_t m_Left{}, m_Right{};
+
+		// Items of a leaf, zero for inner nodes.
+		uint32_t m_First{}, m_Count{};
+	};
+
+	static CollisionBox EmptyBox( )
+	{
+		return CollisionBox( glm::vec3( std::numeric_limits<float>::max( ) ), glm::vec3( -std::numeric_limits<float>::max( ) ) );
+	}
+
+	static float SurfaceArea( const CollisionBox& box )
+	{
+		const glm::vec3 d = glm::max( box.m_Maxs - box.m_Mins, glm::vec3( 0.f ) );
+		return 2.f * ( d.x * d.y + d.y * d.z + d.z * d.x );
+	}
+
+	void CollisionBVH::Build( const std::vector<CollisionBox>& bounds )
+	{
+		Clear( );
+
+		if ( bounds.empty( ) )
+			return;
+
+		std::vector<glm::vec3> centroids( bounds.size( ) );
+		m_Items.resize( bounds.size( ) );
+
+		for ( uint32_t i = 0; i < bounds.size( ); i++ )
+		{
+			centroids[ i ] = ( bounds[ i ].m_Mins + bounds[ i ].m_Maxs ) * 0.5f;
+			m_Items[ i ] = i;
+		}
+
+		std::vector<BuildNode> nodes{};
+		nodes.reserve( bounds.size( ) * 2 / MAX_LEAF_SIZE + 1 );
+
+		BuildRecursive( nodes, bounds, centroids, 0, static_cast< uint32_t >( bounds.size( ) ), 0 );
+		Collapse( nodes, 0 );
+	}
+
+	void CollisionBVH::Clear( )
+	{
+		m_Nodes.clear( );
+		m_Items.clear( );
+	}
+
+	uint32_t CollisionBVH::BuildRecursive( std::vector<BuildNode>& nodes, const std::vector<CollisionBox>& bounds, const std::vector<glm::vec3>& centroids, uint32_t first, uint32_t count, uint32_t depth )
+	{
+		const uint32_t index = static_cast< uint32_t >( nodes.size( ) );
+		nodes.emplace_back( );
+
+		CollisionBox nodeBounds = EmptyBox( ), centroidBounds = EmptyBox( );
+
+		for ( uint32_t i = first; i < first + count; i++ )
+		{
+			nodeBounds = CollisionBox::Merge( nodeBounds, bounds[ m_Items[ i ] ] );
+			centroidBounds = CollisionBox::Merge( centroidBounds, CollisionBox( centroids[ m_Items[ i ] ], centroids[ m_Items[ i ] ] ) );
+		}
+
+		nodes[ index ].m_Bounds = nodeBounds;
+
+		if ( count <= MAX_LEAF_SIZE )
+		{
+			nodes[ index ].m_First = first;
+			nodes[ index ].m_Count = count;
+			return index;
+		}
+
+		const glm::vec3 extent = centroidBounds.m_Maxs - centroidBounds.m_Mins;
+		const int axis = extent.x > extent.y ? ( extent.x > extent.z ? 0 : 2 ) : ( extent.y > extent.z ? 1 : 2 );
+
+		uint32_t* begin = m_Items.data( ) + first;
+		uint32_t* end = begin + count;
+		uint32_t mid = first;
+
+		if ( extent[ axis ] > 0.f && depth < MAX_DEPTH )
+		{
+			struct Bin {
+				CollisionBox m_Bounds = EmptyBox( );
+				uint32_t m_Count{};
+			};
+
+			std::array<Bin, SAH_BIN_COUNT> bins{};
+			const float scale = SAH_BIN_COUNT / extent[ axis ];
+
+			const auto binOf = [ & ]( uint32_t item )
+			{
+				return std::min( SAH_BIN_COUNT - 1, static_cast< uint32_t >( ( centroids[ item ][ axis ] - centroidBounds.m_Mins[ axis ] ) * scale ) );
+			};
+
+			for ( auto* item = begin; item != end; item++ )
+			{
+				Bin& bin = bins[ binOf( *item ) ];
+				bin.m_Bounds = CollisionBox::Merge( bin.m_Bounds, bounds[ *item ] );
+				bin.m_Count++;
+			}
+
+			// Cost of everything right of each split plane, then sweep from the left.
+			std::array<float, SAH_BIN_COUNT - 1> rightCosts{};
+			CollisionBox right = EmptyBox( );
+			uint32_t rightCount = 0;
+
+			for ( uint32_t b = SAH_BIN_COUNT - 1; b > 0; b-- )
+			{
+				right = CollisionBox::Merge( right, bins[ b ].m_Bounds );
+				rightCount += bins[ b ].m_Count;
+				rightCosts[ b - 1 ] = rightCount > 0 ? rightCount * SurfaceArea( right ) : 0.f;
+			}
+
+			CollisionBox left = EmptyBox( );
+			uint32_t leftCount = 0, bestBin = 0;
+			float bestCost = std::numeric_limits<float>::max( );
+
+			for ( uint32_t b = 0; b < SAH_BIN_COUNT - 1; b++ )
+			{
+				left = CollisionBox::Merge( left, bins[ b ].m_Bounds );
+				leftCount += bins[ b ].m_Count;
+
+				if ( leftCount == 0 || leftCount == count )
+					continue;
+
+				const float cost = leftCount * SurfaceArea( left ) + rightCosts[ b ];
+				if ( cost < bestCost )
+				{
+					bestCost = cost;
+					bestBin = b;
+				}
+			}
+
+			if ( bestCost < std::numeric_limits<float>::max( ) )
+				mid = static_cast< uint32_t >( std::partition( begin, end, [ & ]( uint32_t item ) { return binOf( item ) <= bestBin; } ) - m_Items.data( ) );
+		}
+
+		// Coincident centroids or too deep, split at the median instead.
+		if ( mid == first || mid == first + count )
+		{
+			mid = first + count / 2;
+			std::nth_element( begin, m_Items.data( ) + mid, end, [ & ]( uint32_t a, uint32_t b ) { return centroids[ a ][ axis ] < centroids[ b ][ axis ]; } );
+		}
+
+		const uint32_t leftChild = BuildRecursive( nodes, bounds, centroids, first, mid - first, depth + 1 );
+		const uint32_t rightChild = BuildRecursive( nodes, bounds, centroids, mid, first + count - mid, depth + 1 );
+
+		nodes[ index ].m_Left = leftChild;
+		nodes[ index ].m_Right = rightChild;
+
+		return index;
+	}
+
+	uint32_t CollisionBVH::Collapse( const std::vector<BuildNode>& nodes, uint32_t index )
+	{
+		const uint32_t nodeIndex = static_cast< uint32_t >( m_Nodes.size( ) );
+		m_Nodes.emplace_back( );
+
+		// Pull grandchildren up by opening the largest inner child until the node is full.
+		std::array<uint32_t, 4> children{};
+		uint32_t childCount = 0;
+
+		if ( nodes[ index ].m_Count > 0 )
+			children[ childCount++ ] = index;
+		else
+		{
+			children[ childCount++ ] = nodes[ index ].m_Left;
+			children[ childCount++ ] = nodes[ index ].m_Right;
+		}
+
+		while ( childCount < 4 )
+		{
+			int largest = -1;
+			float largestArea = -1.f;
+
+			for ( uint32_t c = 0; c < childCount; c++ )
+			{
+				const BuildNode& child = nodes[ children[ c ] ];
+				if ( child.m_Count == 0 && SurfaceArea( child.m_Bounds ) > largestArea )
+				{
+					largest = static_cast< int >( c );
+					largestArea = SurfaceArea( child.m_Bounds );
+				}
+			}
+
+			if ( largest < 0 )
+				break;
+
+			const BuildNode& opened = nodes[ children[ largest ] ];
+			children[ largest ] = opened.m_Left;
+			children[ childCount++ ] = opened.m_Right;
+		}
+
+		Node node{};
+
+		for ( uint32_t c = 0; c < 4; c++ )
+		{
+			const CollisionBox box = c < childCount ? nodes[ children[ c ] ].m_Bounds : EmptyBox( );
+
+			node.m_MinX[ c ] = box.m_Mins.x;
+			node.m_MinY[ c ] = box.m_Mins.y;
+			node.m_MinZ[ c ] = box.m_Mins.z;
+			node.m_MaxX[ c ] = box.m_Maxs.x;
+			node.m_MaxY[ c ] = box.m_Maxs.y;
+			node.m_MaxZ[ c ] = box.m_Maxs.z;
+
+			if ( c >= childCount )
+				continue;
+
+			const BuildNode& child = nodes[ children[ c ] ];
+
+			if ( child.m_Count > 0 )
+			{
+				node.m_Children[ c ] = child.m_First;
+				node.m_Counts[ c ] = child.m_Count;
+			}
+			else
+			{
+				node.m_Children[ c ] = Collapse( nodes, children[ c ] );
+				node.m_Counts[ c ] = 0;
+			}
+		}
+
+		m_Nodes[ nodeIndex ] = node;
+
+		return nodeIndex;
+	}
+}
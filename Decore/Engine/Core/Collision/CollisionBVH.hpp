@@ -0,0 +1,153 @@
+#pragma once
+#include "CollisionBox.hpp"
+
+#include <vector>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <xmmintrin.h>
+
+namespace Engine::Core {
+	// Bounding volume hierarchy over a set of boxes, built once with binned SAH and collapsed to 4 children per node.
+	// Traversal tests the four child boxes of a node at once with SSE.
+	class CollisionBVH {
+	public:
+		// Items per leaf, a node child references at most this many.
+		static constexpr uint32_t MAX_LEAF_SIZE = 4;
+
+		void Build( const std::vector<CollisionBox>& bounds );
+		void Clear( );
+
+		// Calls visitor( itemIndex ) for every item of the leaves overlapping the query, stops as soon as it returns true.
+		// Leaves are only tested as a whole, the visitor does the exact test. Returns whether the visitor stopped the query.
+		template<typename Visitor>
+		bool Query( const CollisionBox& box, Visitor&& visitor ) const
+		{
+			if ( m_Nodes.empty( ) )
+				return false;
+
+			const __m128 minX = _mm_set1_ps( box.m_Mins.x ), minY = _mm_set1_ps( box.m_Mins.y ), minZ = _mm_set1_ps( box.m_Mins.z );
+			const __m128 maxX = _mm_set1_ps( box.m_Maxs.x ), maxY = _mm_set1_ps( box.m_Maxs.y ), maxZ = _mm_set1_ps( box.m_Maxs.z );
+
+			std::array<uint32_t, MAX_STACK_SIZE> stack;
+			uint32_t stackSize = 0;
+			stack[ stackSize++ ] = 0;
+
+			while ( stackSize > 0 )
+			{
+				const Node& node = m_Nodes[ stack[ --stackSize ] ];
+
+				__m128 overlap = _mm_and_ps( _mm_cmple_ps( _mm_load_ps( node.m_MinX ), maxX ), _mm_cmpge_ps( _mm_load_ps( node.m_MaxX ), minX ) );
+				overlap = _mm_and_ps( overlap, _mm_and_ps( _mm_cmple_ps( _mm_load_ps( node.m_MinY ), maxY ), _mm_cmpge_ps( _mm_load_ps( node.m_MaxY ), minY ) ) );
+				overlap = _mm_and_ps( overlap, _mm_and_ps( _mm_cmple_ps( _mm_load_ps( node.m_MinZ ), maxZ ), _mm_cmpge_ps( _mm_load_ps( node.m_MaxZ ), minZ ) ) );
+
+				// Empty children have inverted bounds and never overlap.
+				for ( uint32_t mask = static_cast< uint32_t >( _mm_movemask_ps( overlap ) ); mask != 0; mask &= mask - 1 )
+				{
+					const int child = std::countr_zero( mask );
+
+					if ( node.m_Counts[ child ] == 0 )
+					{
+						stack[ stackSize++ ] = node.m_Children[ child ];
+						continue;
+					}
+
+					for ( uint32_t i = 0; i < node.m_Counts[ child ]; i++ )
+					{
+						if ( visitor( m_Items[ node.m_Children[ child ] + i ] ) )
+							return true;
+					}
+				}
+			}
+
+			return false;
+		}
+
+		// Calls visitor( itemIndex ) for every item of the leaves the ray passes through within maxDistance, stops as soon as it returns true.
+		// The visitor may shorten maxDistance on a hit, the remaining nodes are culled against it. Returns whether the visitor stopped the query.
+		template<typename Visitor>
+		bool Raycast( const glm::vec3& origin, const glm::vec3& direction, float& maxDistance, Visitor&& visitor ) const
+		{
+			if ( m_Nodes.empty( ) )
+				return false;
+
+			// Finite reciprocals keep axis parallel rays free of NaNs.
+			const auto safeInverse = [ ]( float d ) { return 1.f / ( std::abs( d ) < 1e-8f ? std::copysign( 1e-8f, d ) : d ); };
+
+			const __m128 originX = _mm_set1_ps( origin.x ), originY = _mm_set1_ps( origin.y ), originZ = _mm_set1_ps( origin.z );
+			const __m128 invX = _mm_set1_ps( safeInverse( direction.x ) ), invY = _mm_set1_ps( safeInverse( direction.y ) ), invZ = _mm_set1_ps( safeInverse( direction.z ) );
+
+			std::array<uint32_t, MAX_STACK_SIZE> stack;
+			uint32_t stackSize = 0;
+			stack[ stackSize++ ] = 0;
+
+			while ( stackSize > 0 )
+			{
+				const Node& node = m_Nodes[ stack[ --stackSize ] ];
+
+				const __m128 minX = _mm_load_ps( node.m_MinX ), minY = _mm_load_ps( node.m_MinY ), minZ = _mm_load_ps( node.m_MinZ );
+				const __m128 maxX = _mm_load_ps( node.m_MaxX ), maxY = _mm_load_ps( node.m_MaxY ), maxZ = _mm_load_ps( node.m_MaxZ );
+
+				const __m128 x0 = _mm_mul_ps( _mm_sub_ps( minX, originX ), invX ), x1 = _mm_mul_ps( _mm_sub_ps( maxX, originX ), invX );
+				const __m128 y0 = _mm_mul_ps( _mm_sub_ps( minY, originY ), invY ), y1 = _mm_mul_ps( _mm_sub_ps( maxY, originY ), invY );
+				const __m128 z0 = _mm_mul_ps( _mm_sub_ps( minZ, originZ ), invZ ), z1 = _mm_mul_ps( _mm_sub_ps( maxZ, originZ ), invZ );
+
+				__m128 tMin = _mm_max_ps( _mm_max_ps( _mm_min_ps( x0, x1 ), _mm_min_ps( y0, y1 ) ), _mm_max_ps( _mm_min_ps( z0, z1 ), _mm_setzero_ps( ) ) );
+				__m128 tMax = _mm_min_ps( _mm_min_ps( _mm_max_ps( x0, x1 ), _mm_max_ps( y0, y1 ) ), _mm_min_ps( _mm_max_ps( z0, z1 ), _mm_set1_ps( maxDistance ) ) );
+
+				// Empty children have inverted bounds, the slabs alone would accept them.
+				const __m128 valid = _mm_cmple_ps( minX, maxX );
+
+				for ( uint32_t mask = static_cast< uint32_t >( _mm_movemask_ps( _mm_and_ps( _mm_cmple_ps( tMin, tMax ), valid ) ) ); mask != 0; mask &= mask - 1 )
+				{
+					const int child = std::countr_zero( mask );
+
+					if ( node.m_Counts[ child ] == 0 )
+					{
+						stack[ stackSize++ ] = node.m_Children[ child ];
+						continue;
+					}
+
+					for ( uint32_t i = 0; i < node.m_Counts[ child ]; i++ )
+					{
+						if ( visitor( m_Items[ node.m_Children[ child ] + i ] ) )
+							return true;
+					}
+				}
+			}
+
+			return false;
+		}
+
+		bool IsEmpty( ) const { return m_Nodes.empty( ); }
+		size_t GetNodeCount( ) const { return m_Nodes.size( ); }
+		size_t GetMemoryUsage( ) const { return m_Nodes.size( ) * sizeof( Node ) + m_Items.size( ) * sizeof( uint32_t ); }
+	private:
+		// The builder falls back to median splits past this depth, every node then pushes at most three children
+		// per level of a tree no deeper than MAX_DEPTH + 32.
+		static constexpr uint32_t MAX_DEPTH = 48;
+		static constexpr uint32_t MAX_STACK_SIZE = 256;
+
+		// Child bounds in SoA layout, one lane per child.
+		struct alignas( 16 ) Node {
+			float m_MinX[ 4 ], m_MinY[ 4 ], m_MinZ[ 4 ];
+			float m_MaxX[ 4 ], m_MaxY[ 4 ], m_MaxZ[ 4 ];
+
+			// Inner child: node index and a zero count. Leaf child: first entry in m_Items and its item count.
+			uint32_t m_Children[ 4 ];
+			uint32_t m_Counts[ 4 ];
+		};
+
+		std::vector<Node> m_Nodes{};
+
+		// Item indices, grouped by leaf.
+		std::vector<uint32_t> m_Items{};
+
+		// Binary tree built first, then collapsed into m_Nodes.
+		struct BuildNode;
+
+		uint32_t BuildRecursive( std::vector<BuildNode>& nodes, const std::vector<CollisionBox>& bounds, const std::vector<glm::vec3>& centroids, uint32_t first, uint32_t count, uint32_t depth );
+		uint32_t Collapse( const std::vector<BuildNode>& nodes, uint32_t index );
+	};
+}
@@ -21,6 +21,48 @@ namespace Engine::Core
 			( mins1.z <= maxs.z && maxs1.z >= mins.z );
 	}
 
+	bool CollisionBox::Intersects( const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2 ) const
+	{
+		const glm::vec3 center = ( m_Mins + m_Maxs ) * 0.5f;
+		const glm::vec3 extents = ( m_Maxs - m_Mins ) * 0.5f;
+
+		// Relative to the box center.
+		const glm::vec3 v0 = p0 - center, v1 = p1 - center, v2 = p2 - center;
+
+		// Box face normals.
+		const glm::vec3 triMins = glm::min( v0, glm::min( v1, v2 ) );
+		const glm::vec3 triMaxs = glm::max( v0, glm::max( v1, v2 ) );
+
+		if ( glm::any( glm::greaterThan( triMins, extents ) ) || glm::any( glm::lessThan( triMaxs, -extents ) ) )
+			return false;
+
+		const glm::vec3 edges[ 3 ] = { v1 - v0, v2 - v1, v0 - v2 };
+
+		// Triangle plane.
+		const glm::vec3 normal = glm::cross( edges[ 0 ], edges[ 1 ] );
+		if ( glm::abs( glm::dot( normal, v0 ) ) > glm::dot( extents, glm::abs( normal ) ) )
+			return false;
+
+		// Box axes crossed with the triangle edges.
+		for ( const auto& edge : edges )
+		{
+			for ( int i = 0; i < 3; i++ )
+			{
+				glm::vec3 boxAxis( 0.f );
+				boxAxis[ i ] = 1.f;
+
+				const glm::vec3 axis = glm::cross( boxAxis, edge );
+				const float d0 = glm::dot( v0, axis ), d1 = glm::dot( v1, axis ), d2 = glm::dot( v2, axis );
+				const float radius = glm::dot( extents, glm::abs( axis ) );
+
+				if ( glm::max( d0, glm::max( d1, d2 ) ) < -radius || glm::min( d0, glm::min( d1, d2 ) ) > radius )
+					return false;
+			}
+		}
+
+		return true;
+	}
+
 	glm::vec3 CollisionBox::GetClosestPoint( const glm::vec3& target )
 	{
 		glm::vec3 result = target;
@@ -37,6 +79,19 @@ namespace Engine::Core
 		return result;
 	}
 
+	CollisionBox CollisionBox::Transform( const glm::mat4& matrix ) const
+	{
+		// Center and extents, the extents grow by the absolute value of the rotation and scale.
+		const glm::vec3 center = glm::vec3( matrix * glm::vec4( ( m_Mins + m_Maxs ) * 0.5f, 1.f ) );
+		const glm::vec3 extents = ( m_Maxs - m_Mins ) * 0.5f;
+
+		glm::vec3 newExtents( 0.f );
+		for ( int i = 0; i < 3; i++ )
+			newExtents += glm::abs( glm::vec3( matrix[ i ] ) ) * extents[ i ];
+
+		return CollisionBox( center - newExtents, center + newExtents );
+	}
+
 	CollisionBox CollisionBox::Merge( const CollisionBox& b1, const CollisionBox& b2 )
 	{
 		const auto& mins = glm::min( b1.GetMins( ), b2.GetMins( ) );
@@ -45,6 +100,41 @@ namespace Engine::Core
 		return CollisionBox( mins, maxs );
 	}
 
+	glm::vec3 CollisionBox::ClosestPointOnTriangle( const glm::vec3& point, const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2 )
+	{
+		// Voronoi regions of the vertices and edges, then the face.
+		const glm::vec3 ab = p1 - p0, ac = p2 - p0, ap = point - p0;
+
+		const float d1 = glm::dot( ab, ap ), d2 = glm::dot( ac, ap );
+		if ( d1 <= 0.f && d2 <= 0.f )
+			return p0;
+
+		const glm::vec3 bp = point - p1;
+		const float d3 = glm::dot( ab, bp ), d4 = glm::dot( ac, bp );
+		if ( d3 >= 0.f && d4 <= d3 )
+			return p1;
+
+		const float vc = d1 * d4 - d3 * d2;
+		if ( vc <= 0.f && d1 >= 0.f && d3 <= 0.f )
+			return p0 + ab * ( d1 / ( d1 - d3 ) );
+
+		const glm::vec3 cp = point - p2;
+		const float d5 = glm::dot( ab, cp ), d6 = glm::dot( ac, cp );
+		if ( d6 >= 0.f && d5 <= d6 )
+			return p2;
+
+		const float vb = d5 * d2 - d1 * d6;
+		if ( vb <= 0.f && d2 >= 0.f && d6 <= 0.f )
+			return p0 + ac * ( d2 / ( d2 - d6 ) );
+
+		const float va = d3 * d6 - d5 * d4;
+		if ( va <= 0.f && ( d4 - d3 ) >= 0.f && ( d5 - d6 ) >= 0.f )
+			return p1 + ( p2 - p1 ) * ( ( d4 - d3 ) / ( ( d4 - d3 ) + ( d5 - d6 ) ) );
+
+		const float denom = 1.f / ( va + vb + vc );
+		return p0 + ab * ( vb * denom ) + ac * ( vc * denom );
+	}
+
 	CollisionBox CollisionBox::MinkowskiDifference( const CollisionBox b1, const CollisionBox& b2 )
 	{
 		//const auto& mins = b1.GetMins( ) - b2.GetMaxs( );
@@ -16,8 +16,14 @@ namespace Engine::Core {
 
 		bool Intersects( const glm::vec3& mins, const glm::vec3& maxs ) const;
 
+		// AABB to Triangle (separating axis test).
+		bool Intersects( const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2 ) const;
+
 		glm::vec3 GetClosestPoint( const glm::vec3& target );
 
+		// Bounds of the box corners after the transform.
+		CollisionBox Transform( const glm::mat4& matrix ) const;
+
 
 
 		inline glm::vec3 GetMins( ) const { return m_Mins; }
@@ -25,5 +31,7 @@ namespace Engine::Core {
 
 		static CollisionBox Merge( const CollisionBox& b1, const CollisionBox& b2 );
 		static CollisionBox MinkowskiDifference( const CollisionBox b1, const CollisionBox& b2 );
+
+		static glm::vec3 ClosestPointOnTriangle( const glm::vec3& point, const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2 );
 	};
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "CollisionCapsule.hpp"
 #include "CollisionBox.hpp"
 
+#include <limits>
+
 namespace Engine::Core {
 	inline glm::vec3 
 		ClosestPointOnLineSegment(
@@ -56,33 +58,121 @@ namespace Engine::Core {
 		return false;
 	}
 
-	bool CollisionCapsule::Intersects(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2) {
-		glm::vec3 CapsuleNormal = glm::normalize(m_Top - m_Bottom);
-		glm::vec3 LineEndOffset = CapsuleNormal * m_Radius;
-		glm::vec3 A = m_Bottom + LineEndOffset;
-		glm::vec3 B = m_Top - LineEndOffset;
-
-		glm::vec3 N = glm::normalize(glm::cross(p1 - p0, p2 - p0)); // plane normal
+	// Closest points of the segments p1q1 and p2q2 (Ericson, Real-Time Collision Detection 5.1.9).
+	static float ClosestPointsOnSegments(
+		const glm::vec3& p1, const glm::vec3& q1,
+		const glm::vec3& p2, const glm::vec3& q2,
+		glm::vec3& c1, glm::vec3& c2)
+	{
+		constexpr float epsilon = 1e-8f;
+
+		const glm::vec3 d1 = q1 - p1, d2 = q2 - p2, r = p1 - p2;
+		const float a = glm::dot(d1, d1), e = glm::dot(d2, d2), f = glm::dot(d2, r);
+
+		float s = 0.f, t = 0.f;
+
+		if (a <= epsilon && e <= epsilon) {
+			// Both degenerate to points.
+		}
+		else if (a <= epsilon) {
+			t = glm::clamp(f / e, 0.f, 1.f);
+		}
+		else {
+			const float c = glm::dot(d1, r);
+
+			if (e <= epsilon) {
+				s = glm::clamp(-c / a, 0.f, 1.f);
+			}
+			else {
+				const float b = glm::dot(d1, d2);
+				const float denom = a * e - b * b;
+
+				// Parallel segments pick any s.
+				s = denom != 0.f ? glm::clamp((b * f - c * e) / denom, 0.f, 1.f) : 0.f;
+				t = (b * s + f) / e;
+
+				if (t < 0.f) {
+					t = 0.f;
+					s = glm::clamp(-c / a, 0.f, 1.f);
+				}
+				else if (t > 1.f) {
+					t = 1.f;
+					s = glm::clamp((b - c) / a, 0.f, 1.f);
+				}
+			}
+		}
+
+		c1 = p1 + d1 * s;
+		c2 = p2 + d2 * t;
+
+		return glm::dot(c1 - c2, c1 - c2);
+	}
 
-		float t = glm::dot(N, (p0 - m_Bottom) / abs(dot(N, CapsuleNormal)));
-		glm::vec3 line_plane_intersection = m_Bottom + CapsuleNormal * t;
+	bool CollisionCapsule::Intersects(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2) const {
+		glm::vec3 segmentPoint{}, trianglePoint{};
+		return GetClosestPoints(p0, p1, p2, segmentPoint, trianglePoint) <= m_Radius * m_Radius;
+	}
 
-		return false;
+	float CollisionCapsule::GetClosestPoints(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, glm::vec3& segmentPoint, glm::vec3& trianglePoint) const {
+		const glm::vec3 A = GetSegmentStart();
+		const glm::vec3 B = GetSegmentEnd();
+
+		// Segment crossing the triangle plane inside the triangle.
+		const glm::vec3 N = glm::cross(p1 - p0, p2 - p0);
+		const float dA = glm::dot(A - p0, N);
+		const float dB = glm::dot(B - p0, N);
+
+		if (dA * dB <= 0.f && dA != dB) {
+			const glm::vec3 P = A + (B - A) * (dA / (dA - dB));
+			const glm::vec3 Q = CollisionBox::ClosestPointOnTriangle(P, p0, p1, p2);
+
+			if (glm::dot(P - Q, P - Q) <= 1e-10f) {
+				segmentPoint = trianglePoint = P;
+				return 0.f;
+			}
+		}
+
+		// Otherwise the closest pair involves a segment end point or a triangle edge.
+		float best = std::numeric_limits<float>::max();
+
+		for (const glm::vec3& end : { A, B }) {
+			const glm::vec3 Q = CollisionBox::ClosestPointOnTriangle(end, p0, p1, p2);
+			const float distance = glm::dot(end - Q, end - Q);
+
+			if (distance < best) {
+				best = distance;
+				segmentPoint = end;
+				trianglePoint = Q;
+			}
+		}
+
+		const glm::vec3 edges[3][2] = { { p0, p1 }, { p1, p2 }, { p2, p0 } };
+
+		for (const auto& edge : edges) {
+			glm::vec3 c1{}, c2{};
+			const float distance = ClosestPointsOnSegments(A, B, edge[0], edge[1], c1, c2);
+
+			if (distance < best) {
+				best = distance;
+				segmentPoint = c1;
+				trianglePoint = c2;
+			}
+		}
+
+		return best;
 	}
 
-	/*
-	CollisionBox CollisionCapsule::GetAABB() const {
-		//glm::vec3 halfWidth = glm::vec3(m_Radius, m_Radius, m_Radius);
+	glm::vec3 CollisionCapsule::GetSegmentStart() const {
+		// m_Bottom and m_Top are the tips, the segment ends one radius inwards.
+		return m_Bottom + glm::normalize(m_Top - m_Bottom) * m_Radius;
+	}
 
-		//CollisionBox bottomAABB{};
-		//bottomAABB.m_Center = m_Bottom;
-		//bottomAABB.m_Extents = halfWidth;
-		//
-		//CollisionBox topAABB = { m_Top, halfWidth };
+	glm::vec3 CollisionCapsule::GetSegmentEnd() const {
+		return m_Top - glm::normalize(m_Top - m_Bottom) * m_Radius;
+	}
 
-		//return CollisionBox::Merge(topAABB, bottomAABB);
-	
-	
+	CollisionBox CollisionCapsule::GetAABB() const {
+		const glm::vec3 A = GetSegmentStart(), B = GetSegmentEnd();
+		return CollisionBox(glm::min(A, B) - m_Radius, glm::max(A, B) + m_Radius);
 	}
-	*/
-}
\ No newline at end of file
+}
@@ -18,8 +18,15 @@ namespace Engine::Core {
 		bool Intersects(const CollisionBox& aabb);
 
 		// Capsule to Triangle...
-		bool Intersects(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2);
+		bool Intersects(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2) const;
 
-		// CollisionBox GetAABB() const;
+		// Squared distance between the core segment and the triangle, with the closest point on each.
+		float GetClosestPoints(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, glm::vec3& segmentPoint, glm::vec3& trianglePoint) const;
+
+		// Core segment, the tips pulled in by the radius.
+		glm::vec3 GetSegmentStart() const;
+		glm::vec3 GetSegmentEnd() const;
+
+		CollisionBox GetAABB() const;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "CollisionRay.hpp"
+#include "CollisionBox.hpp"
+
+#include <algorithm>
+
+namespace Engine::Core {
+	bool CollisionRay::Intersects(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, float& distance) const {
+		// Moller-Trumbore.
+		constexpr float epsilon = 1e-8f;
+
+		const glm::vec3 e1 = p1 - p0, e2 = p2 - p0;
+		const glm::vec3 p = glm::cross(m_Direction, e2);
+		const float det = glm::dot(e1, p);
+
+		if (std::abs(det) < epsilon)
+			return false;
+
+		const float invDet = 1.f / det;
+		const glm::vec3 s = m_Origin - p0;
+
+		const float u = glm::dot(s, p) * invDet;
+		if (u < 0.f || u > 1.f)
+			return false;
+
+		const glm::vec3 q = glm::cross(s, e1);
+
+		const float v = glm::dot(m_Direction, q) * invDet;
+		if (v < 0.f || u + v > 1.f)
+			return false;
+
+		const float t = glm::dot(e2, q) * invDet;
+		if (t < 0.f || t > m_Length)
+			return false;
+
+		distance = t;
+		return true;
+	}
+
+	bool CollisionRay::Intersects(const CollisionBox& aabb, float& distance) const {
+		float tMin = 0.f, tMax = m_Length;
+
+		for (int axis = 0; axis < 3; axis++) {
+			if (std::abs(m_Direction[axis]) < 1e-8f) {
+				// Parallel to the slab, has to start inside it.
+				if (m_Origin[axis] < aabb.m_Mins[axis] || m_Origin[axis] > aabb.m_Maxs[axis])
+					return false;
+
+				continue;
+			}
+
+			const float invDir = 1.f / m_Direction[axis];
+			float t0 = (aabb.m_Mins[axis] - m_Origin[axis]) * invDir;
+			float t1 = (aabb.m_Maxs[axis] - m_Origin[axis]) * invDir;
+
+			if (t0 > t1)
+				std::swap(t0, t1);
+
+			tMin = std::max(tMin, t0);
+			tMax = std::min(tMax, t1);
+
+			if (tMin > tMax)
+				return false;
+		}
+
+		distance = tMin;
+		return true;
+	}
+}
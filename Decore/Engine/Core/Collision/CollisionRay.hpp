@@ -0,0 +1,20 @@
+#pragma once
+#include <glm.hpp>
+#include <limits>
+
+namespace Engine::Core {
+	class CollisionBox;
+
+	class CollisionRay {
+	public:
+		glm::vec3 m_Origin{};
+		glm::vec3 m_Direction{ 0.f, 0.f, 1.f }; // Normalized.
+		float m_Length{ std::numeric_limits<float>::max() };
+
+		// Ray to Triangle, both faces. distance is along m_Direction.
+		bool Intersects(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, float& distance) const;
+
+		// Ray to AABB, distance is where the ray enters the box (0 when it starts inside).
+		bool Intersects(const CollisionBox& aabb, float& distance) const;
+	};
+}
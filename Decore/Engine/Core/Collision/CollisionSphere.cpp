@@ -0,0 +1,20 @@
+#include "CollisionSphere.hpp"
+#include "CollisionBox.hpp"
+
+namespace Engine::Core {
+	bool CollisionSphere::Intersects(const CollisionSphere& sphere) const {
+		const glm::vec3 delta = sphere.m_Center - m_Center;
+		const float radius = m_Radius + sphere.m_Radius;
+
+		return glm::dot(delta, delta) <= radius * radius;
+	}
+
+	bool CollisionSphere::Intersects(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2) const {
+		const glm::vec3 delta = m_Center - CollisionBox::ClosestPointOnTriangle(m_Center, p0, p1, p2);
+		return glm::dot(delta, delta) <= m_Radius * m_Radius;
+	}
+
+	CollisionBox CollisionSphere::GetAABB() const {
+		return CollisionBox(m_Center - m_Radius, m_Center + m_Radius);
+	}
+}
@@ -2,11 +2,18 @@
 #include <glm.hpp>
 
 namespace Engine::Core {
+	class CollisionBox;
+
 	class CollisionSphere {
 	public:
 		glm::vec3 m_Center{};
 		float m_Radius{};
 
-		bool Intersects(const CollisionSphere& sphere);
+		bool Intersects(const CollisionSphere& sphere) const;
+
+		// Sphere to Triangle...
+		bool Intersects(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2) const;
+
+		CollisionBox GetAABB() const;
 	};
-}
\ No newline at end of file
+}
@@ -2,6 +2,8 @@
 #include "Application/Application.hpp"
 #include "Camera/Camera.hpp"
 #include "Collision/Collision.hpp"
+#include "Collision/CharacterController.hpp"
 
 #include "Input/InputSystem.hpp"
+#include "Jobs/JobSystem.hpp"
 #include "Time/TimeSystem.hpp"
\ No newline at end of file
@@ -0,0 +1,299 @@
+#include "JobSystem.hpp"
+
+#include <algorithm>
+
+namespace Engine::Core {
+	JobSystem::JobSystem(uint32_t threadCount)
+	{
+		if (threadCount == 0)
+			threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+		m_Workers.reserve(threadCount);
+
+		for (uint32_t i = 0; i < threadCount; i++)
+			m_Workers.push_back(std::make_unique<Worker>());
+
+		// Started once every deque exists, workers steal from each other right away.
+		for (uint32_t i = 0; i < threadCount; i++)
+			m_Workers[i]->m_Thread = std::thread(&JobSystem::WorkerLoop, this, i);
+
+		m_SampleTime = std::chrono::steady_clock::now();
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_SleepMutex);
+			m_Quit = true;
+		}
+
+		m_WakeCondition.notify_all();
+
+		for (auto& worker : m_Workers)
+			worker->m_Thread.join();
+	}
+
+	void JobSystem::Run(Task_t task, Counter* counter)
+	{
+		if (counter)
+			counter->m_Count.fetch_add(1, std::memory_order_relaxed);
+
+		Push({ std::move(task), counter });
+	}
+
+	void JobSystem::RunAfter(Counter& dependency, Task_t task, Counter* counter)
+	{
+		if (counter)
+			counter->m_Count.fetch_add(1, std::memory_order_relaxed);
+
+		{
+			// Finish drains the continuations under the same lock once the count hits zero.
+			std::lock_guard<std::mutex> lock(dependency.m_Mutex);
+
+			if (!dependency.IsDone())
+			{
+				dependency.m_Continuations.emplace_back(std::move(task), counter);
+				return;
+			}
+		}
+
+		Push({ std::move(task), counter });
+	}
+
+	void JobSystem::Wait(Counter& counter)
+	{
+		while (!counter.IsDone())
+		{
+			if (!TryRunJob())
+				std::this_thread::yield();
+		}
+
+		// The last job may still be inside Finish.
+		std::lock_guard<std::mutex> lock(counter.m_Mutex);
+	}
+
+	void JobSystem::ParallelFor(uint32_t count, uint32_t batchSize, const Job_t& job)
+	{
+		if (count == 0)
+			return;
+
+		batchSize = std::max(batchSize, 1u);
+
+		// Not worth waking anyone.
+		if (m_Workers.empty() || count <= batchSize)
+		{
+			for (uint32_t i = 0; i < count; i++)
+				job(i);
+
+			return;
+		}
+
+		// One job per thread that can help, each claims batches until none are left so uneven batches still balance.
+		std::atomic<uint32_t> next{};
+
+		const auto runBatches = [&]()
+		{
+			uint32_t begin;
+			while ((begin = next.fetch_add(batchSize, std::memory_order_relaxed)) < count)
+			{
+				const uint32_t end = std::min(begin + batchSize, count);
+
+				for (uint32_t i = begin; i < end; i++)
+					job(i);
+			}
+		};
+
+		const uint32_t batchCount = (count + batchSize - 1) / batchSize;
+		const uint32_t helperCount = std::min(batchCount, GetWorkerCount() + 1) - 1;
+
+		Counter counter{};
+		for (uint32_t i = 0; i < helperCount; i++)
+			Run(runBatches, &counter);
+
+		runBatches();
+		Wait(counter);
+	}
+
+	std::vector<JobSystem::WorkerStats> JobSystem::SampleStats()
+	{
+		const auto now = std::chrono::steady_clock::now();
+		const double elapsed = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_SampleTime).count());
+		m_SampleTime = now;
+
+		std::vector<WorkerStats> stats(m_Workers.size());
+
+		for (size_t i = 0; i < m_Workers.size(); i++)
+		{
+			auto& worker = *m_Workers[i];
+
+			const uint64_t busyTime = worker.m_BusyTime.load(std::memory_order_relaxed);
+			const uint64_t jobCount = worker.m_JobCount.load(std::memory_order_relaxed);
+			const uint64_t stealCount = worker.m_StealCount.load(std::memory_order_relaxed);
+
+			stats[i].m_Utilization = elapsed > 0.0 ? std::min(static_cast<float>((busyTime - worker.m_SampledBusyTime) / elapsed), 1.f) : 0.f;
+			stats[i].m_Jobs = jobCount - worker.m_SampledJobCount;
+			stats[i].m_Steals = stealCount - worker.m_SampledStealCount;
+
+			worker.m_SampledBusyTime = busyTime;
+			worker.m_SampledJobCount = jobCount;
+			worker.m_SampledStealCount = stealCount;
+		}
+
+		return stats;
+	}
+
+	void JobSystem::WorkerLoop(uint32_t index)
+	{
+		s_WorkerIndex = static_cast<int>(index);
+
+		while (true)
+		{
+			if (TryRunJob())
+				continue;
+
+			std::unique_lock<std::mutex> lock(m_SleepMutex);
+			m_WakeCondition.wait(lock, [this] { return m_Quit || m_QueuedJobs.load(std::memory_order_acquire) > 0; });
+
+			if (m_Quit)
+				return;
+		}
+	}
+
+	void JobSystem::Push(Job job)
+	{
+		// No workers to run it, the caller does it right away.
+		if (m_Workers.empty())
+		{
+			Execute(job);
+			return;
+		}
+
+		if (s_WorkerIndex >= 0)
+		{
+			auto& worker = *m_Workers[s_WorkerIndex];
+
+			std::lock_guard<std::mutex> lock(worker.m_Mutex);
+			worker.m_Jobs.push_back(std::move(job));
+		}
+		else
+		{
+			std::lock_guard<std::mutex> lock(m_SharedMutex);
+			m_SharedJobs.push_back(std::move(job));
+		}
+
+		m_QueuedJobs.fetch_add(1, std::memory_order_release);
+
+		// Taking the lock orders the increment against a worker about to sleep.
+		{
+			std::lock_guard<std::mutex> lock(m_SleepMutex);
+		}
+
+		m_WakeCondition.notify_one();
+	}
+
+	bool JobSystem::Pop(Job& job)
+	{
+		if (m_QueuedJobs.load(std::memory_order_acquire) == 0)
+			return false;
+
+		const int self = s_WorkerIndex;
+
+		const auto take = [&](std::mutex& mutex, std::deque<Job>& jobs, bool newest)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if (jobs.empty())
+				return false;
+
+			if (newest)
+			{
+				job = std::move(jobs.back());
+				jobs.pop_back();
+			}
+			else
+			{
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+
+			m_QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		};
+
+		// Own jobs first, newest first while its data is still in cache.
+		if (self >= 0 && take(m_Workers[self]->m_Mutex, m_Workers[self]->m_Jobs, true))
+			return true;
+
+		if (take(m_SharedMutex, m_SharedJobs, false))
+			return true;
+
+		// Steal the oldest job of another worker, starting next to this one so thieves spread out.
+		const uint32_t workerCount = GetWorkerCount();
+		const uint32_t start = self >= 0 ? static_cast<uint32_t>(self) + 1 : 0;
+
+		for (uint32_t i = 0; i < workerCount; i++)
+		{
+			const uint32_t victim = (start + i) % workerCount;
+			if (static_cast<int>(victim) == self)
+				continue;
+
+			if (take(m_Workers[victim]->m_Mutex, m_Workers[victim]->m_Jobs, false))
+			{
+				if (self >= 0)
+					m_Workers[self]->m_StealCount.fetch_add(1, std::memory_order_relaxed);
+
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool JobSystem::TryRunJob()
+	{
+		Job job{};
+		if (!Pop(job))
+			return false;
+
+		Execute(job);
+		return true;
+	}
+
+	void JobSystem::Execute(Job& job)
+	{
+		const int self = s_WorkerIndex;
+		const auto start = std::chrono::steady_clock::now();
+
+		job.m_Task();
+
+		if (self >= 0)
+		{
+			auto& worker = *m_Workers[self];
+			worker.m_BusyTime.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+			worker.m_JobCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		Finish(job.m_Counter);
+	}
+
+	void JobSystem::Finish(Counter* counter)
+	{
+		if (!counter)
+			return;
+
+		std::vector<std::pair<Task_t, Counter*>> continuations{};
+
+		{
+			// Decremented under the lock, Wait takes it once more before the owner may destroy the counter.
+			std::lock_guard<std::mutex> lock(counter->m_Mutex);
+
+			if (counter->m_Count.fetch_sub(1, std::memory_order_acq_rel) != 1)
+				return;
+
+			continuations.swap(counter->m_Continuations);
+		}
+
+		for (auto& [task, continuationCounter] : continuations)
+			Push({ std::move(task), continuationCounter });
+	}
+}
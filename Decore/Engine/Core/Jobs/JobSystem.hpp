@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Engine::Core {
+	// Work stealing job scheduler shared by the whole engine (animation, asset loading, scene queries, physics, ...).
+	// Every worker owns a deque, it pops its own jobs newest first and steals the oldest jobs of the others when it runs dry.
+	// Threads that are not workers submit through a shared queue. Any thread may submit jobs and wait, waiting threads run jobs meanwhile.
+	class JobSystem {
+	public:
+		using Job_t = std::function<void(uint32_t)>;
+		using Task_t = std::function<void()>;
+
+		// Number of unfinished jobs submitted with it. Jobs can be scheduled to start once a counter is done.
+		// A counter has to outlive its jobs, destroy or reuse it only after Wait returned.
+		class Counter {
+		public:
+			bool IsDone() const { return m_Count.load(std::memory_order_acquire) == 0; }
+		private:
+			friend class JobSystem;
+
+			std::atomic<uint32_t> m_Count{};
+
+			// Jobs waiting for this counter, guarded by m_Mutex.
+			std::mutex m_Mutex{};
+			std::vector<std::pair<Task_t, Counter*>> m_Continuations{};
+		};
+
+		// Per worker activity since the previous SampleStats.
+		struct WorkerStats {
+			float m_Utilization{};	// Busy time over wall time, 0 to 1.
+			uint64_t m_Jobs{};
+			uint64_t m_Steals{};
+		};
+
+		static inline JobSystem* s_Inst = nullptr;
+
+		// threadCount 0 uses one worker per hardware thread, minus the main thread.
+		static JobSystem* Create(uint32_t threadCount = 0)
+		{
+			if (!s_Inst)
+				s_Inst = new JobSystem(threadCount);
+
+			return s_Inst;
+		}
+
+		static JobSystem* Get()
+		{
+			return s_Inst;
+		}
+
+		static void Dispose()
+		{
+			delete s_Inst;
+			s_Inst = nullptr;
+		}
+
+		// Queues task, counter (optional) is incremented now and decremented once the task returned.
+		void Run(Task_t task, Counter* counter = nullptr);
+
+		// Queues task once dependency is done.
+		void RunAfter(Counter& dependency, Task_t task, Counter* counter = nullptr);
+
+		// Runs queued jobs on the calling thread until counter is done.
+		void Wait(Counter& counter);
+
+		// Calls job(i) for every i in [0, count) and returns once all calls are done.
+		// Indices are handed out batchSize at a time, the calling thread works along. Safe to nest inside jobs.
+		void ParallelFor(uint32_t count, uint32_t batchSize, const Job_t& job);
+
+		uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_Workers.size()); }
+
+		// Index of the calling worker, -1 on other threads.
+		static int GetWorkerIndex() { return s_WorkerIndex; }
+
+		// Activity of every worker since the previous call, meant to be sampled once per frame from one thread.
+		std::vector<WorkerStats> SampleStats();
+	private:
+		JobSystem(uint32_t threadCount);
+		~JobSystem();
+
+		struct Job {
+			Task_t m_Task{};
+			Counter* m_Counter = nullptr;
+		};
+
+		struct Worker {
+			std::thread m_Thread{};
+
+			// Back: newest, popped by the owner. Front: oldest, stolen by the others.
+			std::mutex m_Mutex{};
+			std::deque<Job> m_Jobs{};
+
+			std::atomic<uint64_t> m_BusyTime{};	// Nanoseconds spent in jobs.
+			std::atomic<uint64_t> m_JobCount{};
+			std::atomic<uint64_t> m_StealCount{};
+
+			// SampleStats bookkeeping.
+			uint64_t m_SampledBusyTime{}, m_SampledJobCount{}, m_SampledStealCount{};
+		};
+
+		void WorkerLoop(uint32_t index);
+
+		void Push(Job job);
+		bool Pop(Job& job);
+		bool TryRunJob();
+		void Execute(Job& job);
+		void Finish(Counter* counter);
+
+		static thread_local inline int s_WorkerIndex = -1;
+
+		std::vector<std::unique_ptr<Worker>> m_Workers{};
+
+		// Jobs submitted from threads that are not workers.
+		std::mutex m_SharedMutex{};
+		std::deque<Job> m_SharedJobs{};
+
+		// Queued jobs over every deque, idle workers sleep while it is zero.
+		std::atomic<uint32_t> m_QueuedJobs{};
+		std::mutex m_SleepMutex{};
+		std::condition_variable m_WakeCondition{};
+		std::atomic<bool> m_Quit{};
+
+		std::chrono::steady_clock::time_point m_SampleTime{};
+	};
+}
@@ -2,4 +2,5 @@
 
 namespace Engine::Core {
 	float TimeSystem::m_DeltaTime = 0.f;
+	double TimeSystem::m_Time = 0.0;
 }
\ No newline at end of file
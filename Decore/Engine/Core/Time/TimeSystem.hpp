@@ -3,8 +3,12 @@
 namespace Engine::Core {
 	class TimeSystem {
 		static float m_DeltaTime;
+		static double m_Time;
 	public:
 		static float GetDeltaTime() { return m_DeltaTime; }
-		static void SetDeltaTime(float value) { m_DeltaTime = value; }
+		static void SetDeltaTime(float value) { m_DeltaTime = value; m_Time += value; }
+
+		// Seconds since the first frame, sum of every delta time.
+		static double GetTime() { return m_Time; }
 	};
 }
\ No newline at end of file
@@ -1,8 +1,9 @@
 #include "SceneCuller.hpp"
+#include "../Shadows/ShadowMapPass.hpp"
 
 namespace Engine::Renderer
 {
-	SceneCuller::SceneCuller( std::shared_ptr<Device> device, Swapchain* swapchain, const DescriptorLayout& primitiveLayout )
+	SceneCuller::SceneCuller( std::shared_ptr<Device> device, Swapchain* swapchain, const DescriptorLayout& primitiveLayout ) : m_Device( device ), m_Swapchain( swapchain )
 	{
 		auto indirectLayout = Renderer::DescriptorLayout(device, { { 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr} });
 
@@ -16,16 +17,244 @@ namespace Engine::Renderer
 										   VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT );
 		}
 
-		m_Descriptor = new Descriptor(
+		for ( auto i = 0; i < m_Descriptors.size( ); i++ )
+		{
+			m_Descriptors[ i ] = new Descriptor(
+				device,
+				{
+					{ 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr }
+				},
+				VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+			);
+
+			m_Descriptors[ i ]->Bind(
+				{
+					Descriptor::BindingInfo{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, {.m_Buffer = m_CullDatas[ i ] } }
+				}
+			);
+		}
+
+		// Set 3 holds the per draw LOD table, set 4 the compacted instances of the view. The push constant selects the pass.
+		m_Pipeline = new ComputePipeline( cullComputeShader, { indirectLayout, primitiveLayout, m_Descriptors[ 0 ]->GetLayout( ), indirectLayout, primitiveLayout },
+			{ VkPushConstantRange{ VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( uint32_t ) } }, *swapchain );
+
+		if ( !device->SupportsDrawIndirectCount( ) )
+			return;
+
+		m_MeshletCullData = new Buffer( device, sizeof( MeshletCullingUniforms ),
+										VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+										VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+										VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT );
+
+		// Stage ALL, the task shader runs the same tests.
+		m_MeshletDescriptor = new Descriptor(
 			device,
 			{
-				{ 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr }
+				{ 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_ALL, nullptr }
 			},
 			VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
 		);
 
+		m_MeshletDescriptor->Bind(
+			{
+				Descriptor::BindingInfo{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, {.m_Buffer = m_MeshletCullData } }
+			}
+		);
+
+		m_DepthPyramidSampler = new Sampler( device, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_FILTER_NEAREST, 1.f );
+
+		CreateDepthPyramid( );
+
+		const auto meshletCullShader = Shader( "../Shaders/Compute/MeshletCullCS.hlsl", VK_SHADER_STAGE_COMPUTE_BIT );
+		const auto depthPyramidShader = Shader( "../Shaders/Compute/DepthPyramidCS.hlsl", VK_SHADER_STAGE_COMPUTE_BIT );
+
+		auto meshletLayout = Renderer::DescriptorLayout( device, { { 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_ALL, nullptr} } );
+
+		// Sets: primitive draws, primitive data, UBO, LOD table, meshlets, compacted draws, draw counts, depth pyramid.
+		m_MeshletPipeline = new ComputePipeline( meshletCullShader,
+			{ indirectLayout, primitiveLayout, m_MeshletDescriptor->GetLayout( ), indirectLayout, meshletLayout, meshletLayout, meshletLayout, m_DepthPyramidDescriptor->GetLayout( ) },
+			{ VkPushConstantRange{ VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( uint32_t ) * 2 } }, *swapchain );
+
+		m_DepthPyramidPipeline = new ComputePipeline( depthPyramidShader,
+			{ m_PyramidSources[ 0 ]->GetLayout( ), m_PyramidTargets[ 0 ]->GetLayout( ) },
+			{ VkPushConstantRange{ VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( glm::uvec4 ) } }, *swapchain );
+	}
+
+	void SceneCuller::CreateDepthPyramid( )
+	{
+		const auto& extents = m_Swapchain->GetExtents( );
+		const auto format = VK_FORMAT_R32_SFLOAT;
+
+		m_DepthPyramidLevels = static_cast< uint32_t >( std::floor( std::log2( std::max( extents.width, extents.height ) ) ) ) + 1;
+
+		m_DepthPyramid = new Image(
+			m_Device,
+			extents.width,
+			extents.height,
+			m_DepthPyramidLevels,
+			format,
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_SAMPLE_COUNT_1_BIT,
+			VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		);
+
+		m_DepthPyramidView = new ImageView( m_Device, *m_DepthPyramid, m_DepthPyramidLevels, format );
+
+		m_DepthPyramidLevelViews.resize( m_DepthPyramidLevels );
+
+		for ( auto i = 0u; i < m_DepthPyramidLevels; i++ )
+		{
+			VkImageViewCreateInfo createInfo = ImageView::GetDefault2DCreateInfo( *m_DepthPyramid, 1, format );
+			createInfo.subresourceRange.baseMipLevel = i;
+
+			m_DepthPyramidLevelViews[ i ] = new ImageView( m_Device, *m_DepthPyramid, 1, format, &createInfo );
+		}
+
+		const auto createSampled =
+			[ & ]( ImageView* view, VkImageLayout layout )
+		{
+			auto* descriptor = new Descriptor(
+				m_Device,
+				{ { 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_ALL, nullptr } },
+				VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+			);
+
+			if ( view )
+			{
+				descriptor->Bind(
+					{
+						Descriptor::BindingInfo{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, {.m_ImageView = view }, m_DepthPyramidSampler, layout }
+					}
+				);
+			}
+
+			return descriptor;
+		};
+
+		// The pyramid stays in GENERAL, it is written and sampled level by level.
+		m_DepthPyramidDescriptor = createSampled( m_DepthPyramidView, VK_IMAGE_LAYOUT_GENERAL );
+
+		m_PyramidSources.resize( m_DepthPyramidLevels );
+		m_PyramidTargets.resize( m_DepthPyramidLevels );
+
+		for ( auto i = 0u; i < m_DepthPyramidLevels; i++ )
+		{
+			// Level 0 is bound to the pre-pass depth once it is known.
+			m_PyramidSources[ i ] = createSampled( i == 0 ? nullptr : m_DepthPyramidLevelViews[ i - 1 ], VK_IMAGE_LAYOUT_GENERAL );
+
+			m_PyramidTargets[ i ] = new Descriptor(
+				m_Device,
+				{ { 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr } },
+				VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+			);
+
+			m_PyramidTargets[ i ]->Bind(
+				{
+					Descriptor::BindingInfo{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, {.m_ImageView = m_DepthPyramidLevelViews[ i ] } }
+				}
+			);
+		}
+
+		m_PyramidDepthView = nullptr;
+		m_PyramidValid = false;
+	}
+
+	void SceneCuller::DestroyDepthPyramid( )
+	{
+		for ( auto* descriptor : m_PyramidSources )
+			delete descriptor;
+
+		for ( auto* descriptor : m_PyramidTargets )
+			delete descriptor;
+
+		for ( auto* view : m_DepthPyramidLevelViews )
+			delete view;
+
+		m_PyramidSources.clear( );
+		m_PyramidTargets.clear( );
+		m_DepthPyramidLevelViews.clear( );
+
+		delete m_DepthPyramidDescriptor;
+		delete m_DepthPyramidView;
+		delete m_DepthPyramid;
+
+		m_DepthPyramidDescriptor = nullptr;
+		m_DepthPyramidView = nullptr;
+		m_DepthPyramid = nullptr;
+	}
+
+	void SceneCuller::RecreateDepthPyramid( )
+	{
+		if ( !m_DepthPyramid )
+			return;
+
+		DestroyDepthPyramid( );
+		CreateDepthPyramid( );
+	}
+
+	void SceneCuller::BuildDepthPyramid( CommandBuffer& commandBuffer, ImageView* depthView, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix )
+	{
+		if ( !m_DepthPyramid )
+			return;
+
+		if ( depthView != m_PyramidDepthView )
+		{
+			m_PyramidSources[ 0 ]->Bind(
+				{
+					Descriptor::BindingInfo{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, {.m_ImageView = depthView }, m_DepthPyramidSampler }
+				}
+			);
+
+			m_PyramidDepthView = depthView;
+		}
+
+		// Every level is rewritten, the previous contents can be dropped.
+		commandBuffer.ImageBarrier(
+			*m_DepthPyramid,
+			0,
+			VK_ACCESS_SHADER_WRITE_BIT,
+			VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, m_DepthPyramidLevels, 0, 1 }
+		);
+
+		commandBuffer.BindPipeline( *m_DepthPyramidPipeline );
+
+		glm::uvec2 sourceSize = glm::uvec2( m_DepthPyramid->GetWidth( ), m_DepthPyramid->GetHeight( ) );
 
-		m_Pipeline = new ComputePipeline( cullComputeShader, { indirectLayout, primitiveLayout, m_Descriptor->GetLayout( ) }, {}, *swapchain );
+		for ( auto i = 0u; i < m_DepthPyramidLevels; i++ )
+		{
+			const glm::uvec2 levelSize = glm::max( glm::uvec2( m_DepthPyramid->GetWidth( ) >> i, m_DepthPyramid->GetHeight( ) >> i ), glm::uvec2( 1 ) );
+			const glm::uvec4 sizes = glm::uvec4( sourceSize, levelSize );
+
+			std::vector<Descriptor*> descriptors = { m_PyramidSources[ i ], m_PyramidTargets[ i ] };
+
+			commandBuffer.BindDescriptors( descriptors );
+			commandBuffer.SetDescriptorOffsets( descriptors, *m_DepthPyramidPipeline );
+
+			vkCmdPushConstants( commandBuffer, m_DepthPyramidPipeline->GetPipelineLayout( ), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( sizes ), &sizes );
+			vkCmdDispatch( commandBuffer, ( levelSize.x + 7 ) / 8, ( levelSize.y + 7 ) / 8, 1 );
+
+			commandBuffer.ImageBarrier(
+				*m_DepthPyramid,
+				VK_ACCESS_SHADER_WRITE_BIT,
+				VK_ACCESS_SHADER_READ_BIT,
+				VK_IMAGE_LAYOUT_GENERAL,
+				VK_IMAGE_LAYOUT_GENERAL,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, i, 1, 0, 1 }
+			);
+
+			sourceSize = levelSize;
+		}
+
+		m_PyramidView = viewMatrix;
+		m_PyramidProjection = glm::vec4( projectionMatrix[ 0 ][ 0 ], projectionMatrix[ 1 ][ 1 ], projectionMatrix[ 2 ][ 2 ], projectionMatrix[ 3 ][ 2 ] );
+		m_PyramidValid = true;
 	}
 
 	void SceneCuller::Cull( const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, const float nearClip, const float farClip, CommandBuffer& commandBuffer, std::vector<Assets::BaseAsset*> staticGeometry, int cascadeIndex )
@@ -41,39 +270,117 @@ namespace Engine::Renderer
 			return p / glm::length( glm::vec3( p ) );
 		};
 
-		glm::vec4 frustumX = normalizePlane( projectionT[ 3 ] + projectionT[ 0 ] ); // x + w < 0
-		glm::vec4 frustumY = normalizePlane( projectionT[ 3 ] + projectionT[ 1 ] ); // y + w < 0
+		// Shadow cascades use orthographic projections, the planes do not go through the eye.
+		const bool orthographic = projectionMatrix[ 3 ][ 3 ] == 1.f;
+
+		if ( orthographic )
+		{
+			cullUniforms.Frustum = glm::vec4( 1.f / glm::abs( projectionMatrix[ 0 ][ 0 ] ), 1.f / glm::abs( projectionMatrix[ 1 ][ 1 ] ), 0.f, 0.f );
+		}
+		else
+		{
+			glm::vec4 frustumX = normalizePlane( projectionT[ 3 ] + projectionT[ 0 ] ); // x + w < 0
+			glm::vec4 frustumY = normalizePlane( projectionT[ 3 ] + projectionT[ 1 ] ); // y + w < 0
+
+			cullUniforms.Frustum[ 0 ] = frustumX.x;
+			cullUniforms.Frustum[ 1 ] = frustumX.z;
+			cullUniforms.Frustum[ 2 ] = frustumY.y;
+			cullUniforms.Frustum[ 3 ] = frustumY.z;
+		}
 
-		cullUniforms.Frustum[ 0 ] = frustumX.x;
-		cullUniforms.Frustum[ 1 ] = frustumX.z;
-		cullUniforms.Frustum[ 2 ] = frustumY.y;
-		cullUniforms.Frustum[ 3 ] = frustumY.z;
 		cullUniforms.CameraView = viewMatrix;
 		cullUniforms.NearFar = glm::vec2( nearClip, farClip );
 
+		// Pixels covered by one unit, for perspective views at a distance of one.
+		const float viewportHeight = cascadeIndex == -1 ? static_cast< float >( m_Swapchain->GetExtents( ).height ) : static_cast< float >( SHADOW_MAP_DIMENSIONS );
+
+		cullUniforms.LodParams.x = glm::abs( projectionMatrix[ 1 ][ 1 ] ) * viewportHeight * 0.5f;
+		cullUniforms.LodParams.y = m_LodErrorThreshold;
+		cullUniforms.LodParams.z = cascadeIndex == -1 ? 0.f : static_cast< float >( m_ShadowLodBias );
+		cullUniforms.LodParams.w = orthographic ? 1.f : 0.f;
+
 		auto index = cascadeIndex == -1 ? 0 : cascadeIndex + 1;
 
 		m_CullDatas[ index ]->Patch( &cullUniforms, sizeof( cullUniforms ) );
 
-		m_Descriptor->Bind(
-			{
-				Descriptor::BindingInfo{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, {.m_Buffer = m_CullDatas[ index ] } }
-			}
-		);
-
 		for ( auto& object : staticGeometry )
 		{
 			if ( Assets::StaticGLTFAsset* staticGLTF = dynamic_cast< Assets::StaticGLTFAsset* >( object ) )
 			{
-				std::vector<Descriptor*> descriptors = { staticGLTF->GetIndirectDescriptor( index ), staticGLTF->GetPrimitiveDescriptor( ), m_Descriptor };
+				std::vector<Descriptor*> descriptors = { staticGLTF->GetIndirectDescriptor( index ), staticGLTF->GetPrimitiveDescriptor( ), m_Descriptors[ index ], staticGLTF->GetLodDescriptor( ), staticGLTF->GetVisibleInstanceDescriptor( index ) };
 
-				vkCmdBindPipeline( commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, *( m_Pipeline ) );
+				commandBuffer.BindPipeline( *( m_Pipeline ) );
 
 				commandBuffer.BindDescriptors( descriptors );
 				commandBuffer.SetDescriptorOffsets( descriptors, *( m_Pipeline ) );
 
-				vkCmdDispatch( commandBuffer, static_cast< uint32_t >( staticGLTF->GetIndirectCommandsCount( ) ) / 16, 1, 1 );
+				const uint32_t drawCount = static_cast< uint32_t >( staticGLTF->GetIndirectCommandsCount( ) );
+				const uint32_t instanceCount = static_cast< uint32_t >( staticGLTF->GetInstanceCount( ) );
+
+				// Reset the draws, compact the visible instances per draw, then resolve the LOD of every draw.
+				for ( uint32_t pass = 0; pass < 3; pass++ )
+				{
+					vkCmdPushConstants( commandBuffer, m_Pipeline->GetPipelineLayout( ), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( pass ), &pass );
+					vkCmdDispatch( commandBuffer, ( ( pass == 1 ? instanceCount : drawCount ) + 15 ) / 16, 1, 1 );
+
+					if ( pass < 2 )
+						commandBuffer.BufferBarrier( *staticGLTF->GetIndirectBuffer( index ), VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT );
+				}
 			}
 		}
+
+		if ( cascadeIndex == -1 && m_MeshletPipeline )
+			CullMeshlets( viewMatrix, cullUniforms.Frustum, nearClip, farClip, commandBuffer, staticGeometry );
+	}
+
+	void SceneCuller::CullMeshlets( const glm::mat4& viewMatrix, const glm::vec4& frustum, const float nearClip, const float farClip, CommandBuffer& commandBuffer, std::vector<Assets::BaseAsset*> staticGeometry )
+	{
+		MeshletCullingUniforms meshletUniforms{};
+		meshletUniforms.CameraView = viewMatrix;
+		meshletUniforms.PyramidView = m_PyramidView;
+		meshletUniforms.Frustum = frustum;
+		meshletUniforms.PyramidProjection = m_PyramidProjection;
+		meshletUniforms.PyramidSize = glm::vec4(
+			static_cast< float >( m_DepthPyramid->GetWidth( ) ),
+			static_cast< float >( m_DepthPyramid->GetHeight( ) ),
+			static_cast< float >( m_DepthPyramidLevels ),
+			m_OcclusionCulling && m_PyramidValid ? 1.f : 0.f );
+		meshletUniforms.NearFar = glm::vec2( nearClip, farClip );
+
+		m_MeshletCullData->Patch( &meshletUniforms, sizeof( meshletUniforms ) );
+
+		// The task shader path reads the primitive draws as well.
+		const VkPipelineStageFlags2 readStages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | ( m_Device->SupportsMeshShader( ) ? VK_PIPELINE_STAGE_2_TASK_SHADER_BIT_EXT : 0 );
+
+		for ( auto& object : staticGeometry )
+		{
+			Assets::StaticGLTFAsset* staticGLTF = dynamic_cast< Assets::StaticGLTFAsset* >( object );
+			if ( !staticGLTF || !staticGLTF->UsesMeshletDraws( ) )
+				continue;
+
+			commandBuffer.BufferBarrier( *staticGLTF->GetIndirectBuffer( 0 ), VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_WRITE_BIT, readStages, VK_ACCESS_2_SHADER_READ_BIT );
+
+			vkCmdFillBuffer( commandBuffer, *staticGLTF->GetMeshletCountBuffer( ), 0, VK_WHOLE_SIZE, 0 );
+			commandBuffer.BufferBarrier( *staticGLTF->GetMeshletCountBuffer( ), VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT );
+
+			std::vector<Descriptor*> descriptors = {
+				staticGLTF->GetIndirectDescriptor( 0 ), staticGLTF->GetPrimitiveDescriptor( ), m_MeshletDescriptor, staticGLTF->GetLodDescriptor( ),
+				staticGLTF->GetMeshletDescriptor( ), staticGLTF->GetMeshletCommandsDescriptor( ), staticGLTF->GetMeshletCountDescriptor( ), m_DepthPyramidDescriptor
+			};
+
+			commandBuffer.BindPipeline( *( m_MeshletPipeline ) );
+
+			commandBuffer.BindDescriptors( descriptors );
+			commandBuffer.SetDescriptorOffsets( descriptors, *( m_MeshletPipeline ) );
+
+			const uint32_t pushConstants[ 2 ] = { staticGLTF->GetMeshletCount( ), staticGLTF->GetShortIndexedMeshletCount( ) };
+			vkCmdPushConstants( commandBuffer, m_MeshletPipeline->GetPipelineLayout( ), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( pushConstants ), pushConstants );
+
+			vkCmdDispatch( commandBuffer, ( staticGLTF->GetMeshletCount( ) + 63 ) / 64, 1, 1 );
+
+			// Consumed as indirect draws (and counts) by the graphics queue.
+			commandBuffer.BufferBarrier( *staticGLTF->GetMeshletCommandsBuffer( ), VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT );
+			commandBuffer.BufferBarrier( *staticGLTF->GetMeshletCountBuffer( ), VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT );
+		}
 	}
 }
\ No newline at end of file
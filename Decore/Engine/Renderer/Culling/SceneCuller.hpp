@@ -8,17 +8,82 @@ namespace Engine::Renderer {
 	class SceneCuller {
 	public:
 		struct CullingUniforms {
-			glm::vec4 Frustum{};
+			glm::vec4 Frustum{}; // Half extents in xy for orthographic views.
+			glm::mat4 CameraView;
+			glm::vec4 LodParams; // x: pixels per unit (at distance 1 for perspective views), y: error threshold in pixels, z: LOD bias, w: 1 when orthographic.
+			glm::vec2 NearFar;
+		};
+
+		struct MeshletCullingUniforms {
 			glm::mat4 CameraView;
+			glm::mat4 PyramidView; // View the depth pyramid was built with.
+			glm::vec4 Frustum{};
+			glm::vec4 PyramidProjection; // P00, P11, P22, P32
+			glm::vec4 PyramidSize; // xy: level 0 size, z: level count, w: 1 when valid.
 			glm::vec2 NearFar;
 		};
 
 		SceneCuller(std::shared_ptr<Device> device, Swapchain* swapchain, const DescriptorLayout& primitiveLayout);
 
+		// Largest projected simplification error accepted when picking a LOD.
+		float m_LodErrorThreshold = 1.f;
+
+		// Extra LOD levels skipped by the shadow cascades.
+		uint32_t m_ShadowLodBias = 1;
+
+		// Tests the meshlets against the previous frame's depth pyramid as well.
+		bool m_OcclusionCulling = true;
+
 		void Cull(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, const float nearClip, const float farClip, CommandBuffer& commandBuffer, std::vector<Assets::BaseAsset*> staticGeometry, int cascadeIndex = -1);
+
+		// Max reduces the depth pre-pass (in SHADER_READ_ONLY_OPTIMAL) for the next frame's occlusion tests.
+		void BuildDepthPyramid(CommandBuffer& commandBuffer, ImageView* depthView, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
+
+		// Called when the swapchain extents change.
+		void RecreateDepthPyramid();
+
+		// Culling inputs read by the task shader (meshlet UBO, depth pyramid).
+		std::vector<Descriptor*> GetMeshletDescriptors() const { return { m_MeshletDescriptor, m_DepthPyramidDescriptor }; }
 	private:
-		Descriptor* m_Descriptor = nullptr;
+		void CullMeshlets(const glm::mat4& viewMatrix, const glm::vec4& frustum, const float nearClip, const float farClip, CommandBuffer& commandBuffer, std::vector<Assets::BaseAsset*> staticGeometry);
+
+		void CreateDepthPyramid();
+		void DestroyDepthPyramid();
+
+		std::shared_ptr<Device> m_Device;
+
+		Swapchain* m_Swapchain = nullptr;
+
+		// One per indirect buffer (main view + cascades), the views are culled within the same frame.
+		std::array<Descriptor*, 5> m_Descriptors = {};
 		std::array<Buffer*, 5> m_CullDatas = {}; // Culling UBO (Frustum Planes)
 		ComputePipeline* m_Pipeline = nullptr;
+
+		// Per meshlet pass, main view only.
+		Buffer* m_MeshletCullData = nullptr;
+		Descriptor* m_MeshletDescriptor = nullptr;
+		ComputePipeline* m_MeshletPipeline = nullptr;
+
+		// R32 max depth, level 0 matches the swapchain.
+		Image* m_DepthPyramid = nullptr;
+		ImageView* m_DepthPyramidView = nullptr;
+		std::vector<ImageView*> m_DepthPyramidLevelViews{};
+		Sampler* m_DepthPyramidSampler = nullptr;
+		uint32_t m_DepthPyramidLevels{};
+
+		// Sampled by the meshlet pass, all levels.
+		Descriptor* m_DepthPyramidDescriptor = nullptr;
+
+		// Level i reads m_PyramidSources[i] and writes m_PyramidTargets[i].
+		std::vector<Descriptor*> m_PyramidSources{};
+		std::vector<Descriptor*> m_PyramidTargets{};
+		// Level 0 source, rebound to the pre-pass depth when it changes.
+		ImageView* m_PyramidDepthView = nullptr;
+
+		ComputePipeline* m_DepthPyramidPipeline = nullptr;
+
+		glm::mat4 m_PyramidView{ 1.f };
+		glm::vec4 m_PyramidProjection{};
+		bool m_PyramidValid = false;
 	};
 }
\ No newline at end of file
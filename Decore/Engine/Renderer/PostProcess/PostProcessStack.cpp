@@ -0,0 +1,300 @@
+#include "PostProcessStack.hpp"
+
+namespace Engine::Renderer {
+
+	PostProcessStack::PostProcessStack(std::shared_ptr<Device> device, const std::unique_ptr<Swapchain>& swapchain) : m_Device(device), m_Swapchain(swapchain.get())
+	{
+		m_Sampler = std::make_unique<Sampler>(device);
+
+		const auto createSampled =
+			[&]()
+		{
+			return std::make_unique<Descriptor>(
+				device,
+				std::vector<VkDescriptorSetLayoutBinding>{ { 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr } },
+				VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+			);
+		};
+
+		for (auto& descriptor : m_InputDescriptors)
+			descriptor = createSampled();
+
+		m_BloomDescriptor = createSampled();
+
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(*device->GetPhysicalDevice(), &properties);
+
+		if (properties.limits.timestampComputeAndGraphics)
+		{
+			VkQueryPoolCreateInfo queryPoolCreateInfo{ VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+			queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			queryPoolCreateInfo.queryCount = QUERY_COUNT;
+
+			if (vkCreateQueryPool(*device, &queryPoolCreateInfo, nullptr, &m_QueryPool) != VK_SUCCESS)
+			{
+				printf("Failed to create the post processing query pool\n");
+				m_QueryPool = VK_NULL_HANDLE;
+			}
+
+			m_TimestampPeriod = properties.limits.timestampPeriod;
+		}
+	}
+
+	PostProcessStack::~PostProcessStack()
+	{
+		if (m_QueryPool)
+			vkDestroyQueryPool(*m_Device, m_QueryPool, nullptr);
+
+		DestroyImages();
+	}
+
+	const char* PostProcessStack::GetStageName(PostProcessStage stage)
+	{
+		switch (stage)
+		{
+		case POST_PROCESS_BLOOM:
+			return "Bloom";
+		case POST_PROCESS_EXPOSURE:
+			return "Exposure";
+		case POST_PROCESS_TONEMAP:
+			return "Tonemap";
+		case POST_PROCESS_GRADING:
+			return "Grading";
+		default:
+			return "Unknown";
+		}
+	}
+
+	void PostProcessStack::Render(CommandBuffer& commandBuffer, ImageView* hdrView, ImageView* bloomView, VkImageLayout bloomLayout, ImageView* target)
+	{
+		ReadTimings();
+
+		m_InputDescriptors[0]->Bind(
+			{
+				Descriptor::BindingInfo{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, {.m_ImageView = hdrView }, m_Sampler.get() }
+			}
+		);
+
+		m_BloomDescriptor->Bind(
+			{
+				Descriptor::BindingInfo{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, {.m_ImageView = bloomView }, m_Sampler.get(), bloomLayout }
+			}
+		);
+
+		if (m_QueryPool)
+		{
+			vkCmdResetQueryPool(commandBuffer, m_QueryPool, 0, QUERY_COUNT);
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_QueryPool, 0);
+		}
+
+		m_RecordedPasses.clear();
+
+		const auto writeTimestamp = [&](uint32_t stage)
+		{
+			m_RecordedPasses.push_back(stage);
+
+			if (m_QueryPool)
+				vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_QueryPool, static_cast<uint32_t>(m_RecordedPasses.size()));
+		};
+
+		uint32_t enabledMask = 0;
+		for (uint32_t stage = 0; stage < POST_PROCESS_STAGE_COUNT; stage++)
+		{
+			if (m_EnabledStages[stage])
+				enabledMask |= 1u << stage;
+		}
+
+		// Nothing to split without stages, the single pass only encodes.
+		if (m_Fused || enabledMask == 0)
+		{
+			RenderPass(commandBuffer, enabledMask | ENCODE_OUTPUT_BIT, m_InputDescriptors[0].get(), target);
+			writeTimestamp(POST_PROCESS_STAGE_COUNT);
+			return;
+		}
+
+		// Only allocated once the stack runs unfused.
+		if (!m_Intermediates[0])
+			CreateImages();
+
+		Descriptor* input = m_InputDescriptors[0].get();
+		uint32_t intermediate = 0;
+
+		for (uint32_t stage = 0; stage < POST_PROCESS_STAGE_COUNT; stage++)
+		{
+			if (!m_EnabledStages[stage])
+				continue;
+
+			const uint32_t mask = 1u << stage;
+
+			// The last enabled stage writes the swapchain.
+			if ((enabledMask >> stage) == 1u)
+			{
+				RenderPass(commandBuffer, mask | ENCODE_OUTPUT_BIT, input, target);
+				writeTimestamp(stage);
+				break;
+			}
+
+			Image& image = *m_Intermediates[intermediate];
+
+			commandBuffer.ImageBarrier(
+				image,
+				VK_ACCESS_SHADER_READ_BIT,
+				VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				VK_IMAGE_LAYOUT_UNDEFINED,
+				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+			);
+
+			RenderPass(commandBuffer, mask, input, m_IntermediateViews[intermediate].get());
+			writeTimestamp(stage);
+
+			commandBuffer.ImageBarrier(
+				image,
+				VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				VK_ACCESS_SHADER_READ_BIT,
+				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+			);
+
+			input = m_InputDescriptors[1 + intermediate].get();
+			intermediate ^= 1;
+		}
+	}
+
+	void PostProcessStack::RenderPass(CommandBuffer& commandBuffer, uint32_t mask, Descriptor* input, ImageView* target)
+	{
+		Pipeline* pipeline = GetPipeline(mask);
+
+		const auto& extents = m_Swapchain->GetExtents();
+
+		VkClearValue clearValue = { { 0.1f, 0.1f, 0.1f, 1.f } };
+		VkRenderingAttachmentInfo colorAttachment = RenderPassSpecification::GetColorAttachmentInfo(*target, &clearValue, VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL);
+		VkRenderingInfo renderingInfo = RenderPassSpecification::CreateRenderingInfo(extents, &colorAttachment, nullptr);
+
+		commandBuffer.BeginRendering(&renderingInfo);
+		commandBuffer.SetViewport(static_cast<float>(extents.width), static_cast<float>(extents.height));
+		commandBuffer.SetScissor(extents.width, extents.height);
+
+		std::vector descs = { input, m_BloomDescriptor.get() };
+
+		commandBuffer.BindDescriptors(descs);
+		commandBuffer.SetDescriptorOffsets(descs, *pipeline);
+
+		commandBuffer.BindPipeline(*pipeline);
+
+		vkCmdPushConstants(commandBuffer, pipeline->GetPipelineLayout(), VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PostProcessParameters), &m_Parameters);
+		vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+
+		commandBuffer.EndRendering();
+	}
+
+	Pipeline* PostProcessStack::GetPipeline(uint32_t mask)
+	{
+		if (auto it = m_Pipelines.find(mask); it != m_Pipelines.end())
+			return it->second.get();
+
+		// One constant per stage, then the output encoding.
+		std::vector<uint32_t> specializationConstants(POST_PROCESS_STAGE_COUNT + 1);
+		for (uint32_t i = 0; i < specializationConstants.size(); i++)
+			specializationConstants[i] = (mask >> i) & 1u;
+
+		auto rasterizationState = Pipeline::SetupRasterizationState();
+		rasterizationState.cullMode = VK_CULL_MODE_FRONT_BIT;
+		rasterizationState.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+		const VkFormat format = (mask & ENCODE_OUTPUT_BIT) ? m_Swapchain->GetImageFormat() : VK_FORMAT_R16G16B16A16_SFLOAT;
+
+		Pipeline* pipeline = PipelineBuilder()
+			.SetShaders(
+				{
+					ShaderRegistry::Get()->Register("..\\Shaders\\QuadVS.hlsl", VK_SHADER_STAGE_VERTEX_BIT),
+					ShaderRegistry::Get()->Register("..\\Shaders\\PostProcess\\PostProcessPS.hlsl", VK_SHADER_STAGE_FRAGMENT_BIT)
+				})
+			.SetColorAttachmentFormats({ format })
+			.SetDescriptorSetLayouts({ m_InputDescriptors[0]->GetLayout(), m_BloomDescriptor->GetLayout() })
+			.SetPushConstants({ VkPushConstantRange{ VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PostProcessParameters) } })
+			.SetRasterizationState(rasterizationState)
+			.SetSpecializationConstants(specializationConstants)
+			.Build(*m_Swapchain);
+
+		m_Pipelines[mask].reset(pipeline);
+		return pipeline;
+	}
+
+	void PostProcessStack::ReadTimings()
+	{
+		// Only one frame is in flight, the previous one is done by the time the next is recorded.
+		if (!m_QueryPool || m_RecordedPasses.empty())
+			return;
+
+		std::array<uint64_t, QUERY_COUNT> timestamps{};
+		const uint32_t count = static_cast<uint32_t>(m_RecordedPasses.size()) + 1;
+
+		if (vkGetQueryPoolResults(*m_Device, m_QueryPool, 0, count, sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+			return;
+
+		const auto toMilliseconds = [&](uint64_t ticks) { return static_cast<float>(static_cast<double>(ticks) * m_TimestampPeriod / 1e6); };
+
+		m_Timings = {};
+		m_Timings.m_Fused = m_RecordedPasses.size() == 1 && m_RecordedPasses[0] == POST_PROCESS_STAGE_COUNT;
+		m_Timings.m_Total = toMilliseconds(timestamps[count - 1] - timestamps[0]);
+
+		for (uint32_t i = 0; i < m_RecordedPasses.size(); i++)
+		{
+			if (m_RecordedPasses[i] < POST_PROCESS_STAGE_COUNT)
+				m_Timings.m_Stages[m_RecordedPasses[i]] = toMilliseconds(timestamps[i + 1] - timestamps[i]);
+		}
+	}
+
+	void PostProcessStack::RecreateImages()
+	{
+		if (!m_Intermediates[0])
+			return;
+
+		DestroyImages();
+		CreateImages();
+	}
+
+	void PostProcessStack::CreateImages()
+	{
+		const auto& extents = m_Swapchain->GetExtents();
+		const VkFormat format = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+		for (uint32_t i = 0; i < m_Intermediates.size(); i++)
+		{
+			m_Intermediates[i] = std::make_unique<Image>(
+				m_Device,
+				extents.width,
+				extents.height,
+				1,
+				format,
+				VK_IMAGE_TILING_OPTIMAL,
+				VK_SAMPLE_COUNT_1_BIT,
+				VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+			);
+
+			m_IntermediateViews[i] = std::make_unique<ImageView>(m_Device, *m_Intermediates[i], 1, format);
+
+			m_InputDescriptors[1 + i]->Bind(
+				{
+					Descriptor::BindingInfo{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, {.m_ImageView = m_IntermediateViews[i].get() }, m_Sampler.get() }
+				}
+			);
+		}
+	}
+
+	void PostProcessStack::DestroyImages()
+	{
+		for (uint32_t i = 0; i < m_Intermediates.size(); i++)
+		{
+			m_IntermediateViews[i].reset();
+			m_Intermediates[i].reset();
+		}
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "../Vulkan/VulkanRenderer.hpp"
+
+#include <array>
+#include <unordered_map>
+
+namespace Engine::Renderer
+{
+	// Stages of the post processing stack, in the order they run. Every stage is a block of PostProcessPS.hlsl enabled by the
+	// specialization constant with the same index, registering a stage means an entry here, a name in GetStageName and a block there.
+	enum PostProcessStage : uint32_t {
+		POST_PROCESS_BLOOM,
+		POST_PROCESS_EXPOSURE,
+		POST_PROCESS_TONEMAP,
+		POST_PROCESS_GRADING,
+		POST_PROCESS_STAGE_COUNT
+	};
+
+	// Parameters of every stage, pushed to each pass. Same layout as the push constants of PostProcessPS.hlsl.
+	struct PostProcessParameters {
+		float m_BloomStrength = 0.06f;
+		float m_Exposure = 0.f;		// In stops.
+		float m_Saturation = 1.f;
+		float m_Contrast = 1.f;
+	};
+
+	// GPU time of the stack in the previous frame, in milliseconds.
+	struct PostProcessTimings {
+		std::array<float, POST_PROCESS_STAGE_COUNT> m_Stages{};	// Unfused only.
+		float m_Total{};
+		bool m_Fused{};
+	};
+
+	// Final pass of the frame, from the HDR target to the swapchain image.
+	// Fused, every enabled stage runs in one fullscreen pass so the HDR target is read once and the swapchain written once.
+	// Unfused (debugging), every stage is a pass of its own through RGBA16F intermediates and is timed on its own.
+	class PostProcessStack {
+	public:
+		PostProcessStack(std::shared_ptr<Device> device, const std::unique_ptr<Swapchain>& swapchain);
+		~PostProcessStack();
+
+		// bloomLayout is the layout the bloom chain is left in by the bloom pass.
+		void Render(CommandBuffer& commandBuffer, ImageView* hdrView, ImageView* bloomView, VkImageLayout bloomLayout, ImageView* target);
+
+		// The unfused intermediates follow the swapchain extents, they are allocated the first time the stack runs unfused.
+		void RecreateImages();
+
+		static const char* GetStageName(PostProcessStage stage);
+
+		std::array<bool, POST_PROCESS_STAGE_COUNT> m_EnabledStages = { true, true, true, true };
+		PostProcessParameters m_Parameters{};
+		bool m_Fused{ true };
+
+		// Empty when the device can't write timestamps from the graphics queue.
+		const PostProcessTimings& GetTimings() const { return m_Timings; }
+	private:
+		// Stage mask of the pass, the bit after the stages encodes to sRGB for the swapchain.
+		static constexpr uint32_t ENCODE_OUTPUT_BIT = 1u << POST_PROCESS_STAGE_COUNT;
+
+		// One timestamp before the first pass and one after every pass.
+		static constexpr uint32_t QUERY_COUNT = POST_PROCESS_STAGE_COUNT + 2;
+
+		Pipeline* GetPipeline(uint32_t mask);
+		void RenderPass(CommandBuffer& commandBuffer, uint32_t mask, Descriptor* input, ImageView* target);
+		void ReadTimings();
+
+		void CreateImages();
+		void DestroyImages();
+
+		std::shared_ptr<Device> m_Device;
+		Swapchain* m_Swapchain;
+
+		// Built on first use, one per stage mask.
+		std::unordered_map<uint32_t, std::unique_ptr<Pipeline>> m_Pipelines{};
+
+		// Input of a pass: the HDR target, then the two intermediates. Separate descriptors, the passes of a frame read different images.
+		std::array<std::unique_ptr<Descriptor>, 3> m_InputDescriptors{};
+		std::unique_ptr<Descriptor> m_BloomDescriptor = nullptr;
+		std::unique_ptr<Sampler> m_Sampler = nullptr;
+
+		std::array<std::unique_ptr<Image>, 2> m_Intermediates{};
+		std::array<std::unique_ptr<ImageView>, 2> m_IntermediateViews{};
+
+		// Timestamps of the previous frame, read back once its fence was waited.
+		VkQueryPool m_QueryPool = VK_NULL_HANDLE;
+		float m_TimestampPeriod{};	// Nanoseconds per tick.
+
+		// Stage of every pass written last frame, POST_PROCESS_STAGE_COUNT for a fused pass.
+		std::vector<uint32_t> m_RecordedPasses{};
+		PostProcessTimings m_Timings{};
+	};
+}
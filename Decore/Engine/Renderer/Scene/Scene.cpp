@@ -5,6 +5,8 @@
 
 #include "../../../../Dependencies/imgui/backends/imgui_impl_vulkan.h"
 
+#include <algorithm>
+
 namespace Engine::Renderer
 {
 	VkPipelineCache pipelineCache = 0;
@@ -74,14 +76,20 @@ namespace Engine::Renderer
 		for (auto& layout : objectLayouts)
 			setLayouts.push_back(layout.GetLayout());
 
+		auto vertexAnimationLayout = Renderer::DescriptorLayout(device, { { 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_ALL, nullptr} });
+
+		// Static assets bind their baked vertex animation after the object sets (see Shaders/VertexAnimation.hlsli).
+		std::vector<VkDescriptorSetLayout> staticSetLayouts = setLayouts;
+		staticSetLayouts.push_back(vertexAnimationLayout);
+
 		SetupDetphPrepass(colorFormats, depthFormat, objectLayouts, setLayouts);
 		// Setup skybox.
-		SetupSkybox(colorFormats, depthFormat, objectLayouts, setLayouts);
+		SetupSkybox(colorFormats, depthFormat, objectLayouts, staticSetLayouts);
 
 		auto msaaMultisampleState = Pipeline::SetupMultiSampleState();
 		msaaMultisampleState.rasterizationSamples = m_Swapchain->GetMSAASamples();
 
-		m_OpaqueGLTFPipeline = PipelineBuilder()
+		auto staticBuilder = PipelineBuilder()
 			.SetShaders(
 				{
 					ShaderRegistry::Get()->Register("..\\Shaders\\GLTF_StaticVS.hlsl", VK_SHADER_STAGE_VERTEX_BIT),
@@ -89,14 +97,16 @@ namespace Engine::Renderer
 				})
 			.SetColorAttachmentFormats(colorFormats)
 			.SetDepthAttachmentFormat(depthFormat)
-			.SetInputAttributeDescriptions(Engine::Assets::StaticGLTFAsset::VertexType::GetInputAttributeDescriptions())
-			.SetInputBindingDescriptions({ Engine::Assets::StaticGLTFAsset::VertexType::GetBindingDescription() })
-			.SetDescriptorSetLayouts(setLayouts)
+			.SetInputAttributeDescriptions(Engine::Assets::StaticGLTFAsset::GetInputAttributeDescriptions())
+			.SetInputBindingDescriptions({ Engine::Assets::StaticGLTFAsset::GetBindingDescription() })
+			.SetDescriptorSetLayouts(staticSetLayouts)
 			.SetPushConstants({ VkPushConstantRange{ VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(uint32_t) } })
-			.SetMultisampleState(msaaMultisampleState)
-			.Build(*m_Swapchain);
-		
-		m_PrePassOpaqueGLTFPipeline = PipelineBuilder()
+			.SetMultisampleState(msaaMultisampleState);
+
+		m_StaticGLTFPipelines = BuildBucketPipelines(staticBuilder, false);
+		m_EqualStaticGLTFPipelines = BuildBucketPipelines(staticBuilder, false, true);
+
+		auto prePassStaticBuilder = PipelineBuilder()
 			.SetShaders(
 				{
 					ShaderRegistry::Get()->Register("..\\Shaders\\GLTF_StaticVS.hlsl", VK_SHADER_STAGE_VERTEX_BIT),
@@ -104,16 +114,27 @@ namespace Engine::Renderer
 				})
 			.SetColorAttachmentFormats({ m_Swapchain->GetImageFormat() })
 			.SetDepthAttachmentFormat(depthFormat)
-			.SetInputAttributeDescriptions(Engine::Assets::StaticGLTFAsset::VertexType::GetInputAttributeDescriptions())
-			.SetInputBindingDescriptions({ Engine::Assets::StaticGLTFAsset::VertexType::GetBindingDescription() })
-			.SetDescriptorSetLayouts(setLayouts)
-			.Build(*m_Swapchain);
+			.SetInputAttributeDescriptions(Engine::Assets::StaticGLTFAsset::GetInputAttributeDescriptions())
+			.SetInputBindingDescriptions({ Engine::Assets::StaticGLTFAsset::GetBindingDescription() })
+			.SetDescriptorSetLayouts(staticSetLayouts);
+
+		m_PrePassStaticGLTFPipelines = BuildBucketPipelines(prePassStaticBuilder, true);
+		m_MSAAPrePassStaticGLTFPipelines = BuildBucketPipelines(prePassStaticBuilder.SetMultisampleState(msaaMultisampleState), true);
+
+		if (device->SupportsMeshShader())
+			SetupMeshletPipelines(colorFormats, depthFormat, setLayouts, msaaMultisampleState);
 
 		auto skinnedJointDescriptor = Renderer::DescriptorLayout(device, { { 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_ALL, nullptr} });
 
+		// Joint palettes, then the morph target deltas.
+		setLayouts.push_back(skinnedJointDescriptor);
 		setLayouts.push_back(skinnedJointDescriptor);
 
-		m_SkinnedGLTFPipeline = PipelineBuilder()
+		// Sets: morphed vertices, deltas, weights, jobs, outputs. All single storage buffers.
+		m_MorphTargetPipeline = new ComputePipeline(Shader("../Shaders/Compute/MorphTargetsCS.hlsl", VK_SHADER_STAGE_COMPUTE_BIT),
+			{ skinnedJointDescriptor, skinnedJointDescriptor, skinnedJointDescriptor, skinnedJointDescriptor, skinnedJointDescriptor }, {}, *m_Swapchain);
+
+		auto skinnedBuilder = PipelineBuilder()
 			.SetShaders(
 				{
 					ShaderRegistry::Get()->Register("..\\Shaders\\GLTF_SkinnedVS.hlsl", VK_SHADER_STAGE_VERTEX_BIT),
@@ -121,14 +142,16 @@ namespace Engine::Renderer
 				})
 			.SetColorAttachmentFormats(colorFormats)
 			.SetDepthAttachmentFormat(depthFormat)
-			.SetInputAttributeDescriptions(Engine::Assets::SkinnedGLTFAsset::VertexType::GetInputAttributeDescriptions())
-			.SetInputBindingDescriptions({ Engine::Assets::SkinnedGLTFAsset::VertexType::GetBindingDescription() })
+			.SetInputAttributeDescriptions(Engine::Assets::SkinnedGLTFAsset::GetInputAttributeDescriptions())
+			.SetInputBindingDescriptions({ Engine::Assets::SkinnedGLTFAsset::GetBindingDescription() })
 			.SetDescriptorSetLayouts(setLayouts)
 			.SetPushConstants({ VkPushConstantRange{ VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(uint32_t) } })
-			.SetMultisampleState(msaaMultisampleState)
-			.Build(*m_Swapchain);
+			.SetMultisampleState(msaaMultisampleState);
 
-		m_PrePassSkinnedGLTFPipeline = PipelineBuilder()
+		m_SkinnedGLTFPipelines = BuildBucketPipelines(skinnedBuilder, false);
+		m_EqualSkinnedGLTFPipelines = BuildBucketPipelines(skinnedBuilder, false, true);
+
+		auto prePassSkinnedBuilder = PipelineBuilder()
 			.SetShaders(
 				{
 					ShaderRegistry::Get()->Register("..\\Shaders\\GLTF_SkinnedVS.hlsl", VK_SHADER_STAGE_VERTEX_BIT),
@@ -136,11 +159,28 @@ namespace Engine::Renderer
 				})
 			.SetColorAttachmentFormats({ m_Swapchain->GetImageFormat() })
 			.SetDepthAttachmentFormat(depthFormat)
-			.SetInputAttributeDescriptions(Engine::Assets::SkinnedGLTFAsset::VertexType::GetInputAttributeDescriptions())
-			.SetInputBindingDescriptions({ Engine::Assets::SkinnedGLTFAsset::VertexType::GetBindingDescription() })
+			.SetInputAttributeDescriptions(Engine::Assets::SkinnedGLTFAsset::GetInputAttributeDescriptions())
+			.SetInputBindingDescriptions({ Engine::Assets::SkinnedGLTFAsset::GetBindingDescription() })
 			.SetDescriptorSetLayouts(setLayouts)
-			.SetPushConstants({ VkPushConstantRange{ VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(uint32_t) } })
-			.Build(*m_Swapchain);
+			.SetPushConstants({ VkPushConstantRange{ VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(uint32_t) } });
+
+		m_PrePassSkinnedGLTFPipelines = BuildBucketPipelines(prePassSkinnedBuilder, true);
+		m_MSAAPrePassSkinnedGLTFPipelines = BuildBucketPipelines(prePassSkinnedBuilder.SetMultisampleState(msaaMultisampleState), true);
+
+		// Same pipelines over full vertices, for the skinned assets that couldn't be packed.
+		if (Assets::BaseGLTFAsset::s_VertexFormat == Assets::VertexFormat::VF_PACKED)
+		{
+			const auto fullAttributes = Engine::Assets::SkinnedGLTFAsset::GetInputAttributeDescriptions(Assets::VertexFormat::VF_FULL);
+			const auto fullBinding = Engine::Assets::SkinnedGLTFAsset::GetBindingDescription(Assets::VertexFormat::VF_FULL);
+
+			skinnedBuilder.SetInputAttributeDescriptions(fullAttributes).SetInputBindingDescriptions({ fullBinding });
+			m_FullSkinnedGLTFPipelines = BuildBucketPipelines(skinnedBuilder, false);
+			m_FullEqualSkinnedGLTFPipelines = BuildBucketPipelines(skinnedBuilder, false, true);
+
+			prePassSkinnedBuilder.SetInputAttributeDescriptions(fullAttributes).SetInputBindingDescriptions({ fullBinding });
+			m_FullMSAAPrePassSkinnedGLTFPipelines = BuildBucketPipelines(prePassSkinnedBuilder, true);
+			m_FullPrePassSkinnedGLTFPipelines = BuildBucketPipelines(prePassSkinnedBuilder.SetMultisampleState(Pipeline::SetupMultiSampleState()), true);
+		}
 
 		auto collisionRasterizationState = Pipeline::SetupRasterizationState();
 		collisionRasterizationState.cullMode = VK_CULL_MODE_NONE;
@@ -172,21 +212,10 @@ namespace Engine::Renderer
 			VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
 		);
 
-		m_ApplyBloomFullscreenDescriptor = new Descriptor(
-			device,
-			{ { 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr } },
-			VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
-		);
-
 		std::vector<VkDescriptorSetLayout> fullscreenLayouts = {
 			m_FullscreenDescriptor->GetLayout()
 		};
 
-		std::vector<VkDescriptorSetLayout> finalFullscreenLayouts = {
-			m_FullscreenDescriptor->GetLayout(),
-			m_ApplyBloomFullscreenDescriptor->GetLayout()
-		};
-
 		auto fullscreenRasterizationState = Pipeline::SetupRasterizationState();
 		fullscreenRasterizationState.cullMode = VK_CULL_MODE_FRONT_BIT;
 		fullscreenRasterizationState.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
@@ -239,16 +268,20 @@ namespace Engine::Renderer
 			.SetColorBlendAttachmentStates({ upscaleBlendAttachmentState })
 			.Build(*m_Swapchain);
 
-		m_FullscreenPipeline = PipelineBuilder()
-			.SetShaders(
-				{
-					ShaderRegistry::Get()->Register("..\\Shaders\\QuadVS.hlsl", VK_SHADER_STAGE_VERTEX_BIT),
-					ShaderRegistry::Get()->Register("..\\Shaders\\QuadPS.hlsl", VK_SHADER_STAGE_FRAGMENT_BIT)
-				})
-			.SetColorAttachmentFormats({ m_Swapchain->GetImageFormat() })
-			.SetDescriptorSetLayouts(finalFullscreenLayouts)
-			.SetRasterizationState(fullscreenRasterizationState)
-			.Build(*m_Swapchain);
+		if (device->SupportsComputeQuadOperations())
+		{
+			const VkDescriptorSetLayout levelLayout = m_ComputeBloomLevelDescriptors[0]->GetLayout();
+
+			// Sets: HDR frame, then the four levels.
+			m_BloomDownsampleComputePipeline = new ComputePipeline(Shader("../Shaders/Bloom/BloomDownsampleCS.hlsl", VK_SHADER_STAGE_COMPUTE_BIT),
+				{ m_ComputeBloomSourceDescriptor->GetLayout(), levelLayout, levelLayout, levelLayout, levelLayout }, {}, *m_Swapchain);
+
+			// Sets: the four levels, level 0 is written in place.
+			m_BloomUpsampleComputePipeline = new ComputePipeline(Shader("../Shaders/Bloom/BloomUpsampleCS.hlsl", VK_SHADER_STAGE_COMPUTE_BIT),
+				{ levelLayout, levelLayout, levelLayout, levelLayout }, {}, *m_Swapchain);
+		}
+
+		m_PostProcess = new PostProcessStack(device, swapchain);
 
 		m_SceneDescriptors = {
 			m_SceneDescriptor,
@@ -257,17 +290,46 @@ namespace Engine::Renderer
 			m_ShadowMapPass->GetCascadeDescriptor().get(),
 			m_SSAOImageDescriptor
 		};
+
+		// Reset as a whole before every recording.
+		for (auto& recorder : m_PassRecorders)
+		{
+			recorder.m_CommandPool = std::make_shared<CommandPool>(*device, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+			recorder.m_CommandBuffer = new CommandBuffer(device, recorder.m_CommandPool, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+		}
 	}
 
 	Scene::~Scene()
 	{
+		for (auto& recorder : m_PassRecorders)
+			delete recorder.m_CommandBuffer;
+
 		delete m_ShadowMapPass;
+		delete m_PostProcess;
 		delete m_SkyboxPipeline;
 		delete m_SceneDescriptor;
 		delete m_SceneUniforms;
 		delete m_SkyboxPipeline;
-		delete m_OpaqueGLTFPipeline;
-		delete m_SkinnedGLTFPipeline;
+		for (auto* pipelines : { &m_StaticGLTFPipelines, &m_SkinnedGLTFPipelines, &m_EqualStaticGLTFPipelines, &m_EqualSkinnedGLTFPipelines,
+			&m_PrePassStaticGLTFPipelines, &m_PrePassSkinnedGLTFPipelines, &m_MSAAPrePassStaticGLTFPipelines, &m_MSAAPrePassSkinnedGLTFPipelines,
+			&m_FullSkinnedGLTFPipelines, &m_FullEqualSkinnedGLTFPipelines, &m_FullPrePassSkinnedGLTFPipelines, &m_FullMSAAPrePassSkinnedGLTFPipelines })
+		{
+			for (auto* pipeline : *pipelines)
+				delete pipeline;
+		}
+		delete m_MeshletGLTFPipeline;
+		delete m_PrePassMeshletGLTFPipeline;
+		delete m_EqualMeshletGLTFPipeline;
+		delete m_MSAAPrePassMeshletGLTFPipeline;
+		delete m_MorphTargetPipeline;
+		delete m_BloomDownsampleComputePipeline;
+		delete m_BloomUpsampleComputePipeline;
+
+		for (auto* descriptor : m_ComputeBloomLevelDescriptors)
+			delete descriptor;
+
+		delete m_ComputeBloomSourceDescriptor;
+		DestroyBloomImages();
 		delete m_ActiveEnvironment;
 		delete m_SkyCube;
 	}
@@ -294,8 +356,8 @@ namespace Engine::Renderer
 				})
 			.SetColorAttachmentFormats(colorFormats)
 			.SetDepthAttachmentFormat(depthFormat)
-			.SetInputAttributeDescriptions(Engine::Assets::StaticGLTFAsset::VertexType::GetInputAttributeDescriptions())
-			.SetInputBindingDescriptions({ Engine::Assets::StaticGLTFAsset::VertexType::GetBindingDescription() })
+			.SetInputAttributeDescriptions(Engine::Assets::StaticGLTFAsset::GetInputAttributeDescriptions())
+			.SetInputBindingDescriptions({ Engine::Assets::StaticGLTFAsset::GetBindingDescription() })
 			.SetDescriptorSetLayouts(setLayouts)
 			.SetDepthStencilState(depthState)
 			.SetRasterizationState(skyRasterizationState)
@@ -314,6 +376,117 @@ namespace Engine::Renderer
 		m_ImguiDepthPrePass = ImGui_ImplVulkan_AddTexture( *m_PrePassDepthSampler, *( m_Swapchain->m_PrePassDepthImageView ), VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL );
 	}
 
+	void Scene::SetupMeshletPipelines(const std::vector<VkFormat>& colorFormats, VkFormat depthFormat, const std::vector<VkDescriptorSetLayout>& setLayouts, const VkPipelineMultisampleStateCreateInfo& multisampleState)
+	{
+		// Same descriptors as the vertex path, the task and mesh stages need their own layouts for the sets they read.
+		auto uniformLayout = Renderer::DescriptorLayout(m_Device, { { 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_ALL, nullptr} });
+		auto storageLayout = Renderer::DescriptorLayout(m_Device, { { 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_ALL, nullptr} });
+		auto samplerLayout = Renderer::DescriptorLayout(m_Device, { { 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_ALL, nullptr} });
+
+		// See Shaders/Meshlet/MeshletCommon.glsl.
+		std::vector<VkDescriptorSetLayout> meshletSetLayouts = setLayouts;
+		meshletSetLayouts[0] = uniformLayout;
+		meshletSetLayouts[7] = storageLayout;
+
+		meshletSetLayouts.insert(meshletSetLayouts.end(), { storageLayout, storageLayout, storageLayout, storageLayout, uniformLayout, samplerLayout });
+
+		// The fragment shader keeps offset 0 (SSAO toggle), the task shader reads the meshlet count after it.
+		const std::vector<VkPushConstantRange> pushConstants = {
+			VkPushConstantRange{ VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(uint32_t) },
+			VkPushConstantRange{ VK_SHADER_STAGE_TASK_BIT_EXT, sizeof(uint32_t), sizeof(uint32_t) }
+		};
+
+		// Meshlets are only built for the opaque single sided bucket, no alpha test.
+		auto meshletBuilder = PipelineBuilder()
+			.SetShaders(
+				{
+					ShaderRegistry::Get()->Register("..\\Shaders\\Meshlet\\MeshletTS.glsl", VK_SHADER_STAGE_TASK_BIT_EXT),
+					ShaderRegistry::Get()->Register("..\\Shaders\\Meshlet\\MeshletMS.glsl", VK_SHADER_STAGE_MESH_BIT_EXT),
+					ShaderRegistry::Get()->Register("..\\Shaders\\DecorePBR_Standard.hlsl", VK_SHADER_STAGE_FRAGMENT_BIT)
+				})
+			.SetColorAttachmentFormats(colorFormats)
+			.SetDepthAttachmentFormat(depthFormat)
+			.SetDescriptorSetLayouts(meshletSetLayouts)
+			.SetPushConstants(pushConstants)
+			.SetMultisampleState(multisampleState)
+			.SetSpecializationConstants({ VK_FALSE });
+
+		m_MeshletGLTFPipeline = meshletBuilder.Build(*m_Swapchain);
+
+		auto equalDepthState = Pipeline::SetupDepthStencilState();
+		equalDepthState.depthCompareOp = VK_COMPARE_OP_EQUAL;
+		equalDepthState.depthWriteEnable = VK_FALSE;
+
+		m_EqualMeshletGLTFPipeline = meshletBuilder
+			.SetDepthStencilState(equalDepthState)
+			.Build(*m_Swapchain);
+
+		auto prePassMeshletBuilder = PipelineBuilder()
+			.SetShaders(
+				{
+					ShaderRegistry::Get()->Register("..\\Shaders\\Meshlet\\MeshletTS.glsl", VK_SHADER_STAGE_TASK_BIT_EXT),
+					ShaderRegistry::Get()->Register("..\\Shaders\\Meshlet\\MeshletMS.glsl", VK_SHADER_STAGE_MESH_BIT_EXT),
+					ShaderRegistry::Get()->Register("..\\Shaders\\PrePass\\StaticPrepassPS.hlsl", VK_SHADER_STAGE_FRAGMENT_BIT)
+				})
+			.SetColorAttachmentFormats({ m_Swapchain->GetImageFormat() })
+			.SetDepthAttachmentFormat(depthFormat)
+			.SetDescriptorSetLayouts(meshletSetLayouts)
+			.SetPushConstants(pushConstants)
+			.SetSpecializationConstants({ VK_FALSE });
+
+		m_PrePassMeshletGLTFPipeline = prePassMeshletBuilder.Build(*m_Swapchain);
+
+		m_MSAAPrePassMeshletGLTFPipeline = prePassMeshletBuilder
+			.SetMultisampleState(multisampleState)
+			.Build(*m_Swapchain);
+	}
+
+	void Scene::RenderMeshletObjects(CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline)
+	{
+		for (auto& asset : m_SceneModels)
+		{
+			Assets::StaticGLTFAsset* staticGLTF = dynamic_cast<Assets::StaticGLTFAsset*>(asset);
+			if (staticGLTF && !staticGLTF->HasVertexAnimation())
+				staticGLTF->RenderMeshlets(commandBuffer, pipeline, m_SceneDescriptors, m_Culler->GetMeshletDescriptors());
+		}
+	}
+
+	Assets::DrawBucketPipelines_t Scene::BuildBucketPipelines(PipelineBuilder& builder, bool depthOnly, bool depthEqual)
+	{
+		Assets::DrawBucketPipelines_t pipelines{};
+
+		for (uint32_t i = 0; i < Assets::DRAW_BUCKET_COUNT; i++)
+		{
+			const auto bucket = static_cast<Assets::DrawBucket>(i);
+			if ((depthOnly || depthEqual) && Assets::IsBlended(bucket))
+				continue;
+
+			auto rasterizationState = Pipeline::SetupRasterizationState();
+			if (Assets::IsDoubleSided(bucket))
+				rasterizationState.cullMode = VK_CULL_MODE_NONE;
+
+			// Only blended draws read the target back, they test against the depth without writing it.
+			auto colorBlendAttachmentState = Pipeline::SetupDefaultColorBlendAttachmentState();
+			colorBlendAttachmentState.blendEnable = Assets::IsBlended(bucket);
+
+			auto depthStencilState = Pipeline::SetupDepthStencilState();
+			depthStencilState.depthWriteEnable = !Assets::IsBlended(bucket) && !depthEqual;
+
+			// The prepass already discarded the cut out texels, only what it kept passes EQUAL.
+			if (depthEqual)
+				depthStencilState.depthCompareOp = VK_COMPARE_OP_EQUAL;
+
+			pipelines[i] = builder
+				.SetRasterizationState(rasterizationState)
+				.SetColorBlendAttachmentStates({ colorBlendAttachmentState })
+				.SetDepthStencilState(depthStencilState)
+				.SetSpecializationConstants({ Assets::IsAlphaTested(bucket) && !depthEqual })
+				.Build(*m_Swapchain);
+		}
+
+		return pipelines;
+	}
+
 	void Scene::SetupSSAOPass()
 	{
 		const auto& extents = m_Swapchain->GetExtents();
@@ -371,6 +544,16 @@ namespace Engine::Renderer
 			delete m_EmissionImageViews[i];
 			m_EmissionImageViews[i] = nullptr;
 		}
+
+		for (auto& view : m_ComputeBloomLevelViews) {
+			delete view;
+			view = nullptr;
+		}
+
+		delete m_ComputeBloomImageView;
+		delete m_ComputeBloomImage;
+		m_ComputeBloomImageView = nullptr;
+		m_ComputeBloomImage = nullptr;
 	}
 
 	void Scene::CreateBloomImages(bool createDescriptors)
@@ -443,6 +626,59 @@ namespace Engine::Renderer
 			m_UpsampleImageViews.push_back(m_EmissionImageViews[mipLevel]);
 			--mipLevel;
 		}
+
+		if (!m_Device->SupportsComputeQuadOperations())
+			return;
+
+		// Compute chain, starts at half resolution. Stays in GENERAL, written by both dispatches and sampled by the final pass.
+		constexpr const VkFormat computeFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+		m_ComputeBloomImage = new Image(
+			m_Device,
+			std::max(m_BloomImageWidth >> 1, 1u),
+			std::max(m_BloomImageHeight >> 1, 1u),
+			COMPUTE_BLOOM_LEVELS,
+			computeFormat,
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_SAMPLE_COUNT_1_BIT,
+			VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		);
+
+		// Level 0 only, the final pass samples the finished chain there.
+		m_ComputeBloomImageView = new ImageView(m_Device, *m_ComputeBloomImage, 1, computeFormat);
+
+		if (createDescriptors)
+		{
+			m_ComputeBloomSourceDescriptor = new Descriptor(
+				m_Device,
+				{ { 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr } },
+				VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+			);
+		}
+
+		for (uint32_t i = 0; i < COMPUTE_BLOOM_LEVELS; i++)
+		{
+			VkImageViewCreateInfo createInfo = ImageView::GetDefault2DCreateInfo(*m_ComputeBloomImage, 1, computeFormat);
+			createInfo.subresourceRange.baseMipLevel = i;
+
+			m_ComputeBloomLevelViews[i] = new ImageView(m_Device, *m_ComputeBloomImage, 1, computeFormat, &createInfo);
+
+			if (createDescriptors)
+			{
+				m_ComputeBloomLevelDescriptors[i] = new Descriptor(
+					m_Device,
+					{ { 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr } },
+					VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+				);
+			}
+
+			m_ComputeBloomLevelDescriptors[i]->Bind(
+				{
+					Descriptor::BindingInfo{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, {.m_ImageView = m_ComputeBloomLevelViews[i] } }
+				}
+			);
+		}
 	}
 
 	bool Scene::RenderCollisions()
@@ -548,92 +784,66 @@ namespace Engine::Renderer
 	{
 		PreRender(frameId, commandBuffer, computeCommandBuffer, callback);
 
+		const bool debuggingColliders = RenderCollisions();
+		m_ShadowMapPass->Update(computeCommandBuffer, m_MainCamera, LightDirection, m_Culler, m_SceneModels, GetVertexAnimationTime());
+
+		m_PrepassDepthReused = m_ReusePrepassDepth && !debuggingColliders;
+
+		RecordPasses(debuggingColliders);
+
 		RenderDepthPrepass(frameId, commandBuffer, computeCommandBuffer);
 		RenderSSAOPass(frameId, commandBuffer, computeCommandBuffer);
 
+		for (uint32_t i = 0; i < SHADOW_MAP_CASCADES; i++)
+		{
+			m_ShadowMapPass->BeginCascade(commandBuffer, i, VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT);
+			commandBuffer.ExecuteCommands({ m_PassRecorders[RECORDED_PASS_SHADOW_CASCADES + i].m_CommandBuffer });
+			commandBuffer.EndRendering();
+		}
+
 		// Main Forward Color Pass
 		{
 			ImageView* depthTarget = m_Swapchain->m_DepthImageView;
-
-			Image* msaaImage = m_Swapchain->m_MSAAImage;
 			ImageView* msaaTarget = m_Swapchain->m_MSAAImageView;
-
-			Image* hdrImage = m_Swapchain->m_HDRImage;
 			ImageView* hdrTarget = m_Swapchain->m_HDRImageView;
 
-			VkClearValue clearValue = { { 0.1f, 0.1f, 0.1f, 1.f } };
-			VkRenderingAttachmentInfo colorAttachment = RenderPassSpecification::GetColorAttachmentInfo(*msaaTarget, &clearValue, VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL, VK_RESOLVE_MODE_AVERAGE_BIT, *hdrTarget, VK_IMAGE_LAYOUT_GENERAL);
-			VkRenderingAttachmentInfo depthAttachment = RenderPassSpecification::GetDepthAttachmentInfo(*depthTarget, VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL);
-
-			const auto& extents = m_Swapchain->GetExtents();
-
-			const auto objectDraw =
-				[&](const std::vector<Descriptor*>& _sceneDescriptors, Renderer::Pipeline* _pipeline, bool isStatic, int bufferIndex) -> void
-				{
-					if (isStatic)
-					{
-						for (auto& asset : m_SceneModels)
-							asset->Render(commandBuffer, _pipeline, _sceneDescriptors, bufferIndex);
-					}
-					else
-					{
-						for (auto& asset : m_SkinnedSceneModels)
-							asset->Render(commandBuffer, _pipeline, _sceneDescriptors, bufferIndex);
-					}
-				};
-
-			m_ShadowMapPass->Render(commandBuffer, computeCommandBuffer, m_MainCamera, LightDirection, m_Culler, m_SceneModels, objectDraw);
-
+			// The prepass depth has to be written before the forward depth tests read it.
+			if (m_PrepassDepthReused)
 			{
-				VkRenderingInfo renderingInfo = RenderPassSpecification::CreateRenderingInfo(m_Swapchain->GetExtents(), &colorAttachment, &depthAttachment);
-
-				commandBuffer.BeginRendering(&renderingInfo);
-				commandBuffer.SetViewport(static_cast<float>(extents.width), static_cast<float>(extents.height));
-				commandBuffer.SetScissor(extents.width, extents.height);
-
-				{
-					bool debuggingColliders = RenderCollisions();
-					if (!debuggingColliders)
-						m_SkyCube->Render(commandBuffer, m_SkyboxPipeline, m_SceneDescriptors);
-
-					uint32_t ssaoEnabled = m_SSAOEnabled;
-					vkCmdPushConstants(commandBuffer, m_OpaqueGLTFPipeline->GetPipelineLayout(), VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(ssaoEnabled), &ssaoEnabled);
-
-					// Draw Scene Objects to standard pass.
-					if (!debuggingColliders)
-						objectDraw(m_SceneDescriptors, m_OpaqueGLTFPipeline, true, 0);
-
-					// Draw Skinned Scene Objects to standard pass.
-					objectDraw(m_SceneDescriptors, m_SkinnedGLTFPipeline, false, 0);
-
-					if (debuggingColliders)
-					{
-						vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, *m_CollisionDebugPipeline);
-
-						const VkDeviceSize offsets[1] = { 0 };
-						const VkBuffer vertexBuffer = *m_CollisionDebugVertexBuffer;
-						vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, offsets);
-
-						struct {
-							glm::mat4 m1;
-							glm::mat4 m2;
-						} data = {};
-
-						data.m1 = m_MainCamera.GetViewMatrix();
-						data.m2 = m_MainCamera.GetProjectionMatrix();
+				commandBuffer.ImageBarrier(
+					*m_Swapchain->m_DepthImage,
+					VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+					VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+					VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
+					VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
+					VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+					VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+					VkImageSubresourceRange{ VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 }
+				);
+			}
 
-						vkCmdPushConstants(commandBuffer, m_CollisionDebugPipeline->GetPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(data), &data);
-						vkCmdDraw(commandBuffer, static_cast<uint32_t>(debugVertexBufferSize), 1, 0, 0);
-					}
-				}
+			VkClearValue clearValue = { { 0.1f, 0.1f, 0.1f, 1.f } };
+			VkRenderingAttachmentInfo colorAttachment = RenderPassSpecification::GetColorAttachmentInfo(*msaaTarget, &clearValue, VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL, VK_RESOLVE_MODE_AVERAGE_BIT, *hdrTarget, VK_IMAGE_LAYOUT_GENERAL);
+			VkRenderingAttachmentInfo depthAttachment = RenderPassSpecification::GetDepthAttachmentInfo(*depthTarget, VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL, !m_PrepassDepthReused);
 
-				commandBuffer.EndRendering();
-			}
+			VkRenderingInfo renderingInfo = RenderPassSpecification::CreateRenderingInfo(m_Swapchain->GetExtents(), &colorAttachment, &depthAttachment);
+			renderingInfo.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
 
+			commandBuffer.BeginRendering(&renderingInfo);
+			commandBuffer.ExecuteCommands({ m_PassRecorders[RECORDED_PASS_FORWARD].m_CommandBuffer });
+			commandBuffer.EndRendering();
 		}
 
 		RenderBloomPass(frameId, commandBuffer, computeCommandBuffer);
 		RenderFinalPass(frameId, commandBuffer, computeCommandBuffer);
+
+		// Everything of the scene is recorded, the debug UI shows this frame.
+		m_BindStats = commandBuffer.GetBindStats();
+		m_BindStats += computeCommandBuffer.GetBindStats();
+
+		for (auto& recorder : m_PassRecorders)
+			m_BindStats += recorder.m_CommandBuffer->GetBindStats();
+
 		EndRender(frameId, commandBuffer, computeCommandBuffer, callback);
 
 		// Transition image layout to be presentable.
@@ -658,6 +868,8 @@ namespace Engine::Renderer
 		DestroyBloomImages();
 		CreateBloomImages(false);
 
+		m_PostProcess->RecreateImages();
+
 		FFX_CACAO_VkScreenSizeInfo screenSizeInfo = {};
 		screenSizeInfo.width = extents.width/* width of the input/output buffers */;
 		screenSizeInfo.height = extents.height/* height of the input/output buffers */;
@@ -666,20 +878,170 @@ namespace Engine::Renderer
 		screenSizeInfo.output = *m_SSAOImage/* a VkImage for writing the output of FFX CACAO */;
 		screenSizeInfo.outputView = *m_SSAOImageView/* a VkImageView corresponding to the VkImage for writing the output of FFX CACAO */;
 		auto status = FFX_CACAO_VkInitScreenSizeDependentResources(m_CacaoContext, &screenSizeInfo);
+
+		if (m_Culler)
+			m_Culler->RecreateDepthPyramid();
 	}
 
-	void Scene::PreRender(uint32_t frameId, CommandBuffer& commandBuffer, CommandBuffer& computeCommandBuffer, std::function<void()> callback)
+	void Scene::RegisterAnimatedAsset(Assets::BaseAsset* asset)
+	{
+		if (auto* skinned = dynamic_cast<Assets::SkinnedGLTFAsset*>(asset))
+			m_AnimatedModels.push_back(skinned);
+	}
+
+	void Scene::RegisterCollisionAsset(Assets::BaseAsset* asset)
+	{
+		if (auto* collision = dynamic_cast<Assets::StaticGLTFAsset*>(asset))
+			m_CollisionModels.push_back(collision);
+	}
+
+	void Scene::RegisterVertexAnimation(Assets::BaseAsset* asset)
 	{
-		// Update skinned mesh animations.
-		for (auto& skinnedModel : m_SkinnedSceneModels)
+		auto* crowd = dynamic_cast<Assets::CrowdGLTFAsset*>(asset);
+		if (!crowd || crowd->GetVertexAnimation().m_FrameCount == 0)
+			return;
+
+		// Same frame rate as the shader reads, the clip wraps after exactly frame count frames.
+		const auto& animation = crowd->GetVertexAnimation();
+		const double length = animation.m_FrameCount / static_cast<double>(animation.m_FrameRate);
+
+		if (m_VertexAnimationPeriod == 0.0)
+		{
+			m_VertexAnimationPeriod = length;
+			return;
+		}
+
+		// Smallest multiple of the current period that also holds a whole number of this clip.
+		for (uint32_t n = 1; n <= 1024; n++)
+		{
+			const double cycles = m_VertexAnimationPeriod * n / length;
+
+			if (std::abs(cycles - std::round(cycles)) < 1e-4)
+			{
+				m_VertexAnimationPeriod *= n;
+				return;
+			}
+		}
+
+		printf("%s: no common period with the other baked clips, it jumps every %.2f s.\n", crowd->GetName().c_str(), m_VertexAnimationPeriod);
+	}
+
+	float Scene::GetVertexAnimationTime() const
+	{
+		const double time = Core::TimeSystem::GetTime();
+		return static_cast<float>(m_VertexAnimationPeriod > 0.0 ? std::fmod(time, m_VertexAnimationPeriod) : time);
+	}
+
+	void Scene::SelectAnimationLods()
+	{
+		using AnimationUpdate = Assets::SkinnedGLTFAsset::AnimationUpdate;
+
+		m_AnimatedInstances.clear();
+
+		for (auto* asset : m_AnimatedModels)
+		{
+			for (uint32_t i = 0; i < asset->GetInstanceCount(); i++)
+				m_AnimatedInstances.emplace_back(asset, i);
+		}
+
+		m_AnimationLodStats = {};
+
+		if (m_AnimatedInstances.empty())
+			return;
+
+		const glm::mat4 viewMatrix = m_MainCamera.GetViewMatrix();
+		const glm::mat4 projectionMatrix = m_MainCamera.GetProjectionMatrix();
+
+		// Side planes of the view in world space (Gribb/Hartmann), the depth range does not matter here.
+		const glm::mat4 viewProjectionT = glm::transpose(projectionMatrix * viewMatrix);
+
+		std::array<glm::vec4, 4> planes = { viewProjectionT[3] + viewProjectionT[0], viewProjectionT[3] - viewProjectionT[0], viewProjectionT[3] + viewProjectionT[1], viewProjectionT[3] - viewProjectionT[1] };
+		for (auto& plane : planes)
+			plane /= glm::length(glm::vec3(plane));
+
+		const glm::vec3 cameraPos = glm::inverse(viewMatrix)[3];
+		const float projectionScale = glm::abs(projectionMatrix[1][1]);
+
+		std::array<uint32_t, ANIMATION_LOD_COUNT> sampled{};
+
+		// Starts somewhere else every frame so budgets do not always favour the same instances.
+		const uint32_t count = static_cast<uint32_t>(m_AnimatedInstances.size());
+		const uint32_t first = m_AnimationFrame % count;
+
+		for (uint32_t n = 0; n < count; n++)
 		{
-			if (!skinnedModel)
+			auto& [asset, index] = m_AnimatedInstances[(first + n) % count];
+			auto* instance = asset->GetInstance(index);
+
+			const glm::vec4 sphere = asset->GetBoundingSphere(*instance);
+			const glm::vec3 center = sphere;
+
+			bool visible = true;
+			for (const auto& plane : planes)
+				visible = visible && glm::dot(glm::vec3(plane), center) + plane.w > -sphere.w;
+
+			if (!visible)
+			{
+				instance->m_Update = AnimationUpdate::Skip;
+				m_AnimationLodStats.m_Culled++;
 				continue;
+			}
+
+			const float screenSize = sphere.w * projectionScale / std::max(glm::length(center - cameraPos), m_MainCamera.GetNearClip());
+
+			uint32_t lod = 0;
+			while (lod < ANIMATION_LOD_COUNT - 1 && screenSize < m_AnimationLods[lod].m_MinScreenSize)
+				lod++;
+
+			const auto& tier = m_AnimationLods[lod];
+			const uint32_t interval = std::max(tier.m_SampleInterval, 1u);
+
+			instance->m_Lod = lod;
+			instance->m_SampleInterval = interval;
+			instance->m_SkipLeafJoints = tier.m_SkipLeafJoints;
+
+			// Phased by instance so a crowd does not sample on the same frame, late ones catch up.
+			const bool due = !instance->m_HistoryValid || interval == 1 || (m_AnimationFrame + index) % interval == 0 || instance->m_FramesSinceSample + 1 >= interval * 2;
+			const bool overBudget = tier.m_Budget > 0 && sampled[lod] >= tier.m_Budget;
+
+			if (due && !overBudget)
+			{
+				instance->m_Update = AnimationUpdate::Sample;
+				sampled[lod]++;
+				m_AnimationLodStats.m_Sampled[lod]++;
+				continue;
+			}
+
+			if (due)
+				m_AnimationLodStats.m_Deferred++;
 
-			if (Assets::SkinnedGLTFAsset* asset = dynamic_cast<Assets::SkinnedGLTFAsset*>(skinnedModel))
-				asset->UpdateAnimation(asset->m_ActiveAnimIndex, Core::TimeSystem::GetDeltaTime());
+			// Without sampled history there is nothing to blend, the palette holds until the next sample.
+			instance->m_Update = instance->m_HistoryValid ? AnimationUpdate::Interpolate : AnimationUpdate::Skip;
+
+			if (instance->m_HistoryValid)
+				m_AnimationLodStats.m_Interpolated[lod]++;
 		}
 
+		m_AnimationFrame++;
+	}
+
+	void Scene::PreRender(uint32_t frameId, CommandBuffer& commandBuffer, CommandBuffer& computeCommandBuffer, std::function<void()> callback)
+	{
+		// Update skinned mesh animations. Every instance owns its hierarchy and palette range, one job per instance.
+		SelectAnimationLods();
+
+		const float dt = Core::TimeSystem::GetDeltaTime();
+
+		Core::JobSystem::Get()->ParallelFor(static_cast<uint32_t>(m_AnimatedInstances.size()), 4, [this, dt](uint32_t i)
+		{
+			auto& [asset, instance] = m_AnimatedInstances[i];
+			asset->UpdateInstance(instance, dt);
+		});
+
+		// Blend shapes of the instances whose weights changed, read by every skinned pass of this frame.
+		for (auto* asset : m_AnimatedModels)
+			asset->DispatchMorphTargets(computeCommandBuffer, m_MorphTargetPipeline);
+
 		// Update Scene Uniforms.
 		m_Uniforms.ModelMatrix = glm::mat4(1.f);
 		m_Uniforms.ModelMatrix[2][2] *= -1.f;
@@ -690,12 +1052,17 @@ namespace Engine::Renderer
 		m_Uniforms.CamPos = glm::inverse(m_Uniforms.ViewMatrix)[3];
 		m_Uniforms.LightDirection = LightDirection;
 		m_Uniforms.LightColor = LightColor;
+		m_Uniforms.Time = glm::vec4(GetVertexAnimationTime(), 0.f, 0.f, 0.f);
 
 		m_SceneUniforms->Patch(&m_Uniforms, sizeof(m_Uniforms));
 	
 		if (Core::InputSystem::GetKeyPressed('C'))
 			m_FreezeFrustum = !m_FreezeFrustum;
 
+		// The mesh shader path only draws meshlet geometry.
+		if (Core::InputSystem::GetKeyPressed('M') && m_MeshletGLTFPipeline && m_Culler && Assets::BaseGLTFAsset::s_BuildMeshlets)
+			m_MeshShading = !m_MeshShading;
+
 		if (!m_FreezeFrustum)
 			m_Culler->Cull(m_MainCamera.GetViewMatrix(), m_MainCamera.GetProjectionMatrix(), m_MainCamera.GetNearClip(), m_MainCamera.GetFarClip(), computeCommandBuffer, m_SceneModels);
 	}
@@ -716,6 +1083,7 @@ namespace Engine::Renderer
 		commandBuffer.SetScissor(extents.width, extents.height);
 
 		callback();
+		commandBuffer.InvalidateBindings();
 
 		commandBuffer.EndRendering();
 	}
@@ -733,6 +1101,39 @@ namespace Engine::Renderer
 		VkRenderingAttachmentInfo depthAttachment = RenderPassSpecification::GetDepthAttachmentInfo( *depthTarget, VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL );
 		VkRenderingAttachmentInfo colorAttachment = RenderPassSpecification::GetColorAttachmentInfo( *normalsTarget, &clear, VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL );
 
+		// Rendered into the MSAA targets of the forward pass instead, the single sampled ones receive the resolve.
+		// Sample zero is the only depth resolve every device supports.
+		if ( m_PrepassDepthReused )
+		{
+			Image* msaaDepthImage = m_Swapchain->m_DepthImage;
+			Image* msaaNormalsImage = m_Swapchain->m_PrePassMSAANormalsImage;
+
+			depthAttachment = RenderPassSpecification::GetDepthAttachmentInfo( *m_Swapchain->m_DepthImageView, VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL, true, VK_RESOLVE_MODE_SAMPLE_ZERO_BIT, *depthTarget, VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL );
+			colorAttachment = RenderPassSpecification::GetColorAttachmentInfo( *m_Swapchain->m_PrePassMSAANormalsImageView, &clear, VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL, VK_RESOLVE_MODE_AVERAGE_BIT, *normalsTarget, VK_IMAGE_LAYOUT_GENERAL );
+
+			commandBuffer.ImageBarrier(
+				*msaaDepthImage,
+				0,
+				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+				VK_IMAGE_LAYOUT_UNDEFINED,
+				VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
+				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+				VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+				VkImageSubresourceRange{ VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 }
+			);
+
+			commandBuffer.ImageBarrier(
+				*msaaNormalsImage,
+				0,
+				VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				VK_IMAGE_LAYOUT_UNDEFINED,
+				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+				VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+			);
+		}
+
 		commandBuffer.ImageBarrier(
 			*depthImage,
 			0,
@@ -758,47 +1159,20 @@ namespace Engine::Renderer
 		const auto& extents = m_Swapchain->GetExtents( );
 
 		VkRenderingInfo renderingInfo = RenderPassSpecification::CreateRenderingInfo( extents, &colorAttachment, &depthAttachment );
+		renderingInfo.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
 
 		commandBuffer.BeginRendering( &renderingInfo );
-		commandBuffer.SetViewport( static_cast< float >( extents.width ), static_cast< float >( extents.height ) );
-		commandBuffer.SetScissor( extents.width, extents.height );
-
-		const auto objectDraw =
-			[ & ]( const std::vector<Descriptor*>& _sceneDescriptors, Renderer::Pipeline* _pipeline, bool isStatic, int bufferIndex ) -> void
-		{
-			if ( isStatic )
-			{
-				for ( auto& asset : m_SceneModels )
-				{
-					asset->Render( commandBuffer, _pipeline, _sceneDescriptors, bufferIndex );
-				}
-			}
-			else
-			{
-				for ( auto& asset : m_SkinnedSceneModels )
-				{
-					asset->Render( commandBuffer, _pipeline, _sceneDescriptors, bufferIndex );
-				}
-			}
-		};
-
-		{
-			// Draw Scene Objects to depth pre-pass.
-			objectDraw( m_SceneDescriptors, m_PrePassOpaqueGLTFPipeline, true, 0 );
-
-			// Draw Skinned Scene Objects to depth pre-pass.
-			objectDraw( m_SceneDescriptors, m_PrePassSkinnedGLTFPipeline, false, 0 );
-		}
-
+		commandBuffer.ExecuteCommands( { m_PassRecorders[ RECORDED_PASS_PREPASS ].m_CommandBuffer } );
 		commandBuffer.EndRendering( );
 
+		// Depth resolves are written in the color attachment output stage.
 		commandBuffer.ImageBarrier(
 			*depthImage,
-			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
 			0,
 			VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
 			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
 			VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
 			VkImageSubresourceRange{ VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 }
 		);
@@ -813,6 +1187,23 @@ namespace Engine::Renderer
 			VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
 			VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
 		);
+
+		// Occlusion culling input for the next frame.
+		if ( m_Culler && !m_FreezeFrustum )
+		{
+			commandBuffer.ImageBarrier(
+				*depthImage,
+				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+				VK_ACCESS_SHADER_READ_BIT,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VkImageSubresourceRange{ VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 }
+			);
+
+			m_Culler->BuildDepthPyramid( commandBuffer, depthTarget, m_Uniforms.ViewMatrix, m_Uniforms.ProjectionMatrix );
+		}
 	}
 
 	void Scene::RenderSSAOPass(uint32_t frameId, CommandBuffer& commandBuffer, CommandBuffer& computeCommandBuffer)
@@ -832,6 +1223,7 @@ namespace Engine::Renderer
 		memcpy( &normalsToView, glm::value_ptr( identity ), sizeof( FFX_CACAO_Matrix4x4 ) );
 
 		status = FFX_CACAO_VkDraw( m_CacaoContext, commandBuffer, &proj, &normalsToView );
+		commandBuffer.InvalidateBindings( );
 
 		m_SSAOImageDescriptor->Bind(
 			{
@@ -842,6 +1234,14 @@ namespace Engine::Renderer
 
 	void Scene::RenderBloomPass(uint32_t frameId, CommandBuffer& commandBuffer, CommandBuffer& computeCommandBuffer)
 	{
+		m_ComputeBloomUsed = m_ComputeBloom && m_BloomDownsampleComputePipeline;
+
+		if (m_ComputeBloomUsed)
+		{
+			RenderComputeBloomPass(commandBuffer);
+			return;
+		}
+
 		VkImage currentImage = *m_Swapchain->m_HDRImage;
 		ImageView* currentFrame = m_Swapchain->m_HDRImageView;
 
@@ -883,7 +1283,7 @@ namespace Engine::Renderer
 			commandBuffer.BindDescriptors(descs);
 			commandBuffer.SetDescriptorOffsets(descs, *m_HDRBloomPipeline);
 
-			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, *m_HDRBloomPipeline);
+			commandBuffer.BindPipeline(*m_HDRBloomPipeline);
 			vkCmdDraw(commandBuffer, 3, 1, 0, 0);
 
 			commandBuffer.EndRendering();
@@ -932,7 +1332,7 @@ namespace Engine::Renderer
 				commandBuffer.BindDescriptors(descs);
 				commandBuffer.SetDescriptorOffsets(descs, *m_BloomDownscalePipeline);
 
-				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, *m_BloomDownscalePipeline);
+				commandBuffer.BindPipeline(*m_BloomDownscalePipeline);
 
 				glm::vec2 screenExtents = { bloomExtents.width, bloomExtents.height };
 
@@ -985,7 +1385,7 @@ namespace Engine::Renderer
 				commandBuffer.BindDescriptors(descs);
 				commandBuffer.SetDescriptorOffsets(descs, *m_BloomUpscalePipeline);
 
-				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, *m_BloomUpscalePipeline);
+				commandBuffer.BindPipeline(*m_BloomUpscalePipeline);
 
 				glm::vec2 screenExtents = { bloomExtents.width, bloomExtents.height };
 
@@ -1021,82 +1421,324 @@ namespace Engine::Renderer
 		//);
 	}
 
+	void Scene::RenderComputeBloomPass(CommandBuffer& commandBuffer)
+	{
+		m_ComputeBloomSourceDescriptor->Bind(
+			{
+				Descriptor::BindingInfo{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, {.m_ImageView = m_Swapchain->m_HDRImageView }, m_RTSampler, VK_IMAGE_LAYOUT_GENERAL }
+			}
+		);
+
+		const VkImageSubresourceRange chainRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, COMPUTE_BLOOM_LEVELS, 0, 1 };
+
+		// The forward pass resolved into the HDR image.
+		commandBuffer.ImageBarrier(
+			*m_Swapchain->m_HDRImage,
+			VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+			VK_ACCESS_SHADER_READ_BIT,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+		);
+
+		// Every level is rewritten, last frame's contents can be dropped.
+		commandBuffer.ImageBarrier(
+			*m_ComputeBloomImage,
+			VK_ACCESS_SHADER_READ_BIT,
+			VK_ACCESS_SHADER_WRITE_BIT,
+			VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			chainRange
+		);
+
+		// One group per 64x64 tile of the frame, 32x32 of level 0.
+		const uint32_t groupsX = (m_ComputeBloomImage->GetWidth() + 31) / 32;
+		const uint32_t groupsY = (m_ComputeBloomImage->GetHeight() + 31) / 32;
+
+		{
+			std::vector descs = { m_ComputeBloomSourceDescriptor, m_ComputeBloomLevelDescriptors[0], m_ComputeBloomLevelDescriptors[1],
+				m_ComputeBloomLevelDescriptors[2], m_ComputeBloomLevelDescriptors[3] };
+
+			commandBuffer.BindPipeline(*m_BloomDownsampleComputePipeline);
+			commandBuffer.BindDescriptors(descs);
+			commandBuffer.SetDescriptorOffsets(descs, *m_BloomDownsampleComputePipeline);
+
+			vkCmdDispatch(commandBuffer, groupsX, groupsY, 1);
+		}
+
+		commandBuffer.ImageBarrier(
+			*m_ComputeBloomImage,
+			VK_ACCESS_SHADER_WRITE_BIT,
+			VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			chainRange
+		);
+
+		// Same tiles, level 0 is finished in place.
+		{
+			std::vector descs = { m_ComputeBloomLevelDescriptors[0], m_ComputeBloomLevelDescriptors[1], m_ComputeBloomLevelDescriptors[2], m_ComputeBloomLevelDescriptors[3] };
+
+			commandBuffer.BindPipeline(*m_BloomUpsampleComputePipeline);
+			commandBuffer.BindDescriptors(descs);
+			commandBuffer.SetDescriptorOffsets(descs, *m_BloomUpsampleComputePipeline);
+
+			vkCmdDispatch(commandBuffer, groupsX, groupsY, 1);
+		}
+
+		commandBuffer.ImageBarrier(
+			*m_ComputeBloomImage,
+			VK_ACCESS_SHADER_WRITE_BIT,
+			VK_ACCESS_SHADER_READ_BIT,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+		);
+	}
+
 	void Scene::RenderFinalPass(uint32_t frameId, CommandBuffer& commandBuffer, CommandBuffer& computeCommandBuffer)
 	{
-		VkImage currentImage = m_Swapchain->GetImages()[frameId];
 		ImageView* currentFrame = m_Swapchain->GetImageViews()[frameId];
 
-		Image* hdrImage = m_Swapchain->m_HDRImage;
-		ImageView* hdrTarget = m_Swapchain->m_HDRImageView;
+		if (m_ComputeBloomUsed)
+			m_PostProcess->Render(commandBuffer, m_Swapchain->m_HDRImageView, m_ComputeBloomImageView, VK_IMAGE_LAYOUT_GENERAL, currentFrame);
+		else
+			m_PostProcess->Render(commandBuffer, m_Swapchain->m_HDRImageView, m_BloomImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, currentFrame);
+	}
 
-		const auto& extents = m_Swapchain->GetExtents();
+	void Scene::RenderSceneObjects(CommandBuffer& commandBuffer, const std::vector<Descriptor*>& sceneDescriptors, const Assets::DrawBucketPipelines_t& pipelines, bool isStatic, int bufferIndex, bool skipMeshlets, const Assets::DrawBucketPipelines_t* fullVertexPipelines)
+	{
+		GeometryArena::Get()->Bind(commandBuffer);
 
-		m_FullscreenDescriptor->Bind(
+		// Bucket by bucket, every pipeline variant is bound once per pass.
+		for (uint32_t i = 0; i < Assets::DB_BLEND; i++)
+		{
+			const auto bucket = static_cast<Assets::DrawBucket>(i);
+			if (!pipelines[bucket])
+				continue;
+
+			for (auto& asset : isStatic ? m_SceneModels : m_SkinnedSceneModels)
 			{
-				Descriptor::BindingInfo{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, {.m_ImageView = hdrTarget }, m_RTSampler }
+				auto* gltf = dynamic_cast<Assets::BaseGLTFAsset*>(asset);
+				if (!gltf)
+				{
+					if (bucket == Assets::DB_OPAQUE)
+						asset->Render(commandBuffer, pipelines[bucket], sceneDescriptors, bufferIndex);
+
+					continue;
+				}
+
+				// The baked vertex animation frames are only fetched by the vertex shader path, these stay on it in mesh shading mode.
+				if (skipMeshlets && bucket == Assets::DB_OPAQUE)
+				{
+					auto* staticGLTF = dynamic_cast<Assets::StaticGLTFAsset*>(gltf);
+					if (staticGLTF && !staticGLTF->HasVertexAnimation())
+						continue;
+				}
+
+				if (!gltf->HasDraws(bucket))
+					continue;
+
+				Pipeline* pipeline = pipelines[bucket];
+				if (fullVertexPipelines && gltf->GetVertexFormat() != Assets::BaseGLTFAsset::s_VertexFormat)
+					pipeline = (*fullVertexPipelines)[bucket];
+
+				gltf->RenderBucket(commandBuffer, pipeline, sceneDescriptors, bufferIndex, bucket);
 			}
-		);
+		}
+	}
+
+	void Scene::RenderBlendedObjects(CommandBuffer& commandBuffer)
+	{
+		struct SortedDraw {
+			Assets::BaseGLTFAsset::BlendedDraw m_Draw;
+			Renderer::Pipeline* m_Pipeline;
+		};
+
+		std::vector<SortedDraw> sortedDraws{};
+		std::vector<Assets::BaseGLTFAsset::BlendedDraw> draws{};
+
+		const glm::vec3 viewPosition = m_MainCamera.GetPosition();
 
-		m_ApplyBloomFullscreenDescriptor->Bind(
+		const auto gather = [&](const std::vector<Assets::BaseAsset*>& models, const Assets::DrawBucketPipelines_t& pipelines, const Assets::DrawBucketPipelines_t* fullVertexPipelines)
+		{
+			for (auto* asset : models)
 			{
-				Descriptor::BindingInfo { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, {.m_ImageView = m_BloomImageView}, m_BloomSampler }
+				auto* gltf = dynamic_cast<Assets::BaseGLTFAsset*>(asset);
+				if (!gltf || (!gltf->HasDraws(Assets::DB_BLEND) && !gltf->HasDraws(Assets::DB_BLEND_DOUBLE_SIDED)))
+					continue;
+
+				draws.clear();
+				gltf->GetBlendedDraws(viewPosition, draws);
+
+				const bool fullVertices = fullVertexPipelines && gltf->GetVertexFormat() != Assets::BaseGLTFAsset::s_VertexFormat;
+
+				for (const auto& draw : draws)
+					sortedDraws.push_back({ draw, fullVertices ? (*fullVertexPipelines)[draw.m_Bucket] : pipelines[draw.m_Bucket] });
 			}
-		);
+		};
 
-		VkClearValue clearValue = { { 0.1f, 0.1f, 0.1f, 1.f } };
-		VkRenderingAttachmentInfo colorAttachment = RenderPassSpecification::GetColorAttachmentInfo(*currentFrame, &clearValue, VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL);
-		VkRenderingInfo renderingInfo = RenderPassSpecification::CreateRenderingInfo(m_Swapchain->GetExtents(), &colorAttachment, nullptr);
+		gather(m_SceneModels, m_StaticGLTFPipelines, nullptr);
+		gather(m_SkinnedSceneModels, m_SkinnedGLTFPipelines, &m_FullSkinnedGLTFPipelines);
 
-		//commandBuffer.ImageBarrier(
-		//	*hdrImage,
-		//	0,
-		//	VK_ACCESS_COLOR_ATTACHMENT_READ_BIT,
-		//	VK_IMAGE_LAYOUT_GENERAL,
-		//	VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-		//	VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-		//	VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-		//	VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
-		//);
+		if (sortedDraws.empty())
+			return;
+
+		// Back to front over every model.
+		std::sort(sortedDraws.begin(), sortedDraws.end(), [](const SortedDraw& a, const SortedDraw& b) { return a.m_Draw.m_Distance > b.m_Draw.m_Distance; });
+
+		GeometryArena::Get()->Bind(commandBuffer);
+
+		for (const auto& sorted : sortedDraws)
+			sorted.m_Draw.m_Asset->RenderBlendedDraw(commandBuffer, sorted.m_Pipeline, m_SceneDescriptors, sorted.m_Draw);
+	}
+
+	void Scene::RecordPasses(bool debuggingColliders)
+	{
+		const auto record = [this, debuggingColliders](uint32_t pass)
+		{
+			const auto start = std::chrono::steady_clock::now();
+
+			// The previous frame of this pass finished on the GPU, BeginFrame waited for it.
+			auto& recorder = m_PassRecorders[pass];
+			recorder.m_CommandPool->Reset();
+
+			CommandBuffer& commandBuffer = *recorder.m_CommandBuffer;
+
+			if (pass == RECORDED_PASS_PREPASS)
+			{
+				commandBuffer.BeginSecondary({ m_Swapchain->GetImageFormat() }, m_Swapchain->GetDepthFormat(), m_PrepassDepthReused ? m_Swapchain->GetMSAASamples() : VK_SAMPLE_COUNT_1_BIT);
+				RecordDepthPrepass(commandBuffer);
+			}
+			else if (pass == RECORDED_PASS_FORWARD)
+			{
+				commandBuffer.BeginSecondary({ m_Swapchain->GetHDRFormat() }, m_Swapchain->GetDepthFormat(), m_Swapchain->GetMSAASamples());
+				RecordForwardPass(commandBuffer, debuggingColliders);
+			}
+			else
+			{
+				commandBuffer.BeginSecondary({}, m_ShadowMapPass->GetDepthFormat());
+				m_ShadowMapPass->RecordCascade(commandBuffer, pass - RECORDED_PASS_SHADOW_CASCADES,
+					[&](const std::vector<Descriptor*>& _sceneDescriptors, const Assets::DrawBucketPipelines_t& _pipelines, const Assets::DrawBucketPipelines_t* fullVertexPipelines, bool isStatic, int bufferIndex)
+					{
+						RenderSceneObjects(commandBuffer, _sceneDescriptors, _pipelines, isStatic, bufferIndex, false, fullVertexPipelines);
+					});
+			}
+
+			commandBuffer.End();
+
+			m_PassRecordingStats.m_PassTimes[pass] = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		};
+
+		const auto start = std::chrono::steady_clock::now();
+
+		// One pass per job, the render thread records along.
+		if (auto* jobs = Core::JobSystem::Get(); jobs && m_ParallelRecording)
+			jobs->ParallelFor(RECORDED_PASS_COUNT, 1, record);
+		else
+		{
+			for (uint32_t pass = 0; pass < RECORDED_PASS_COUNT; pass++)
+				record(pass);
+		}
+
+		m_PassRecordingStats.m_WallTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	void Scene::RecordDepthPrepass(CommandBuffer& commandBuffer)
+	{
+		const auto& extents = m_Swapchain->GetExtents();
 
-		commandBuffer.BeginRendering(&renderingInfo);
 		commandBuffer.SetViewport(static_cast<float>(extents.width), static_cast<float>(extents.height));
 		commandBuffer.SetScissor(extents.width, extents.height);
 
-		std::vector descs = { m_FullscreenDescriptor, m_ApplyBloomFullscreenDescriptor };
-
-		commandBuffer.BindDescriptors(descs);
-		commandBuffer.SetDescriptorOffsets(descs, *m_FullscreenPipeline);
+		// Draw Scene Objects to depth pre-pass.
+		if (m_MeshShading)
+		{
+			GeometryArena::Get()->Bind(commandBuffer);
 
-		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, *m_FullscreenPipeline);
-		vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+			RenderMeshletObjects(commandBuffer, m_PrepassDepthReused ? m_MSAAPrePassMeshletGLTFPipeline : m_PrePassMeshletGLTFPipeline);
+		}
 
-		commandBuffer.EndRendering();
+		RenderSceneObjects(commandBuffer, m_SceneDescriptors, m_PrepassDepthReused ? m_MSAAPrePassStaticGLTFPipelines : m_PrePassStaticGLTFPipelines, true, 0, m_MeshShading);
 
-		//commandBuffer.ImageBarrier(
-		//	*hdrImage,
-		//	0,
-		//	0,
-		//	VK_IMAGE_LAYOUT_GENERAL,
-		//	VK_IMAGE_LAYOUT_GENERAL,
-		//	VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-		//	VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-		//	VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
-		//);
+		// Draw Skinned Scene Objects to depth pre-pass.
+		RenderSceneObjects(commandBuffer, m_SceneDescriptors, m_PrepassDepthReused ? m_MSAAPrePassSkinnedGLTFPipelines : m_PrePassSkinnedGLTFPipelines, false, 0, false,
+			m_PrepassDepthReused ? &m_FullMSAAPrePassSkinnedGLTFPipelines : &m_FullPrePassSkinnedGLTFPipelines);
 	}
 
-	void Scene::RenderSceneObjects(CommandBuffer& commandBuffer, const std::vector<Descriptor*>& sceneDescriptors, Renderer::Pipeline* pipeline, bool isStatic, int bufferIndex)
+	void Scene::RecordForwardPass(CommandBuffer& commandBuffer, bool debuggingColliders)
 	{
+		const auto& extents = m_Swapchain->GetExtents();
+
+		commandBuffer.SetViewport(static_cast<float>(extents.width), static_cast<float>(extents.height));
+		commandBuffer.SetScissor(extents.width, extents.height);
+
+		GeometryArena::Get()->Bind(commandBuffer);
 
+		if (!debuggingColliders)
+			m_SkyCube->Render(commandBuffer, m_SkyboxPipeline, m_SceneDescriptors);
+
+		// Every bucket variant shares the layout of the opaque one.
+		uint32_t ssaoEnabled = m_SSAOEnabled;
+		vkCmdPushConstants(commandBuffer, m_StaticGLTFPipelines[Assets::DB_OPAQUE]->GetPipelineLayout(), VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(ssaoEnabled), &ssaoEnabled);
+
+		// Over the reused prepass depth only the visible surface of each pixel is shaded.
+		const auto& staticPipelines = m_PrepassDepthReused ? m_EqualStaticGLTFPipelines : m_StaticGLTFPipelines;
+		const auto& skinnedPipelines = m_PrepassDepthReused ? m_EqualSkinnedGLTFPipelines : m_SkinnedGLTFPipelines;
+		const auto& fullSkinnedPipelines = m_PrepassDepthReused ? m_FullEqualSkinnedGLTFPipelines : m_FullSkinnedGLTFPipelines;
+
+		// Draw Scene Objects to standard pass.
+		if (!debuggingColliders && m_MeshShading)
+		{
+			Pipeline* meshletPipeline = m_PrepassDepthReused ? m_EqualMeshletGLTFPipeline : m_MeshletGLTFPipeline;
+
+			vkCmdPushConstants(commandBuffer, meshletPipeline->GetPipelineLayout(), VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(ssaoEnabled), &ssaoEnabled);
+			RenderMeshletObjects(commandBuffer, meshletPipeline);
+
+			vkCmdPushConstants(commandBuffer, m_StaticGLTFPipelines[Assets::DB_OPAQUE]->GetPipelineLayout(), VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(ssaoEnabled), &ssaoEnabled);
+		}
+
+		if (!debuggingColliders)
+			RenderSceneObjects(commandBuffer, m_SceneDescriptors, staticPipelines, true, 0, m_MeshShading);
+
+		// Draw Skinned Scene Objects to standard pass.
+		RenderSceneObjects(commandBuffer, m_SceneDescriptors, skinnedPipelines, false, 0, false, &fullSkinnedPipelines);
+
+		// Blended geometry last, over the opaque result.
+		if (!debuggingColliders)
+			RenderBlendedObjects(commandBuffer);
+
+		if (debuggingColliders)
+		{
+			commandBuffer.BindPipeline(*m_CollisionDebugPipeline);
+			commandBuffer.BindVertexBuffer(*m_CollisionDebugVertexBuffer);
+
+			struct {
+				glm::mat4 m1;
+				glm::mat4 m2;
+			} data = {};
+
+			data.m1 = m_MainCamera.GetViewMatrix();
+			data.m2 = m_MainCamera.GetProjectionMatrix();
+
+			vkCmdPushConstants(commandBuffer, m_CollisionDebugPipeline->GetPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(data), &data);
+			vkCmdDraw(commandBuffer, static_cast<uint32_t>(debugVertexBufferSize), 1, 0, 0);
+		}
 	}
 
 	bool Scene::Intersects(const Core::CollisionCapsule& capsule) {
 		bool intersectsAny = false;
 
-		for (auto& model : m_SceneModels) {
-			if (Assets::StaticGLTFAsset* asset = dynamic_cast<Assets::StaticGLTFAsset*>(model)) {
-				intersectsAny = asset->Intersects(capsule);
-			}
-		}
+		for (auto* asset : m_CollisionModels)
+			intersectsAny |= asset->Intersects(capsule);
 
 		return intersectsAny;
 	}
@@ -1104,15 +1746,107 @@ namespace Engine::Renderer
 	bool Scene::Intersects( const Core::CollisionBox& aabb, glm::vec3& normal )
 	{
 		int intersectionCount = 0;
-		for ( auto& model : m_SceneModels )
+		for ( auto* asset : m_CollisionModels )
 		{
-			if ( Assets::StaticGLTFAsset* asset = dynamic_cast< Assets::StaticGLTFAsset* >( model ) )
+			if ( asset->Intersects( aabb, normal ) )
+				intersectionCount++;
+		}
+
+		return intersectionCount > 0;
+	}
+
+	// Queries handed to a worker at a time.
+	constexpr uint32_t SCENE_QUERY_BATCH_SIZE = 64;
+
+	void Scene::Query(const SceneQueries& queries, const SceneQueryResults& results) const
+	{
+		const uint32_t count = static_cast<uint32_t>(queries.GetCount());
+		if (count == 0)
+			return;
+
+		const size_t sphereStart = queries.m_Boxes.size();
+		const size_t capsuleStart = sphereStart + queries.m_Spheres.size();
+		const size_t rayStart = capsuleStart + queries.m_Capsules.size();
+
+		// Overlaps keep the normal of the closest contact over every asset.
+		const auto overlap = [this](const auto& query, const Core::CollisionBox& bounds, glm::vec3& normal)
+		{
+			float closest = std::numeric_limits<float>::max();
+
+			for (auto* asset : m_CollisionModels)
 			{
-				if ( asset->Intersects( aabb, normal ) )
-					intersectionCount++;
+				glm::vec3 assetNormal{};
+				if (!bounds.Intersects(asset->GetCollisionBounds()) || !asset->Intersects(query, assetNormal))
+					continue;
+
+				const float distance = glm::dot(assetNormal, assetNormal);
+				if (distance < closest)
+				{
+					closest = distance;
+					normal = assetNormal;
+				}
 			}
+
+			return closest < std::numeric_limits<float>::max();
+		};
+
+		const auto runQuery = [&](uint32_t i)
+		{
+			glm::vec3 normal{};
+			float distance = 0.f;
+			bool hit = false;
+
+			if (i < sphereStart)
+			{
+				hit = overlap(queries.m_Boxes[i], queries.m_Boxes[i], normal);
+			}
+			else if (i < capsuleStart)
+			{
+				const auto& sphere = queries.m_Spheres[i - sphereStart];
+				hit = overlap(sphere, sphere.GetAABB(), normal);
+			}
+			else if (i < rayStart)
+			{
+				const auto& capsule = queries.m_Capsules[i - capsuleStart];
+				hit = overlap(capsule, capsule.GetAABB(), normal);
+			}
+			else
+			{
+				Core::CollisionRay ray = queries.m_Rays[i - rayStart];
+
+				for (auto* asset : m_CollisionModels)
+				{
+					float assetDistance = 0.f;
+					glm::vec3 assetNormal{};
+
+					// Later assets only need to beat the current hit.
+					if (!ray.Intersects(asset->GetCollisionBounds(), assetDistance) || !asset->Raycast(ray, assetDistance, assetNormal))
+						continue;
+
+					ray.m_Length = assetDistance;
+					normal = assetNormal;
+					hit = true;
+				}
+
+				distance = ray.m_Length;
+			}
+
+			results.m_Hits[i] = hit ? 1 : 0;
+
+			if (results.m_Normals)
+				results.m_Normals[i] = normal;
+
+			if (results.m_Distances)
+				results.m_Distances[i] = distance;
+		};
+
+		if (auto* jobs = Core::JobSystem::Get())
+		{
+			jobs->ParallelFor(count, SCENE_QUERY_BATCH_SIZE, runQuery);
+			return;
 		}
 
-		return intersectionCount > 0;
+		for (uint32_t i = 0; i < count; i++)
+			runQuery(i);
 	}
-}
\ No newline at end of file
+}
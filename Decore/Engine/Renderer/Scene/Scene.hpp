@@ -4,16 +4,27 @@
 #include "../../Assets/BaseAsset.hpp"
 
 #include "../../Core/Camera/Camera.hpp"
+#include "../../Core/Collision/CollisionBox.hpp"
 #include "../../Core/Collision/CollisionCapsule.hpp"
+#include "../../Core/Collision/CollisionSphere.hpp"
+#include "../../Core/Collision/CollisionRay.hpp"
 
 #include "../Culling/SceneCuller.hpp"
 #include "../Environment/EnvironmentInfo.hpp"
 #include "../Shadows/ShadowMapPass.hpp"
+#include "../PostProcess/PostProcessStack.hpp"
 
 #include "../FFX-CACAO/ffx_cacao_impl.h"
 
 #include <entt/entt.hpp>
 
+#include <span>
+
+namespace Engine::Assets {
+	class StaticGLTFAsset;
+	class SkinnedGLTFAsset;
+}
+
 namespace Engine::Renderer {
 	struct alignas( 16 ) PointLight {
 		glm::vec4 Position;
@@ -25,6 +36,54 @@ namespace Engine::Renderer {
 		bool Enabled;
 	};
 
+	// Animation LOD tier of a skinned instance, picked from its projected size (bounding sphere radius over distance, in half screen heights).
+	struct AnimationLodTier {
+		float m_MinScreenSize{};	// Smallest projected size of the tier, the first matching tier is used.
+		uint32_t m_SampleInterval{ 1 };	// Frames between samples, blended palettes in between.
+		uint32_t m_Budget{};		// Samples per frame, 0 for no limit. Instances over budget keep blending and are sampled on a later frame.
+		bool m_SkipLeafJoints{};
+	};
+
+	static constexpr uint32_t ANIMATION_LOD_COUNT = 3;
+
+	// Per frame counters of the animation LOD policy.
+	struct AnimationLodStats {
+		std::array<uint32_t, ANIMATION_LOD_COUNT> m_Sampled{};
+		std::array<uint32_t, ANIMATION_LOD_COUNT> m_Interpolated{};
+		uint32_t m_Culled{};	// Outside the view, no palette written.
+		uint32_t m_Deferred{};	// Due but over the budget of their tier.
+	};
+
+	// Passes recorded by a job each into a secondary command buffer: the depth prepass, every shadow cascade and the forward pass.
+	static constexpr uint32_t RECORDED_PASS_PREPASS = 0;
+	static constexpr uint32_t RECORDED_PASS_SHADOW_CASCADES = 1;
+	static constexpr uint32_t RECORDED_PASS_FORWARD = RECORDED_PASS_SHADOW_CASCADES + SHADOW_MAP_CASCADES;
+	static constexpr uint32_t RECORDED_PASS_COUNT = RECORDED_PASS_FORWARD + 1;
+
+	// CPU time spent recording the passes of the last frame, in milliseconds.
+	struct PassRecordingStats {
+		std::array<float, RECORDED_PASS_COUNT> m_PassTimes{};
+		float m_WallTime{};	// From the first pass started until the last one is recorded.
+	};
+
+	// Batched scene queries, see Scene::Query. Any of the arrays may be empty.
+	struct SceneQueries {
+		std::span<const Core::CollisionBox> m_Boxes{};
+		std::span<const Core::CollisionSphere> m_Spheres{};
+		std::span<const Core::CollisionCapsule> m_Capsules{};
+		std::span<const Core::CollisionRay> m_Rays{};
+
+		size_t GetCount() const { return m_Boxes.size() + m_Spheres.size() + m_Capsules.size() + m_Rays.size(); }
+	};
+
+	// Caller owned results in SoA layout, one entry per query in the order boxes, spheres, capsules, rays.
+	// Every array holds SceneQueries::GetCount() entries, m_Normals and m_Distances are optional.
+	struct SceneQueryResults {
+		uint8_t* m_Hits = nullptr;
+		glm::vec3* m_Normals = nullptr;	// Overlaps: away from the closest triangle, not normalized. Rays: unit face normal.
+		float* m_Distances = nullptr;	// Rays: hit distance, m_Length on a miss. Overlaps: 0.
+	};
+
 	class Scene {
 	public:
 		Scene(std::shared_ptr<Device> device, std::shared_ptr<CommandPool> commandPool, const std::unique_ptr<Swapchain>& swapchain, const std::vector<DescriptorLayout>& objectLayouts);
@@ -33,12 +92,15 @@ namespace Engine::Renderer {
 		template<typename T >
 		inline T* AddAsset(T* asset) {
 			m_SceneModels.push_back(asset);
+			RegisterCollisionAsset(m_SceneModels.back());
+			RegisterVertexAnimation(m_SceneModels.back());
 			return (T*)m_SceneModels.back();
 		}
 
 		template<typename T >
 		inline T* AddSkinnedAsset(T* asset) {
 			m_SkinnedSceneModels.push_back(asset);
+			RegisterAnimatedAsset(m_SkinnedSceneModels.back());
 			return (T*)m_SkinnedSceneModels.back();
 		}
 
@@ -49,6 +111,9 @@ namespace Engine::Renderer {
 		bool Intersects(const Core::CollisionCapsule& capsule);
 		bool Intersects( const Core::CollisionBox& aabb, glm::vec3& normal );
 
+		// Runs every query against the static collision of the scene, spread over the job system. Returns once all results are written.
+		void Query(const SceneQueries& queries, const SceneQueryResults& results) const;
+
 		Descriptor* GetSceneDescriptor() const { return m_SceneDescriptor; }
 		Buffer* GetSceneUniforms() const { return m_SceneUniforms; }
 
@@ -58,18 +123,73 @@ namespace Engine::Renderer {
 		Core::Camera& GetMainCamera() { return m_MainCamera; }
 
 		ShadowMapPass* m_ShadowMapPass = nullptr;
+
+		// Bloom composite, exposure, tonemapping and grading, then the swapchain.
+		PostProcessStack* m_PostProcess = nullptr;
 		SceneCuller* m_Culler = nullptr;
 
 		bool IsFrustumFrozen() const { return m_FreezeFrustum; }
 		bool IsSSAOEnabled( ) const { return m_SSAOEnabled; }
+		bool IsMeshShadingEnabled( ) const { return m_MeshShading; }
+
+		std::array<AnimationLodTier, ANIMATION_LOD_COUNT> m_AnimationLods = { {
+			{ 0.25f, 1, 0, false },
+			{ 0.08f, 2, 64, false },
+			{ 0.f, 4, 32, true }
+		} };
+
+		const AnimationLodStats& GetAnimationLodStats( ) const { return m_AnimationLodStats; }
+
+		// Records the passes on the job system, one after the other on the render thread otherwise.
+		bool m_ParallelRecording{ true };
+
+		const PassRecordingStats& GetPassRecordingStats( ) const { return m_PassRecordingStats; }
+
+		// The prepass renders at the MSAA sample count straight into the forward depth buffer (resolved for SSAO and the depth pyramid),
+		// the forward pass then tests EQUAL without writing and only shades visible surfaces. Off: the forward pass clears and redraws its own depth.
+		bool m_ReusePrepassDepth{ true };
+		bool IsPrepassDepthReused( ) const { return m_PrepassDepthReused; }
+
+		// Builds the bloom chain with two compute dispatches (single pass downsample, fused upsample) from half resolution,
+		// instead of the nine fullscreen passes. Needs quad operations in compute, see Device::SupportsComputeQuadOperations.
+		bool m_ComputeBloom{ true };
+		bool IsComputeBloomUsed( ) const { return m_ComputeBloomUsed; }
+
+		// Bind calls of the frame over every command buffer the scene records.
+		const BindStats& GetBindStats( ) const { return m_BindStats; }
 
 		std::vector<Engine::Assets::BaseAsset*> m_SceneModels{};
 		std::vector<Engine::Assets::BaseAsset*> m_SkinnedSceneModels{};
 
+		// m_SceneModels with static collision, resolved once when added.
+		std::vector<Engine::Assets::StaticGLTFAsset*> m_CollisionModels{};
+
+		// m_SkinnedSceneModels that play animations, resolved once when added.
+		std::vector<Engine::Assets::SkinnedGLTFAsset*> m_AnimatedModels{};
+
+		// Every instance of m_AnimatedModels, one animation job each. Kept to reuse its storage.
+		std::vector<std::pair<Engine::Assets::SkinnedGLTFAsset*, uint32_t>> m_AnimatedInstances{};
+
+		AnimationLodStats m_AnimationLodStats{};
+		uint32_t m_AnimationFrame{};
+
 		VkDescriptorSet m_ImguiDepthPrePass = VK_NULL_HANDLE;
 
 		void RecreateSwapchainResources( );
 	private:
+		void RegisterAnimatedAsset(Engine::Assets::BaseAsset* asset);
+		void RegisterCollisionAsset(Engine::Assets::BaseAsset* asset);
+		void RegisterVertexAnimation(Engine::Assets::BaseAsset* asset);
+
+		// Shader time of the baked vertex animations, wrapped in double precision so the float frame lookup stays exact.
+		float GetVertexAnimationTime() const;
+
+		// Common multiple of every baked clip length the time wraps at, zero without vertex animations.
+		double m_VertexAnimationPeriod{};
+
+		// Picks how every skinned instance is advanced this frame (see AnimationLodTier).
+		void SelectAnimationLods();
+
 		// Called before the main scene rendering occurs.
 		void PreRender(uint32_t frameId, CommandBuffer& commandBuffer, CommandBuffer& computeCommandBuffer, std::function<void()> callback);
 		
@@ -81,23 +201,61 @@ namespace Engine::Renderer {
 		void RenderBloomPass( uint32_t frameId, CommandBuffer& commandBuffer, CommandBuffer& computeCommandBuffer );
 		void RenderFinalPass(uint32_t frameId, CommandBuffer& commandBuffer, CommandBuffer& computeCommandBuffer);
 
-		void RenderSceneObjects(CommandBuffer& commandBuffer, const std::vector<Descriptor*>& sceneDescriptors, Renderer::Pipeline* pipeline, bool isStatic, int bufferIndex);
+		// Draws every non blended bucket that has a pipeline. skipMeshlets leaves out what RenderMeshletObjects already drew.
+		// fullVertexPipelines draw the assets that kept full vertices while s_VertexFormat is packed.
+		void RenderSceneObjects(CommandBuffer& commandBuffer, const std::vector<Descriptor*>& sceneDescriptors, const Assets::DrawBucketPipelines_t& pipelines, bool isStatic, int bufferIndex, bool skipMeshlets = false,
+			const Assets::DrawBucketPipelines_t* fullVertexPipelines = nullptr);
+
+		// Blended draws of every model, sorted back to front from the main camera.
+		void RenderBlendedObjects(CommandBuffer& commandBuffer);
+
+		// Records every RECORDED_PASS_* into its secondary command buffer, returns once all of them are done.
+		// Only records draws, whatever the passes read on the CPU has to be final before.
+		void RecordPasses(bool debuggingColliders);
+		void RecordDepthPrepass(CommandBuffer& commandBuffer);
+		void RecordForwardPass(CommandBuffer& commandBuffer, bool debuggingColliders);
 
 		void Setup(std::shared_ptr<Device> device, std::shared_ptr<CommandPool> commandPool, const std::unique_ptr<Swapchain>& swapchain, const std::vector<DescriptorLayout>& objectLayouts);
 		void SetupSkybox(const std::vector<VkFormat>& colorFormats, VkFormat depthFormat, const std::vector<DescriptorLayout>& objectLayouts, const std::vector<VkDescriptorSetLayout>& setLayouts);
 
 		void SetupDetphPrepass(const std::vector<VkFormat>& colorFormats, VkFormat depthFormat, const std::vector<DescriptorLayout>& objectLayouts, const std::vector<VkDescriptorSetLayout>& setLayouts);
 		void SetupSSAOPass();
+		void SetupMeshletPipelines(const std::vector<VkFormat>& colorFormats, VkFormat depthFormat, const std::vector<VkDescriptorSetLayout>& setLayouts, const VkPipelineMultisampleStateCreateInfo& multisampleState);
+
+		// Builds one variant of builder per draw bucket, depth only pipelines leave the blended buckets empty.
+		// depthEqual: opaque and masked buckets shading the prepass depth, EQUAL test, no writes and no alpha test. Blended buckets are left empty too.
+		Assets::DrawBucketPipelines_t BuildBucketPipelines(PipelineBuilder& builder, bool depthOnly, bool depthEqual = false);
+
+		// Static objects through the task/mesh shader path.
+		void RenderMeshletObjects(CommandBuffer& commandBuffer, Renderer::Pipeline* pipeline);
 		void SetupBloomPasses( );
 
 		// Create bloom mip chain.
 		void DestroyBloomImages();
 		void CreateBloomImages(bool createDescriptors);
+		void RenderComputeBloomPass( CommandBuffer& commandBuffer );
 
 		bool RenderCollisions();
 
+		// Secondary command buffer of a recorded pass. Every pass has its own pool, the jobs recording them never share one.
+		struct PassRecorder {
+			std::shared_ptr<CommandPool> m_CommandPool{};
+			CommandBuffer* m_CommandBuffer = nullptr;
+		};
+
+		std::array<PassRecorder, RECORDED_PASS_COUNT> m_PassRecorders{};
+		PassRecordingStats m_PassRecordingStats{};
+		BindStats m_BindStats{};
+
 		bool m_FreezeFrustum{};
 		bool m_SSAOEnabled{ true };
+		bool m_MeshShading{};
+
+		// m_ComputeBloom for the frame being recorded, off when the device can't run it.
+		bool m_ComputeBloomUsed{};
+
+		// m_ReusePrepassDepth for the frame being recorded, off while debugging colliders (the forward pass skips static geometry then).
+		bool m_PrepassDepthReused{};
 
 		struct alignas(16) SceneUniforms {
 			glm::mat4 ModelMatrix;
@@ -107,6 +265,7 @@ namespace Engine::Renderer {
 			glm::vec4 CamPos;
 			glm::vec4 LightDirection;
 			glm::vec4 LightColor;
+			glm::vec4 Time; // x: seconds, wrapped at m_VertexAnimationPeriod, drives the baked vertex animations.
 		} m_Uniforms;
 
 		std::shared_ptr<Device> m_Device;
@@ -122,15 +281,38 @@ namespace Engine::Renderer {
 		Pipeline* m_CollisionDebugPipeline = nullptr;
 		Buffer* m_CollisionDebugVertexBuffer = nullptr;
 
-		// Rendering of Opaque glTF Objects.
-		Pipeline* m_OpaqueGLTFPipeline = nullptr;
-		Pipeline* m_SkinnedGLTFPipeline = nullptr;
+		// Rendering of glTF Objects, one pipeline per draw bucket.
+		Assets::DrawBucketPipelines_t m_StaticGLTFPipelines{};
+		Assets::DrawBucketPipelines_t m_SkinnedGLTFPipelines{};
+
+		// Forward variants over the reused prepass depth, see m_ReusePrepassDepth.
+		Assets::DrawBucketPipelines_t m_EqualStaticGLTFPipelines{};
+		Assets::DrawBucketPipelines_t m_EqualSkinnedGLTFPipelines{};
+
+		// Morph target evaluation, feeds the skinned pipelines.
+		ComputePipeline* m_MorphTargetPipeline = nullptr;
 
 		// Depth Prepass
-		Pipeline* m_PrePassOpaqueGLTFPipeline = nullptr;
-		Pipeline* m_PrePassSkinnedGLTFPipeline = nullptr;
+		Assets::DrawBucketPipelines_t m_PrePassStaticGLTFPipelines{};
+		Assets::DrawBucketPipelines_t m_PrePassSkinnedGLTFPipelines{};
+
+		// Prepass variants at the MSAA sample count, see m_ReusePrepassDepth.
+		Assets::DrawBucketPipelines_t m_MSAAPrePassStaticGLTFPipelines{};
+		Assets::DrawBucketPipelines_t m_MSAAPrePassSkinnedGLTFPipelines{};
+
+		// VF_FULL layout variants of the skinned pipelines, only built when s_VertexFormat is packed.
+		Assets::DrawBucketPipelines_t m_FullSkinnedGLTFPipelines{};
+		Assets::DrawBucketPipelines_t m_FullEqualSkinnedGLTFPipelines{};
+		Assets::DrawBucketPipelines_t m_FullPrePassSkinnedGLTFPipelines{};
+		Assets::DrawBucketPipelines_t m_FullMSAAPrePassSkinnedGLTFPipelines{};
 		Sampler* m_PrePassDepthSampler = nullptr;
 
+		// Task/mesh shader variants of the static pipelines, only when VK_EXT_mesh_shader is supported.
+		Pipeline* m_MeshletGLTFPipeline = nullptr;
+		Pipeline* m_PrePassMeshletGLTFPipeline = nullptr;
+		Pipeline* m_EqualMeshletGLTFPipeline = nullptr;
+		Pipeline* m_MSAAPrePassMeshletGLTFPipeline = nullptr;
+
 		// SSAO Pass
 		uint32_t m_SSAOImageWidth{}, m_SSAOImageHeight{};
 		Image* m_SSAOImage = nullptr;
@@ -154,10 +336,20 @@ namespace Engine::Renderer {
 		std::vector< ImageView* > m_UpsampleImageViews{};
 		std::vector< Descriptor* > m_BloomMipDescriptors{};
 
+		// Compute bloom chain, four levels from half resolution. RGBA16F, storage support for the HDR format is optional.
+		static constexpr uint32_t COMPUTE_BLOOM_LEVELS = 4;
+
+		Image* m_ComputeBloomImage = nullptr;
+		ImageView* m_ComputeBloomImageView = nullptr;
+		std::array< ImageView*, COMPUTE_BLOOM_LEVELS > m_ComputeBloomLevelViews{};
+		std::array< Descriptor*, COMPUTE_BLOOM_LEVELS > m_ComputeBloomLevelDescriptors{};
+		Descriptor* m_ComputeBloomSourceDescriptor = nullptr;
+
+		ComputePipeline* m_BloomDownsampleComputePipeline = nullptr;
+		ComputePipeline* m_BloomUpsampleComputePipeline = nullptr;
+
 		// Fullscreen Utilities
-		Pipeline* m_FullscreenPipeline = nullptr;
 		Descriptor* m_FullscreenDescriptor = nullptr;
-		Descriptor* m_ApplyBloomFullscreenDescriptor = nullptr;
 		Sampler* m_RTSampler = nullptr;
 
 		EnvironmentInfo* m_ActiveEnvironment = nullptr;
@@ -113,46 +113,81 @@ namespace Engine::Renderer {
 			setLayouts.push_back(layout.GetLayout());
 		}
 
-		std::vector<Shader*> shaders = {
-			ShaderRegistry::Get( )->Register( "..\\Shaders\\ShadowMapVS.hlsl", VK_SHADER_STAGE_VERTEX_BIT ),
-			ShaderRegistry::Get( )->Register( "..\\Shaders\\ShadowMapPS.hlsl", VK_SHADER_STAGE_FRAGMENT_BIT )
-		};
+		// Baked vertex animations of static assets, joint palettes for skinned ones.
+		setLayouts.push_back(Renderer::DescriptorLayout(device, { { 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_ALL, nullptr} }));
+
+		std::vector<Shader*> shaders = { ShaderRegistry::Get( )->Register( "..\\Shaders\\ShadowMapVS.hlsl", VK_SHADER_STAGE_VERTEX_BIT ) };
 
 		std::vector<VkPushConstantRange> pushConstants = { VkPushConstantRange{ VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t) } };
 
+		// Opaque geometry never discards, no fragment stage at all.
 		m_Pipeline = std::unique_ptr<Pipeline>(
 			PipelineBuilder()
 			.SetShaders(shaders)
 			.SetColorAttachmentFormats(colorFormats)
 			.SetDepthAttachmentFormat(depthFormat)
-			.SetInputAttributeDescriptions(Assets::StaticGLTFAsset::VertexType::GetInputAttributeDescriptions())
-			.SetInputBindingDescriptions({ Assets::StaticGLTFAsset::VertexType::GetBindingDescription() })
+			.SetInputAttributeDescriptions(Assets::StaticGLTFAsset::GetInputAttributeDescriptions())
+			.SetInputBindingDescriptions({ Assets::StaticGLTFAsset::GetBindingDescription() })
 			.SetDescriptorSetLayouts(setLayouts)
 			.SetPushConstants(pushConstants)
 			.SetRasterizationState(rasterizationState)
 			.Build(*swapchain)
 		);
 
+		shaders.push_back( ShaderRegistry::Get( )->Register( "..\\Shaders\\ShadowMapPS.hlsl", VK_SHADER_STAGE_FRAGMENT_BIT ) );
+
+		m_MaskedPipeline = std::unique_ptr<Pipeline>(
+			PipelineBuilder()
+			.SetShaders(shaders)
+			.SetColorAttachmentFormats(colorFormats)
+			.SetDepthAttachmentFormat(depthFormat)
+			.SetInputAttributeDescriptions(Assets::StaticGLTFAsset::GetInputAttributeDescriptions())
+			.SetInputBindingDescriptions({ Assets::StaticGLTFAsset::GetBindingDescription() })
+			.SetDescriptorSetLayouts(setLayouts)
+			.SetPushConstants(pushConstants)
+			.SetRasterizationState(rasterizationState)
+			.SetSpecializationConstants({ VK_TRUE })
+			.Build(*swapchain)
+		);
+
 		shaders = { ShaderRegistry::Get()->Register("..\\Shaders\\SkinnedShadowMapVS.hlsl", VK_SHADER_STAGE_VERTEX_BIT) };
 		pushConstants = { VkPushConstantRange{ VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t) } };
 
-		setLayouts.push_back(Renderer::DescriptorLayout(device, { { 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_ALL, nullptr} }));
+		// Morph target deltas.
+		setLayouts.push_back(setLayouts.back());
 
 		m_SkinnedPipeline = std::unique_ptr<Pipeline>(
 			PipelineBuilder()
 			.SetShaders(shaders)
 			.SetColorAttachmentFormats(colorFormats)
 			.SetDepthAttachmentFormat(depthFormat)
-			.SetInputAttributeDescriptions(Assets::SkinnedGLTFAsset::VertexType::GetInputAttributeDescriptions())
-			.SetInputBindingDescriptions({ Assets::SkinnedGLTFAsset::VertexType::GetBindingDescription() })
+			.SetInputAttributeDescriptions(Assets::SkinnedGLTFAsset::GetInputAttributeDescriptions())
+			.SetInputBindingDescriptions({ Assets::SkinnedGLTFAsset::GetBindingDescription() })
 			.SetDescriptorSetLayouts(setLayouts)
 			.SetPushConstants(pushConstants)
 			.SetRasterizationState(rasterizationState)
 			.Build(*swapchain)
 		);
+
+		// For the skinned assets that kept full vertices, same layout as m_SkinnedPipeline otherwise.
+		if (Assets::BaseGLTFAsset::s_VertexFormat == Assets::VertexFormat::VF_PACKED)
+		{
+			m_FullSkinnedPipeline = std::unique_ptr<Pipeline>(
+				PipelineBuilder()
+				.SetShaders(shaders)
+				.SetColorAttachmentFormats(colorFormats)
+				.SetDepthAttachmentFormat(depthFormat)
+				.SetInputAttributeDescriptions(Assets::SkinnedGLTFAsset::GetInputAttributeDescriptions(Assets::VertexFormat::VF_FULL))
+				.SetInputBindingDescriptions({ Assets::SkinnedGLTFAsset::GetBindingDescription(Assets::VertexFormat::VF_FULL) })
+				.SetDescriptorSetLayouts(setLayouts)
+				.SetPushConstants(pushConstants)
+				.SetRasterizationState(rasterizationState)
+				.Build(*swapchain)
+			);
+		}
 	}
 
-	void ShadowMapPass::Render(CommandBuffer& commandBuffer, CommandBuffer& computeCommandBuffer, const Core::Camera& camera, const glm::vec4 lightDirection, class SceneCuller* culler, const std::vector<Assets::BaseAsset*>& sceneAssets, std::function<void(const std::vector<Descriptor*>&, Renderer::Pipeline*, bool, int)> callback) {
+	void ShadowMapPass::Update(CommandBuffer& computeCommandBuffer, const Core::Camera& camera, const glm::vec4 lightDirection, class SceneCuller* culler, const std::vector<Assets::BaseAsset*>& sceneAssets, float animationTime) {
 		float cascadeSplits[SHADOW_MAP_CASCADES] = {};
 		float lastSplitDist = 0.f;
 
@@ -226,54 +261,61 @@ namespace Engine::Renderer {
 
 		m_CascadeMatrixUniformBuffer->Patch(&cascadeUbo, sizeof(CascadeUBO));
 
-		//for ( auto i = 0; i < m_Cascades.size( ); i++ )
-		//{
-		//	culler->Cull( m_Cascades[ i ].m_ViewMatrix, m_Cascades[ i ].m_ProjectionMatrix, 0.f, m_Cascades[ i ].m_Far, computeCommandBuffer, sceneAssets, i );
-		//}
+		// Culls and picks the (biased) LOD of every cascade.
+		for ( auto i = 0; i < m_Cascades.size( ); i++ )
+		{
+			culler->Cull( m_Cascades[ i ].m_ViewMatrix, m_Cascades[ i ].m_ProjectionMatrix, 0.f, m_Cascades[ i ].m_Far, computeCommandBuffer, sceneAssets, i );
+		}
 
-		for (auto i = 0; i < m_Cascades.size(); i++) {
-			auto& cascade = m_Cascades[i];
+		ShadowUBO shadowScene{};
+		shadowScene.ModelMatrix = glm::mat4(1.f);
+		shadowScene.ModelMatrix[2][2] *= -1.f;
+		shadowScene.Time = glm::vec4(animationTime, 0.f, 0.f, 0.f);
 
-			ShadowUBO shadowScene{};
-			shadowScene.ModelMatrix = glm::mat4(1.f);
-			shadowScene.ModelMatrix[2][2] *= -1.f;
+		m_SceneUniformBuffer->Patch(&shadowScene, sizeof(shadowScene));
+	}
 
-			m_SceneUniformBuffer->Patch(&shadowScene, sizeof(shadowScene));
+	void ShadowMapPass::BeginCascade(CommandBuffer& commandBuffer, uint32_t cascadeIndex, VkRenderingFlags flags) {
+		VkExtent2D extents = { SHADOW_MAP_DIMENSIONS, SHADOW_MAP_DIMENSIONS };
 
-			VkExtent2D extents = { SHADOW_MAP_DIMENSIONS, SHADOW_MAP_DIMENSIONS };
-			VkClearValue val = { .depthStencil = { 1.0f, 0 } };
+		VkImageView depthImageView = *m_Cascades[cascadeIndex].m_ImageView;
 
-			VkImageView depthImageView = *cascade.m_ImageView;
+		auto depthAttachment = RenderPassSpecification::GetDepthAttachmentInfo(depthImageView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
 
-			auto depthAttachment = RenderPassSpecification::GetDepthAttachmentInfo(depthImageView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+		commandBuffer.ImageBarrier(*
+			m_ShadowMap,
+			0,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+			VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+			VkImageSubresourceRange{ VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, cascadeIndex, 1 }
+		);
 
-			commandBuffer.ImageBarrier(*
-				m_ShadowMap,
-				0,
-				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-				VK_IMAGE_LAYOUT_UNDEFINED,
-				VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-				VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-				VkImageSubresourceRange{ VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, uint32_t(i), 1 }
-			);
+		VkRenderingInfo renderingInfo = RenderPassSpecification::CreateRenderingInfo(extents, nullptr, &depthAttachment);
+		renderingInfo.flags = flags;
 
-			VkRenderingInfo renderingInfo = RenderPassSpecification::CreateRenderingInfo(extents, nullptr, &depthAttachment);
-			
-			commandBuffer.BeginRendering(&renderingInfo);			
-			commandBuffer.SetViewport(static_cast<float>(SHADOW_MAP_DIMENSIONS), static_cast<float>(SHADOW_MAP_DIMENSIONS));
-			commandBuffer.SetScissor(SHADOW_MAP_DIMENSIONS, SHADOW_MAP_DIMENSIONS);
+		commandBuffer.BeginRendering(&renderingInfo);
+	}
 
-			std::vector<Descriptor*> sceneDescriptors = { m_SceneDescriptor.get(), m_MatricesDescriptor.get() };
+	void ShadowMapPass::RecordCascade(CommandBuffer& commandBuffer, uint32_t cascadeIndex, const std::function<void(const std::vector<Descriptor*>&, const Assets::DrawBucketPipelines_t&, const Assets::DrawBucketPipelines_t*, bool, int)>& callback) const {
+		commandBuffer.SetViewport(static_cast<float>(SHADOW_MAP_DIMENSIONS), static_cast<float>(SHADOW_MAP_DIMENSIONS));
+		commandBuffer.SetScissor(SHADOW_MAP_DIMENSIONS, SHADOW_MAP_DIMENSIONS);
 
-			uint32_t cascadeIndex = i;
-			vkCmdPushConstants(commandBuffer, m_Pipeline->GetPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t), &cascadeIndex);
-			callback(sceneDescriptors, m_Pipeline.get(), true, 1 + i);
+		std::vector<Descriptor*> sceneDescriptors = { m_SceneDescriptor.get(), m_MatricesDescriptor.get() };
 
-			vkCmdPushConstants(commandBuffer, m_SkinnedPipeline->GetPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t), &cascadeIndex);
-			callback(sceneDescriptors, m_SkinnedPipeline.get(), false, 1 + i);
+		// No face culling in the shadow pass, single and double sided buckets share their pipeline.
+		const Assets::DrawBucketPipelines_t staticPipelines = { m_Pipeline.get(), m_Pipeline.get(), m_MaskedPipeline.get(), m_MaskedPipeline.get(), nullptr, nullptr };
 
-			commandBuffer.EndRendering();
-		}
+		// The skinned shadow pipeline has no fragment stage, masked geometry is not alpha tested.
+		const Assets::DrawBucketPipelines_t skinnedPipelines = { m_SkinnedPipeline.get(), m_SkinnedPipeline.get(), m_SkinnedPipeline.get(), m_SkinnedPipeline.get(), nullptr, nullptr };
+		const Assets::DrawBucketPipelines_t fullSkinnedPipelines = { m_FullSkinnedPipeline.get(), m_FullSkinnedPipeline.get(), m_FullSkinnedPipeline.get(), m_FullSkinnedPipeline.get(), nullptr, nullptr };
+
+		vkCmdPushConstants(commandBuffer, m_Pipeline->GetPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t), &cascadeIndex);
+		callback(sceneDescriptors, staticPipelines, nullptr, true, 1 + cascadeIndex);
+
+		vkCmdPushConstants(commandBuffer, m_SkinnedPipeline->GetPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t), &cascadeIndex);
+		callback(sceneDescriptors, skinnedPipelines, &fullSkinnedPipelines, false, 1 + cascadeIndex);
 	}
 }
\ No newline at end of file
@@ -26,7 +26,17 @@ namespace Engine::Renderer
 		ShadowMapPass(std::shared_ptr<Device> device, const std::unique_ptr<Swapchain>& swapchain, const std::vector<DescriptorLayout>& objectLayouts );
 
 		void Setup(std::shared_ptr<Device> device, const std::unique_ptr<Swapchain>& swapchain, const std::vector<DescriptorLayout>& objectLayouts);
-		void Render( CommandBuffer& commandBuffer, CommandBuffer& computeCommandBuffer, const Core::Camera& camera, const glm::vec4 lightDirection, class SceneCuller* culler, const std::vector<class Assets::BaseAsset*>& sceneAssets, std::function<void( const std::vector<Descriptor*>&, Renderer::Pipeline*, bool, int )> callback );
+		// Fits the cascades to the camera and culls them, before any cascade is recorded.
+		// Every cascade is then rendered with BeginCascade, RecordCascade and EndRendering. RecordCascade only records draws,
+		// it may run on any thread with its own (secondary) command buffer when BeginCascade was given VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT.
+		// animationTime: time of the baked vertex animations, see Scene::GetVertexAnimationTime.
+		void Update( CommandBuffer& computeCommandBuffer, const Core::Camera& camera, const glm::vec4 lightDirection, class SceneCuller* culler, const std::vector<class Assets::BaseAsset*>& sceneAssets, float animationTime );
+		void BeginCascade( CommandBuffer& commandBuffer, uint32_t cascadeIndex, VkRenderingFlags flags = 0 );
+		// The callback gets one pipeline per draw bucket, blended buckets cast no shadow and have none,
+		// and for skinned assets the variants over full vertices (see Scene::RenderSceneObjects).
+		void RecordCascade( CommandBuffer& commandBuffer, uint32_t cascadeIndex, const std::function<void( const std::vector<Descriptor*>&, const Assets::DrawBucketPipelines_t&, const Assets::DrawBucketPipelines_t*, bool, int )>& callback ) const;
+
+		VkFormat GetDepthFormat( ) const { return m_ShadowMap->GetFormat( ); }
 
 		VkDescriptorSet GetImage( uint32_t index ) const { return m_Cascades[index].m_ImGuiShadowMapView; }
 
@@ -43,6 +53,7 @@ namespace Engine::Renderer
 
 		struct alignas( 16 ) ShadowUBO {
 			glm::mat4 ModelMatrix;
+			glm::vec4 Time; // x: seconds, wrapped like Scene::SceneUniforms.
 		};
 
 		std::shared_ptr<Descriptor> m_Descriptor = nullptr;
@@ -54,8 +65,11 @@ namespace Engine::Renderer
 		std::unique_ptr<Image> m_ShadowMap = nullptr;
 		std::unique_ptr<ImageView> m_ShadowMapView = nullptr;
 
+		// Static geometry: depth only for the opaque buckets, alpha tested for the masked ones. No face culling for any of them.
 		std::unique_ptr<Pipeline> m_Pipeline = nullptr;
+		std::unique_ptr<Pipeline> m_MaskedPipeline = nullptr;
 		std::unique_ptr<Pipeline> m_SkinnedPipeline = nullptr;
+		std::unique_ptr<Pipeline> m_FullSkinnedPipeline = nullptr;	// VF_FULL variant, only when s_VertexFormat is packed.
 
 		std::unique_ptr<Descriptor> m_SceneDescriptor = nullptr;
 
@@ -0,0 +1,139 @@
+#include "../VulkanRenderer.hpp"
+
+namespace Engine::Renderer {
+	BufferArena::BufferArena(std::shared_ptr<Device> device, const VkDeviceSize size, const VkBufferUsageFlags usage) {
+		const VkMemoryAllocateFlags allocateFlags = (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) ? VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT : 0;
+
+		m_Buffer = new Buffer(device, size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_SHARING_MODE_EXCLUSIVE, allocateFlags);
+		m_FreeBlocks[0] = size;
+	}
+
+	BufferArena::~BufferArena() {
+		delete m_Buffer;
+	}
+
+	BufferArena::Range BufferArena::Allocate(const VkDeviceSize size, const VkDeviceSize alignment) {
+		if (size == 0)
+			return {};
+
+		// First fit.
+		for (auto it = m_FreeBlocks.begin(); it != m_FreeBlocks.end(); it++) {
+			const VkDeviceSize blockOffset = it->first;
+			const VkDeviceSize blockSize = it->second;
+
+			const VkDeviceSize alignedOffset = ((blockOffset + alignment - 1) / alignment) * alignment;
+			const VkDeviceSize padding = alignedOffset - blockOffset;
+
+			if (padding + size > blockSize)
+				continue;
+
+			m_FreeBlocks.erase(it);
+
+			// Keep the alignment padding and the remaining tail free.
+			if (padding > 0)
+				m_FreeBlocks[blockOffset] = padding;
+
+			if (const VkDeviceSize tail = blockSize - padding - size; tail > 0)
+				m_FreeBlocks[alignedOffset + size] = tail;
+
+			m_UsedSize += size;
+			return { alignedOffset, size };
+		}
+
+		printf("Geometry arena out of memory (requested %llu bytes, %llu/%llu used)!\n", size, m_UsedSize, m_Buffer->GetSize());
+		return {};
+	}
+
+	void BufferArena::Free(const Range& range) {
+		if (!range.IsValid())
+			return;
+
+		auto [it, inserted] = m_FreeBlocks.emplace(range.m_Offset, range.m_Size);
+		if (!inserted) {
+			printf("Range at offset %llu was freed twice!\n", range.m_Offset);
+			return;
+		}
+
+		m_UsedSize -= range.m_Size;
+
+		// Merge with the next block.
+		if (auto next = std::next(it); next != m_FreeBlocks.end() && it->first + it->second == next->first) {
+			it->second += next->second;
+			m_FreeBlocks.erase(next);
+		}
+
+		// Merge with the previous block.
+		if (it != m_FreeBlocks.begin()) {
+			auto prev = std::prev(it);
+			if (prev->first + prev->second == it->first) {
+				prev->second += it->second;
+				m_FreeBlocks.erase(it);
+			}
+		}
+	}
+
+	GeometryArena::GeometryArena(std::shared_ptr<Device> device, std::shared_ptr<CommandPool> commandPool, const VkDeviceSize vertexCapacity, const VkDeviceSize indexCapacity) :
+		m_Device(device), m_CommandPool(commandPool) {
+		// Storage access for the mesh shader vertex fetch.
+		m_VertexArena = new BufferArena(device, vertexCapacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT);
+		m_IndexArena = new BufferArena(device, indexCapacity, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+
+		m_VertexDescriptor = new Descriptor(device,
+			{
+				{ 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_ALL, nullptr }
+			},
+			VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+		);
+
+		m_VertexDescriptor->Bind(
+			{
+				Descriptor::BindingInfo{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, {.m_Buffer = m_VertexArena->GetBuffer() } }
+			}
+		);
+	}
+
+	GeometryArena::~GeometryArena() {
+		delete m_VertexDescriptor;
+		delete m_VertexArena;
+		delete m_IndexArena;
+	}
+
+	BufferArena::Range GeometryArena::AllocateVertices(const void* data, const VkDeviceSize size, const uint32_t stride) {
+		const auto range = m_VertexArena->Allocate(size, stride);
+
+		if (range.IsValid())
+			Upload(*m_VertexArena->GetBuffer(), range, data, size);
+
+		return range;
+	}
+
+	BufferArena::Range GeometryArena::AllocateIndices(const void* data, const VkDeviceSize size, const uint32_t indexSize) {
+		const auto range = m_IndexArena->Allocate(size, indexSize);
+
+		if (range.IsValid())
+			Upload(*m_IndexArena->GetBuffer(), range, data, size);
+
+		return range;
+	}
+
+	void GeometryArena::Bind(CommandBuffer& commandBuffer) const {
+		commandBuffer.BindVertexBuffer(*m_VertexArena->GetBuffer());
+		BindIndices(commandBuffer, VK_INDEX_TYPE_UINT32);
+	}
+
+	void GeometryArena::BindIndices(CommandBuffer& commandBuffer, const VkIndexType indexType) const {
+		commandBuffer.BindIndexBuffer(*m_IndexArena->GetBuffer(), indexType);
+	}
+
+	void GeometryArena::Upload(const Buffer& destination, const BufferArena::Range& range, const void* data, const VkDeviceSize size) {
+		std::unique_ptr<StagingBuffer> stagingBuffer = std::make_unique<StagingBuffer>(m_Device, size);
+		stagingBuffer->Patch(const_cast<void*>(data), size);
+
+		std::unique_ptr<CommandBuffer> commandBuffer = std::make_unique<CommandBuffer>(m_Device, m_CommandPool);
+
+		commandBuffer->Begin();
+		commandBuffer->CopyBuffer(*stagingBuffer, destination, size, 0, range.m_Offset);
+		commandBuffer->End();
+		commandBuffer->SubmitToQueue(m_Device->GetGraphicsQueue());
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+namespace Engine::Renderer {
+	class Descriptor;
+
+	// Sub-allocates ranges out of one large device-local buffer.
+	// Freed ranges are merged back with their free neighbours.
+	class BufferArena {
+	public:
+		struct Range {
+			VkDeviceSize m_Offset{};
+			VkDeviceSize m_Size{};
+
+			bool IsValid() const { return m_Size != 0; }
+		};
+
+		BufferArena(std::shared_ptr<Device> device, const VkDeviceSize size, const VkBufferUsageFlags usage);
+		~BufferArena();
+
+		// Alignment does not have to be a power of two (vertex ranges are aligned to the vertex stride).
+		Range Allocate(const VkDeviceSize size, const VkDeviceSize alignment);
+		void Free(const Range& range);
+
+		Buffer* GetBuffer() const { return m_Buffer; }
+		VkDeviceSize GetUsedSize() const { return m_UsedSize; }
+		VkDeviceSize GetCapacity() const { return m_Buffer->GetSize(); }
+	private:
+		Buffer* m_Buffer = nullptr;
+
+		// Free blocks, offset -> size.
+		std::map<VkDeviceSize, VkDeviceSize> m_FreeBlocks{};
+		VkDeviceSize m_UsedSize{};
+	};
+
+	// Shared vertex and index storage for every asset in the scene.
+	// Assets own ranges instead of buffers, so a pass binds geometry once and draws with absolute firstIndex/vertexOffset.
+	class GeometryArena {
+	public:
+		static inline GeometryArena* s_Inst = nullptr;
+
+		static GeometryArena* Create(std::shared_ptr<Device> device, std::shared_ptr<CommandPool> commandPool, const VkDeviceSize vertexCapacity, const VkDeviceSize indexCapacity)
+		{
+			if (!s_Inst)
+				s_Inst = new GeometryArena(device, commandPool, vertexCapacity, indexCapacity);
+
+			return s_Inst;
+		}
+
+		static GeometryArena* Get()
+		{
+			return s_Inst;
+		}
+
+		static void Dispose()
+		{
+			delete s_Inst;
+			s_Inst = nullptr;
+		}
+
+		// Uploads the data into a new range, offsets are aligned so that (offset / stride) is a valid vertexOffset.
+		BufferArena::Range AllocateVertices(const void* data, const VkDeviceSize size, const uint32_t stride);
+		BufferArena::Range AllocateIndices(const void* data, const VkDeviceSize size, const uint32_t indexSize = sizeof(uint32_t));
+
+		void FreeVertices(const BufferArena::Range& range) { m_VertexArena->Free(range); }
+		void FreeIndices(const BufferArena::Range& range) { m_IndexArena->Free(range); }
+
+		// Binds the vertex buffer and the index buffer as 32-bit indices.
+		void Bind(CommandBuffer& commandBuffer) const;
+		// Rebinds the index buffer, 16 and 32-bit ranges share the same buffer.
+		void BindIndices(CommandBuffer& commandBuffer, const VkIndexType indexType) const;
+
+		BufferArena* GetVertexArena() const { return m_VertexArena; }
+		BufferArena* GetIndexArena() const { return m_IndexArena; }
+
+		// The whole vertex arena as a storage buffer, read by the mesh shaders.
+		Descriptor* GetVertexDescriptor() const { return m_VertexDescriptor; }
+	private:
+		GeometryArena(std::shared_ptr<Device> device, std::shared_ptr<CommandPool> commandPool, const VkDeviceSize vertexCapacity, const VkDeviceSize indexCapacity);
+		~GeometryArena();
+
+		void Upload(const Buffer& destination, const BufferArena::Range& range, const void* data, const VkDeviceSize size);
+
+		std::shared_ptr<Device> m_Device;
+		std::shared_ptr<CommandPool> m_CommandPool;
+
+		BufferArena* m_VertexArena = nullptr;
+		BufferArena* m_IndexArena = nullptr;
+
+		Descriptor* m_VertexDescriptor = nullptr;
+	};
+}
@@ -1,10 +1,10 @@
 #include "../VulkanRenderer.hpp"
 
 namespace Engine::Renderer {
-	CommandBuffer::CommandBuffer(std::shared_ptr<Device> device, std::shared_ptr<CommandPool> commandPool) : m_Device(device), m_CommandPool(commandPool) {
+	CommandBuffer::CommandBuffer(std::shared_ptr<Device> device, std::shared_ptr<CommandPool> commandPool, VkCommandBufferLevel level) : m_Device(device), m_CommandPool(commandPool) {
 		VkCommandBufferAllocateInfo commandBufferAllocInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
 		commandBufferAllocInfo.commandPool = *m_CommandPool;
-		commandBufferAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		commandBufferAllocInfo.level = level;
 		commandBufferAllocInfo.commandBufferCount = 1;
 
 		if (const auto result = vkAllocateCommandBuffers(*m_Device, &commandBufferAllocInfo, &m_CommandBuffer); result != VK_SUCCESS) {
@@ -28,6 +28,29 @@ namespace Engine::Renderer {
 		if (const auto result = vkBeginCommandBuffer(m_CommandBuffer, &commandBufferBeginInfo); result != VK_SUCCESS) {
 			printf("failed to begin command buffer %d\n", result);
 		}
+		InvalidateBindings();
+		m_BindStats = {};
+	}
+
+	void CommandBuffer::BeginSecondary(const std::vector<VkFormat>& colorFormats, VkFormat depthFormat, VkSampleCountFlagBits samples) {
+		VkCommandBufferInheritanceRenderingInfo renderingInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO };
+		renderingInfo.colorAttachmentCount = static_cast<uint32_t>(colorFormats.size());
+		renderingInfo.pColorAttachmentFormats = colorFormats.data();
+		renderingInfo.depthAttachmentFormat = depthFormat;
+		renderingInfo.rasterizationSamples = samples;
+
+		VkCommandBufferInheritanceInfo inheritanceInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+		inheritanceInfo.pNext = &renderingInfo;
+
+		VkCommandBufferBeginInfo commandBufferBeginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+		commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		commandBufferBeginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		if (const auto result = vkBeginCommandBuffer(m_CommandBuffer, &commandBufferBeginInfo); result != VK_SUCCESS) {
+			printf("failed to begin secondary command buffer %d\n", result);
+		}
+		InvalidateBindings();
+		m_BindStats = {};
 	}
 
 	void CommandBuffer::End() {
@@ -46,10 +69,10 @@ namespace Engine::Renderer {
 			vkQueueWaitIdle(queue);
 	}
 
-	void CommandBuffer::CopyBuffer(const VkBuffer& source, const VkBuffer& destination, const VkDeviceSize& size) const {
+	void CommandBuffer::CopyBuffer(const VkBuffer& source, const VkBuffer& destination, const VkDeviceSize& size, const VkDeviceSize srcOffset, const VkDeviceSize dstOffset) const {
 		VkBufferCopy bufferCopy = {};
-		bufferCopy.srcOffset = 0;
-		bufferCopy.dstOffset = 0;
+		bufferCopy.srcOffset = srcOffset;
+		bufferCopy.dstOffset = dstOffset;
 		bufferCopy.size = size;
 
 		vkCmdCopyBuffer(m_CommandBuffer, source, destination, 1, &bufferCopy);
@@ -106,6 +129,19 @@ namespace Engine::Renderer {
 		vkCmdEndRendering(m_CommandBuffer);
 	}
 
+	void CommandBuffer::ExecuteCommands(const std::vector<CommandBuffer*>& commandBuffers) {
+		std::vector<VkCommandBuffer> handles{};
+		handles.reserve(commandBuffers.size());
+
+		for (auto* commandBuffer : commandBuffers)
+			handles.push_back(*commandBuffer);
+
+		vkCmdExecuteCommands(m_CommandBuffer, static_cast<uint32_t>(handles.size()), handles.data());
+
+		// Bindings are undefined after secondaries ran.
+		InvalidateBindings();
+	}
+
 	/*
 	void CommandBuffer::EndRenderPass() {
 		vkCmdEndRenderPass(m_CommandBuffer);
@@ -174,8 +210,60 @@ namespace Engine::Renderer {
 		vkCmdPipelineBarrier2( m_CommandBuffer, &dependencyInfo );
 	}
 
+	void CommandBuffer::BindPipeline(const Pipeline& pipeline) {
+		auto& state = m_BindPoints[VK_PIPELINE_BIND_POINT_GRAPHICS];
+
+		if (state.m_Pipeline == pipeline) {
+			m_BindStats.m_Elided++;
+			return;
+		}
+
+		vkCmdBindPipeline(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		state.m_Pipeline = pipeline;
+		m_BindStats.m_Issued++;
+	}
+
+	void CommandBuffer::BindPipeline(const ComputePipeline& pipeline) {
+		auto& state = m_BindPoints[VK_PIPELINE_BIND_POINT_COMPUTE];
+
+		if (state.m_Pipeline == pipeline) {
+			m_BindStats.m_Elided++;
+			return;
+		}
+
+		vkCmdBindPipeline(m_CommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+		state.m_Pipeline = pipeline;
+		m_BindStats.m_Issued++;
+	}
+
+	void CommandBuffer::BindVertexBuffer(VkBuffer buffer, VkDeviceSize offset) {
+		if (m_VertexBuffer == buffer && m_VertexOffset == offset) {
+			m_BindStats.m_Elided++;
+			return;
+		}
+
+		vkCmdBindVertexBuffers(m_CommandBuffer, 0, 1, &buffer, &offset);
+		m_VertexBuffer = buffer;
+		m_VertexOffset = offset;
+		m_BindStats.m_Issued++;
+	}
+
+	void CommandBuffer::BindIndexBuffer(VkBuffer buffer, VkIndexType indexType, VkDeviceSize offset) {
+		if (m_IndexBuffer == buffer && m_IndexType == indexType && m_IndexOffset == offset) {
+			m_BindStats.m_Elided++;
+			return;
+		}
+
+		vkCmdBindIndexBuffer(m_CommandBuffer, buffer, offset, indexType);
+		m_IndexBuffer = buffer;
+		m_IndexType = indexType;
+		m_IndexOffset = offset;
+		m_BindStats.m_Issued++;
+	}
+
 	void CommandBuffer::BindDescriptors(const std::vector<Descriptor*>& descriptors) {
-		std::vector<VkDescriptorBufferBindingInfoEXT> bindingInfos{};
+		auto& bindingInfos = m_PendingDescriptorBuffers;
+		bindingInfos.clear();
 
 		for (auto i = 0; i < descriptors.size(); i++) {
 			auto* desc = descriptors[i];
@@ -191,52 +279,83 @@ namespace Engine::Renderer {
 			bindingInfos.push_back(bindingInfo);
 		}
 
+		const bool bound = bindingInfos.size() == m_DescriptorBuffers.size() &&
+			std::equal(bindingInfos.cbegin(), bindingInfos.cend(), m_DescriptorBuffers.cbegin(),
+				[](const VkDescriptorBufferBindingInfoEXT& a, const VkDescriptorBufferBindingInfoEXT& b) { return a.address == b.address && a.usage == b.usage; });
+
+		if (bound) {
+			m_BindStats.m_Elided++;
+			return;
+		}
+
 		vkCmdBindDescriptorBuffersEXT(m_CommandBuffer, static_cast<uint32_t>(bindingInfos.size()), bindingInfos.data());
+		m_DescriptorBuffers.swap(bindingInfos);
+		m_BindStats.m_Issued++;
+
+		// Not relying on set offsets surviving a rebind, every set is pointed at its buffer again.
+		for (auto& state : m_BindPoints)
+			state.m_SetCount = 0;
 	}
 
 	void CommandBuffer::SetDescriptorOffsets(const std::vector<class Descriptor*>& descriptors, const Pipeline& pipeline) {
-		std::vector<uint32_t> setIndices{};
-		std::vector<VkDeviceSize> setOffsets{};
+		SetDescriptorOffsets(static_cast<uint32_t>(descriptors.size()), VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.GetPipelineLayout());
+	}
 
-		setIndices.resize(descriptors.size());
-		setOffsets.resize(descriptors.size());
+	void CommandBuffer::SetDescriptorOffsets(const std::vector<class Descriptor*>& descriptors, const ComputePipeline& pipeline) {
+		SetDescriptorOffsets(static_cast<uint32_t>(descriptors.size()), VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.GetPipelineLayout());
+	}
 
-		for (auto i = 0; i < descriptors.size(); i++) {
-			setIndices[i] = i;
-			setOffsets[i] = 0;
+	void CommandBuffer::SetDescriptorOffsets(uint32_t setCount, VkPipelineBindPoint bindPoint, VkPipelineLayout layout) {
+		auto& state = m_BindPoints[bindPoint];
+
+		// Other layouts may not be compatible, all sets are set again then.
+		if (state.m_Layout != layout) {
+			state.m_Layout = layout;
+			state.m_SetCount = 0;
 		}
 
-		vkCmdSetDescriptorBufferOffsetsEXT(
-			m_CommandBuffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			pipeline.GetPipelineLayout(),
-			0,
-			static_cast<uint32_t>(setIndices.size()),
-			setIndices.data(),
-			setOffsets.data()
-		);
-	}
+		// Set i always uses descriptor buffer i at offset 0, only sets past the ones already pointed need it.
+		if (setCount <= state.m_SetCount) {
+			m_BindStats.m_Elided++;
+			return;
+		}
+
+		const uint32_t firstSet = state.m_SetCount;
 
-	void CommandBuffer::SetDescriptorOffsets(const std::vector<class Descriptor*>& descriptors, const ComputePipeline& pipeline) {
 		std::vector<uint32_t> setIndices{};
 		std::vector<VkDeviceSize> setOffsets{};
 
-		setIndices.resize(descriptors.size());
-		setOffsets.resize(descriptors.size());
+		setIndices.resize(setCount - firstSet);
+		setOffsets.resize(setCount - firstSet);
 
-		for (auto i = 0; i < descriptors.size(); i++) {
-			setIndices[i] = i;
+		for (uint32_t i = 0; i < setIndices.size(); i++) {
+			setIndices[i] = firstSet + i;
 			setOffsets[i] = 0;
 		}
 
 		vkCmdSetDescriptorBufferOffsetsEXT(
 			m_CommandBuffer,
-			VK_PIPELINE_BIND_POINT_COMPUTE,
-			pipeline.GetPipelineLayout(),
-			0,
+			bindPoint,
+			layout,
+			firstSet,
 			static_cast<uint32_t>(setIndices.size()),
 			setIndices.data(),
 			setOffsets.data()
 		);
+
+		state.m_SetCount = setCount;
+		m_BindStats.m_Issued++;
+	}
+
+	void CommandBuffer::InvalidateBindings() {
+		m_BindPoints = {};
+		m_DescriptorBuffers.clear();
+
+		m_VertexBuffer = VK_NULL_HANDLE;
+		m_VertexOffset = 0;
+
+		m_IndexBuffer = VK_NULL_HANDLE;
+		m_IndexOffset = 0;
+		m_IndexType = VK_INDEX_TYPE_MAX_ENUM;
 	}
 }
\ No newline at end of file
@@ -2,19 +2,59 @@
 #include <variant>
 
 namespace Engine::Renderer {
+	// Bind calls of one recording, see CommandBuffer::BindPipeline.
+	struct BindStats {
+		uint32_t m_Issued{};
+		uint32_t m_Elided{};	// Skipped, the same state was bound already.
+
+		BindStats& operator+=(const BindStats& other) {
+			m_Issued += other.m_Issued;
+			m_Elided += other.m_Elided;
+			return *this;
+		}
+	};
+
 	class CommandBuffer {
 		VkCommandBuffer m_CommandBuffer = VK_NULL_HANDLE;
 
 		std::shared_ptr<Device> m_Device;
 		std::shared_ptr<CommandPool> m_CommandPool;
+
+		// Bindings of the recording so far, per bind point (graphics, compute).
+		struct BindPointState {
+			VkPipeline m_Pipeline = VK_NULL_HANDLE;
+
+			// Sets [0, m_SetCount) were pointed at the descriptor buffers of the same index through m_Layout.
+			VkPipelineLayout m_Layout = VK_NULL_HANDLE;
+			uint32_t m_SetCount{};
+		};
+
+		std::array<BindPointState, 2> m_BindPoints{};
+		std::vector<VkDescriptorBufferBindingInfoEXT> m_DescriptorBuffers{};
+		std::vector<VkDescriptorBufferBindingInfoEXT> m_PendingDescriptorBuffers{};
+
+		VkBuffer m_VertexBuffer = VK_NULL_HANDLE;
+		VkDeviceSize m_VertexOffset{};
+
+		VkBuffer m_IndexBuffer = VK_NULL_HANDLE;
+		VkDeviceSize m_IndexOffset{};
+		VkIndexType m_IndexType = VK_INDEX_TYPE_MAX_ENUM;
+
+		BindStats m_BindStats{};
+
+		void SetDescriptorOffsets(uint32_t setCount, VkPipelineBindPoint bindPoint, VkPipelineLayout layout);
 	public:
-		CommandBuffer(std::shared_ptr<Device> device, std::shared_ptr<CommandPool> commandPool);
+		CommandBuffer(std::shared_ptr<Device> device, std::shared_ptr<CommandPool> commandPool, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 		~CommandBuffer();
 
 		void Begin(VkCommandBufferUsageFlags flags = 0);
+
+		// Secondary command buffers only, continues a dynamic rendering scope the primary began with VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT.
+		// The attachment formats and sample count have to match that scope. Viewport and scissor are not inherited.
+		void BeginSecondary(const std::vector<VkFormat>& colorFormats, VkFormat depthFormat, VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT);
 		void End();
 		void SubmitToQueue(const VkQueue& queue, bool wait = true);
-		void CopyBuffer(const VkBuffer& source, const VkBuffer& destination, const VkDeviceSize& size) const;
+		void CopyBuffer(const VkBuffer& source, const VkBuffer& destination, const VkDeviceSize& size, const VkDeviceSize srcOffset = 0, const VkDeviceSize dstOffset = 0) const;
 		void CopyBufferToImage(const VkBuffer& buffer, const VkImage& image, uint32_t width, uint32_t height) const;
 
 		void SetScissor(uint32_t width, uint32_t height, int32_t x = 0, int32_t y = 0);
@@ -34,13 +74,28 @@ namespace Engine::Renderer {
 		void BeginRendering(VkRenderingInfo* renderingInfo);
 		void EndRendering();
 
+		void ExecuteCommands(const std::vector<CommandBuffer*>& commandBuffers);
+
 		// void BeginRenderPass(RenderPass* renderPass, Swapchain* swapChain, const VkFramebuffer& frameBuffer, VkClearValue* clearValues = nullptr, VkExtent2D* extents = nullptr);
 		// void EndRenderPass();
 
+		// The binds below skip whatever is bound already and count it in GetBindStats. Begin and ExecuteCommands forget the bindings,
+		// anything else that changes them behind the command buffer's back (raw vkCmd* calls, libraries) has to call InvalidateBindings.
+		void BindPipeline(const Pipeline& pipeline);
+		void BindPipeline(const ComputePipeline& pipeline);
+
+		void BindVertexBuffer(VkBuffer buffer, VkDeviceSize offset = 0);
+		void BindIndexBuffer(VkBuffer buffer, VkIndexType indexType, VkDeviceSize offset = 0);
+
 		void BindDescriptors(const std::vector<class Descriptor*>& descriptors);
 		void SetDescriptorOffsets(const std::vector<class Descriptor*>& descriptors, const Pipeline& pipeline);
 		void SetDescriptorOffsets(const std::vector<class Descriptor*>& descriptors, const ComputePipeline& pipeline);
 
+		void InvalidateBindings();
+
+		// Since the last Begin.
+		const BindStats& GetBindStats() const { return m_BindStats; }
+
 		DEFINE_IMPLICIT_VK(m_CommandBuffer);
 	};
 
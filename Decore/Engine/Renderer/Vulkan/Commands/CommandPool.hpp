@@ -6,9 +6,12 @@ namespace Engine::Renderer {
 
 		const Device& m_Device;
 	public:
-		CommandPool(const Device& device);
+		CommandPool(const Device& device, VkCommandPoolCreateFlags flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
 		~CommandPool();
 
+		// Resets every command buffer allocated from the pool, none of them may be pending.
+		void Reset();
+
 		DEFINE_IMPLICIT_VK(m_CommandPool);
 	};
 }
\ No newline at end of file
@@ -34,6 +34,9 @@ namespace Engine::Renderer {
         delete m_PrePassDepthImage;
         delete m_PrePassDepthImageView;
 
+        delete m_PrePassMSAANormalsImage;
+        delete m_PrePassMSAANormalsImageView;
+
         delete m_HDRImage;
         delete m_HDRImageView;
 
@@ -209,5 +212,20 @@ namespace Engine::Renderer {
 
         m_PrePassNormalsImageView =
             new ImageView(m_Device, *m_PrePassNormalsImage, 1, GetImageFormat());
+
+        m_PrePassMSAANormalsImage = new Image(
+            m_Device,
+            extents.width,
+            extents.height,
+            1,
+            GetImageFormat(),
+            VK_IMAGE_TILING_OPTIMAL,
+            m_MSAASamples,
+            VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        );
+
+        m_PrePassMSAANormalsImageView =
+            new ImageView(m_Device, *m_PrePassMSAANormalsImage, 1, GetImageFormat());
     }
 }
\ No newline at end of file
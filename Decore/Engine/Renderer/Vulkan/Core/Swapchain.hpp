@@ -29,6 +29,10 @@ namespace Engine::Renderer {
 		Image* m_PrePassNormalsImage = nullptr;
 		ImageView* m_PrePassNormalsImageView = nullptr;
 
+		// Prepass normals at the MSAA sample count, resolved into m_PrePassNormalsImage when the prepass renders into m_DepthImage.
+		Image* m_PrePassMSAANormalsImage = nullptr;
+		ImageView* m_PrePassMSAANormalsImageView = nullptr;
+
 		Image* m_MSAAImage = nullptr;
 		ImageView* m_MSAAImageView = nullptr;
 
@@ -56,7 +56,7 @@ namespace Engine::Renderer {
 			VkDeviceSize descSize = {};
 
 			if (info.m_Type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) {
-				descImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				descImageInfo.imageLayout = info.m_ImageLayout;
 				descImageInfo.imageView = *info.m_Data.m_ImageView;
 				descImageInfo.sampler = *info.m_CombinedSampler;
 
@@ -69,6 +69,16 @@ namespace Engine::Renderer {
 				m_Flags |= VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT;
 			}
 
+			if (info.m_Type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE) {
+				descImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+				descImageInfo.imageView = *info.m_Data.m_ImageView;
+
+				descGetInfo.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+				descGetInfo.data.pStorageImage = &descImageInfo;
+
+				descSize = descriptorBufferProperties.storageImageDescriptorSize;
+			}
+
 			if (info.m_Type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
 				descAddrInfo.address = info.m_Data.m_Buffer->GetDeviceAddress();
 				descAddrInfo.range = info.m_Data.m_Buffer->GetSize();
@@ -17,6 +17,7 @@ namespace Engine::Renderer {
 
 			// Optional
 			class Sampler* m_CombinedSampler = nullptr;
+			VkImageLayout m_ImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 		};
 
 		Descriptor(std::shared_ptr<Device> device, const std::vector<VkDescriptorSetLayoutBinding>& layoutBindings, const VkBufferUsageFlags bufferUsageFlags, void* optionalNext = nullptr);
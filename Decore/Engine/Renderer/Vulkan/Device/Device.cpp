@@ -31,6 +31,25 @@ namespace Engine::Renderer {
         
         VkPhysicalDeviceVulkan12Features testFeatures12{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
 
+        // VK_EXT_mesh_shader is optional, its features are only queried when the device exposes it.
+        bool meshShaderExtension = false;
+        {
+            uint32_t extensionCount = 0;
+            vkEnumerateDeviceExtensionProperties(*m_PhysicalDevice, nullptr, &extensionCount, nullptr);
+
+            std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+            vkEnumerateDeviceExtensionProperties(*m_PhysicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+            for (const auto& ext : availableExtensions) {
+                if (strcmp(ext.extensionName, VK_EXT_MESH_SHADER_EXTENSION_NAME) == 0)
+                    meshShaderExtension = true;
+            }
+        }
+
+        VkPhysicalDeviceMeshShaderFeaturesEXT testMeshShaderFeatures{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT };
+        if (meshShaderExtension)
+            testFeatures12.pNext = &testMeshShaderFeatures;
+
         VkPhysicalDeviceFeatures2 deviceFeatures2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
         deviceFeatures2.pNext = &testFeatures12;
 
@@ -67,13 +86,37 @@ namespace Engine::Renderer {
             deviceFeatures.shaderInt16 = VK_TRUE;
         }
 
+        {
+            VkPhysicalDeviceSubgroupProperties subgroupProperties = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES };
+
+            VkPhysicalDeviceProperties2 properties2 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+            properties2.pNext = &subgroupProperties;
+            vkGetPhysicalDeviceProperties2(*m_PhysicalDevice, &properties2);
+
+            // quadOperationsInAllStages only covers the non fragment/compute stages, compute always has them with the quad bit.
+            m_ComputeQuadOperations =
+                (subgroupProperties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) &&
+                (subgroupProperties.supportedOperations & VK_SUBGROUP_FEATURE_QUAD_BIT);
+
+            if (m_ComputeQuadOperations)
+                printf("Device Supports Compute Quad Operations\n");
+        }
+
         VkDeviceCreateInfo deviceCreateInfo{ VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
         deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
 
-        const auto& extensions = m_PhysicalDevice->GetExtensions();
+        m_EnabledExtensions = m_PhysicalDevice->GetExtensions();
+
+        // The meshlet path falls back to compute culling + indexed draws without mesh shaders.
+        m_MeshShader = meshShaderExtension && testMeshShaderFeatures.taskShader && testMeshShaderFeatures.meshShader;
 
-        deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
-        deviceCreateInfo.ppEnabledExtensionNames = extensions.data();
+        if (m_MeshShader) {
+            printf("Device Supports MeshShader\n");
+            m_EnabledExtensions.push_back(VK_EXT_MESH_SHADER_EXTENSION_NAME);
+        }
+
+        deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(m_EnabledExtensions.size());
+        deviceCreateInfo.ppEnabledExtensionNames = m_EnabledExtensions.data();
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
         std::set<uint32_t> uniqueQueueFamilies = { m_QueueFamilyIndices.m_GraphicsFamilyIndex, m_QueueFamilyIndices.m_PresentFamilyIndex, m_QueueFamilyIndices.m_ComputeFamilyIndex };
@@ -118,6 +161,13 @@ namespace Engine::Renderer {
         features12.descriptorBindingVariableDescriptorCount = VK_TRUE;
         features12.descriptorBindingPartiallyBound = VK_TRUE;
 
+        // Meshlet culling emits a variable number of draws.
+        if (testFeatures12.drawIndirectCount) {
+            printf("Device Supports DrawIndirectCount\n");
+            features12.drawIndirectCount = VK_TRUE;
+            m_DrawIndirectCount = true;
+        }
+
         // Buffer Device Addresses.
         features12.bufferDeviceAddress = VK_TRUE;
 
@@ -128,8 +178,12 @@ namespace Engine::Renderer {
         featuresDescriptorBuffer.descriptorBuffer = VK_TRUE;
         featuresDescriptorBuffer.pNext = &features13;
         
+        VkPhysicalDeviceMeshShaderFeaturesEXT featuresMeshShader = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT };
+        featuresMeshShader.taskShader = VK_TRUE;
+        featuresMeshShader.meshShader = VK_TRUE;
+        featuresMeshShader.pNext = &featuresDescriptorBuffer;
 
-        features14.pNext = &featuresDescriptorBuffer;
+        features14.pNext = m_MeshShader ? static_cast<void*>(&featuresMeshShader) : static_cast<void*>(&featuresDescriptorBuffer);
         deviceCreateInfo.pNext = &features14;
 
         if (const auto result = vkCreateDevice(*m_PhysicalDevice, &deviceCreateInfo, nullptr, &m_Device); result != VK_SUCCESS) {
@@ -13,6 +13,13 @@ namespace Engine::Renderer {
 		VkQueue m_GraphicsQueue = VK_NULL_HANDLE, m_PresentQueue = VK_NULL_HANDLE, m_ComputeQueue = VK_NULL_HANDLE;
 
 		QueueFamilyIndices_t m_QueueFamilyIndices{};
+
+		// Optional features, enabled when the physical device has them.
+		bool m_DrawIndirectCount{};
+		bool m_MeshShader{};
+		bool m_ComputeQuadOperations{};
+
+		std::vector<const char*> m_EnabledExtensions{};
 	public:
 		Device(std::shared_ptr<Instance> instance, std::shared_ptr<PhysicalDevice> physicalDevice, std::shared_ptr<Surface> surface);
 		~Device();
@@ -25,6 +32,12 @@ namespace Engine::Renderer {
 
 		const QueueFamilyIndices_t& GetQueueFamilyIndices() const { return m_QueueFamilyIndices; }
 
+		bool SupportsDrawIndirectCount() const { return m_DrawIndirectCount; }
+		bool SupportsMeshShader() const { return m_MeshShader; }
+
+		// Subgroup quad operations in compute shaders (core 1.1 properties, no feature to enable).
+		bool SupportsComputeQuadOperations() const { return m_ComputeQuadOperations; }
+
 		DEFINE_IMPLICIT_VK(m_Device);
 	};
 }
\ No newline at end of file
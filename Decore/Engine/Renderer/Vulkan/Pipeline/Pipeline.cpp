@@ -16,7 +16,8 @@ namespace Engine::Renderer {
         VkPipelineDepthStencilStateCreateInfo depthStencilState,
         VkPipelineDynamicStateCreateInfo dynamicState,
         VkPipelineColorBlendStateCreateInfo colorBlendState,
-        const std::vector<VkPipelineColorBlendAttachmentState>& colorBlendAttachmentStates) :
+        const std::vector<VkPipelineColorBlendAttachmentState>& colorBlendAttachmentStates,
+        const std::vector<uint32_t>& specializationConstants) :
         m_Shaders(shaders),
         m_Swapchain(swapChain),
         m_ColorFormats(colorFormats),
@@ -24,7 +25,8 @@ namespace Engine::Renderer {
         m_VertexInfo(vertexInfo),
         m_DescriptorSets(descriptorSets),
         m_PushConstants(pushConstants),
-        m_PipelineCache(pipelineCache)
+        m_PipelineCache(pipelineCache),
+        m_SpecializationConstants(specializationConstants)
     {
         m_MultisampleState = multisampleState;
         m_InputAssemblyState = inputAssemblyState;
@@ -95,6 +97,15 @@ namespace Engine::Renderer {
         m_ShaderStages.resize(shaders.size());
         m_ShaderModules.resize(shaders.size());
 
+        m_SpecializationEntries.resize(m_SpecializationConstants.size());
+        for (uint32_t i = 0; i < m_SpecializationConstants.size(); i++)
+            m_SpecializationEntries[i] = { i, i * static_cast<uint32_t>(sizeof(uint32_t)), sizeof(uint32_t) };
+
+        m_SpecializationInfo.mapEntryCount = static_cast<uint32_t>(m_SpecializationEntries.size());
+        m_SpecializationInfo.pMapEntries = m_SpecializationEntries.data();
+        m_SpecializationInfo.dataSize = m_SpecializationConstants.size() * sizeof(uint32_t);
+        m_SpecializationInfo.pData = m_SpecializationConstants.data();
+
         // Adapted from zeux - https://github.com/zeux/niagara/blob/master/src/shaders.cpp#L531
         for (auto i = 0; i < shaders.size(); i++)
         {
@@ -114,6 +125,7 @@ namespace Engine::Renderer {
             stage.stage = shader->GetStageFlags();
             stage.pName = "main";
             stage.pNext = &module;
+            stage.pSpecializationInfo = m_SpecializationConstants.empty() ? nullptr : &m_SpecializationInfo;
         }
     }
 
@@ -334,7 +346,8 @@ namespace Engine::Renderer {
             m_DepthStencilState,
             m_DynamicState,
             m_ColorBlendState,
-            m_ColorBlendAttachmentStates
+            m_ColorBlendAttachmentStates,
+            m_SpecializationConstants
         );
     }
 }
\ No newline at end of file
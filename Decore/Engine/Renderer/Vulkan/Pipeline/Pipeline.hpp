@@ -37,6 +37,11 @@ namespace Engine::Renderer {
 		std::vector<VkPipelineShaderStageCreateInfo> m_ShaderStages{};
 		std::vector<VkShaderModuleCreateInfo> m_ShaderModules{};
 
+		// Constant i is constant_id i, the same values go to every stage.
+		std::vector<uint32_t> m_SpecializationConstants{};
+		std::vector<VkSpecializationMapEntry> m_SpecializationEntries{};
+		VkSpecializationInfo m_SpecializationInfo{};
+
 		VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
 		VkPipeline m_Pipeline = VK_NULL_HANDLE;
 		VkPipelineCache m_PipelineCache = VK_NULL_HANDLE;
@@ -73,7 +78,8 @@ namespace Engine::Renderer {
 			VkPipelineDepthStencilStateCreateInfo depthStencilState,
 			VkPipelineDynamicStateCreateInfo dynamicState,
 			VkPipelineColorBlendStateCreateInfo colorBlendState,
-			const std::vector<VkPipelineColorBlendAttachmentState>& colorBlendAttachmentStates);
+			const std::vector<VkPipelineColorBlendAttachmentState>& colorBlendAttachmentStates,
+			const std::vector<uint32_t>& specializationConstants = {});
 		~Pipeline();
 
 		bool Recreate( );
@@ -115,6 +121,10 @@ namespace Engine::Renderer {
 		PipelineBuilder& SetColorBlendState(const VkPipelineColorBlendStateCreateInfo& colorBlendState) { m_ColorBlendState = colorBlendState;return *this;
 		}
 
+		// 32-bit values for constant_id 0, 1, ... of every shader stage.
+		PipelineBuilder& SetSpecializationConstants(const std::vector<uint32_t>& specializationConstants) { m_SpecializationConstants = specializationConstants; return *this;
+		}
+
 		Pipeline* Build(const Swapchain& swapchain);
 	private:
 		std::vector<Shader*> m_Shaders{};
@@ -133,5 +143,7 @@ namespace Engine::Renderer {
 
 		std::vector<VkPipelineColorBlendAttachmentState> m_ColorBlendAttachmentStates{};
 		VkPipelineColorBlendStateCreateInfo m_ColorBlendState{};
+
+		std::vector<uint32_t> m_SpecializationConstants{};
 	};
 }
\ No newline at end of file
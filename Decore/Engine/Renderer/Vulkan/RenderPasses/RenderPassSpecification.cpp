@@ -20,16 +20,20 @@ namespace Engine::Renderer {
 		return colorAttachment;
 	}
 
-	VkRenderingAttachmentInfo RenderPassSpecification::GetDepthAttachmentInfo(const VkImageView view, VkImageLayout layout)
+	VkRenderingAttachmentInfo RenderPassSpecification::GetDepthAttachmentInfo(const VkImageView view, VkImageLayout layout, bool clear, VkResolveModeFlagBits resolveMode, VkImageView resolveImage, VkImageLayout resolveLayout)
 	{
 		VkRenderingAttachmentInfo depthAttachment = { VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO };
 
 		depthAttachment.imageView = view;
 		depthAttachment.imageLayout = layout;
-		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depthAttachment.loadOp = clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
 		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 		depthAttachment.clearValue.depthStencil.depth = 1.f;
 
+		depthAttachment.resolveMode = resolveMode;
+		depthAttachment.resolveImageView = resolveImage;
+		depthAttachment.resolveImageLayout = resolveLayout;
+
 		return depthAttachment;
 	}
 
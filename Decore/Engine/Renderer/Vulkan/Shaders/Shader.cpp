@@ -135,7 +135,9 @@ namespace Engine::Renderer {
 	bool Shader::Compile() {
 		static shaderc_compiler_t compiler = shaderc_compiler_initialize();
 		static shaderc_compile_options_t options = shaderc_compile_options_initialize();
-		shaderc_compile_options_set_source_language(options, shaderc_source_language_hlsl);
+		// The HLSL front-end has no task/mesh stages, those are written in GLSL.
+		const bool isGLSL = std::filesystem::path(m_Path).extension() == ".glsl";
+		shaderc_compile_options_set_source_language(options, isGLSL ? shaderc_source_language_glsl : shaderc_source_language_hlsl);
 		shaderc_compile_options_set_invert_y(options, false);
 		shaderc_compile_options_set_target_env(options, shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_4);
 		shaderc_compile_options_set_target_spirv(options, shaderc_spirv_version_1_6);
@@ -36,6 +36,12 @@ namespace Engine::Renderer {
 			if (flags & VK_SHADER_STAGE_COMPUTE_BIT)
 				return shaderc_compute_shader;
 
+			if (flags & VK_SHADER_STAGE_TASK_BIT_EXT)
+				return shaderc_task_shader;
+
+			if (flags & VK_SHADER_STAGE_MESH_BIT_EXT)
+				return shaderc_mesh_shader;
+
 			// assume its a fragment shader by default.
 			return shaderc_fragment_shader;
 		}
@@ -29,6 +29,9 @@ namespace Engine::Renderer
 		m_CommandBuffer = std::make_shared<CommandBuffer>(m_Device, m_CommandPool);
 		m_ComputeCommandBuffer = std::make_shared<CommandBuffer>(m_Device, m_CommandPool);
 
+		// Shared vertex/index storage for every asset (256MB vertices, 128MB indices), every scene pass binds it.
+		GeometryArena::Create(m_Device, m_CommandPool, 256ull * 1024 * 1024, 128ull * 1024 * 1024);
+
 		CreateSwapChain();
 		CreateSyncObjects();
 
@@ -124,8 +127,10 @@ namespace Engine::Renderer
 		}
 
 		// Render Submit.
+		// Compute results are read as indirect commands and by the vertex shaders (morph targets) too, not just by compute.
 		VkSemaphore waitSemaphores[] = { m_ImageAvailableSemaphore, m_ComputeFinishedSemaphore };
-		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT };
+		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT };
 
 		std::vector<VkCommandBuffer> commandBuffers = { *m_CommandBuffer };
 
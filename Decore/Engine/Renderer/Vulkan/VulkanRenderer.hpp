@@ -2,6 +2,7 @@
 #include <set>
 #include <cstdint>
 #include <vector>
+#include <map>
 #include <array>
 #include <string>
 #include <algorithm>
@@ -33,6 +34,7 @@
 #include "Pipeline/ComputePipeline.hpp"
 #include "Buffers/Buffer.hpp"
 #include "Commands/CommandBuffer.hpp"
+#include "Buffers/GeometryArena.hpp"
 #include "Descriptors/DescriptorLayout.hpp"
 #include "Descriptors/Descriptor.hpp"
 #include "Images/Sampler.hpp"
@@ -18,13 +18,17 @@
 #include <gtc/matrix_transform.hpp>
 #include <gtx/matrix_decompose.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <random>
+
 using namespace Engine::Core;
 using namespace Engine::Renderer;
 using namespace Engine::Assets;
 
 namespace Engine::Tests
 {
-	static bool ThirdPersonMovement( const float dt, const Core::Camera& camera, glm::vec3& targetPos, glm::mat4* outMatrix )
+	static bool ThirdPersonMovement( const float dt, const Core::Camera& camera, Core::CharacterController& controller, glm::vec3& targetPos, glm::mat4* outMatrix )
 	{
 		const float moveSpeed = 5.f;
 		float xdir = float( InputSystem::GetKeyHeld( 'W' ) ) - float( InputSystem::GetKeyHeld( 'S' ) );
@@ -62,41 +66,10 @@ namespace Engine::Tests
 
 		movementInput = ( ( movementInput.x * glm::normalize( cameraForwardXZ ) ) + ( movementInput.z * glm::normalize( cameraRightXZ ) ) );
 
-		glm::vec3 newMovement = movementInput;
-
-		// Temporary AABB while theres no PlayerController class and Collider components.
-		glm::vec3 boxSize = glm::vec3( 0.25f, 0.5f, 0.25f );
-		glm::vec3 boxOffset = glm::vec3( 0.f, 0.75f, 0.f );
-
-		Core::CollisionBox playerAABB( targetPos + boxOffset - boxSize, targetPos + boxOffset + boxSize );
-
-#if 0
-		glm::vec3 intersectDir{};
-		bool hit = m_Scene->Intersects( playerAABB, intersectDir );
-
-		// Wall sliding.
-		if ( hit )
-		{
-			glm::vec3 normal = glm::normalize( intersectDir );
-			glm::vec3 projected = normal * glm::dot( newMovement, normal );
-			newMovement -= projected;
-		}
-#endif
-		targetPos += ( newMovement * moveSpeed * dt );
-#if 0
-		// Update AABB and Check for intersection.
-		playerAABB = Core::CollisionBox( targetPos + boxOffset - boxSize, targetPos + boxOffset + boxSize );
-		hit = m_Scene->Intersects( playerAABB, intersectDir );
-
-		// If we are interescting again offset the player position (Push it away from the intersected AABB).
-		if ( hit )
-		{
-			glm::vec3 normal = glm::normalize( intersectDir );
-			glm::vec3 offset = ( normal * boxSize ) - intersectDir;
+		// Sliding, stepping and ground snapping are resolved by the controller against the static mesh bodies on the physics thread.
+		controller.SetVelocity( movementInput * moveSpeed );
+		targetPos = controller.GetPosition( );
 
-			targetPos += offset;
-		}
-#endif
 		( *outMatrix ) = localRotation;
 		( *outMatrix )[ 3 ] = glm::vec4( targetPos, 1.f );
 
@@ -105,8 +78,43 @@ namespace Engine::Tests
 		return isMoving;
 	}
 
+	// Frame time averaged over half a second, kept per mode of a toggle to compare both.
+	struct ModeFrameTimer {
+		float m_FrameTimes[2] = {};
+		float m_FrameTimeSum = 0.f;
+		uint32_t m_FrameCount = 0;
+		bool m_SampledMode = false;
+
+		// Once per frame with the mode the frame ran in, switching modes starts a new average.
+		void Sample(bool mode)
+		{
+			if (mode != m_SampledMode)
+			{
+				m_FrameTimeSum = 0.f;
+				m_FrameCount = 0;
+				m_SampledMode = mode;
+			}
+
+			m_FrameTimeSum += TimeSystem::GetDeltaTime();
+			m_FrameCount++;
+
+			if (m_FrameTimeSum >= 0.5f)
+			{
+				m_FrameTimes[mode] = m_FrameTimeSum * 1000.f / m_FrameCount;
+				m_FrameTimeSum = 0.f;
+				m_FrameCount = 0;
+			}
+		}
+
+		// In milliseconds.
+		float Get(bool mode) const { return m_FrameTimes[mode]; }
+	};
+
 	bool m_ShowImGui{ true };
 
+	ModeFrameTimer m_PrePassFrameTimer{};
+	ModeFrameTimer m_BloomFrameTimer{};
+
 	// Scene.
 	Scene* m_Scene = nullptr;
 
@@ -114,10 +122,60 @@ namespace Engine::Tests
 	std::vector<Renderer::DescriptorLayout> m_ObjectLayouts{};
 
 	SkinnedGLTFAsset* m_Soldier = nullptr;
+	SkinnedGLTFAsset::Instance* m_Player = nullptr;
+
+	// Extra soldiers sharing the player's asset, laid out on a CROWD_SIZE x CROWD_SIZE grid.
+	constexpr int CROWD_SIZE = 8;
+
+	// Background crowd playing the baked run cycle, BACKGROUND_CROWD_SIZE x BACKGROUND_CROWD_SIZE behind the skinned soldiers.
+	constexpr int BACKGROUND_CROWD_SIZE = 64;
+	CrowdGLTFAsset* m_Crowd = nullptr;
 	StaticGLTFAsset* m_Bistro = nullptr;
 	StaticGLTFAsset* m_Cube = nullptr;
 
 	std::unique_ptr<Physics> m_PhysicsSystem = nullptr;
+	std::unique_ptr<CharacterController> m_PlayerController = nullptr;
+
+	// Times one batch of countPerType queries of every kind inside the bistro bounds, results are printed to the console.
+	static void BenchmarkSceneQueries(uint32_t countPerType)
+	{
+		const Core::CollisionBox& bounds = m_Bistro->GetCollisionBounds();
+
+		std::mt19937 rng(1337);
+		std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+		const auto randomPoint = [&]() { return bounds.m_Mins + (bounds.m_Maxs - bounds.m_Mins) * glm::vec3(unit(rng), unit(rng), unit(rng)); };
+		const auto randomDirection = [&]() { return glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) * 2.f - 1.f + glm::vec3(0.f, 0.f, 1e-4f)); };
+
+		std::vector<Core::CollisionBox> boxes(countPerType);
+		std::vector<Core::CollisionSphere> spheres(countPerType);
+		std::vector<Core::CollisionCapsule> capsules(countPerType);
+		std::vector<Core::CollisionRay> rays(countPerType);
+
+		for (uint32_t i = 0; i < countPerType; i++)
+		{
+			const glm::vec3 center = randomPoint();
+			boxes[i] = Core::CollisionBox(center - 0.5f, center + 0.5f);
+			spheres[i] = { randomPoint(), 0.5f };
+			capsules[i].m_Bottom = randomPoint();
+			capsules[i].m_Top = capsules[i].m_Bottom + glm::vec3(0.f, 1.8f, 0.f);
+			capsules[i].m_Radius = 0.3f;
+			rays[i] = { randomPoint(), randomDirection(), 50.f };
+		}
+
+		const SceneQueries queries{ boxes, spheres, capsules, rays };
+		const size_t count = queries.GetCount();
+
+		std::vector<uint8_t> hits(count);
+		std::vector<glm::vec3> normals(count);
+		std::vector<float> distances(count);
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		m_Scene->Query(queries, { hits.data(), normals.data(), distances.data() });
+		const float elapsed = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		printf("Scene queries: %zu in %.2f ms (%.0f queries/ms), %zu hits\n", count, elapsed, count / elapsed, static_cast<size_t>(std::count(hits.begin(), hits.end(), 1)));
+	}
 
 	void Test1Renderer::Startup()
 	{
@@ -134,16 +192,66 @@ namespace Engine::Tests
 
 		m_ObjectLayouts = { MaterialDescriptorLayout, TextureDescriptorLayout, PrimitiveDescriptorLayout };
 
-		m_Bistro = new StaticGLTFAsset("C:\\TestAssets\\Sponza\\Sponza.gltf", m_Context->m_Device, m_Context->m_CommandPool);
+		// Quantized vertices and 16-bit indices, the load-time memory/bandwidth report is printed per asset.
+		BaseGLTFAsset::s_VertexFormat = VertexFormat::VF_PACKED;
+
+		// Keyframe reduction + quantization, the per clip size/error report is printed at load.
+		SkinnedGLTFAsset::s_CompressAnimations = true;
+
+		// Parsing, LOD, meshlet and collision building are CPU only, both assets load at once. Device setup stays on this thread.
+		{
+			JobSystem::Counter loading{};
+
+			JobSystem::Get()->Run([this]() { m_Bistro = new StaticGLTFAsset("C:\\TestAssets\\Sponza\\Sponza.gltf", m_Context->m_Device, m_Context->m_CommandPool); }, &loading);
+			JobSystem::Get()->Run([this]() { m_Soldier = new SkinnedGLTFAsset("C:\\TestAssets\\Running.glb", m_Context->m_Device, m_Context->m_CommandPool); }, &loading);
+			JobSystem::Get()->Wait(loading);
+		}
+
 		m_Bistro->SetupDevice(m_ObjectLayouts);
 
-		m_Soldier = new SkinnedGLTFAsset("C:\\TestAssets\\Running.glb", m_Context->m_Device, m_Context->m_CommandPool);
+		// Built on a background thread on first run, restored from the cache afterwards.
+		{
+			std::vector<glm::vec3> positions{};
+			std::vector<uint32_t> indices{};
+			m_Bistro->GetCollisionMesh(positions, indices);
+			m_PhysicsSystem->AddStaticMesh(std::move(positions), std::move(indices), "C:\\TestAssets\\Sponza\\Sponza.jolt");
+		}
+
+		m_PlayerController = std::make_unique<CharacterController>(*m_PhysicsSystem, glm::vec3(0.f));
+		m_PhysicsSystem->Start(60);
+
+		m_Player = m_Soldier->GetInstance(0);
+
+		for (int i = 0; i < CROWD_SIZE * CROWD_SIZE; i++)
+			m_Soldier->CreateInstance(glm::translate(glm::mat4(1.f), glm::vec3(i % CROWD_SIZE - CROWD_SIZE * 0.5f, 0.f, 2.f + i / CROWD_SIZE)));
+
 		m_Soldier->SetupDevice(m_ObjectLayouts);
 
+		// Run in place, out of step with each other.
+		for (size_t i = 1; i < m_Soldier->GetInstanceCount(); i++)
+		{
+			auto* soldier = m_Soldier->GetInstance(i);
+			soldier->m_ActiveAnimIndex = 1;
+
+			if (soldier->m_AnimationStates.size() > 1)
+				soldier->m_AnimationStates[1].m_CurTime = i * 0.137f;
+		}
+
+		std::vector<CrowdGLTFAsset::CrowdInstance> crowd(BACKGROUND_CROWD_SIZE * BACKGROUND_CROWD_SIZE);
+		for (int i = 0; i < crowd.size(); i++)
+		{
+			crowd[i].m_WorldMatrix = glm::translate(glm::mat4(1.f), glm::vec3(i % BACKGROUND_CROWD_SIZE - BACKGROUND_CROWD_SIZE * 0.5f, 0.f, 4.f + CROWD_SIZE + i / BACKGROUND_CROWD_SIZE));
+			crowd[i].m_TimeOffset = i * 0.137f;
+		}
+
+		m_Crowd = new CrowdGLTFAsset(*m_Soldier, 1, crowd);
+		m_Crowd->SetupDevice(m_ObjectLayouts);
+
 		m_Scene = new Scene(m_Context->m_Device, m_Context->m_CommandPool, m_Context->m_SwapChain, m_ObjectLayouts);
 		m_Scene->m_Culler = new SceneCuller(m_Context->m_Device, m_Context->m_SwapChain.get(), PrimitiveDescriptorLayout);
 
 		m_Scene->AddAsset(m_Bistro);
+		m_Scene->AddAsset(m_Crowd);
 		m_Scene->AddSkinnedAsset(m_Soldier);
 	}
 
@@ -173,18 +281,20 @@ namespace Engine::Tests
 
 		float dt = TimeSystem::GetDeltaTime();
 
+		m_PhysicsSystem->BeginFrame();
+
 		mainCamera.SetAttachment(playerPos + glm::vec3(0.f, 0.5f, 0.f));
 
-		bool inMotion = ThirdPersonMovement(dt, mainCamera, playerPos, &m_Soldier->m_WorldMatrix);
+		bool inMotion = ThirdPersonMovement(dt, mainCamera, *m_PlayerController, playerPos, &m_Player->m_WorldMatrix);
 
-		m_Soldier->m_ActiveAnimIndex = inMotion ? 1 : 0;
+		m_Player->m_ActiveAnimIndex = inMotion ? 1 : 0;
 
 		static bool emoting;
 		if (InputSystem::GetKeyPressed('B'))
 			emoting = !emoting;
 
 		if (emoting && !inMotion)
-			m_Soldier->m_ActiveAnimIndex = 2;
+			m_Player->m_ActiveAnimIndex = 2;
 
 		if (InputSystem::GetKeyPressed(260))
 			m_ShowImGui = !m_ShowImGui;
@@ -213,6 +323,13 @@ namespace Engine::Tests
 								{
 									if (ImGui::BeginTabItem("Scene"))
 									{
+										// Results are printed to the console.
+										if (ImGui::Button("Benchmark Collision"))
+											m_Bistro->BenchmarkCollision(100000);
+
+										if (ImGui::Button("Benchmark Scene Queries"))
+											BenchmarkSceneQueries(10000);
+
 										ImGui::EndTabItem();
 									}
 									if (ImGui::BeginTabItem("Lighting"))
@@ -227,12 +344,149 @@ namespace Engine::Tests
 										ImGui::EndTabItem();
 									}
 
+									if (ImGui::BeginTabItem("Jobs"))
+									{
+										// Averaged over half a second, sampling every frame is too noisy to read.
+										static std::vector<JobSystem::WorkerStats> workerStats{};
+										static float sampleTimer = 0.f;
+
+										sampleTimer += TimeSystem::GetDeltaTime();
+										if (sampleTimer >= 0.5f || workerStats.empty())
+										{
+											workerStats = JobSystem::Get()->SampleStats();
+											sampleTimer = 0.f;
+										}
+
+										for (size_t i = 0; i < workerStats.size(); i++)
+										{
+											char label[64] = {};
+											sprintf_s(label, "%llu jobs, %llu stolen", workerStats[i].m_Jobs, workerStats[i].m_Steals);
+
+											ImGui::Text("Worker %zu", i);
+											ImGui::SameLine();
+											ImGui::ProgressBar(workerStats[i].m_Utilization, ImVec2(-1.f, 0.f), label);
+										}
+
+										ImGui::Separator();
+										ImGui::Checkbox("Parallel Command Recording", &m_Scene->m_ParallelRecording);
+
+										const auto& recordingStats = m_Scene->GetPassRecordingStats();
+										float passTotal = 0.f;
+
+										for (uint32_t pass = 0; pass < RECORDED_PASS_COUNT; pass++)
+										{
+											if (pass == RECORDED_PASS_PREPASS)
+												ImGui::Text("Depth Prepass: %.3f ms", recordingStats.m_PassTimes[pass]);
+											else if (pass == RECORDED_PASS_FORWARD)
+												ImGui::Text("Forward: %.3f ms", recordingStats.m_PassTimes[pass]);
+											else
+												ImGui::Text("Shadow Cascade %u: %.3f ms", pass - RECORDED_PASS_SHADOW_CASCADES, recordingStats.m_PassTimes[pass]);
+
+											passTotal += recordingStats.m_PassTimes[pass];
+										}
+
+										ImGui::Text("Recording: %.3f ms for %.3f ms of passes", recordingStats.m_WallTime, passTotal);
+
+										const auto& bindStats = m_Scene->GetBindStats();
+										ImGui::Text("Binds: %u issued, %u redundant ones skipped", bindStats.m_Issued, bindStats.m_Elided);
+
+										ImGui::EndTabItem();
+									}
+
+									if (ImGui::BeginTabItem("Animation"))
+									{
+										ImGui::Text(SkinnedGLTFAsset::s_ResampleAnimations ? "Clips resampled to %.0f Hz" : "Clips use their source keys", SkinnedGLTFAsset::s_AnimationSampleRate);
+
+										if (SkinnedGLTFAsset::s_CompressAnimations)
+											ImGui::Text("Clips compressed, tolerance %.4f", SkinnedGLTFAsset::s_AnimationTolerance);
+
+										const auto& lodStats = m_Scene->GetAnimationLodStats();
+
+										for (uint32_t lod = 0; lod < ANIMATION_LOD_COUNT; lod++)
+											ImGui::Text("LOD %u: %u sampled, %u interpolated", lod, lodStats.m_Sampled[lod], lodStats.m_Interpolated[lod]);
+
+										ImGui::Text("Culled: %u, deferred: %u", lodStats.m_Culled, lodStats.m_Deferred);
+
+										for (uint32_t lod = 0; lod < ANIMATION_LOD_COUNT; lod++)
+										{
+											auto& tier = m_Scene->m_AnimationLods[lod];
+
+											ImGui::PushID(static_cast<int>(lod));
+											ImGui::SliderFloat("Min Screen Size", &tier.m_MinScreenSize, 0.f, 1.f);
+											ImGui::SliderInt("Sample Interval", (int*)&tier.m_SampleInterval, 1, 8);
+											ImGui::SliderInt("Budget", (int*)&tier.m_Budget, 0, 256);
+											ImGui::PopID();
+										}
+
+										// Results are printed to the console.
+										if (ImGui::Button("Benchmark Update"))
+											m_Soldier->BenchmarkAnimation(m_Player->m_ActiveAnimIndex, 10000);
+
+										const auto& crowdAnimation = m_Crowd->GetVertexAnimation();
+										ImGui::Text("Crowd: %zu instances, %u frames at %.1f fps", m_Crowd->GetCrowdSize(), crowdAnimation.m_FrameCount, crowdAnimation.m_FrameRate);
+
+										ImGui::EndTabItem();
+									}
+
 									if (ImGui::BeginTabItem("PrePass"))
 									{
+										ImGui::Checkbox("Reuse Prepass Depth (EQUAL test)", &m_Scene->m_ReusePrepassDepth);
+
+										m_PrePassFrameTimer.Sample(m_Scene->IsPrepassDepthReused());
+
+										ImGui::Text("Separate depth: %.3f ms", m_PrePassFrameTimer.Get(false));
+										ImGui::Text("Reused depth: %.3f ms", m_PrePassFrameTimer.Get(true));
+
 										ImGui::Image((ImTextureID)m_Scene->m_ImguiDepthPrePass, ImVec2(1920 * 0.25f, 1080 * 0.25f));
 										ImGui::EndTabItem();
 									}
 
+									if (ImGui::BeginTabItem("Bloom"))
+									{
+										ImGui::Checkbox("Compute Bloom", &m_Scene->m_ComputeBloom);
+
+										const bool computeBloom = m_Scene->IsComputeBloomUsed();
+										if (m_Scene->m_ComputeBloom && !computeBloom)
+											ImGui::Text("Not supported, the device has no quad operations in compute shaders.");
+
+										m_BloomFrameTimer.Sample(computeBloom);
+
+										ImGui::Text("Graphics passes: %.3f ms", m_BloomFrameTimer.Get(false));
+										ImGui::Text("Compute dispatches: %.3f ms", m_BloomFrameTimer.Get(true));
+
+										ImGui::EndTabItem();
+									}
+
+									if (ImGui::BeginTabItem("Post Process"))
+									{
+										auto* postProcess = m_Scene->m_PostProcess;
+										const auto& timings = postProcess->GetTimings();
+
+										ImGui::Checkbox("Fused", &postProcess->m_Fused);
+
+										// Stage costs are only known unfused.
+										for (uint32_t stage = 0; stage < POST_PROCESS_STAGE_COUNT; stage++)
+										{
+											ImGui::Checkbox(PostProcessStack::GetStageName(static_cast<PostProcessStage>(stage)), &postProcess->m_EnabledStages[stage]);
+
+											if (!timings.m_Fused && postProcess->m_EnabledStages[stage])
+											{
+												ImGui::SameLine();
+												ImGui::Text("%.3f ms", timings.m_Stages[stage]);
+											}
+										}
+
+										ImGui::Text("Total: %.3f ms (%s)", timings.m_Total, timings.m_Fused ? "fused" : "unfused");
+
+										auto& parameters = postProcess->m_Parameters;
+										ImGui::SliderFloat("Bloom Strength", &parameters.m_BloomStrength, 0.f, 0.5f);
+										ImGui::SliderFloat("Exposure", &parameters.m_Exposure, -4.f, 4.f);
+										ImGui::SliderFloat("Saturation", &parameters.m_Saturation, 0.f, 2.f);
+										ImGui::SliderFloat("Contrast", &parameters.m_Contrast, 0.5f, 2.f);
+
+										ImGui::EndTabItem();
+									}
+
 									if (ImGui::BeginTabItem("Shaders"))
 									{
 										for (auto& [name, shader] : ShaderRegistry::Get()->GetShaders())
@@ -261,6 +515,6 @@ namespace Engine::Tests
 
 	void Test1Renderer::Shutdown( )
 	{
-
+		m_PhysicsSystem->Stop( );
 	}
 }
\ No newline at end of file
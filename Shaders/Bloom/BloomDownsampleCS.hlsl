@@ -0,0 +1,118 @@
+// Single pass bloom downsample, every level of the chain in one dispatch.
+// A group owns a 64x64 tile of the HDR frame and writes the matching 32x32, 16x16, 8x8 and 4x4 texels of the four levels,
+// no level needs texels of another tile so the groups never wait on each other.
+// Level 0 (half resolution) keeps the bright texels only, averaged 2x2. Level 1 is reduced across subgroup quads, the last two through LDS.
+
+[[vk::binding(0, 0)]]
+Texture2D Source;
+[[vk::binding(0, 0)]]
+SamplerState SourceSampler;
+
+[[vk::binding(0, 1)]]
+[[vk::image_format("rgba16f")]]
+RWTexture2D<float4> Level0;
+
+[[vk::binding(0, 2)]]
+[[vk::image_format("rgba16f")]]
+RWTexture2D<float4> Level1;
+
+[[vk::binding(0, 3)]]
+[[vk::image_format("rgba16f")]]
+RWTexture2D<float4> Level2;
+
+[[vk::binding(0, 4)]]
+[[vk::image_format("rgba16f")]]
+RWTexture2D<float4> Level3;
+
+groupshared float3 Intermediate[16][16];
+
+// Same threshold as BloomCollectPS.
+float3 Collect(int2 texel, int2 sourceSize) {
+    float3 color = Source.Load(int3(min(texel, sourceSize - 1), 0)).rgb;
+
+    float brightness = dot(color, float3(0.2126, 0.7152, 0.0722));
+    return brightness >= 1.f ? color : 0.f;
+}
+
+// 64 threads to 8x8 texels, the four lanes of every quad cover a 2x2 block (lane bit 0 is x, bit 1 is y).
+uint2 RemapForQuad(uint a) {
+    return uint2((a & 1u) | ((a >> 2u) & 6u), ((a >> 1u) & 3u) | ((a >> 3u) & 4u));
+}
+
+// Tiles on the right and bottom edges reach past the smaller levels.
+bool IsInside(int2 texel, int2 sourceSize, uint level) {
+    return all(texel < (sourceSize >> (level + 1u)));
+}
+
+[numthreads(256, 1, 1)]
+void main(uint3 groupId : SV_GroupID, uint localIndex : SV_GroupIndex) {
+    uint sourceWidth, sourceHeight;
+    Source.GetDimensions(sourceWidth, sourceHeight);
+    const int2 sourceSize = int2(sourceWidth, sourceHeight);
+
+    // 16x16 threads, each one owns four texels of the 32x32 level 0 block, 16 apart.
+    const uint2 thread = RemapForQuad(localIndex % 64u) + 8u * uint2((localIndex >> 6u) & 1u, localIndex >> 7u);
+    const int2 tile = int2(groupId.xy);
+
+    float3 level0[4];
+
+    [unroll]
+    for (uint i = 0; i < 4; i++) {
+        const int2 texel = int2(thread + 16u * uint2(i & 1u, i >> 1u));
+        const int2 sourceTexel = (tile * 32 + texel) * 2;
+
+        level0[i] = (Collect(sourceTexel, sourceSize) + Collect(sourceTexel + int2(1, 0), sourceSize) +
+            Collect(sourceTexel + int2(0, 1), sourceSize) + Collect(sourceTexel + int2(1, 1), sourceSize)) * 0.25f;
+
+        if (IsInside(tile * 32 + texel, sourceSize, 0u))
+            Level0[tile * 32 + texel] = float4(level0[i], 1.f);
+    }
+
+    // Level 1: every quad holds a 2x2 block of level 0, its first lane writes the average.
+    [unroll]
+    for (uint i = 0; i < 4; i++) {
+        const float3 color = (level0[i] + QuadReadAcrossX(level0[i]) + QuadReadAcrossY(level0[i]) + QuadReadAcrossDiagonal(level0[i])) * 0.25f;
+
+        if ((localIndex & 3u) == 0u) {
+            const int2 texel = int2(thread / 2u + 8u * uint2(i & 1u, i >> 1u));
+
+            if (IsInside(tile * 16 + texel, sourceSize, 1u))
+                Level1[tile * 16 + texel] = float4(color, 1.f);
+
+            Intermediate[texel.x][texel.y] = color;
+        }
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    // Level 2 from the 16x16 block of level 1.
+    const uint2 texel8 = RemapForQuad(localIndex);
+    float3 level2 = 0.f;
+
+    if (localIndex < 64u) {
+        const uint2 first = texel8 * 2u;
+        level2 = (Intermediate[first.x][first.y] + Intermediate[first.x + 1][first.y] +
+            Intermediate[first.x][first.y + 1] + Intermediate[first.x + 1][first.y + 1]) * 0.25f;
+
+        if (IsInside(tile * 8 + int2(texel8), sourceSize, 2u))
+            Level2[tile * 8 + int2(texel8)] = float4(level2, 1.f);
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if (localIndex < 64u)
+        Intermediate[texel8.x][texel8.y] = level2;
+
+    GroupMemoryBarrierWithGroupSync();
+
+    // Level 3 from the 8x8 block of level 2, the first 16 threads map to 4x4.
+    if (localIndex < 16u) {
+        const uint2 texel4 = RemapForQuad(localIndex);
+        const uint2 first = texel4 * 2u;
+        const float3 level3 = (Intermediate[first.x][first.y] + Intermediate[first.x + 1][first.y] +
+            Intermediate[first.x][first.y + 1] + Intermediate[first.x + 1][first.y + 1]) * 0.25f;
+
+        if (IsInside(tile * 4 + int2(texel4), sourceSize, 3u))
+            Level3[tile * 4 + int2(texel4)] = float4(level3, 1.f);
+    }
+}
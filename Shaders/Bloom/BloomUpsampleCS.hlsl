@@ -0,0 +1,126 @@
+// Fused bloom upsample, from the smallest level back to level 0 in one dispatch.
+// A group writes a 32x32 tile of level 0 and rebuilds the texels of the smaller levels it needs in LDS, every level summed with the 3x3 tent
+// of the one below, so the upsampled intermediate levels never go through memory. Level 0 ends up with the sum of the four levels,
+// like the additive upsample passes of the graphics path.
+
+[[vk::binding(0, 0)]]
+[[vk::image_format("rgba16f")]]
+RWTexture2D<float4> Level0;
+
+[[vk::binding(0, 1)]]
+[[vk::image_format("rgba16f")]]
+RWTexture2D<float4> Level1;
+
+[[vk::binding(0, 2)]]
+[[vk::image_format("rgba16f")]]
+RWTexture2D<float4> Level2;
+
+[[vk::binding(0, 3)]]
+[[vk::image_format("rgba16f")]]
+RWTexture2D<float4> Level3;
+
+// Texels of every level the tile needs, one texel of border around what the next level up reads.
+groupshared float3 Level3Tile[8][8];
+groupshared float3 Level2Tile[12][12];
+groupshared float3 Level1Tile[18][18];
+
+// 1 2 1 tent over the 3x3 neighbours.
+float TentWeight(int2 offset) {
+    return (2 - abs(offset.x)) * (2 - abs(offset.y)) / 16.f;
+}
+
+int2 LevelSize(uint level) {
+    uint width, height;
+
+    if (level == 1u)
+        Level1.GetDimensions(width, height);
+    else if (level == 2u)
+        Level2.GetDimensions(width, height);
+    else
+        Level3.GetDimensions(width, height);
+
+    return int2(width, height);
+}
+
+[numthreads(256, 1, 1)]
+void main(uint3 groupId : SV_GroupID, uint localIndex : SV_GroupIndex) {
+    const int2 tile = int2(groupId.xy);
+
+    const int2 origin1 = tile * 16 - 1;
+    const int2 origin2 = tile * 8 - 2;
+    const int2 origin3 = tile * 4 - 2;
+
+    if (localIndex < 64u) {
+        const int2 local = int2(localIndex % 8u, localIndex / 8u);
+        const int2 texel = clamp(origin3 + local, 0, LevelSize(3u) - 1);
+
+        Level3Tile[local.x][local.y] = Level3[texel].rgb;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if (localIndex < 144u) {
+        const int2 local = int2(localIndex % 12u, localIndex / 12u);
+        const int2 texel = origin2 + local;
+        const int2 center = (texel >> 1) - origin3;
+
+        float3 color = Level2[clamp(texel, 0, LevelSize(2u) - 1)].rgb;
+
+        [unroll]
+        for (int y = -1; y <= 1; y++) {
+            [unroll]
+            for (int x = -1; x <= 1; x++)
+                color += Level3Tile[center.x + x][center.y + y] * TentWeight(int2(x, y));
+        }
+
+        Level2Tile[local.x][local.y] = color;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    const int2 size1 = LevelSize(1u);
+
+    for (uint i = localIndex; i < 18u * 18u; i += 256u) {
+        const int2 local = int2(i % 18u, i / 18u);
+        const int2 texel = origin1 + local;
+        const int2 center = (texel >> 1) - origin2;
+
+        float3 color = Level1[clamp(texel, 0, size1 - 1)].rgb;
+
+        [unroll]
+        for (int y = -1; y <= 1; y++) {
+            [unroll]
+            for (int x = -1; x <= 1; x++)
+                color += Level2Tile[center.x + x][center.y + y] * TentWeight(int2(x, y));
+        }
+
+        Level1Tile[local.x][local.y] = color;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    uint width, height;
+    Level0.GetDimensions(width, height);
+
+    // Level 0 is read and written by the same thread only, done in place.
+    [unroll]
+    for (uint i = 0; i < 4u; i++) {
+        const int2 local = int2(localIndex % 16u, localIndex / 16u) + 16 * int2(i & 1u, i >> 1u);
+        const int2 texel = tile * 32 + local;
+
+        if (any(texel >= int2(width, height)))
+            continue;
+
+        const int2 center = (texel >> 1) - origin1;
+        float3 color = Level0[texel].rgb;
+
+        [unroll]
+        for (int y = -1; y <= 1; y++) {
+            [unroll]
+            for (int x = -1; x <= 1; x++)
+                color += Level1Tile[center.x + x][center.y + y] * TentWeight(int2(x, y));
+        }
+
+        Level0[texel] = float4(color, 1.f);
+    }
+}
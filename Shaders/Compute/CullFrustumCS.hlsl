@@ -1,5 +1,7 @@
 #pragma pack_matrix(row_major)
 
+#define MAX_LOD_COUNT 5
+
 struct IndexedIndirectCommand {
     uint indexCount;
     uint instanceCount;
@@ -8,6 +10,7 @@ struct IndexedIndirectCommand {
     uint firstInstance;
 };
 
+// One draw per mesh primitive, instanceCount/firstIndex are used as counters until the last pass
 [[vk::binding(0, 0)]]
 RWStructuredBuffer<IndexedIndirectCommand> IndirectDraws;
 
@@ -15,8 +18,11 @@ struct PrimitiveData {
 	int4 MaterialIndex;
 	float4x4 NodeMatrix;
     float4 NodePos;
+	float4 PosOffset;
+	float4 PosScale;
 };
 
+// Every instance, MaterialIndex.z is the draw it belongs to
 [[vk::binding(0, 1)]]
 StructuredBuffer<PrimitiveData> DrawPrimitives;
 
@@ -24,17 +30,44 @@ StructuredBuffer<PrimitiveData> DrawPrimitives;
 cbuffer CullUBO {
     float4 Frustum;
     float4x4 CameraView;
+    float4 LodParams; // x: pixels per unit, y: error threshold in pixels, z: LOD bias, w: 1 when orthographic
     float2 NearFar;
 };
 
+// Lods[i] = (firstIndex, indexCount, error bits, 0), Lods[0] is the full detail range
+struct LodData {
+    uint4 Lods[MAX_LOD_COUNT];
+    uint4 LodCount; // x: LOD count, y: first instance, z: instance count
+};
+
+[[vk::binding(0, 3)]]
+StructuredBuffer<LodData> DrawLods;
+
+// Visible instances, packed from the firstInstance of their draw
+[[vk::binding(0, 4)]]
+RWStructuredBuffer<PrimitiveData> VisibleInstances;
+
+#define PASS_RESET 0
+#define PASS_INSTANCES 1
+#define PASS_RESOLVE 2
+
+[[vk::push_constant]]
+cbuffer _ {
+    uint Pass;
+};
+
 // vkguide / zeux
-[numthreads(16,1,1)]
-bool IsVisible(float3 boundsCenter, float radius) {
-	float3 center = mul(float4(boundsCenter, 1.f), CameraView).xyz;
-	
+bool IsVisible(float3 center, float radius) {
     bool visible = true;
-    visible = visible && center.z * Frustum[1] - abs(center.x) * Frustum[0] > -radius;
-	visible = visible && center.z * Frustum[3] - abs(center.y) * Frustum[2] > -radius;
+
+    if (LodParams.w > 0.f) {
+        // orthographic, Frustum holds the half extents of the view volume
+        visible = visible && abs(center.x) - radius < Frustum.x;
+        visible = visible && abs(center.y) - radius < Frustum.y;
+    } else {
+        visible = visible && center.z * Frustum[1] - abs(center.x) * Frustum[0] > -radius;
+        visible = visible && center.z * Frustum[3] - abs(center.y) * Frustum[2] > -radius;
+    }
 
     // the near/far plane culling uses camera space Z directly
 	visible = visible && center.z + radius > NearFar.x && center.z - radius < NearFar.y;
@@ -42,17 +75,74 @@ bool IsVisible(float3 boundsCenter, float radius) {
     return visible;
 }
 
+// Picks the coarsest LOD whose projected error stays under the threshold
+uint SelectLod(uint drawIndex, uint instanceIndex, float3 center, float radius) {
+    LodData lodData = DrawLods[drawIndex];
+    uint lodCount = lodData.LodCount.x;
+
+    float4x4 nodeMatrix = DrawPrimitives[instanceIndex].NodeMatrix;
+    float scale = max(length(nodeMatrix[0].xyz), max(length(nodeMatrix[1].xyz), length(nodeMatrix[2].xyz)));
+
+    float pixelsPerUnit = LodParams.x;
+    if (LodParams.w == 0.f) {
+        float distance = max(length(center) - radius, max(NearFar.x, 0.001f));
+        pixelsPerUnit /= distance;
+    }
+
+    uint lod = 0;
+    for (uint i = 1; i < lodCount; i++) {
+        float error = asfloat(lodData.Lods[i].z) * scale * pixelsPerUnit;
+        if (error > LodParams.y)
+            break;
+
+        lod = i;
+    }
+
+    return min(lod + (uint)LodParams.z, lodCount - 1);
+}
+
 [numthreads(16, 1, 1)]
 void main(uint3 dispatchId : SV_DispatchThreadID) {
     uint idx = dispatchId.x;
 
-    float4 bounds = DrawPrimitives[idx].NodePos;
-    
-    float3 pos = bounds.xyz; 
-    float radius = bounds.w;
-    if( IsVisible(pos, radius) ) {
-        IndirectDraws[idx].instanceCount = 1;
+    uint drawCount, instanceCount, stride;
+    IndirectDraws.GetDimensions(drawCount, stride);
+    DrawPrimitives.GetDimensions(instanceCount, stride);
+
+    if (Pass == PASS_RESET) {
+        if (idx >= drawCount)
+            return;
+
+        // firstIndex holds the finest LOD of the visible instances until it is resolved
+        IndirectDraws[idx].instanceCount = 0;
+        IndirectDraws[idx].firstIndex = 0xFFFFFFFF;
+    } else if (Pass == PASS_INSTANCES) {
+        if (idx >= instanceCount)
+            return;
+
+        float4 bounds = DrawPrimitives[idx].NodePos;
+
+        float3 center = mul(float4(bounds.xyz, 1.f), CameraView).xyz;
+        float radius = bounds.w;
+        if (!IsVisible(center, radius))
+            return;
+
+        uint drawIndex = DrawPrimitives[idx].MaterialIndex.z;
+        uint lod = SelectLod(drawIndex, idx, center, radius);
+
+        uint slot;
+        InterlockedAdd(IndirectDraws[drawIndex].instanceCount, 1, slot);
+        InterlockedMin(IndirectDraws[drawIndex].firstIndex, lod);
+
+        VisibleInstances[DrawLods[drawIndex].LodCount.y + slot] = DrawPrimitives[idx];
     } else {
-        IndirectDraws[idx].instanceCount = 0;    
+        if (idx >= drawCount)
+            return;
+
+        // all instances share the draw, so they get the finest LOD any of them asked for
+        uint lod = IndirectDraws[idx].instanceCount > 0 ? IndirectDraws[idx].firstIndex : 0;
+
+        IndirectDraws[idx].firstIndex = DrawLods[idx].Lods[lod].x;
+        IndirectDraws[idx].indexCount = DrawLods[idx].Lods[lod].y;
     }
-}
\ No newline at end of file
+}
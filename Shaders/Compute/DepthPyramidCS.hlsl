@@ -0,0 +1,38 @@
+// Builds one level of the max depth pyramid used for occlusion culling.
+// Level 0 copies the depth pre-pass, every other level reduces the previous one.
+
+[[vk::binding(0, 0)]]
+Texture2D Source;
+
+[[vk::binding(0, 0)]]
+SamplerState SourceSampler;
+
+[[vk::binding(0, 1)]]
+[[vk::image_format("r32f")]]
+RWTexture2D<float> Destination;
+
+[[vk::push_constant]]
+cbuffer _ {
+    uint2 SourceSize;
+    uint2 DestinationSize;
+};
+
+[numthreads(8, 8, 1)]
+void main(uint3 dispatchId : SV_DispatchThreadID) {
+    uint2 texel = dispatchId.xy;
+    if (any(texel >= DestinationSize))
+        return;
+
+    // odd source sizes fold the extra row/column into the last texel so nothing is skipped
+    uint2 first = texel * SourceSize / DestinationSize;
+    uint2 last = min(((texel + 1) * SourceSize + DestinationSize - 1) / DestinationSize, SourceSize) - 1;
+
+    float depth = 0.f;
+    for (uint y = first.y; y <= last.y; y++) {
+        for (uint x = first.x; x <= last.x; x++) {
+            depth = max(depth, Source.Load(int3(x, y, 0)).x);
+        }
+    }
+
+    Destination[texel] = depth;
+}
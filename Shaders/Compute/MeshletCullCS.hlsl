@@ -0,0 +1,224 @@
+#pragma pack_matrix(row_major)
+
+#define MAX_LOD_COUNT 5
+
+// Draw.w flags, see StaticGLTFAsset::IndirectMeshletData
+#define MESHLET_LONG_INDICES 1
+#define MESHLET_FIRST_IN_DRAW 2
+#define MESHLET_WHOLE_DRAW 4
+
+struct IndexedIndirectCommand {
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint firstInstance;
+};
+
+// Output of the per primitive pass (CullFrustumCS)
+[[vk::binding(0, 0)]]
+StructuredBuffer<IndexedIndirectCommand> IndirectDraws;
+
+struct PrimitiveData {
+	int4 MaterialIndex;
+	float4x4 NodeMatrix;
+    float4 NodePos;
+	float4 PosOffset;
+	float4 PosScale;
+};
+
+// Every instance, the emitted draws index it directly through firstInstance
+[[vk::binding(0, 1)]]
+StructuredBuffer<PrimitiveData> DrawPrimitives;
+
+[[vk::binding(0, 2)]]
+cbuffer MeshletCullUBO {
+    float4x4 CameraView;
+    float4x4 PyramidView;       // view the depth pyramid was rendered with (previous frame)
+    float4 Frustum;
+    float4 PyramidProjection;   // P00, P11, P22, P32 of the pyramid view
+    float4 PyramidSize;         // xy: level 0 size, z: level count, w: 1 when the pyramid is valid
+    float2 NearFar;
+};
+
+struct LodData {
+    uint4 Lods[MAX_LOD_COUNT];
+    uint4 LodCount;
+};
+
+[[vk::binding(0, 3)]]
+StructuredBuffer<LodData> DrawLods;
+
+struct MeshletData {
+    float4 Sphere;
+    float4 Cone;
+    uint4 Draw;     // x: draw index, y: first index inside LOD0, z: index count, w: flags
+    uint4 Geometry; // w: instance
+};
+
+[[vk::binding(0, 4)]]
+StructuredBuffer<MeshletData> Meshlets;
+
+[[vk::binding(0, 5)]]
+RWStructuredBuffer<IndexedIndirectCommand> MeshletDraws;
+
+// x: 16-bit indexed draws, y: 32-bit indexed draws
+[[vk::binding(0, 6)]]
+RWStructuredBuffer<uint> MeshletDrawCount;
+
+// Max depth pyramid of the previous frame
+[[vk::binding(0, 7)]]
+Texture2D DepthPyramid;
+
+[[vk::binding(0, 7)]]
+SamplerState DepthPyramidSampler;
+
+[[vk::push_constant]]
+cbuffer _ {
+    uint MeshletCount;
+    uint LongIndexBase; // first output slot of the 32-bit indexed draws
+};
+
+bool IsInFrustum(float3 center, float radius) {
+    bool visible = true;
+
+    visible = visible && center.z * Frustum[1] - abs(center.x) * Frustum[0] > -radius;
+    visible = visible && center.z * Frustum[3] - abs(center.y) * Frustum[2] > -radius;
+	visible = visible && center.z + radius > NearFar.x && center.z - radius < NearFar.y;
+
+    return visible;
+}
+
+// meshoptimizer cone test, the camera sits at the view space origin
+bool IsBackfacing(float3 center, float radius, float3 axis, float cutoff) {
+    return dot(center, axis) >= cutoff * length(center) + radius;
+}
+
+// 2D Polyhedral Bounds of a Clipped, Perspective-Projected 3D Sphere - Mara & McGuire 2013
+// Signed P00/P11 so the flipped Y projection works too, returns the uv rect (min xy, max xy).
+bool ProjectSphere(float3 c, float r, float P00, float P11, out float4 uvRect) {
+    uvRect = 0.f;
+
+    if (c.z < r + NearFar.x)
+        return false;
+
+    float3 cr = c * r;
+    float czr2 = c.z * c.z - r * r;
+
+    float vx = sqrt(c.x * c.x + czr2);
+    float minx = (vx * c.x - cr.z) / (vx * c.z + cr.x);
+    float maxx = (vx * c.x + cr.z) / (vx * c.z - cr.x);
+
+    float vy = sqrt(c.y * c.y + czr2);
+    float miny = (vy * c.y - cr.z) / (vy * c.z + cr.y);
+    float maxy = (vy * c.y + cr.z) / (vy * c.z - cr.y);
+
+    float4 ndc = float4(minx * P00, miny * P11, maxx * P00, maxy * P11);
+    ndc = float4(min(ndc.xy, ndc.zw), max(ndc.xy, ndc.zw));
+
+    uvRect = ndc * 0.5f + 0.5f;
+    return true;
+}
+
+bool IsOccluded(float3 worldCenter, float radius) {
+    if (PyramidSize.w == 0.f)
+        return false;
+
+    float3 c = mul(float4(worldCenter, 1.f), PyramidView).xyz;
+
+    float4 uvRect;
+    if (!ProjectSphere(c, radius, PyramidProjection.x, PyramidProjection.y, uvRect))
+        return false;
+
+    if (any(uvRect.zw < 0.f) || any(uvRect.xy > 1.f))
+        return false;
+
+    uvRect = saturate(uvRect);
+
+    float2 size = (uvRect.zw - uvRect.xy) * PyramidSize.xy;
+    float level = min(ceil(log2(max(max(size.x, size.y), 1.f))), PyramidSize.z - 1.f);
+
+    // the footprint covers at most 2x2 texels of the chosen level
+    float2 levelSize = max(floor(PyramidSize.xy / exp2(level)), 1.f);
+    int2 minTexel = min(int2(uvRect.xy * levelSize), int2(levelSize) - 1);
+    int2 maxTexel = min(int2(uvRect.zw * levelSize), int2(levelSize) - 1);
+
+    float depth = 0.f;
+    depth = max(depth, DepthPyramid.Load(int3(minTexel.x, minTexel.y, level)).x);
+    depth = max(depth, DepthPyramid.Load(int3(maxTexel.x, minTexel.y, level)).x);
+    depth = max(depth, DepthPyramid.Load(int3(minTexel.x, maxTexel.y, level)).x);
+    depth = max(depth, DepthPyramid.Load(int3(maxTexel.x, maxTexel.y, level)).x);
+
+    // depth of the closest point of the sphere, larger is farther
+    float sphereDepth = PyramidProjection.z + PyramidProjection.w / (c.z - radius);
+
+    return sphereDepth > depth;
+}
+
+void Emit(IndexedIndirectCommand cmd, bool longIndices) {
+    uint slot;
+    InterlockedAdd(MeshletDrawCount[longIndices ? 1 : 0], 1, slot);
+
+    MeshletDraws[(longIndices ? LongIndexBase : 0) + slot] = cmd;
+}
+
+[numthreads(64, 1, 1)]
+void main(uint3 dispatchId : SV_DispatchThreadID) {
+    uint idx = dispatchId.x;
+    if (idx >= MeshletCount)
+        return;
+
+    MeshletData meshlet = Meshlets[idx];
+
+    uint drawIndex = meshlet.Draw.x;
+    uint instance = meshlet.Geometry.w;
+    uint flags = meshlet.Draw.w;
+    bool longIndices = (flags & MESHLET_LONG_INDICES) != 0;
+
+    // no instance of the draw survived the per instance pass
+    IndexedIndirectCommand cmd = IndirectDraws[drawIndex];
+    if (cmd.instanceCount == 0)
+        return;
+
+    cmd.instanceCount = 1;
+    cmd.firstInstance = instance;
+
+    // a coarser LOD was picked or there is nothing to split, the first meshlet emits the whole primitive of its instance
+    if ((flags & MESHLET_WHOLE_DRAW) != 0 || cmd.firstIndex != DrawLods[drawIndex].Lods[0].x) {
+        if ((flags & MESHLET_FIRST_IN_DRAW) == 0)
+            return;
+
+        float4 bounds = DrawPrimitives[instance].NodePos;
+        if (IsInFrustum(mul(float4(bounds.xyz, 1.f), CameraView).xyz, bounds.w))
+            Emit(cmd, longIndices);
+
+        return;
+    }
+
+    float4x4 nodeMatrix = DrawPrimitives[instance].NodeMatrix;
+    float scale = max(length(nodeMatrix[0].xyz), max(length(nodeMatrix[1].xyz), length(nodeMatrix[2].xyz)));
+
+    // object -> world (the scene model matrix flips z) -> view
+    float3 worldCenter = mul(float4(meshlet.Sphere.xyz, 1.f), nodeMatrix).xyz * float3(1.f, 1.f, -1.f);
+    float3 center = mul(float4(worldCenter, 1.f), CameraView).xyz;
+    float radius = meshlet.Sphere.w * scale;
+
+    if (!IsInFrustum(center, radius))
+        return;
+
+    if (meshlet.Cone.w < 1.f) {
+        float3 axis = mul(meshlet.Cone.xyz, (float3x3)nodeMatrix) * float3(1.f, 1.f, -1.f);
+        axis = normalize(mul(axis, (float3x3)CameraView));
+
+        if (IsBackfacing(center, radius, axis, meshlet.Cone.w))
+            return;
+    }
+
+    if (IsOccluded(worldCenter, radius))
+        return;
+
+    cmd.firstIndex += meshlet.Draw.y;
+    cmd.indexCount = meshlet.Draw.z;
+
+    Emit(cmd, longIndices);
+}
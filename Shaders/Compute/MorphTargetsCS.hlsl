@@ -0,0 +1,68 @@
+// Sparse morph target evaluation, one thread per morphed vertex of a job (one instance and primitive).
+// Only vertices moved by at least one target are stored, the others keep a zero delta.
+// The skinned VS adds the deltas before skinning (see GLTF_SkinnedVS.hlsl).
+
+struct MorphVertex {
+	uint Output; // Inside the instance block of MorphOutputs.
+	uint FirstDelta;
+	uint DeltaCount;
+	uint Padding;
+};
+
+struct MorphDelta {
+	float4 Position; // w: target index
+	float4 Normal;
+};
+
+struct MorphOutput {
+	float4 Position;
+	float4 Normal;
+};
+
+[[vk::binding(0, 0)]]
+StructuredBuffer<MorphVertex> MorphVertices;
+
+[[vk::binding(0, 1)]]
+StructuredBuffer<MorphDelta> MorphDeltas;
+
+// Every instance, the weights of its morphed nodes back to back
+[[vk::binding(0, 2)]]
+StructuredBuffer<float> MorphWeights;
+
+// x: first morphed vertex, y: morphed vertex count, z: first output of the instance, w: first weight of the node
+[[vk::binding(0, 3)]]
+StructuredBuffer<uint4> MorphJobs;
+
+[[vk::binding(0, 4)]]
+RWStructuredBuffer<MorphOutput> MorphOutputs;
+
+[numthreads(64, 1, 1)]
+void main(uint3 dispatchId : SV_DispatchThreadID) {
+	uint4 job = MorphJobs[dispatchId.y];
+
+	if (dispatchId.x >= job.y)
+		return;
+
+	MorphVertex vertex = MorphVertices[job.x + dispatchId.x];
+
+	float3 position = 0.f;
+	float3 normal = 0.f;
+
+	for (uint i = 0; i < vertex.DeltaCount; i++) {
+		MorphDelta delta = MorphDeltas[vertex.FirstDelta + i];
+		float weight = MorphWeights[job.w + uint(delta.Position.w)];
+
+		// Inactive targets are skipped.
+		if (weight == 0.f)
+			continue;
+
+		position += delta.Position.xyz * weight;
+		normal += delta.Normal.xyz * weight;
+	}
+
+	MorphOutput output;
+	output.Position = float4(position, 0.f);
+	output.Normal = float4(normal, 0.f);
+
+	MorphOutputs[job.z + vertex.Output] = output;
+}
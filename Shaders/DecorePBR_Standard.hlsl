@@ -69,6 +69,8 @@ struct PrimitiveData {
 	int4 MaterialIndex;
 	float4x4 NodeMatrix;
 	float4 NodePos;
+	float4 PosOffset;
+	float4 PosScale;
 };
 
 [[vk::binding(0, 7)]]
@@ -309,7 +311,7 @@ PS_Output main(PS_Input input) {
 	// color *= GetCascadeColorTint(cascadeIndex);
 	// color.a = 1.f;
 
-	if(mat.AlphaMode == AM_MASK) {
+	if(AlphaTest && mat.AlphaMode == AM_MASK) {
 		if(albedoColor.a < mat.AlphaCutoff)
 			discard;
 
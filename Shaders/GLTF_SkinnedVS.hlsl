@@ -1,11 +1,15 @@
 #pragma pack_matrix(row_major)
 
+#include "VertexDecode.hlsli"
+
 const int MAX_JOINTS = 128;
 
 struct PrimitiveData {
-	int4 MaterialIndex;
+	int4 MaterialIndex; // z: morph output of vertex 0 minus the base vertex, w: first joint matrix of the instance palette.
 	float4x4 WorldMatrix;
 	float4 NodePos;
+	float4 PosOffset; // w: 1 when the primitive has morph targets.
+	float4 PosScale;
 };
 
 [[vk::binding(0, 7)]]
@@ -14,6 +18,15 @@ StructuredBuffer<PrimitiveData> SSBO;
 [[vk::binding(0, 8)]]
 StructuredBuffer<float4x4> JointMatrices;
 
+struct MorphOutput {
+	float4 Position;
+	float4 Normal;
+};
+
+// Position and normal deltas written by Compute/MorphTargetsCS.hlsl.
+[[vk::binding(0, 9)]]
+StructuredBuffer<MorphOutput> MorphOutputs;
+
 [[vk::binding(0, 0)]]
 cbuffer UBO {
 	float4x4 ModelMatrix;
@@ -26,7 +39,7 @@ cbuffer UBO {
 };
 
 struct VS_Input {
-	float3 Position : POSITION;
+	float4 Position : POSITION;
 	float3 Normal : NORMAL;
 	float2 UV : TEXCOORD0;
 	float4 Tangent : TANGENT;
@@ -34,6 +47,7 @@ struct VS_Input {
 	float4 Weights : WEIGHTS;
 
 	int index : SV_InstanceID;
+	uint vertexId : SV_VertexID; // Base vertex included.
 };
 
 struct VS_Output {
@@ -51,21 +65,32 @@ struct VS_Output {
 VS_Output main(VS_Input input)
 {
     VS_Output res;
-    res.Position = float4(input.Position, 1.f);
- 
 	PrimitiveData primData = SSBO[input.index];
 
-	float4x4 skinMat = mul(JointMatrices[input.Joints.x], input.Weights.x) +
-		mul(JointMatrices[input.Joints.y], input.Weights.y) +
-		mul(JointMatrices[input.Joints.z], input.Weights.z) +
-		mul(JointMatrices[input.Joints.w], input.Weights.w);
+    res.Position = float4(DecodePosition(input.Position, primData.PosOffset, primData.PosScale), 1.f);
+	float3 normal = DecodeNormal(input.Normal, primData.PosScale);
+
+	// Morph targets apply before skinning.
+	if (primData.PosOffset.w > 0.f) {
+		MorphOutput morph = MorphOutputs[primData.MaterialIndex.z + int(input.vertexId)];
+
+		res.Position.xyz += morph.Position.xyz;
+		normal = normalize(normal + morph.Normal.xyz);
+	}
+
+	uint4 joints = input.Joints + primData.MaterialIndex.w;
+
+	float4x4 skinMat = mul(JointMatrices[joints.x], input.Weights.x) +
+		mul(JointMatrices[joints.y], input.Weights.y) +
+		mul(JointMatrices[joints.z], input.Weights.z) +
+		mul(JointMatrices[joints.w], input.Weights.w);
 
 	res.Position = mul(res.Position, skinMat);
 	res.Position = mul(res.Position, ModelMatrix);
 	res.Position = mul(res.Position, primData.WorldMatrix);
 	res.WorldPos = res.Position.xyz;
 
-	res.Normal = mul(input.Normal, float3x3(skinMat));
+	res.Normal = mul(normal, float3x3(skinMat));
 	res.Normal = mul(res.Normal, float3x3(ModelMatrix));
 	res.Normal = mul(res.Normal, float3x3(primData.WorldMatrix));
 	res.Normal = normalize(res.Normal);	
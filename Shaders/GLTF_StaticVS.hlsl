@@ -1,11 +1,18 @@
 #pragma pack_matrix(row_major)
 
+#include "VertexDecode.hlsli"
+
+#define VERTEX_ANIMATION_SET 8
+#include "VertexAnimation.hlsli"
+
 const int MAX_JOINTS = 256;
 
 struct PrimitiveData {
-	int4 MaterialIndex;
+	int4 MaterialIndex; // w: 1 when the instance plays the vertex animation.
 	float4x4 NodeMatrix;
 	float4 NodePos;
+	float4 PosOffset; // w: clip time offset of vertex animated instances.
+	float4 PosScale;
 	//float4x4 JointMatrix[MAX_JOINTS];
     //int4 JointCount;
 };
@@ -22,10 +29,11 @@ cbuffer UBO {
 	float4 CamPos;
 	float4 LightDirection;
 	float4 LightColor;
+	float4 Time;
 };
 
 struct VS_Input {
-	float3 Position : POSITION;
+	float4 Position : POSITION;
 	float3 Normal : NORMAL;
 	float2 UV : TEXCOORD0;
 	float4 Tangent : TANGENT;
@@ -33,6 +41,7 @@ struct VS_Input {
 	float4 Weights : WEIGHTS;
 
 	int index : SV_InstanceID;
+	uint vertexId : SV_VertexID; // Base vertex included.
 };
 
 struct VS_Output {
@@ -52,7 +61,12 @@ VS_Output main(VS_Input input)
 	PrimitiveData data = SSBO[input.index];
 
     VS_Output res;
-    res.Position = float4(input.Position, 1.f);
+    res.Position = float4(DecodePosition(input.Position, data.PosOffset, data.PosScale), 1.f);
+	float3 normal = DecodeNormal(input.Normal, data.PosScale);
+
+	// Baked frames replace the bind pose, the tangent stays as is.
+	if (HasVertexAnimation(data.MaterialIndex))
+		FetchVertexAnimation(input.vertexId, Time.x + data.PosOffset.w, res.Position.xyz, normal);
 	
 	/*
 	if(data.JointCount.x > 0) {
@@ -83,13 +97,13 @@ VS_Output main(VS_Input input)
 	
 	// float3x3 normMatrix = transpose(Inverse(mul(float3x3(ModelMatrix), float3x3(ViewMatrix)))); 
 
-	float3 norm = mul(input.Normal, float3x3(data.NodeMatrix));
+	float3 norm = mul(normal, float3x3(data.NodeMatrix));
 	norm = mul(norm, float3x3(ModelMatrix));
 	// norm = mul(norm, normMatrix);
 	res.Normal = normalize(norm);
 
 	res.UV = input.UV;
-	res.Tangent = input.Tangent;
+	res.Tangent = DecodeTangent(input.Tangent, input.Position, data.PosScale);
 	res.index = input.index;
 
     return res;
@@ -0,0 +1,72 @@
+// Shared by the task and mesh shaders, mirrors Compute/MeshletCullCS.hlsl.
+// Matrices are uploaded like the HLSL shaders, column major here so M * v matches mul(v, M) there.
+
+struct PrimitiveData {
+	ivec4 MaterialIndex;
+	mat4 NodeMatrix;
+	vec4 NodePos;
+	vec4 PosOffset;
+	vec4 PosScale;
+};
+
+struct MeshletData {
+	vec4 Sphere;
+	vec4 Cone;
+	uvec4 Draw;		// x: draw index, y: first index inside LOD0, z: index count, w: flags
+	uvec4 Geometry;	// x: first vertex word, y: first triangle word, z: vertex count | triangle count << 16, w: instance
+};
+
+struct IndexedIndirectCommand {
+	uint indexCount;
+	uint instanceCount;
+	uint firstIndex;
+	int vertexOffset;
+	uint firstInstance;
+};
+
+// Sets 0 - 6 are the scene and material sets of the regular static pipeline.
+layout(set = 0, binding = 0) uniform UBO {
+	mat4 ModelMatrix;
+	mat4 ViewMatrix;
+	mat4 ProjectionMatrix;
+
+	vec4 CamPos;
+	vec4 LightDirection;
+	vec4 LightColor;
+};
+
+layout(std430, set = 7, binding = 0) readonly buffer Primitives {
+	PrimitiveData DrawPrimitives[];
+};
+
+layout(std430, set = 8, binding = 0) readonly buffer MeshletBuffer {
+	MeshletData Meshlets[];
+};
+
+layout(std430, set = 9, binding = 0) readonly buffer MeshletGeometryBuffer {
+	uint MeshletGeometry[];
+};
+
+// The whole geometry arena, full or packed vertices (see VertexDecode.hlsli).
+layout(std430, set = 10, binding = 0) readonly buffer VertexBuffer {
+	uint VertexWords[];
+};
+
+// Output of the per primitive pass (CullFrustumCS).
+layout(std430, set = 11, binding = 0) readonly buffer IndirectDrawBuffer {
+	IndexedIndirectCommand IndirectDraws[];
+};
+
+layout(set = 12, binding = 0) uniform MeshletCullUBO {
+	mat4 CameraView;
+	mat4 PyramidView;
+	vec4 Frustum;
+	vec4 PyramidProjection;	// P00, P11, P22, P32
+	vec4 PyramidSize;		// xy: level 0 size, z: level count, w: 1 when the pyramid is valid
+	vec2 NearFar;
+};
+
+layout(set = 13, binding = 0) uniform sampler2D DepthPyramid;
+
+#define MESHLET_WHOLE_DRAW 4
+#define MESHLETS_PER_TASK 32
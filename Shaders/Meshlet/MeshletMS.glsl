@@ -0,0 +1,97 @@
+#version 460
+#extension GL_EXT_mesh_shader : require
+
+#include "MeshletCommon.glsl"
+
+// Fetches and transforms one meshlet, outputs match the GLTF_StaticVS.hlsl varyings.
+
+layout(local_size_x = MESHLETS_PER_TASK) in;
+layout(triangles, max_vertices = 64, max_primitives = 124) out;
+
+struct TaskPayload {
+	uint MeshletIndices[MESHLETS_PER_TASK];
+};
+
+taskPayloadSharedEXT TaskPayload Payload;
+
+layout(location = 0) out vec3 OutNormal[];
+layout(location = 1) out vec2 OutUV[];
+layout(location = 2) out vec3 OutWorldPos[];
+layout(location = 3) out vec4 OutTangent[];
+layout(location = 4) out vec3 OutViewPos[];
+layout(location = 5) flat out int OutIndex[];
+
+// Vertex strides in words, see StaticGLTFAsset::VertexAttribute / PackedVertexAttribute.
+#define FULL_VERTEX_WORDS 12
+#define PACKED_VERTEX_WORDS 5
+
+// VertexDecode.hlsli
+vec3 OctDecode(vec2 e) {
+	vec3 n = vec3(e.x, e.y, 1.f - abs(e.x) - abs(e.y));
+	float t = clamp(-n.z, 0.f, 1.f);
+
+	n.x += n.x >= 0.f ? -t : t;
+	n.y += n.y >= 0.f ? -t : t;
+
+	return normalize(n);
+}
+
+void FetchVertex(uint vertexIndex, vec4 posOffset, vec4 posScale, out vec3 position, out vec3 normal, out vec2 uv, out vec4 tangent) {
+	if (posScale.w > 0.f) {
+		uint base = vertexIndex * PACKED_VERTEX_WORDS;
+
+		vec4 packedPosition = vec4(unpackUnorm2x16(VertexWords[base]), unpackUnorm2x16(VertexWords[base + 1]));
+
+		position = packedPosition.xyz * posScale.xyz + posOffset.xyz;
+		normal = OctDecode(unpackSnorm2x16(VertexWords[base + 2]));
+		uv = unpackHalf2x16(VertexWords[base + 3]);
+		tangent = vec4(OctDecode(unpackSnorm2x16(VertexWords[base + 4])), packedPosition.w * 2.f - 1.f);
+	} else {
+		uint base = vertexIndex * FULL_VERTEX_WORDS;
+
+		position = uintBitsToFloat(uvec3(VertexWords[base], VertexWords[base + 1], VertexWords[base + 2])) * posScale.xyz + posOffset.xyz;
+		normal = uintBitsToFloat(uvec3(VertexWords[base + 3], VertexWords[base + 4], VertexWords[base + 5]));
+		uv = uintBitsToFloat(uvec2(VertexWords[base + 6], VertexWords[base + 7]));
+		tangent = uintBitsToFloat(uvec4(VertexWords[base + 8], VertexWords[base + 9], VertexWords[base + 10], VertexWords[base + 11]));
+	}
+}
+
+uint TriangleIndex(uint firstWord, uint i) {
+	return (MeshletGeometry[firstWord + i / 4] >> ((i % 4) * 8)) & 0xff;
+}
+
+void main() {
+	MeshletData meshlet = Meshlets[Payload.MeshletIndices[gl_WorkGroupID.x]];
+
+	uint instance = meshlet.Geometry.w;
+	PrimitiveData data = DrawPrimitives[instance];
+
+	uint vertexCount = meshlet.Geometry.z & 0xffff;
+	uint triangleCount = meshlet.Geometry.z >> 16;
+
+	SetMeshOutputsEXT(vertexCount, triangleCount);
+
+	for (uint v = gl_LocalInvocationIndex; v < vertexCount; v += MESHLETS_PER_TASK) {
+		vec3 position, normal;
+		vec2 uv;
+		vec4 tangent;
+		FetchVertex(MeshletGeometry[meshlet.Geometry.x + v], data.PosOffset, data.PosScale, position, normal, uv, tangent);
+
+		vec4 world = ModelMatrix * (data.NodeMatrix * vec4(position, 1.f));
+		vec4 view = ViewMatrix * world;
+
+		gl_MeshVerticesEXT[v].gl_Position = ProjectionMatrix * view;
+
+		OutNormal[v] = normalize(mat3(ModelMatrix) * (mat3(data.NodeMatrix) * normal));
+		OutUV[v] = uv;
+		OutWorldPos[v] = world.xyz;
+		OutTangent[v] = tangent;
+		OutViewPos[v] = view.xyz;
+		OutIndex[v] = int(instance);
+	}
+
+	for (uint t = gl_LocalInvocationIndex; t < triangleCount; t += MESHLETS_PER_TASK) {
+		uint first = meshlet.Geometry.y;
+		gl_PrimitiveTriangleIndicesEXT[t] = uvec3(TriangleIndex(first, t * 3), TriangleIndex(first, t * 3 + 1), TriangleIndex(first, t * 3 + 2));
+	}
+}
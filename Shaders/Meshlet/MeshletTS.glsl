@@ -0,0 +1,139 @@
+#version 460
+#extension GL_EXT_mesh_shader : require
+
+#include "MeshletCommon.glsl"
+
+// Same tests as Compute/MeshletCullCS.hlsl, the survivors are passed on to MeshletMS.
+// Only LOD0 meshlets are drawn on this path, whole draw entries are skipped.
+
+layout(local_size_x = MESHLETS_PER_TASK) in;
+
+// Offset 0 is the SSAO toggle of the fragment shader.
+layout(push_constant) uniform PushConstants {
+	layout(offset = 4) uint MeshletCount;
+};
+
+struct TaskPayload {
+	uint MeshletIndices[MESHLETS_PER_TASK];
+};
+
+taskPayloadSharedEXT TaskPayload Payload;
+
+shared uint VisibleCount;
+
+bool IsInFrustum(vec3 center, float radius) {
+	bool visible = true;
+
+	visible = visible && center.z * Frustum[1] - abs(center.x) * Frustum[0] > -radius;
+	visible = visible && center.z * Frustum[3] - abs(center.y) * Frustum[2] > -radius;
+	visible = visible && center.z + radius > NearFar.x && center.z - radius < NearFar.y;
+
+	return visible;
+}
+
+// Mara & McGuire 2013, see MeshletCullCS.hlsl
+bool ProjectSphere(vec3 c, float r, float P00, float P11, out vec4 uvRect) {
+	uvRect = vec4(0.f);
+
+	if (c.z < r + NearFar.x)
+		return false;
+
+	vec3 cr = c * r;
+	float czr2 = c.z * c.z - r * r;
+
+	float vx = sqrt(c.x * c.x + czr2);
+	float minx = (vx * c.x - cr.z) / (vx * c.z + cr.x);
+	float maxx = (vx * c.x + cr.z) / (vx * c.z - cr.x);
+
+	float vy = sqrt(c.y * c.y + czr2);
+	float miny = (vy * c.y - cr.z) / (vy * c.z + cr.y);
+	float maxy = (vy * c.y + cr.z) / (vy * c.z - cr.y);
+
+	vec4 ndc = vec4(minx * P00, miny * P11, maxx * P00, maxy * P11);
+	ndc = vec4(min(ndc.xy, ndc.zw), max(ndc.xy, ndc.zw));
+
+	uvRect = ndc * 0.5f + 0.5f;
+	return true;
+}
+
+bool IsOccluded(vec3 worldCenter, float radius) {
+	if (PyramidSize.w == 0.f)
+		return false;
+
+	vec3 c = (PyramidView * vec4(worldCenter, 1.f)).xyz;
+
+	vec4 uvRect;
+	if (!ProjectSphere(c, radius, PyramidProjection.x, PyramidProjection.y, uvRect))
+		return false;
+
+	if (any(lessThan(uvRect.zw, vec2(0.f))) || any(greaterThan(uvRect.xy, vec2(1.f))))
+		return false;
+
+	uvRect = clamp(uvRect, 0.f, 1.f);
+
+	vec2 size = (uvRect.zw - uvRect.xy) * PyramidSize.xy;
+	int level = int(min(ceil(log2(max(max(size.x, size.y), 1.f))), PyramidSize.z - 1.f));
+
+	ivec2 levelSize = textureSize(DepthPyramid, level);
+	ivec2 minTexel = min(ivec2(uvRect.xy * vec2(levelSize)), levelSize - 1);
+	ivec2 maxTexel = min(ivec2(uvRect.zw * vec2(levelSize)), levelSize - 1);
+
+	float depth = 0.f;
+	depth = max(depth, texelFetch(DepthPyramid, ivec2(minTexel.x, minTexel.y), level).x);
+	depth = max(depth, texelFetch(DepthPyramid, ivec2(maxTexel.x, minTexel.y), level).x);
+	depth = max(depth, texelFetch(DepthPyramid, ivec2(minTexel.x, maxTexel.y), level).x);
+	depth = max(depth, texelFetch(DepthPyramid, ivec2(maxTexel.x, maxTexel.y), level).x);
+
+	float sphereDepth = PyramidProjection.z + PyramidProjection.w / (c.z - radius);
+
+	return sphereDepth > depth;
+}
+
+bool IsMeshletVisible(uint index) {
+	MeshletData meshlet = Meshlets[index];
+
+	if ((meshlet.Draw.w & MESHLET_WHOLE_DRAW) != 0)
+		return false;
+
+	// No instance of the draw survived the per instance pass.
+	if (IndirectDraws[meshlet.Draw.x].instanceCount == 0)
+		return false;
+
+	mat4 nodeMatrix = DrawPrimitives[meshlet.Geometry.w].NodeMatrix;
+	float scale = max(length(nodeMatrix[0].xyz), max(length(nodeMatrix[1].xyz), length(nodeMatrix[2].xyz)));
+
+	vec3 worldCenter = (nodeMatrix * vec4(meshlet.Sphere.xyz, 1.f)).xyz * vec3(1.f, 1.f, -1.f);
+	vec3 center = (CameraView * vec4(worldCenter, 1.f)).xyz;
+	float radius = meshlet.Sphere.w * scale;
+
+	if (!IsInFrustum(center, radius))
+		return false;
+
+	if (meshlet.Cone.w < 1.f) {
+		vec3 axis = (mat3(nodeMatrix) * meshlet.Cone.xyz) * vec3(1.f, 1.f, -1.f);
+		axis = normalize(mat3(CameraView) * axis);
+
+		if (dot(center, axis) >= meshlet.Cone.w * length(center) + radius)
+			return false;
+	}
+
+	return !IsOccluded(worldCenter, radius);
+}
+
+void main() {
+	if (gl_LocalInvocationIndex == 0)
+		VisibleCount = 0;
+
+	barrier();
+
+	uint index = gl_GlobalInvocationID.x;
+
+	if (index < MeshletCount && IsMeshletVisible(index)) {
+		uint slot = atomicAdd(VisibleCount, 1);
+		Payload.MeshletIndices[slot] = index;
+	}
+
+	barrier();
+
+	EmitMeshTasksEXT(VisibleCount, 1, 1);
+}
@@ -36,6 +36,9 @@ const int AM_OPAQUE = 0;
 const int AM_BLEND = 1;
 const int AM_MASK = 2;
 
+// Specialized per draw bucket (see Assets::DrawBucket), only the alpha tested pipelines keep the discard.
+[[vk::constant_id(0)]] const bool AlphaTest = true;
+
 struct Material {
 	int AlbedoMapIndex;
 	int NormalMapIndex;
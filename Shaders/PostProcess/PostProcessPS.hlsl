@@ -0,0 +1,63 @@
+#include "../Util.hlsli"
+
+// Post processing uber shader, see PostProcessStack. Every stage is compiled in or out by its specialization constant,
+// fused they all run on the same texel read, unfused every pass enables one stage.
+
+[[vk::binding(0, 0)]]
+Texture2D InputTexture;
+[[vk::binding(0, 0)]]
+SamplerState InputSampler;
+
+[[vk::binding(0, 1)]]
+Texture2D BloomTexture;
+[[vk::binding(0, 1)]]
+SamplerState BloomSampler;
+
+// Same order as PostProcessStage.
+[[vk::constant_id(0)]] const bool BloomStage = true;
+[[vk::constant_id(1)]] const bool ExposureStage = true;
+[[vk::constant_id(2)]] const bool TonemapStage = true;
+[[vk::constant_id(3)]] const bool GradingStage = true;
+// Writes the swapchain, linear to sRGB.
+[[vk::constant_id(4)]] const bool EncodeOutput = true;
+
+// PostProcessParameters.
+[[vk::push_constant]]
+cbuffer _ {
+    float BloomStrength;
+    float Exposure;
+    float Saturation;
+    float Contrast;
+};
+
+struct VS_Output {
+	float4 Position : SV_POSITION;
+	float2 UV : TEXCOORD0;
+};
+
+float4 main(VS_Output input) {
+	float3 color = InputTexture.Sample(InputSampler, input.UV).rgb;
+
+	if (BloomStage) {
+		float3 bloom = BloomTexture.Sample(BloomSampler, input.UV).rgb;
+		color = lerp(color, bloom, BloomStrength);
+	}
+
+	if (ExposureStage)
+		color *= exp2(Exposure);
+
+	if (TonemapStage)
+		color = tonemap(color);
+
+	// Around mid grey, after tonemapping.
+	if (GradingStage) {
+		float luminance = dot(color, float3(0.2126, 0.7152, 0.0722));
+		color = lerp(luminance, color, Saturation);
+		color = max((color - 0.18f) * Contrast + 0.18f, 0.f);
+	}
+
+	if (EncodeOutput)
+		color = LinearTosRGB(color);
+
+	return float4(color, 1.f);
+}
@@ -27,6 +27,8 @@ struct PrimitiveData {
 	int4 MaterialIndex;
 	float4x4 NodeMatrix;
 	float4 NodePos;
+	float4 PosOffset;
+	float4 PosScale;
 };
 
 [[vk::binding(0, 7)]]
@@ -38,17 +40,20 @@ float3 CompressNormals(const float3 normal)
 }
 
 float4 main( PS_Input input ) {
-	PrimitiveData data = SSBO[input.index];
-	Material mat = Materials[int(data.MaterialIndex.x)];
-	
-	float4 albedoColor = mat.BaseColor;
-	
-	if(mat.AlbedoMapIndex > -1) {
-		albedoColor *= sRGBToLinear( Textures[mat.AlbedoMapIndex].Sample(Samplers[mat.AlbedoMapIndex], input.UV ) );
+	// Opaque variants skip the material fetch entirely.
+	if(AlphaTest) {
+		PrimitiveData data = SSBO[input.index];
+		Material mat = Materials[int(data.MaterialIndex.x)];
+		
+		float4 albedoColor = mat.BaseColor;
+		
+		if(mat.AlbedoMapIndex > -1) {
+			albedoColor *= sRGBToLinear( Textures[mat.AlbedoMapIndex].Sample(Samplers[mat.AlbedoMapIndex], input.UV ) );
+		}
+
+		if(albedoColor.a < mat.AlphaCutoff)
+			discard;
 	}
-
-	if(albedoColor.a < mat.AlphaCutoff)
-		discard;
 	
 	return float4( CompressNormals( normalize(input.Normal) ), 1.f );
 }
\ No newline at end of file
@@ -21,21 +21,26 @@ struct PrimitiveData {
 	int4 MaterialIndex;
 	float4x4 NodeMatrix;
 	float4 NodePos;
+	float4 PosOffset;
+	float4 PosScale;
 };
 
 [[vk::binding(0, 4)]]
 StructuredBuffer<PrimitiveData> Primitives;
 
 void main( PS_Input input ) {
-	PrimitiveData data = Primitives[input.index];
-	Material mat = Materials[int(data.MaterialIndex.x)];
-	
-	float4 albedoColor = mat.BaseColor;
-	
-	if(mat.AlbedoMapIndex > -1) {
-		albedoColor *= sRGBToLinear( Textures[mat.AlbedoMapIndex].Sample(Samplers[mat.AlbedoMapIndex], input.UV ) );
+	// Opaque variants skip the material fetch entirely.
+	if(AlphaTest) {
+		PrimitiveData data = Primitives[input.index];
+		Material mat = Materials[int(data.MaterialIndex.x)];
+		
+		float4 albedoColor = mat.BaseColor;
+		
+		if(mat.AlbedoMapIndex > -1) {
+			albedoColor *= sRGBToLinear( Textures[mat.AlbedoMapIndex].Sample(Samplers[mat.AlbedoMapIndex], input.UV ) );
+		}
+
+		if(albedoColor.a < mat.AlphaCutoff)
+			discard;
 	}
-
-	if(albedoColor.a < mat.AlphaCutoff)
-		discard;
 }
\ No newline at end of file
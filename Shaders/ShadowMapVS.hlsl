@@ -1,11 +1,18 @@
 #pragma pack_matrix(row_major)
 
+#include "VertexDecode.hlsli"
+
+#define VERTEX_ANIMATION_SET 5
+#include "VertexAnimation.hlsli"
+
 #define SHADOW_MAP_CASCADE_COUNT 4
 
 struct PrimitiveData {
 	int4 MaterialIndex;
 	float4x4 NodeMatrix;
 	float4 NodePos;
+	float4 PosOffset;
+	float4 PosScale;
 };
 
 [[vk::push_constant]]
@@ -16,8 +23,7 @@ cbuffer PushConst {
 [[vk::binding(0, 0)]]
 cbuffer _ {
 	float4x4 ModelMatrix;
-	float4x4 ViewMatrix;
-	float4x4 ProjectionMatrix;
+	float4 Time;
 };
 
 [[vk::binding(0, 1)]]
@@ -31,12 +37,13 @@ cbuffer ShadowMapUBO {
 StructuredBuffer<PrimitiveData> SSBO;
 
 struct VS_Input {
-	float3 Position : POSIITON;
+	float4 Position : POSIITON;
 	float3 Normal : NORMAL;
 	float2 UV : TEXCOORD0;
 	float4 Tangent : TANGENT;
 
 	int Index : SV_InstanceID;
+	uint VertexId : SV_VertexID; // Base vertex included.
 };
 
 struct VS_Output {
@@ -49,10 +56,15 @@ VS_Output main(VS_Input input)
 {
 	VS_Output outp;
 
-	float4 res = float4(input.Position, 1.f);
-	
 	PrimitiveData data = SSBO[input.Index];
 
+	float4 res = float4(DecodePosition(input.Position, data.PosOffset, data.PosScale), 1.f);
+
+	if (HasVertexAnimation(data.MaterialIndex)) {
+		float3 normal = 0.f;
+		FetchVertexAnimation(input.VertexId, Time.x + data.PosOffset.w, res.xyz, normal);
+	}
+
 	res = mul(res, data.NodeMatrix);
 	res = mul(res, ModelMatrix);
 	res = mul(res, CascadeViewMatrices[CascadeIndex]);
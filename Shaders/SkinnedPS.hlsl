@@ -28,6 +28,8 @@ struct PrimitiveData {
 	int4 MaterialIndex;
 	float4x4 WorldMatrix;
 	float4 NodePos;
+	float4 PosOffset;
+	float4 PosScale;
 };
 
 [[vk::binding(0, 7)]]
@@ -1,11 +1,15 @@
 #pragma pack_matrix(row_major)
 
+#include "VertexDecode.hlsli"
+
 #define SHADOW_MAP_CASCADE_COUNT 4
 
 struct PrimitiveData {
-	int4 MaterialIndex;
+	int4 MaterialIndex; // z: morph output of vertex 0 minus the base vertex, w: first joint matrix of the instance palette.
 	float4x4 NodeMatrix;
 	float4 NodePos;
+	float4 PosOffset; // w: 1 when the primitive has morph targets.
+	float4 PosScale;
 };
 
 const int MAX_JOINTS = 128;
@@ -41,8 +45,17 @@ StructuredBuffer<PrimitiveData> SSBO;
 [[vk::binding(0, 5)]]
 StructuredBuffer<float4x4> JointMatrices;
 
+struct MorphOutput {
+	float4 Position;
+	float4 Normal;
+};
+
+// Position and normal deltas written by Compute/MorphTargetsCS.hlsl.
+[[vk::binding(0, 6)]]
+StructuredBuffer<MorphOutput> MorphOutputs;
+
 struct VS_Input {
-	float3 Position : POSIITON;
+	float4 Position : POSIITON;
 	float3 Normal : NORMAL;
 	float2 UV : TEXCOORD0;
 	float4 Tangent : TANGENT;
@@ -50,18 +63,24 @@ struct VS_Input {
 	float4 Weights : WEIGHTS;
 
 	int Index : SV_InstanceID;
+	uint VertexId : SV_VertexID; // Base vertex included.
 };
 
 float4 main(VS_Input input) : SV_POSITION
 {
-	float4 res = float4(input.Position, 1.f);
-	
 	PrimitiveData primData = SSBO[input.Index];
 
-	float4x4 skinMat = mul(JointMatrices[input.Joints.x], input.Weights.x) +
-		mul(JointMatrices[input.Joints.y], input.Weights.y) +
-		mul(JointMatrices[input.Joints.z], input.Weights.z) +
-		mul(JointMatrices[input.Joints.w], input.Weights.w);
+	float4 res = float4(DecodePosition(input.Position, primData.PosOffset, primData.PosScale), 1.f);
+
+	if (primData.PosOffset.w > 0.f)
+		res.xyz += MorphOutputs[primData.MaterialIndex.z + int(input.VertexId)].Position.xyz;
+
+	uint4 joints = input.Joints + primData.MaterialIndex.w;
+
+	float4x4 skinMat = mul(JointMatrices[joints.x], input.Weights.x) +
+		mul(JointMatrices[joints.y], input.Weights.y) +
+		mul(JointMatrices[joints.z], input.Weights.z) +
+		mul(JointMatrices[joints.w], input.Weights.w);
 
 	res = mul(res, skinMat);
 	
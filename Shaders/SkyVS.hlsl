@@ -1,5 +1,18 @@
 #pragma pack_matrix(row_major)
 
+#include "VertexDecode.hlsli"
+
+struct PrimitiveData {
+	int4 MaterialIndex;
+	float4x4 NodeMatrix;
+	float4 NodePos;
+	float4 PosOffset;
+	float4 PosScale;
+};
+
+[[vk::binding(0, 7)]]
+StructuredBuffer<PrimitiveData> SSBO;
+
 [[vk::binding(0, 0)]]
 cbuffer _ {
 	float4x4 ModelMatrix;
@@ -15,10 +28,12 @@ cbuffer _ {
 };
 
 struct VS_Input {
-	float3 Position : POSITION;
+	float4 Position : POSITION;
 	float3 Normal : NORMAL;
 	float2 UV : TEXCOORD;
 
+	int index : SV_InstanceID;
+
 	
 };
 
@@ -38,12 +53,15 @@ const float4x4 Model =
 VS_Output main(VS_Input input) {
 	VS_Output res;
 	
-	res.UVW = input.Position;
+	PrimitiveData data = SSBO[input.index];
+	float3 position = DecodePosition(input.Position, data.PosOffset, data.PosScale);
+
+	res.UVW = position;
 	
 	float4x4 mat = ViewMatrix;
 	mat[3][0] = mat[3][1] = mat[3][2] = 0.f;
 
-	res.Position = mul(float4(input.Position, 1.f), Model);
+	res.Position = mul(float4(position, 1.f), Model);
 	res.Position = mul(res.Position, mat);
 	res.Position = mul(res.Position, ProjectionMatrix);
 	
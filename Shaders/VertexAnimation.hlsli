@@ -0,0 +1,36 @@
+// Playback of the clips baked by SkinnedGLTFAsset::BakeVertexAnimation (see Engine/Assets/glTF/CrowdGLTFAsset.hpp).
+// Define VERTEX_ANIMATION_SET before including, needs VertexDecode.hlsli.
+
+// Texel 0: frame count, vertex count, frame rate (float bits), base vertex of the asset.
+// Then vertex count texels per frame. xyz: position (float bits), w: octahedral snorm16x2 normal.
+[[vk::binding(0, VERTEX_ANIMATION_SET)]]
+StructuredBuffer<uint4> VertexAnimation;
+
+// PrimitiveData.MaterialIndex.w, the clip time offset of the instance is in PosOffset.w.
+bool HasVertexAnimation(int4 materialIndex) {
+	return materialIndex.w > 0;
+}
+
+float2 UnpackSnorm16x2(uint packed) {
+	int2 v = int2(int(packed << 16) >> 16, int(packed) >> 16);
+	return max(float2(v) / 32767.f, -1.f);
+}
+
+// vertexId is SV_VertexID, base vertex included. Blends the two frames around the time, wrapping at the clip end.
+void FetchVertexAnimation(uint vertexId, float time, inout float3 position, inout float3 normal) {
+	uint4 header = VertexAnimation[0];
+	uint frameCount = header.x;
+	uint vertexCount = header.y;
+
+	float frame = max(time, 0.f) * asfloat(header.z);
+	uint f0 = uint(frame) % frameCount;
+	uint f1 = (f0 + 1) % frameCount;
+	float t = frac(frame);
+
+	uint vertex = vertexId - header.w;
+	uint4 v0 = VertexAnimation[1 + f0 * vertexCount + vertex];
+	uint4 v1 = VertexAnimation[1 + f1 * vertexCount + vertex];
+
+	position = lerp(asfloat(v0.xyz), asfloat(v1.xyz), t);
+	normal = normalize(lerp(OctDecode(UnpackSnorm16x2(v0.w)), OctDecode(UnpackSnorm16x2(v1.w)), t));
+}
@@ -0,0 +1,25 @@
+// Decoding for the packed vertex layout (see Engine/Assets/glTF/VertexPacking.hpp).
+// PosScale.w is 1 when the asset was loaded with packed vertices, full precision vertices pass through unchanged.
+
+float3 OctDecode(float2 e) {
+	float3 n = float3(e.x, e.y, 1.f - abs(e.x) - abs(e.y));
+	float t = saturate(-n.z);
+
+	n.x += n.x >= 0.f ? -t : t;
+	n.y += n.y >= 0.f ? -t : t;
+
+	return normalize(n);
+}
+
+float3 DecodePosition(float4 position, float4 posOffset, float4 posScale) {
+	return position.xyz * posScale.xyz + posOffset.xyz;
+}
+
+float3 DecodeNormal(float3 normal, float4 posScale) {
+	return posScale.w > 0.f ? OctDecode(normal.xy) : normal;
+}
+
+// Packed tangents keep the handedness in the position w component.
+float4 DecodeTangent(float4 tangent, float4 position, float4 posScale) {
+	return posScale.w > 0.f ? float4(OctDecode(tangent.xy), position.w * 2.f - 1.f) : tangent;
+}